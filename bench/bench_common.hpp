@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/intersection.hpp"
+#include "renderer/renderer.hpp"
+
+// Helpers shared by the benchmarks. Images are RGBA32F, as Renderer::readAccumulation returns them
+namespace Bench {
+	inline double luminance(const std::vector<float>& pixels, size_t i) {
+		return 0.2126 * pixels[i] + 0.7152 * pixels[i + 1] + 0.0722 * pixels[i + 2];
+	}
+
+	inline double meanLuminance(const std::vector<float>& pixels) {
+		double sum = 0.0;
+		for (size_t i = 0; i + 3 < pixels.size(); i += 4)
+			sum += luminance(pixels, i);
+		return pixels.empty() ? 0.0 : sum / static_cast<double>(pixels.size() / 4);
+	}
+
+	// Relative RMSE over the pixels' luminance, with a floor so near-black pixels don't dominate
+	inline double relativeError(const std::vector<float>& reference, const std::vector<float>& test) {
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i + 3 < reference.size() && i + 3 < test.size(); i += 4) {
+			double ref = luminance(reference, i);
+			double error = (luminance(test, i) - ref) / std::max(ref, 1e-2);
+			sum += error * error;
+			count++;
+		}
+		return count > 0 ? std::sqrt(sum / static_cast<double>(count)) : 0.0;
+	}
+
+	// RMSE of the pixels' luminance relative to the reference's mean. Unlike relativeError, it isn't dominated by
+	// the rare fireflies in pixels the reference still has black
+	inline double normalizedError(const std::vector<float>& reference, const std::vector<float>& test) {
+		double sum = 0.0;
+		double mean = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i + 3 < reference.size() && i + 3 < test.size(); i += 4) {
+			double ref = luminance(reference, i);
+			double value = luminance(test, i);
+			sum += (value - ref) * (value - ref);
+			mean += ref;
+			count++;
+		}
+		if (count == 0 || mean <= 0.0)
+			return 0.0;
+		return std::sqrt(sum / static_cast<double>(count)) / (mean / static_cast<double>(count));
+	}
+
+	// Signed difference of the mean brightness, as a fraction of the reference's. Noise averages out over the
+	// image, so this stays near 0 unless an estimator is biased
+	inline double meanError(const std::vector<float>& reference, const std::vector<float>& test) {
+		double referenceMean = meanLuminance(reference);
+		return (meanLuminance(test) - referenceMean) / std::max(referenceMean, 1e-6);
+	}
+
+	// Plain path tracing converges to the same image as the modes compared against it, it just takes many samples.
+	// Offset so its samples are independent of the compared renders, which would otherwise share its first frames
+	inline std::vector<float> renderReference(Renderer& renderer, const Camera& camera, uint32_t samples) {
+		renderer.setSamplesPerPixel(16);
+		renderer.setFrameOffset(1u << 20);
+		for (uint32_t rendered = 0; rendered < samples; rendered += 16)
+			renderer.render(camera);
+		std::vector<float> reference;
+		renderer.readAccumulation(reference);
+		renderer.setFrameOffset(0);
+		return reference;
+	}
+
+	// Same primitive at the same distance, or both missed
+	inline bool sameHit(const Intersection::Hit& a, const Intersection::Hit& b) {
+		return a.type == b.type && a.index == b.index && (a.index < 0 || a.distance == b.distance);
+	}
+}
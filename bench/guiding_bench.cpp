@@ -0,0 +1,105 @@
+// Compares plain path tracing against path guiding at equal render time on scenes lit mostly through indirect
+// paths: image error against a long reference after a quarter, half and all of the time budget, rendering the
+// scene's samples per pixel each frame. Guided time includes training, the guide learns from the same frames that
+// are accumulated. Fails if either mode's mean brightness ends further than MAX_MEAN_ERROR from the reference's, which
+// guiding can only cause by weighting its samples wrongly.
+// Usage: guiding_bench [scene.json] [seconds] [reference samples]
+// Without a scene, runs cornell_box_4 and cornell_box_5. Run from the repository root so shaders/ is found.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "bench_common.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/gl_context.hpp"
+
+static const uint32_t WIDTH = 320;
+static const uint32_t HEIGHT = 180;
+static const double CHECKPOINTS[] = { 0.25, 0.5, 1.0 };  // Fractions of the time budget
+static const double MAX_MEAN_ERROR = 0.05;  // Mirror and glass paths leave more noise in the mean than diffuse scenes
+
+static bool runScene(const std::string& scenePath, double seconds, uint32_t referenceSamples) {
+    Scene scene;
+    if (!SceneLoader::loadScene(scenePath, scene))
+        return false;
+
+    Renderer renderer(WIDTH, HEIGHT);
+    renderer.loadScene(scene);
+
+    std::vector<float> reference = Bench::renderReference(renderer, scene.camera, referenceSamples);
+
+    std::printf("\n%s, %.1f s per mode\n", scenePath.c_str(), seconds);
+    std::printf("%-8s %8s %10s", "Mode", "Frames", "Frame ms");
+    for (double checkpoint : CHECKPOINTS)
+        std::printf("   err%% @ %3.0f%%", checkpoint * 100.0);
+    std::printf(" %10s %8s\n", "Mean err %", "Trained");
+
+    bool ok = true;
+    for (bool guided : { false, true }) {
+        GuidingSettings settings;
+        settings.enabled = guided;
+        renderer.setGuiding(settings);
+
+        // Restarts accumulation and training, each mode starts cold
+        renderer.loadScene(scene);
+        glFinish();
+
+        std::vector<double> errors;
+        std::vector<float> pixels;
+        uint32_t frames = 0;
+        size_t nextCheckpoint = 0;
+        double renderSeconds = 0.0;
+        while (nextCheckpoint < std::size(CHECKPOINTS)) {
+            auto start = std::chrono::steady_clock::now();
+            renderer.render(scene.camera);
+            glFinish();
+            renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            frames++;
+
+            // Readbacks stay out of the timing
+            while (nextCheckpoint < std::size(CHECKPOINTS) && renderSeconds >= CHECKPOINTS[nextCheckpoint] * seconds) {
+                renderer.readAccumulation(pixels);
+                errors.push_back(Bench::normalizedError(reference, pixels));
+                nextCheckpoint++;
+            }
+        }
+
+        std::printf("%-8s %8u %10.2f", guided ? "Guided" : "Plain", frames, renderSeconds * 1000.0 / std::max(frames, 1u));
+        for (double error : errors)
+            std::printf(" %14.2f", error * 100.0);
+        // The last checkpoint read the whole budget's image
+        double meanError = Bench::meanError(reference, pixels);
+        ok &= std::abs(meanError) <= MAX_MEAN_ERROR;
+        std::printf(" %10.2f %8s\n", meanError * 100.0, guided ? (renderer.isGuideTrained() ? "yes" : "no") : "-");
+    }
+
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> scenes = { "scenes/cornell_box_4.json", "scenes/cornell_box_5.json" };
+    if (argc > 1)
+        scenes = { argv[1] };
+    double seconds = argc > 2 ? std::atof(argv[2]) : 10.0;
+    uint32_t referenceSamples = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 4096;
+
+    GLFWwindow* context = createHeadlessContext(WIDTH, HEIGHT);
+    if (!context)
+        return EXIT_FAILURE;
+
+    bool ok = true;
+    for (const std::string& scenePath : scenes)
+        ok &= runScene(scenePath, seconds, referenceSamples);
+
+    destroyHeadlessContext(context);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+// Compares ray-primitive intersection on the scene's AoS layout against the SoA kernels at each
+// SIMD level, and checks that every level returns exactly the same closest hits as the AoS loop.
+// Usage: intersection_bench [primitives per type] [rays]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "geometry/intersection.hpp"
+#include "renderer/types.hpp"
+
+using namespace Intersection;
+
+struct Geometry {
+    std::vector<Sphere> spheres;
+    std::vector<Plane> planes;
+    std::vector<Quad> quads;
+};
+
+static Geometry generateGeometry(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+    auto randomDirection = [&]() {
+        glm::vec3 direction;
+        do {
+            direction = glm::vec3(unit(rng), unit(rng), unit(rng));
+        } while (glm::dot(direction, direction) < 1e-3f);
+        return glm::normalize(direction);
+    };
+
+    Geometry geometry;
+    for (size_t i = 0; i < count; ++i) {
+        Sphere sphere = {};
+        sphere.position = glm::vec3(position(rng), position(rng), position(rng));
+        sphere.radius = size(rng);
+        sphere.radiusSquared = sphere.radius * sphere.radius;
+        geometry.spheres.push_back(sphere);
+
+        Plane plane = {};
+        plane.position = glm::vec3(position(rng), position(rng), position(rng));
+        plane.normal = randomDirection();
+        geometry.planes.push_back(plane);
+
+        Quad quad = {};
+        quad.position = glm::vec3(position(rng), position(rng), position(rng));
+        quad.normal = randomDirection();
+        glm::vec3 helper = std::abs(quad.normal.y) < 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        quad.right = glm::normalize(glm::cross(helper, quad.normal));
+        quad.up = glm::cross(quad.normal, quad.right);
+        quad.width = size(rng) * 2.0f;
+        quad.height = size(rng) * 2.0f;
+        geometry.quads.push_back(quad);
+    }
+    return geometry;
+}
+
+// The per-primitive loop a CPU port of CalculateRayCollision would use, on the GPU layout
+template <typename Primitive>
+static Hit closestAoS(const Ray& ray, const std::vector<Primitive>& primitives, bool (*intersect)(const Ray&, const Primitive&, float&), HitType type) {
+    Hit hit;
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        float distance;
+        if (intersect(ray, primitives[i], distance) && distance < hit.distance) {
+            hit.type = type;
+            hit.index = static_cast<int>(i);
+            hit.distance = distance;
+        }
+    }
+    return hit;
+}
+
+// Best of a few runs, returns seconds
+static double timeRays(const std::vector<Ray>& rays, std::vector<Hit>& hits, const std::function<Hit(const Ray&)>& trace) {
+    double best = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < rays.size(); ++i)
+            hits[i] = trace(rays[i]);
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 4099;  // Not a multiple of 8, so the tails run too
+    size_t rayCount = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 4096;
+
+    std::mt19937 rng(1234);
+    Geometry geometry = generateGeometry(count, rng);
+    PrimitiveSoA soa = buildPrimitiveSoA(geometry.spheres, geometry.planes, geometry.quads);
+
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(rayCount);
+    for (Ray& ray : rays) {
+        ray.origin = glm::vec3(position(rng), position(rng), position(rng));
+        ray.dir = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-4f));
+    }
+
+    std::printf("%zu primitives per type, %zu rays, CPU supports %s\n\n", count, rayCount, getSimdLevelName(getSupportedSimdLevel()));
+    std::printf("%-8s %-10s %14s %10s %12s %10s\n", "Type", "Layout", "Mtests/s", "Speedup", "Mismatches", "Hit rays");
+
+    struct TypeCase {
+        const char* name;
+        std::function<Hit(const Ray&)> aos;
+        std::function<Hit(const Ray&)> soa;
+    };
+    const TypeCase cases[] = {
+        { "Sphere", [&](const Ray& r) { return closestAoS(r, geometry.spheres, intersectSphere, HitType::Sphere); },
+                    [&](const Ray& r) { return intersectClosest(r, soa.spheres); } },
+        { "Plane", [&](const Ray& r) { return closestAoS(r, geometry.planes, intersectPlane, HitType::Plane); },
+                   [&](const Ray& r) { return intersectClosest(r, soa.planes); } },
+        { "Quad", [&](const Ray& r) { return closestAoS(r, geometry.quads, intersectQuad, HitType::Quad); },
+                  [&](const Ray& r) { return intersectClosest(r, soa.quads); } },
+    };
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2 };
+    double tests = static_cast<double>(count) * static_cast<double>(rayCount);
+    size_t totalMismatches = 0;
+
+    for (const TypeCase& type : cases) {
+        std::vector<Hit> reference(rayCount);
+        double aosSeconds = timeRays(rays, reference, type.aos);
+
+        size_t hitRays = 0;
+        for (const Hit& hit : reference)
+            hitRays += hit.index >= 0 ? 1 : 0;
+        std::printf("%-8s %-10s %14.1f %9.2fx %12s %10zu\n", type.name, "AoS", tests / aosSeconds / 1e6, 1.0, "-", hitRays);
+
+        for (SimdLevel level : levels) {
+            if (static_cast<int>(level) > static_cast<int>(getSupportedSimdLevel()))
+                continue;
+            setSimdLevel(level);
+
+            std::vector<Hit> hits(rayCount);
+            double seconds = timeRays(rays, hits, type.soa);
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < rayCount; ++i)
+                mismatches += Bench::sameHit(hits[i], reference[i]) ? 0 : 1;
+            totalMismatches += mismatches;
+
+            std::printf("%-8s SoA %-6s %14.1f %9.2fx %12zu\n", "", getSimdLevelName(level), tests / seconds / 1e6, aosSeconds / seconds, mismatches);
+        }
+    }
+
+    // All types together, against the shader's sphere, plane, quad order
+    for (SimdLevel level : levels) {
+        if (static_cast<int>(level) > static_cast<int>(getSupportedSimdLevel()))
+            continue;
+        setSimdLevel(level);
+        for (const Ray& ray : rays) {
+            Hit expected = cases[0].aos(ray);
+            for (int t = 1; t < 3; ++t) {
+                Hit candidate = cases[t].aos(ray);
+                if (candidate.index >= 0 && candidate.distance < expected.distance)
+                    expected = candidate;
+            }
+            totalMismatches += Bench::sameHit(intersectClosest(ray, soa), expected) ? 0 : 1;
+        }
+    }
+
+    std::printf("\n%s\n", totalMismatches == 0 ? "All SIMD levels match the AoS reference" : "MISMATCH between SIMD and AoS results");
+    return totalMismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+// Times picking through the scene index against testing every primitive, checks both find the same hits, and
+// times refitting the index after single-primitive edits like the inspector makes.
+// Usage: picking_bench [primitives] [rays] [edits]
+// Primitives are split between spheres, quads, boxes, discs and cylinders, scattered in a 200 unit cube.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "geometry/intersection.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_compiler.hpp"
+#include "scene/scene_index.hpp"
+
+using namespace Intersection;
+
+static Scene generateScene(size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.2f, 1.0f);
+
+    auto randomDirection = [&]() {
+        glm::vec3 direction;
+        do {
+            direction = glm::vec3(unit(rng), unit(rng), unit(rng));
+        } while (glm::dot(direction, direction) < 1e-3f);
+        return glm::normalize(direction);
+    };
+
+    Scene scene;
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 centre(position(rng), position(rng), position(rng));
+        switch (i % 5) {
+        case 0: {
+            Sphere sphere = {};
+            sphere.position = centre;
+            sphere.radius = size(rng);
+            scene.spheres.push_back(sphere);
+            break;
+        }
+        case 1: {
+            Quad quad = {};
+            quad.position = centre;
+            quad.normal = randomDirection();
+            quad.right = randomDirection();
+            quad.up = randomDirection();
+            quad.width = size(rng) * 2.0f;
+            quad.height = size(rng) * 2.0f;
+            scene.quads.push_back(quad);
+            break;
+        }
+        case 2: {
+            Box box = {};
+            box.position = centre;
+            box.right = randomDirection();
+            box.up = randomDirection();
+            box.width = size(rng) * 2.0f;
+            box.height = size(rng) * 2.0f;
+            box.depth = size(rng) * 2.0f;
+            scene.boxes.push_back(box);
+            break;
+        }
+        case 3: {
+            Disc disc = {};
+            disc.position = centre;
+            disc.normal = randomDirection();
+            disc.radius = size(rng);
+            scene.discs.push_back(disc);
+            break;
+        }
+        default: {
+            Cylinder cylinder = {};
+            cylinder.position = centre;
+            cylinder.axis = randomDirection();
+            cylinder.radius = size(rng) * 0.5f;
+            cylinder.height = size(rng) * 2.0f;
+            scene.cylinders.push_back(cylinder);
+            break;
+        }
+        }
+    }
+    SceneCompiler::compile(scene);
+    return scene;
+}
+
+// Every primitive in turn, the way picking would work without an index
+static Hit pickLinear(const Ray& ray, const Scene& scene) {
+    Hit hit;
+    auto consider = [&](bool found, float distance, HitType type, size_t index, int face) {
+        if (found && distance < hit.distance) {
+            hit.type = type;
+            hit.index = static_cast<int>(index);
+            hit.distance = distance;
+            hit.face = face;
+        }
+    };
+
+    float distance;
+    int face = -1;
+    for (size_t i = 0; i < scene.spheres.size(); ++i) {
+        bool found = intersectSphere(ray, scene.spheres[i], distance);
+        consider(found, distance, HitType::Sphere, i, -1);
+    }
+    for (size_t i = 0; i < scene.planes.size(); ++i) {
+        bool found = intersectPlane(ray, scene.planes[i], distance);
+        consider(found, distance, HitType::Plane, i, -1);
+    }
+    for (size_t i = 0; i < scene.quads.size(); ++i) {
+        bool found = intersectQuad(ray, scene.quads[i], distance);
+        consider(found, distance, HitType::Quad, i, -1);
+    }
+    for (size_t i = 0; i < scene.boxes.size(); ++i) {
+        bool found = intersectBox(ray, scene.boxes[i], distance, face);
+        consider(found, distance, HitType::Box, i, face);
+    }
+    for (size_t i = 0; i < scene.discs.size(); ++i) {
+        bool found = intersectDisc(ray, scene.discs[i], distance);
+        consider(found, distance, HitType::Disc, i, -1);
+    }
+    for (size_t i = 0; i < scene.cylinders.size(); ++i) {
+        bool found = intersectCylinder(ray, scene.cylinders[i], distance);
+        consider(found, distance, HitType::Cylinder, i, -1);
+    }
+    return hit;
+}
+
+struct Timing {
+    double meanUs = 0.0;
+    double maxUs = 0.0;
+};
+
+template <typename Pick>
+static Timing timePicks(const std::vector<Ray>& rays, std::vector<Hit>& hits, Pick pick) {
+    Timing timing;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        hits[i] = pick(rays[i]);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        timing.meanUs += us;
+        timing.maxUs = std::max(timing.maxUs, us);
+    }
+    timing.meanUs /= std::max<size_t>(rays.size(), 1);
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 100000;
+    size_t rayCount = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 1000;
+    size_t editCount = argc > 3 ? static_cast<size_t>(std::atol(argv[3])) : 1000;
+
+    std::mt19937 rng(1234);
+    Scene scene = generateScene(count, rng);
+
+    // Camera-like rays from outside the cloud, aimed at points inside it
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::vector<Ray> rays(rayCount);
+    for (Ray& ray : rays) {
+        ray.origin = glm::vec3(position(rng), position(rng), 250.0f);
+        ray.dir = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) - ray.origin);
+    }
+
+    SceneIndex index;
+    auto start = std::chrono::steady_clock::now();
+    index.build(scene);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu primitives, %zu nodes, built in %.1f ms\n\n", index.getPrimitiveCount(), index.getNodeCount(), buildMs);
+
+    std::vector<Hit> reference(rayCount);
+    std::vector<Hit> hits(rayCount);
+    Timing linear = timePicks(rays, reference, [&](const Ray& ray) { return pickLinear(ray, scene); });
+    Timing indexed = timePicks(rays, hits, [&](const Ray& ray) { return index.intersect(ray, scene); });
+
+    size_t mismatches = 0;
+    size_t hitRays = 0;
+    for (size_t i = 0; i < rayCount; ++i) {
+        mismatches += Bench::sameHit(hits[i], reference[i]) ? 0 : 1;
+        hitRays += reference[i].index >= 0 ? 1 : 0;
+    }
+
+    std::printf("%-18s %12s %12s %12s\n", "Picking", "Mean us", "Max us", "Mismatches");
+    std::printf("%-18s %12.1f %12.1f %12s\n", "Every primitive", linear.meanUs, linear.maxUs, "-");
+    std::printf("%-18s %12.1f %12.1f %12zu\n", "Scene index", indexed.meanUs, indexed.maxUs, mismatches);
+
+    // Inspector edits: one primitive moves a short way and the index refits around it
+    std::uniform_int_distribution<size_t> pickSphere(0, scene.spheres.size() > 0 ? scene.spheres.size() - 1 : 0);
+    std::uniform_real_distribution<float> offset(-5.0f, 5.0f);
+    double refitUs = 0.0;
+    for (size_t edit = 0; edit < editCount && !scene.spheres.empty(); ++edit) {
+        size_t i = pickSphere(rng);
+        scene.spheres[i].position += glm::vec3(offset(rng), offset(rng), offset(rng));
+        start = std::chrono::steady_clock::now();
+        index.update(scene, HitType::Sphere, i);
+        refitUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    linear = timePicks(rays, reference, [&](const Ray& ray) { return pickLinear(ray, scene); });
+    indexed = timePicks(rays, hits, [&](const Ray& ray) { return index.intersect(ray, scene); });
+    size_t editedMismatches = 0;
+    for (size_t i = 0; i < rayCount; ++i)
+        editedMismatches += Bench::sameHit(hits[i], reference[i]) ? 0 : 1;
+    mismatches += editedMismatches;
+
+    std::printf("%-18s %12.1f %12.1f %12zu\n", "After edits", indexed.meanUs, indexed.maxUs, editedMismatches);
+    std::printf("\n%zu sphere edits, %.2f us per refit, %zu of %zu rays hit\n", editCount, refitUs / std::max<size_t>(editCount, 1), hitRays, rayCount);
+
+    std::printf("\n%s\n", mismatches == 0 ? "The index matches testing every primitive" : "MISMATCH between the index and testing every primitive");
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
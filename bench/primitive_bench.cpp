@@ -0,0 +1,131 @@
+// Compares the bundled Cornell boxes built from native box primitives against the same rooms as six quads each,
+// the way the scenes were written before boxes existed. Reports primitive tests per path segment from the
+// instrumented shader, frame time with instrumentation off, and the images' mean luminance, which should match.
+// Fails if a scene doesn't load or its two means differ by more than MAX_MEAN_DIFFERENCE.
+// Usage: primitive_bench [scene.json ...] [--frames N]
+// Without scenes, runs cornell_box_1 to cornell_box_5. Run from the repository root so shaders/ is found.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "bench_common.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_compiler.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/gl_context.hpp"
+
+static const uint32_t WIDTH = 320;
+static const uint32_t HEIGHT = 180;
+static const double MAX_MEAN_DIFFERENCE = 0.01;  // Relative, the same paths only hit at slightly different distances
+
+// Replaces every box with its six faces as one-sided quads facing the same way the box's faces do
+static void expandBoxes(Scene& scene) {
+    for (const Box& box : scene.boxes) {
+        const glm::vec3 axes[3] = { box.right, box.up, box.forward };
+        for (int face = 0; face < BOX_FACE_COUNT; ++face) {
+            int axis = face / 2;
+            float side = face % 2 == 0 ? -1.0f : 1.0f;
+
+            Quad quad;
+            quad.position = box.position + axes[axis] * (side * box.halfSize[axis]);
+            quad.normal = axes[axis] * (box.inward ? -side : side);
+            quad.right = axes[(axis + 1) % 3];
+            quad.up = axes[(axis + 2) % 3];
+            quad.width = box.halfSize[(axis + 1) % 3] * 2.0f;
+            quad.height = box.halfSize[(axis + 2) % 3] * 2.0f;
+            quad.material = box.materials[face];
+            if (SceneCompiler::compileQuad(quad))
+                scene.quads.push_back(quad);
+        }
+    }
+    scene.boxes.clear();
+}
+
+struct Result {
+    double testsPerSegment;
+    double frameMs;
+    double mean;
+};
+
+static Result measure(Renderer& renderer, const Scene& scene, uint32_t frames) {
+    Result result;
+
+    renderer.setStatsEnabled(true);
+    renderer.loadScene(scene);
+    renderer.render(scene.camera);
+    renderer.flushRayStats();
+    const RayStats& stats = renderer.getRayStats();
+    result.testsPerSegment = static_cast<double>(stats.primitiveTests) / std::max<uint64_t>(stats.bounces, 1);
+    renderer.setStatsEnabled(false);
+
+    renderer.loadScene(scene);
+    renderer.render(scene.camera);
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame)
+        renderer.render(scene.camera);
+    glFinish();
+    result.frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / std::max(frames, 1u);
+
+    std::vector<float> pixels;
+    renderer.readAccumulation(pixels);
+    result.mean = Bench::meanLuminance(pixels);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> scenePaths;
+    uint32_t frames = 32;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else
+            scenePaths.push_back(argv[i]);
+    }
+    if (scenePaths.empty()) {
+        for (int i = 1; i <= 5; ++i)
+            scenePaths.push_back("scenes/cornell_box_" + std::to_string(i) + ".json");
+    }
+
+    GLFWwindow* context = createHeadlessContext(WIDTH, HEIGHT);
+    if (!context)
+        return EXIT_FAILURE;
+
+    bool ok = true;
+    {
+        Renderer renderer(WIDTH, HEIGHT);
+
+        std::printf("%-28s %-6s %12s %10s %10s\n", "Scene", "Walls", "Tests/seg", "Frame ms", "Mean");
+        for (const std::string& path : scenePaths) {
+            Scene scene;
+            if (!SceneLoader::loadScene(path, scene)) {
+                ok = false;
+                continue;
+            }
+            Scene quads = scene;
+            expandBoxes(quads);
+
+            Result before = measure(renderer, quads, frames);
+            Result after = measure(renderer, scene, frames);
+
+            std::string name = path.substr(path.find_last_of("/\\") + 1);
+            std::printf("%-28s %-6s %12.2f %10.2f %10.4f\n", name.c_str(), "Quads", before.testsPerSegment, before.frameMs, before.mean);
+            std::printf("%-28s %-6s %12.2f %10.2f %10.4f\n", "", "Box", after.testsPerSegment, after.frameMs, after.mean);
+            if (!(std::abs(after.mean - before.mean) <= MAX_MEAN_DIFFERENCE * std::max(before.mean, 1e-6)))
+                ok = false;
+        }
+    }
+
+    std::printf("\n%s\n", ok ? "Boxes and quads render the same images" : "MISMATCH between the box and quad renders");
+    destroyHeadlessContext(context);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+// Compares plain path tracing against reservoir direct lighting (ReSTIR), biased and unbiased, on a many-light
+// scene: image error against a long reference after a few frames, frame cost, and the mean brightness after
+// many frames, which drifts from the reference only if a mode is biased. Fails if plain path tracing or the unbiased
+// mode drifts further than MAX_MEAN_ERROR.
+// Usage: restir_bench [scene.json] [frames] [reference samples]
+// Run from the repository root so shaders/ is found.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "bench_common.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/gl_context.hpp"
+
+static const uint32_t WIDTH = 320;
+static const uint32_t HEIGHT = 180;
+static const uint32_t CHECKPOINTS[] = { 1, 2, 4, 8, 16 };
+static const double MAX_MEAN_ERROR = 0.02;
+
+int main(int argc, char** argv) {
+    std::string scenePath = argc > 1 ? argv[1] : "scenes/many_lights_1.json";
+    uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 256;
+    uint32_t referenceSamples = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : 4096;
+
+    GLFWwindow* context = createHeadlessContext(WIDTH, HEIGHT);
+    if (!context)
+        return EXIT_FAILURE;
+
+    Scene scene;
+    if (!SceneLoader::loadScene(scenePath, scene))
+        return EXIT_FAILURE;
+
+    bool ok = true;
+    {
+        Renderer renderer(WIDTH, HEIGHT);
+        renderer.loadScene(scene);
+        std::printf("%d sampled lights\n", renderer.getResources().getLightCount());
+
+        std::vector<float> reference = Bench::renderReference(renderer, scene.camera, referenceSamples);
+
+        struct Mode {
+            const char* name;
+            bool enabled;
+            bool unbiased;
+            bool checked;  // Must stay within MAX_MEAN_ERROR of the reference
+        };
+        const Mode modes[] = { { "Off", false, false, true }, { "Biased", true, false, false }, { "Unbiased", true, true, true } };
+
+        std::printf("\n%-10s %10s", "Mode", "Frame ms");
+        for (uint32_t checkpoint : CHECKPOINTS)
+            std::printf(" %8s%-3u", "err% @", checkpoint);
+        std::printf(" %14s\n", "Mean err %");
+
+        renderer.setSamplesPerPixel(1);
+        for (const Mode& mode : modes) {
+            RestirSettings settings;
+            settings.enabled = mode.enabled;
+            settings.unbiased = mode.unbiased;
+            renderer.setRestir(settings);
+
+            // Restarts accumulation and drops reservoirs, each mode starts cold
+            renderer.loadScene(scene);
+            renderer.setSamplesPerPixel(1);
+            glFinish();
+
+            std::vector<double> errors;
+            std::vector<float> pixels;
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 1; frame <= frames; ++frame) {
+                renderer.render(scene.camera);
+                for (uint32_t checkpoint : CHECKPOINTS) {
+                    if (frame == checkpoint) {
+                        renderer.readAccumulation(pixels);
+                        errors.push_back(Bench::relativeError(reference, pixels));
+                    }
+                }
+            }
+            glFinish();
+            double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / std::max(frames, 1u);
+
+            renderer.readAccumulation(pixels);
+            double meanError = Bench::meanError(reference, pixels);
+            if (mode.checked && !(std::abs(meanError) <= MAX_MEAN_ERROR))
+                ok = false;
+
+            std::printf("%-10s", mode.name);
+            std::printf(" %10.2f", frameMs);
+            for (double error : errors)
+                std::printf(" %11.2f", error * 100.0);
+            std::printf(" %14.2f\n", meanError * 100.0);
+        }
+    }
+
+    std::printf("\n%s\n", ok ? "Unbiased modes match the reference's mean" : "BIAS in a mode that should be unbiased");
+    destroyHeadlessContext(context);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
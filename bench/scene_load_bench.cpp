@@ -0,0 +1,89 @@
+// Compares JSON and binary (.rtscene) scene load times.
+// Usage: scene_load_bench [scene.json | sphere count]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "json.hpp"
+
+#include "scene/scene.hpp"
+#include "scene/scene_binary.hpp"
+#include "scene/scene_loader.hpp"
+
+using json = nlohmann::json;
+
+static std::string writeGeneratedScene(size_t sphereCount) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    json j;
+    j["name"] = "Generated " + std::to_string(sphereCount) + " spheres";
+    j["spheres"] = json::array();
+    for (size_t i = 0; i < sphereCount; ++i) {
+        j["spheres"].push_back({
+            { "position", { position(rng), position(rng), position(rng) } },
+            { "radius", 0.1f + unit(rng) },
+            { "material", {
+                { "colour", { unit(rng), unit(rng), unit(rng) } },
+                { "emissionColour", { 0.0f, 0.0f, 0.0f } },
+                { "emissionStrength", 0.0f },
+                { "specularColour", { 1.0f, 1.0f, 1.0f } },
+                { "smoothness", unit(rng) },
+                { "specularProbability", unit(rng) },
+                { "flag", 0 }
+            } }
+        });
+    }
+
+    std::string path = "scene_load_bench.json";
+    std::ofstream(path) << j.dump();
+    return path;
+}
+
+template <typename F>
+static double timeBest(int iterations, F&& function) {
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!function())
+            return -1.0;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    std::string jsonPath;
+    if (argc > 1 && std::string(argv[1]).find(".json") != std::string::npos)
+        jsonPath = argv[1];
+    else
+        jsonPath = writeGeneratedScene(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000);
+
+    Scene scene;
+    if (!SceneLoader::loadScene(jsonPath, scene))
+        return EXIT_FAILURE;
+
+    std::string binaryPath = "scene_load_bench" + std::string(SceneBinary::EXTENSION);
+    if (!SceneBinary::saveScene(binaryPath, scene))
+        return EXIT_FAILURE;
+
+    const int iterations = 5;
+    double jsonMs = timeBest(iterations, [&] { Scene s; return SceneLoader::loadScene(jsonPath, s); });
+    double binaryMs = timeBest(iterations, [&] { Scene s; return SceneBinary::loadScene(binaryPath, s); });
+
+    std::cout << std::endl << "Primitives: " << scene.spheres.size() << " spheres, " << scene.planes.size()
+        << " planes, " << scene.quads.size() << " quads" << std::endl;
+    std::cout << "JSON load:   " << jsonMs << " ms (best of " << iterations << ")" << std::endl;
+    std::cout << "Binary load: " << binaryMs << " ms (best of " << iterations << ")" << std::endl;
+    if (binaryMs > 0.0)
+        std::cout << "Speedup:     " << jsonMs / binaryMs << "x" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+// Compares skybox storage formats against the RGB32F reference: GPU memory,
+// load time, sampling cost while path tracing, and quality of the texture and the render.
+// Usage: skybox_format_bench <skybox.hdr> [scene.json] [frames]
+// Run from the repository root so shaders/ is found.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "skybox/skybox.hpp"
+#include "utils/gl_context.hpp"
+
+static const uint32_t WIDTH = 640;
+static const uint32_t HEIGHT = 360;
+
+struct Error {
+    double meanRelative = 0.0;
+    double maxRelative = 0.0;
+};
+
+// Relative error per component, with a floor so near-black values don't dominate
+static Error compare(const std::vector<float>& reference, const std::vector<float>& test, int stride, int components) {
+    Error error;
+    size_t count = 0;
+    for (size_t i = 0; i + components <= reference.size() && i + components <= test.size(); i += stride) {
+        for (int c = 0; c < components; ++c) {
+            double ref = reference[i + c];
+            double relative = std::abs(test[i + c] - ref) / std::max(std::abs(ref), 1e-2);
+            error.meanRelative += relative;
+            error.maxRelative = std::max(error.maxRelative, relative);
+            count++;
+        }
+    }
+    if (count > 0)
+        error.meanRelative /= static_cast<double>(count);
+    return error;
+}
+
+static std::vector<float> readTexture(const Skybox& skybox) {
+    std::vector<float> pixels(static_cast<size_t>(skybox.getWidth()) * skybox.getHeight() * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, skybox.getTextureID());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    return pixels;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: skybox_format_bench <skybox.hdr> [scene.json] [frames]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string skyboxPath = argv[1];
+    std::string scenePath = argc > 2 ? argv[2] : "scenes/default_scene.json";
+    int frames = argc > 3 ? std::atoi(argv[3]) : 32;
+
+    GLFWwindow* context = createHeadlessContext(WIDTH, HEIGHT);
+    if (!context)
+        return EXIT_FAILURE;
+
+    Scene scene;
+    if (!SceneLoader::loadScene(scenePath, scene))
+        return EXIT_FAILURE;
+    scene.skyboxPath = skyboxPath;
+
+    // Time the cold BC6H encode rather than a stale cache
+    std::filesystem::remove(skyboxPath + ".bc6h");
+
+    const SkyboxFormat formats[] = { SkyboxFormat::RGB32F, SkyboxFormat::RGB16F, SkyboxFormat::RGB9_E5, SkyboxFormat::BC6H };
+
+    std::vector<float> referenceTexture;
+    std::vector<float> referenceRender;
+
+    std::printf("\n%-8s %10s %10s %12s %12s %16s %16s\n", "Format", "Memory MB", "Load ms", "Frame ms", "Tex err %", "Tex max err %", "Render err %");
+
+    {
+        Renderer renderer(WIDTH, HEIGHT);
+        renderer.onResize(WIDTH, HEIGHT);
+
+        for (SkyboxFormat format : formats) {
+            Skybox skybox;
+            auto loadStart = std::chrono::steady_clock::now();
+            if (!skybox.load(skyboxPath, format))
+                return EXIT_FAILURE;
+            glFinish();
+            double loadMs = elapsedMs(loadStart);
+
+            double cachedLoadMs = -1.0;
+            if (format == SkyboxFormat::BC6H) {
+                Skybox cached;
+                auto cachedStart = std::chrono::steady_clock::now();
+                if (cached.load(skyboxPath, format)) {
+                    glFinish();
+                    cachedLoadMs = elapsedMs(cachedStart);
+                }
+            }
+
+            std::vector<float> texture = readTexture(skybox);
+            if (format == SkyboxFormat::RGB32F)
+                referenceTexture = texture;
+            Error textureError = compare(referenceTexture, texture, 3, 3);
+
+            // Same seeds for every format, so render differences come from the texture alone
+            renderer.getResources().setSkyboxFormat(format);
+            renderer.loadScene(scene);
+            renderer.render(scene.camera);
+            glFinish();
+
+            auto renderStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i)
+                renderer.render(scene.camera);
+            glFinish();
+            double frameMs = elapsedMs(renderStart) / std::max(frames, 1);
+
+            std::vector<float> render;
+            renderer.readAccumulation(render);
+            if (format == SkyboxFormat::RGB32F)
+                referenceRender = render;
+            Error renderError = compare(referenceRender, render, 4, 3);
+
+            std::printf("%-8s %10.1f %10.1f %12.2f %12.3f %16.3f %16.3f\n", getSkyboxFormatName(format),
+                skybox.getMemoryUsage() / (1024.0 * 1024.0), loadMs, frameMs,
+                textureError.meanRelative * 100.0, textureError.maxRelative * 100.0, renderError.meanRelative * 100.0);
+            if (cachedLoadMs >= 0.0)
+                std::printf("%-8s %10s %10.1f   (from .bc6h cache)\n", "", "", cachedLoadMs);
+        }
+    }
+
+    destroyHeadlessContext(context);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/job_system.hpp"
+
+struct Camera;
+struct GLFWwindow;
+struct Scene;
+struct SceneChanges;
+class Renderer;
+
+struct RayTracerSettings {
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	std::string shaderDirectory = "shaders";
+	uint32_t samplesPerFrame = 16;  // Samples per dispatch, keeps each GPU submission short
+
+	// Without a context of its own the tracer renders into the caller's current GL 4.4 context.
+	// GL functions are then loaded through getProcAddress, e.g. glfwGetProcAddress
+	bool createContext = true;
+	void* (*getProcAddress)(const char* name) = nullptr;
+};
+
+// In-process entry point to the path tracer, used by tools and by the GUI on its render thread.
+// One instance keeps its GL context, scene and accumulation alive across jobs:
+//
+//     auto tracer = RayTracer::create();
+//     tracer->loadScene("scenes/cornell_box_1.json");
+//     tracer->render(256);
+//     std::vector<float> rgb;
+//     tracer->readPixels(rgb);
+class RayTracer {
+private:
+	GLFWwindow* m_context = nullptr;  // Owned hidden window, null when using the caller's context
+	std::unique_ptr<Scene> m_scene;
+	std::unique_ptr<Renderer> m_renderer;
+	uint32_t m_samplesPerFrame = 16;
+
+	RayTracer() = default;
+
+	void makeCurrent();
+
+public:
+	// Null if there is no usable GL 4.4 context or the shaders fail to build
+	static std::unique_ptr<RayTracer> create(const RayTracerSettings& settings = RayTracerSettings());
+	~RayTracer();
+
+	RayTracer(const RayTracer&) = delete;
+	RayTracer& operator=(const RayTracer&) = delete;
+
+	// JSON or binary scene. Restarts accumulation
+	bool loadScene(const std::string& filepath);
+	void setScene(const Scene& scene);
+
+	// Replaces the scene but uploads only what differs from the current one, and keeps the
+	// accumulation if nothing visible changed. For edits of the same scene, e.g. after a file reload
+	void updateScene(const Scene& scene);
+
+	// For callers that track their own edits: `changes` must name everything that differs from the current scene.
+	// The scene must be compiled already, as loaded scenes are, so primitive indices stay put
+	void updateScene(const Scene& scene, const SceneChanges& changes);
+
+	// Edits the current scene in place, then uploads what `changes` names. Cheaper than a copy for small edits
+	void editScene(const std::function<void(Scene&)>& edit, const SceneChanges& changes);
+	const Scene& getScene() const;
+
+	void setCamera(const Camera& camera);
+	void setResolution(uint32_t width, uint32_t height);
+
+	// Adds samples per pixel to the current accumulation and returns the total
+	uint64_t render(uint32_t samples);
+	uint64_t getSampleCount() const;
+	uint32_t getWidth() const;
+	uint32_t getHeight() const;
+
+	// Linear RGB, 3 floats per pixel, top row first
+	void readPixels(std::vector<float>& rgb);
+
+	// ".hdr" keeps linear floats, anything else is written as PNG with the scene's gamma
+	bool saveImage(const std::string& filepath);
+
+	// As saveImage, but only the readback runs here. Encoding and writing happen on the job system
+	Task<bool> saveImageAsync(const std::string& filepath);
+
+	// Saves the accumulation so a later process can continue it, see renderer/checkpoint.hpp
+	bool saveCheckpoint(const std::string& filepath);
+
+	// Continues a checkpoint taken with the same scene and resolution, including its camera.
+	// False, leaving the accumulation alone, if the checkpoint doesn't match
+	bool resumeCheckpoint(const std::string& filepath);
+
+	// Identifies the scene and settings that checkpoints must match
+	uint64_t getSettingsHash() const;
+
+	// Direct access for features the API doesn't cover
+	Renderer& getRenderer();
+};
\ No newline at end of file
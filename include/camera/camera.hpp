@@ -14,4 +14,7 @@ struct Camera {
 	Camera();
 
 	void updateOrientation();
+
+	// Primary ray direction through a point of the image, both coordinates in [-1, 1] with y up, like the shader's
+	glm::vec3 getRayDirection(float x, float y, float aspectRatio) const;
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+
+struct CameraKeyframe {
+	float time;  // Seconds
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+enum class CameraInterpolation {
+	Linear = 0,
+	Smooth = 1  // Catmull-Rom through the keyframes
+};
+
+// Keyframed camera path. Yaw is interpolated as given, so keyframes should use continuous
+// angles (e.g. 350 -> 370 rather than 350 -> 10) to turn the short way.
+struct CameraTrack {
+	std::vector<CameraKeyframe> keyframes;  // Sorted by time
+	CameraInterpolation interpolation = CameraInterpolation::Smooth;
+	float fps = 30.0f;
+	float duration = 0.0f;  // 0 ends at the last keyframe
+
+	bool isEmpty() const;
+	float getDuration() const;
+	uint32_t getFrameCount() const;
+
+	Camera evaluate(float time) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/socket.hpp"
+
+namespace Distributed {
+	struct CoordinatorSettings {
+		uint16_t port;
+		std::string bindAddress;  // Loopback by default, workers on other machines need e.g. "0.0.0.0"
+		std::string scenePath;
+		std::string outputPath;
+		uint32_t width;
+		uint32_t height;
+		uint32_t samplesPerPixel;  // Per worker frame, 0 uses the scene value
+		uint64_t targetSamples;    // Total merged samples per pixel
+		uint32_t reportInterval;   // Worker frames between uploads
+	};
+
+	// Hands out disjoint RNG streams to workers and merges their accumulation buffers.
+	// Workers may connect or drop out at any time, samples they already uploaded are kept.
+	class Coordinator {
+	public:
+		explicit Coordinator(const CoordinatorSettings& settings);
+		~Coordinator();
+
+		bool run();
+
+	private:
+		struct WorkerState {
+			uint32_t id = 0;
+			Socket socket;
+			std::thread thread;
+			bool connected = true;
+
+			std::vector<float> buffer;  // Latest mean RGBA32F upload
+			uint64_t sampleCount = 0;
+		};
+
+		CoordinatorSettings m_settings;
+		float m_gamma = 2.2f;
+
+		std::mutex m_mutex;
+		std::vector<std::unique_ptr<WorkerState>> m_workers;
+		uint32_t m_nextWorkerId = 0;
+		std::atomic<bool> m_finished{ false };
+
+		void acceptWorker(Socket socket);
+		void serviceWorker(WorkerState* worker);
+
+		uint64_t getTotalSamples();
+		uint64_t mergeBuffers(std::vector<float>& merged);
+		void stopWorkers();
+	};
+
+	int runCoordinator(const CoordinatorSettings& settings);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "net/socket.hpp"
+
+namespace Distributed {
+	const uint16_t DEFAULT_PORT = 47800;
+	const uint32_t MESSAGE_MAGIC = 0x52545244;  // "RTRD"
+
+	// Each worker renders frames [offset + 1, offset + FRAME_OFFSET_STRIDE), keeping RNG streams disjoint
+	const uint32_t FRAME_OFFSET_STRIDE = 1u << 20;
+	const uint32_t MAX_WORKERS = UINT32_MAX / FRAME_OFFSET_STRIDE;  // Frame offsets are 32 bit
+
+	// Largest payload of a message other than a result: a job and its scene path
+	const uint64_t MAX_CONTROL_PAYLOAD = 64 * 1024;
+
+	enum MessageType : uint32_t {
+		MSG_HELLO = 1,   // Worker -> coordinator, request a job
+		MSG_JOB = 2,     // Coordinator -> worker, JobMessage + scene path
+		MSG_RESULT = 3,  // Worker -> coordinator, ResultMessage + RGBA32F mean buffer
+		MSG_STOP = 4     // Coordinator -> worker, render finished
+	};
+
+	struct MessageHeader {
+		uint32_t magic;
+		uint32_t type;
+		uint64_t payloadSize;
+	};
+
+	struct JobMessage {
+		uint32_t workerId;
+		uint32_t frameOffset;
+		uint32_t width;
+		uint32_t height;
+		uint32_t samplesPerPixel;
+		uint32_t reportInterval;  // Frames between result uploads
+	};
+
+	struct ResultMessage {
+		uint32_t width;
+		uint32_t height;
+		uint64_t sampleCount;  // Samples per pixel represented by the buffer
+	};
+
+	bool sendMessage(Socket& socket, MessageType type, const void* payload = nullptr, uint64_t payloadSize = 0);
+	bool sendMessage(Socket& socket, MessageType type, const void* head, uint64_t headSize, const void* body, uint64_t bodySize);
+	// Fails on a payload larger than maxPayloadSize without reading it, the connection should be dropped
+	bool receiveMessage(Socket& socket, MessageHeader& header, std::vector<char>& payload, uint64_t maxPayloadSize);
+}
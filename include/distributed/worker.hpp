@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Distributed {
+	struct WorkerSettings {
+		std::string host;
+		uint16_t port;
+	};
+
+	// Connects to a coordinator, renders its job and uploads the accumulation until told to stop
+	int runWorker(const WorkerSettings& settings);
+}
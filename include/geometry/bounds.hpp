@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box, empty until something is added
+struct Bounds {
+	glm::vec3 min = glm::vec3(FLT_MAX);
+	glm::vec3 max = glm::vec3(-FLT_MAX);
+
+	bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+	void expand(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	void expand(const Bounds& other) {
+		min = glm::min(min, other.min);
+		max = glm::max(max, other.max);
+	}
+
+	glm::vec3 getCentre() const { return (min + max) * 0.5f; }
+	glm::vec3 getExtent() const { return max - min; }
+};
\ No newline at end of file
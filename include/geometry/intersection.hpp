@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "renderer/types.hpp"
+
+// CPU ray-primitive intersection matching the shader's RaySphereIntersect, RayPlaneIntersect, RayQuadIntersect,
+// RayBoxIntersect, RayDiscIntersect and RayCylinderIntersect, for tools such as picking, validation and baking.
+namespace Intersection {
+	struct Ray {
+		glm::vec3 origin;
+		glm::vec3 dir;
+	};
+
+	enum class HitType {
+		None,
+		Sphere,
+		Plane,
+		Quad,
+		Box,
+		Disc,
+		Cylinder
+	};
+
+	struct Hit {
+		HitType type = HitType::None;
+		int index = -1;          // Into the primitive array of that type
+		float distance = 1e20f;  // Along ray.dir, in units of its length
+		int face = -1;           // BoxFace of box hits
+	};
+
+	// One primitive at a time on the scene's layout, compiled so derived fields such as radiusSquared are set.
+	// Only hits in front of the origin count
+	bool intersectSphere(const Ray& ray, const Sphere& sphere, float& distance);
+	bool intersectPlane(const Ray& ray, const Plane& plane, float& distance);
+	bool intersectQuad(const Ray& ray, const Quad& quad, float& distance);
+	bool intersectBox(const Ray& ray, const Box& box, float& distance, int& face);  // face is a BoxFace
+	bool intersectDisc(const Ray& ray, const Disc& disc, float& distance);
+	bool intersectCylinder(const Ray& ray, const Cylinder& cylinder, float& distance);
+
+	// Structure-of-arrays copies of the geometry, so 4 or 8 primitives load with one instruction per field
+	struct SphereSoA {
+		std::vector<float> x, y, z;
+		std::vector<float> radiusSquared;
+		size_t size() const { return radiusSquared.size(); }
+	};
+
+	struct PlaneSoA {
+		std::vector<float> x, y, z;
+		std::vector<float> nx, ny, nz;
+		size_t size() const { return nx.size(); }
+	};
+
+	struct QuadSoA {
+		std::vector<float> x, y, z;
+		std::vector<float> nx, ny, nz;
+		std::vector<float> rx, ry, rz;
+		std::vector<float> ux, uy, uz;
+		std::vector<float> halfWidth, halfHeight;
+		size_t size() const { return nx.size(); }
+	};
+
+	struct PrimitiveSoA {
+		SphereSoA spheres;
+		PlaneSoA planes;
+		QuadSoA quads;
+	};
+
+	PrimitiveSoA buildPrimitiveSoA(const std::vector<Sphere>& spheres, const std::vector<Plane>& planes, const std::vector<Quad>& quads);
+
+	enum class SimdLevel {
+		Scalar,
+		SSE,   // 4 primitives per step
+		AVX2   // 8 primitives per step
+	};
+
+	const char* getSimdLevelName(SimdLevel level);
+	SimdLevel getSupportedSimdLevel();  // Best level this CPU runs
+	SimdLevel getSimdLevel();
+	void setSimdLevel(SimdLevel level);  // Clamped to the supported level, mainly for comparisons
+
+	// Closest hit over every primitive, ties go to the earlier primitive like in the shader
+	Hit intersectClosest(const Ray& ray, const PrimitiveSoA& primitives);
+	Hit intersectClosest(const Ray& ray, const SphereSoA& spheres);
+	Hit intersectClosest(const Ray& ray, const PlaneSoA& planes);
+	Hit intersectClosest(const Ray& ray, const QuadSoA& quads);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+using SocketHandle = SOCKET;
+#else
+using SocketHandle = int;
+#endif
+
+// Minimal blocking TCP socket, used for local IPC between renderer processes
+class Socket {
+public:
+	Socket();
+	~Socket();
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+	Socket(Socket&& other) noexcept;
+	Socket& operator=(Socket&& other) noexcept;
+
+	// Loopback unless another address is given, "0.0.0.0" accepts connections from other machines
+	static Socket listen(uint16_t port, const std::string& address = "127.0.0.1");
+	static Socket connect(const std::string& host, uint16_t port);
+
+	Socket accept();
+
+	bool isValid() const;
+	void close();
+	void shutdown();  // Unblocks any thread waiting on the socket
+
+	// Returns true if data (or a pending connection) is ready within the timeout
+	bool waitReadable(int timeoutMs) const;
+
+	bool sendAll(const void* data, size_t size);
+	bool recvAll(void* data, size_t size);
+	int recvSome(void* data, size_t size);  // Bytes received, 0 on close, negative on error
+
+private:
+	explicit Socket(SocketHandle handle);
+
+	SocketHandle m_handle;
+};
+
+namespace Net {
+	bool initialise();
+	void shutdown();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "skybox/skybox.hpp"
+#include "utils/job_system.hpp"
+
+struct Camera;
+struct Scene;
+struct RestirSettings;
+struct GuidingSettings;
+struct RadianceCacheSettings;
+class Renderer;
+
+// Snapshot of a progressive render, enough to continue the same sample stream after a restart
+struct RenderCheckpoint {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t frame = 1;         // Next frame to render, seeds the RNG
+	uint32_t frameOffset = 0;
+	uint64_t sampleCount = 0;   // Per pixel, weights the accumulation
+	uint64_t settingsHash = 0;  // See Checkpoint::hashSettings
+
+	// Exact camera vectors, so resuming doesn't look like a camera move
+	glm::vec3 cameraPosition = glm::vec3(0.0f);
+	float cameraYaw = 0.0f;
+	float cameraPitch = 0.0f;
+	glm::vec3 cameraForward = glm::vec3(0.0f);
+	glm::vec3 cameraRight = glm::vec3(0.0f);
+	glm::vec3 cameraUp = glm::vec3(0.0f);
+
+	std::vector<float> accumulation;  // RGBA per pixel, bottom row first like GL
+};
+
+struct CheckpointSettings {
+	std::string path;
+	float intervalSeconds = 300.0f;  // 0 only writes when asked
+};
+
+// Checkpoint files (".rtck"): a fixed header followed by the raw accumulation
+namespace Checkpoint {
+	const uint32_t MAGIC = 0x4B435452;  // "RTCK"
+	const uint32_t VERSION = 1;
+	const char* const EXTENSION = ".rtck";
+
+	// Everything that changes the converged image: geometry, materials, environment, tracing settings including the
+	// ReSTIR, guiding and radiance cache ones, and resolution. The camera is stored in the checkpoint instead
+	uint64_t hashSettings(const Scene& scene, SkyboxFormat skyboxFormat, const RestirSettings& restir,
+		const GuidingSettings& guiding, const RadianceCacheSettings& radianceCache, uint32_t width, uint32_t height);
+
+	Camera getCamera(const RenderCheckpoint& checkpoint);
+
+	// Writes a temporary file and renames it over the previous checkpoint, so a crash mid-write keeps the old one
+	bool save(const std::string& filepath, const RenderCheckpoint& checkpoint);
+	// Fails unless the checkpoint is width x height and the file holds all of its accumulation
+	bool load(const std::string& filepath, RenderCheckpoint& checkpoint, uint32_t width, uint32_t height);
+}
+
+// Periodically captures a renderer and writes the checkpoint on the job system.
+// Only the readback happens on the calling thread, and at most one write is in flight
+class CheckpointWriter {
+public:
+	explicit CheckpointWriter(const CheckpointSettings& settings);
+	~CheckpointWriter();  // Waits for the write in flight
+
+	// Call after rendering. Writes when the interval has passed since the last checkpoint
+	bool update(Renderer& renderer, const Camera& camera, uint64_t settingsHash);
+
+	// Writes now unless a write is still in flight
+	bool write(Renderer& renderer, const Camera& camera, uint64_t settingsHash);
+
+	void flush();  // Waits for the write in flight
+	const CheckpointSettings& getSettings() const;
+
+private:
+	CheckpointSettings m_settings;
+	Task<bool> m_pending;
+	std::chrono::steady_clock::time_point m_lastWrite;  // Or construction
+};
\ No newline at end of file
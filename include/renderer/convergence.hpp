@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+class Renderer;
+
+// When progressive rendering should stop. A value of 0 disables that condition.
+struct StopConditions {
+	uint64_t targetSamples = 0;  // Samples per pixel
+	float targetNoise = 0.0f;    // Mean relative standard error, e.g. 0.01 for 1%
+	float timeLimit = 0.0f;      // Seconds of tracing
+};
+
+enum class StopReason {
+	None,
+	Samples,
+	Noise,
+	TimeLimit
+};
+
+const char* getStopReasonName(StopReason reason);
+
+// Tracks a renderer's accumulation against StopConditions. Accumulation resets
+// (camera moves, setting changes) are picked up from the renderer's frame counter.
+class ConvergenceMonitor {
+public:
+	void setConditions(const StopConditions& conditions);
+	const StopConditions& getConditions() const;
+
+	// Call after each rendered frame with the time it took. Returns true once a condition is met
+	bool update(Renderer& renderer, double frameSeconds);
+
+	bool isConverged() const;
+	StopReason getReason() const;
+	float getNoise() const;     // Last estimate, negative until measured
+	double getElapsed() const;  // Seconds of tracing since the last reset
+
+private:
+	StopConditions m_conditions;
+	StopReason m_reason = StopReason::None;
+	uint32_t m_lastFrame = 0;
+	double m_elapsed = 0.0;
+	double m_lastNoiseCheck = 0.0;
+	float m_noise = -1.0f;
+
+	static constexpr double NOISE_CHECK_INTERVAL = 0.5;  // Seconds, each estimate reads the accumulation back
+	static constexpr uint64_t MIN_NOISE_SAMPLES = 32;    // Fewer samples give unreliable variance estimates
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "utils/gl_resource.hpp"
+
+class Renderer;
+
+// Hands finished frames from the render thread to the UI thread without either side waiting.
+// Three textures rotate: the UI shows one, the render thread writes one and the third holds the
+// newest finished frame. Fences order the GPU work between the two threads' contexts.
+class DisplayBuffer {
+public:
+	struct Frame {
+		GLuint texture = 0;                 // 0 until the first frame
+		glm::vec2 scale = glm::vec2(1.0f);  // Part of the texture covered by the image
+		uint64_t sequence = 0;              // Increases with every published frame
+	};
+
+	DisplayBuffer() = default;
+	~DisplayBuffer();
+
+	DisplayBuffer(const DisplayBuffer&) = delete;
+	DisplayBuffer& operator=(const DisplayBuffer&) = delete;
+
+	// Render thread: copies the renderer's display texture and makes it the newest frame
+	void publish(const Renderer& renderer);
+
+	// Render thread: releases the textures, waiting for the UI to finish with them first
+	void reset();
+
+	// UI thread: newest published frame. Stays valid until the next acquire
+	const Frame& acquire();
+
+	// UI thread: call after drawing the acquired frame, so the render thread doesn't overwrite it too early
+	void endRead();
+
+private:
+	struct Slot {
+		GLTexture texture;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		Frame frame;
+		GLsync written = nullptr;  // Copy into the texture finished, waited on by the UI
+		GLsync read = nullptr;     // UI finished drawing it, waited on by the render thread
+	};
+
+	static const uint8_t FRESH = 4;  // Set on m_ready when it holds a frame the UI hasn't taken
+
+	Slot m_slots[3];
+	std::atomic<uint8_t> m_ready{ 1 };
+	uint8_t m_back = 2;   // Render thread
+	uint8_t m_front = 0;  // UI thread
+	uint64_t m_sequence = 0;
+};
\ No newline at end of file
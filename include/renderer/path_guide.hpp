@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Host side of the SD-tree from "Practical Path Guiding" (Mueller et al. 2017): a binary tree over the scene bounds,
+// splitting x, y and z in turn, with a quadtree over the sphere of directions in every leaf. The GPU adds radiance
+// to a copy of the tree, then refine() reads the sums back and lays out the tree for the next iteration, finer where
+// light arrived.
+//
+// Layout, in uints: a header (offsets of the quadtree nodes, their sums and the sample counts, then the number of
+// spatial nodes), two per spatial node (first of its two children or 0 for a leaf, root of its quadtree), four per
+// quadtree node (child per quadrant or 0 for a leaf quadrant), four float sums per quadtree node, and one sample
+// count per spatial node. Indices are relative to the start of the tree. See the PATH GUIDING section of fragment.glsl
+class PathGuide {
+public:
+	void reset();
+
+	// Tree for the GPU to train, sums and counts zeroed
+	std::vector<uint32_t> getTrainingTree() const;
+
+	// Rebuilds from a trained copy of getTrainingTree(). Spatial leaves with more than threshold * sqrt(2^iteration)
+	// samples split, so the tree grows with the doubling iterations, and quadrants holding more than 1% of their
+	// quadtree's radiance subdivide
+	void refine(const std::vector<uint32_t>& trained, uint32_t iteration, uint32_t threshold);
+
+	size_t getSpatialNodeCount() const;
+	size_t getQuadNodeCount() const;
+
+	static const uint32_t HEADER_SIZE = 4;
+
+private:
+	struct SpatialNode {
+		uint32_t firstChild = 0;  // Children are adjacent, 0 for leaves
+		uint32_t quadRoot = 0;
+	};
+
+	struct QuadNode {
+		uint32_t children[4] = {};  // 0 for leaf quadrants, no node points back at the first root
+	};
+
+	std::vector<SpatialNode> m_spatial;
+	std::vector<QuadNode> m_quads;
+
+	static constexpr float SUBDIVIDE_FRACTION = 0.01f;
+	static const uint32_t MAX_QUAD_DEPTH = 20;     // Must match GUIDE_MAX_DEPTH in fragment.glsl
+	static const uint32_t MAX_SPATIAL_DEPTH = 48;  // 16 splits per axis
+
+	static const uint32_t NO_NODE = 0xFFFFFFFF;
+
+	void refineSpatial(const std::vector<uint32_t>& trained, uint32_t node, uint32_t target, uint32_t depth, float limit);
+	void splitSpatial(uint32_t node, uint32_t depth, float samples, float limit);
+
+	// New quadtree from a trained one (NO_NODE below its leaves, whose radiance is spread evenly)
+	uint32_t buildQuadtree(const std::vector<uint32_t>& trained, uint32_t node, const float sums[4], float total,
+		uint32_t depth);
+	uint32_t copyQuadtree(uint32_t node);
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "utils/spsc_queue.hpp"
+
+struct GLFWwindow;
+
+// Runs GL work on its own thread, with a hidden context that shares objects with a window, so slow
+// path tracing frames never hold up the window's event loop. The window's thread hands it work as
+// commands through a lock-free queue. They run in order between frames, with the context current.
+class RenderThread {
+public:
+	using Command = std::function<void()>;
+
+	static const size_t QUEUE_CAPACITY = 1024;
+
+	RenderThread();
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// Call on the thread that owns `window`. `frame` runs repeatedly on the render thread and
+	// returns false when there is nothing to render, the thread then sleeps until the next command
+	bool start(GLFWwindow* window, std::function<bool()> frame);
+
+	// Runs the commands already posted, then joins. Post a command that releases GL objects first
+	void stop();
+
+	// From the window's thread only. Waits for space if the render thread has fallen a full queue behind
+	void post(Command command);
+
+	bool isRunning() const;
+	bool isIdle() const;  // The last frame had nothing to render
+	bool isRenderThread() const;
+
+private:
+	GLFWwindow* m_context = nullptr;
+	std::thread m_thread;
+	std::function<bool()> m_frame;
+
+	SpscQueue<Command> m_commands;
+	std::atomic<bool> m_stopping{ false };
+	std::atomic<bool> m_idle{ false };
+
+	// Only used to sleep while idle, posting takes the lock only when the thread is asleep
+	std::atomic<bool> m_sleeping{ false };
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wake;
+
+	void run();
+	void runCommands();
+	void sleep();
+	void wake();
+};
\ No newline at end of file
@@ -1,112 +1,232 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
-#include "skybox/skybox.hpp"
-#include "types.hpp"
+#include "renderer/path_guide.hpp"
+#include "renderer/scene_resources.hpp"
+#include "utils/gl_resource.hpp"
+#include "utils/job_system.hpp"
 
 struct Camera;
+struct RenderCheckpoint;
 struct Scene;
-
+struct SceneChanges;
+
+// Totals from the instrumented shader since the last accumulation reset
+struct RayStats {
+	uint64_t rays = 0;
+	uint64_t bounces = 0;
+	uint64_t primitiveTests = 0;
+	uint64_t missTerminations = 0;
+	uint64_t rouletteTerminations = 0;
+	uint64_t maxBounceTerminations = 0;
+};
+
+// Reservoir-based spatiotemporal resampling (ReSTIR) of direct light from emissive spheres, quads, discs and the sun
+struct RestirSettings {
+	bool enabled = false;
+	bool unbiased = false;  // Weights reuse by which surfaces could have produced each sample, quadratic in spatialSamples
+	uint32_t candidates = 8;  // New light samples per pixel and frame
+	uint32_t spatialSamples = 3;  // Neighbouring reservoirs merged per pixel
+	float spatialRadius = 20.0f;  // In pixels
+	uint32_t maxHistory = 20;  // Caps a reservoir's weight at this many frames of candidates, so it keeps adapting
+};
+
+// Online path guiding of diffuse bounces, after "Practical Path Guiding" (Mueller et al. 2017). An SD-tree over the
+// scene bounds learns incident radiance from the paths themselves, see PathGuide. Training runs in iterations that
+// double in length, each one sampling with the previous iteration's tree
+struct GuidingSettings {
+	bool enabled = false;
+	float mixing = 0.5f;  // Fraction of diffuse bounces that follow the guide, the rest sample the cosine lobe
+	uint32_t trainingIterations = 8;  // Frames of training are 2^iterations - 1, the tree is fixed after that
+	uint32_t spatialThreshold = 12000;  // Samples a region learns from before it splits, the paper's c
+};
+
+// Preview integrator: a world-space hash grid caches the light leaving surfaces, and paths end in it after a bounce or
+// two. A fraction of samples trace full paths and keep it up to date. The cache survives camera moves, so indirect
+// light is there as soon as the view changes. Biased, the cells blur light over their size
+struct RadianceCacheSettings {
+	bool enabled = false;
+	float cellSize = 0.08f;  // World units, fixed so the grid doesn't move with the camera
+	uint32_t terminationBounce = 1;  // First hit that may end in the cache, 1 being the one after the first bounce
+	float updateFraction = 0.1f;  // Samples that trace full paths and train the cache
+};
+
+// One view of a scene: a camera's accumulation target, sample state and instrumentation.
+// Scene data lives in SceneResources, which several views can share.
 class Renderer {
 private:
-	GLuint m_fbo = 0;
+	std::shared_ptr<SceneResources> m_resources;
+	uint64_t m_resourceRevision = 0;  // Revision the current accumulation was started with
 
-	// Textures
-	GLuint m_accumulatedImage = 0;
-	GLuint m_displayTexture = 0;
+	GLFramebuffer m_fbo;
 
-	// Shader and Quad
-	GLuint m_shaderProgram = 0;
-	GLuint m_VAO = 0;
-	GLuint m_VBO = 0;
+	// Textures
+	GLTexture m_accumulatedImage;
+	GLTexture m_displayTexture;
 
 	uint32_t m_width;
 	uint32_t m_height;
 
-	float m_gamma = 2.2f;
-	uint32_t m_maxBounces = 2;
+	// Allocated texture size, at least the render size. Shrinking and small growth reuse the textures
+	uint32_t m_textureWidth = 0;
+	uint32_t m_textureHeight = 0;
+
 	uint32_t m_samplesPerPixel = 1;
 	uint32_t m_frame = 1;
-
-	// Uniform locations for shader program
-	GLint m_uLocResolution;
-	GLint m_uLocCameraPos;
-	GLint m_uLocCameraForward;
-	GLint m_uLocCameraRight;
-	GLint m_uLocCameraUp;
-	GLint m_uLocGamma;
-	GLint m_uLocMaxBounces;
-	GLint m_uLocSamplesPerPixel;
-	GLint m_uLocFrame;
-	GLint m_uLocSkyboxTexture;
-	GLint m_uLocHasSkybox;
-	GLint m_uLocSkyboxExposure;
-	GLint m_uLocSunDirection;
-	GLint m_uLocSunColour;
-	GLint m_uLocSunIntensity;
-	GLint m_uLocSunFocus;
-
-	Skybox m_skybox;
-	float m_skyboxExposure = 1.0f;
-
-	glm::vec3 m_sunDirection;
-	glm::vec3 m_sunColour;
-	float m_sunIntensity;
-	float m_sunFocus;
-
-	std::vector<Sphere> m_spheres;
-	GLuint m_sphereSSBO = 0;
-	GLint m_uLocNumSpheres;
-
-	std::vector<Plane> m_planes;
-	GLuint m_planeSSBO = 0;
-	GLint m_uLocNumPlanes;
-
-	std::vector<Quad> m_quads;
-	GLuint m_quadSSBO = 0;
-	GLint m_uLocNumQuads;
-
-	void setupShaders();
-	void setupQuad();
-
-	void setupSpheres();
-	void setupPlanes();
-	void setupQuads();
+	uint64_t m_sampleCount = 0;  // Per pixel since the last reset, frames may use different sample counts
+	uint32_t m_frameOffset = 0;  // Offsets the RNG stream without affecting accumulation weights
+
+	// Camera used for the current accumulation
+	bool m_hasLastCamera = false;
+	glm::vec3 m_lastCameraPosition;
+	glm::vec3 m_lastCameraForward;
+	glm::vec3 m_lastCameraRight;
+	glm::vec3 m_lastCameraUp;
+
+	// Instrumentation, renders with the RT_STATS shader variant while enabled
+	bool m_statsEnabled = false;
+	bool m_showHeatmap = false;
+	float m_heatmapScale = 64.0f;
+	GLBuffer m_statsSSBO;
+	GLTexture m_costImage;  // Primitive tests per sample, R32F
+	RayStats m_rayStats;
+
+	// Each frame's counters are copied into a ring of buffers and read once the copy's fence signals, so stats
+	// arrive a few frames late instead of stalling on the frame. While every copy is in flight counters keep adding up
+	static const int STATS_READBACK_COUNT = 3;
+	GLBuffer m_statsReadback[STATS_READBACK_COUNT];
+	GLsync m_statsFences[STATS_READBACK_COUNT] = {};
+	int m_statsHead = 0;     // Next buffer to copy into
+	int m_statsPending = 0;  // Copies not read yet
+	bool m_statsCarried = false;  // The counters hold frames no copy has taken yet
+
+	// Direct lighting reservoirs, a 2D array per frame: layer 0 holds the light sample, layer 1 the shading point it
+	// was chosen for. Frames alternate between the two, reading the previous frame's and writing their own
+	RestirSettings m_restir;
+	GLTexture m_reservoirs[2];
+	int m_reservoirIndex = 0;  // Written by the next frame
+	bool m_hasReservoirHistory = false;  // The other array holds samples of the current scene at this resolution
+
+	// Guiding SD-trees: the one trained by the last iteration, sampled, followed by the one being trained. When an
+	// iteration ends the trained tree is read back, refined and uploaded again with its successor
+	GuidingSettings m_guiding;
+	PathGuide m_pathGuide;
+	GLBuffer m_guideTrees;
+	uint32_t m_guideSamplingTree = 0;  // Offsets into m_guideTrees in uints
+	uint32_t m_guideTrainingTree = 0;
+	size_t m_guideTrainingSize = 0;
+	uint32_t m_guideIteration = 0;  // Finished training iterations, the sampled tree is valid once this is positive
+	uint32_t m_guideIterationFrames = 0;  // Frames into the current iteration
+	Bounds m_guideBounds;  // Scene bounds when training started, the tree stays put until it restarts
+
+	// Radiance cache hash grid, kept across camera moves and cleared when the scene changes
+	static const uint32_t CACHE_ENTRY_COUNT = 1u << 20;
+	static const uint32_t CACHE_ENTRY_SIZE = 10;  // uints, see fragment.glsl
+	static const uint32_t CACHE_MAX_SAMPLES = 256;  // Older light fades out beyond this many samples per entry
+	static const uint32_t CACHE_MAX_AGE = 256;  // Frames an entry is kept without updates
+	RadianceCacheSettings m_cache;
+	GLBuffer m_radianceCache;
+
+	// GPU frame timing, a ring of queries so reading results never stalls
+	static const int TIMER_QUERY_COUNT = 4;
+	GLQuery m_timerQueries[TIMER_QUERY_COUNT];
+	uint32_t m_timerSamplesPerPixel[TIMER_QUERY_COUNT] = {};
+	int m_timerHead = 0;     // Next query to issue
+	int m_timerPending = 0;  // Issued queries without a result yet
 
 	void createTexturesAndFBO(uint32_t width, uint32_t height);
+	void createStatsResources();
+	void createReservoirs();
+	void createGuideTrees();
+	void uploadGuideTrees(const std::vector<uint32_t>& sampling, const std::vector<uint32_t>& training);
+	void finishGuideIteration();
+	void resetGuiding();
+	void createRadianceCache();
+	void clearRadianceCache();
+	void resolveRadianceCache();
+	void copyRayStats();
+	void readRayStats(bool wait = false);
+	void dropRayStats();  // Forgets copies in flight and zeroes the counters
 
 	void resetFrame();
 
 	void cleanup();
 
 public:
-	Renderer(uint32_t width, uint32_t height);
+	// Creates its own SceneResources unless given one to share
+	Renderer(uint32_t width, uint32_t height, std::shared_ptr<SceneResources> resources = nullptr);
 	~Renderer();
 
-	void uploadSpheres(const std::vector<Sphere>& spheres);
-	void uploadPlanes(const std::vector<Plane>& planes);
-	void uploadQuads(const std::vector<Quad>& quads);
+	SceneResources& getResources();
+	const std::shared_ptr<SceneResources>& getSharedResources() const;
 
 	GLuint getDisplayTexture() const;
+	glm::vec2 getDisplayScale() const;  // Part of the display texture covered by the image
 	uint32_t getFrame() const;
+	uint64_t getSampleCount() const;
+	uint32_t getWidth() const;
+	uint32_t getHeight() const;
+	uint32_t getTextureWidth() const;  // Allocated size of the display texture, at least the image size
+	uint32_t getTextureHeight() const;
+	bool hasCameraChanged(const Camera& camera) const;
+	bool needsRestart(const Camera& camera) const;  // The next render will restart accumulation
+
+	struct GpuTiming {
+		float milliseconds;
+		uint32_t samplesPerPixel;  // Used by the timed frame
+	};
+	bool pollGpuTiming(GpuTiming& timing);  // True when a new measurement is available
+
+	// Mean relative standard error of the accumulated pixels. Reads the accumulation back, so call it sparingly.
+	// Negative until there are enough samples for an estimate
+	float estimateNoise();
 
-	void setGamma(float gamma);
-	void setMaxBounces(uint32_t bounces);
 	void setSamplesPerPixel(uint32_t samples);
-	void setSkybox(const std::string& filepath);
-	void setSkyboxExposure(float exposure);
-	void setSunDirection(glm::vec3 direction);
-	void setSunColour(glm::vec3 colour);
-	void setSunIntensity(float intensity);
-	void setSunFocus(float focus);
+	void setFrameOffset(uint32_t offset);
+
+	void setStatsEnabled(bool enabled);
+	bool isStatsEnabled() const;
+	void setHeatmap(bool show, float scale);
+	const RayStats& getRayStats() const;  // Lags the rendered frames by up to STATS_READBACK_COUNT
+	void flushRayStats();  // Waits for the frames rendered so far, so getRayStats() includes all of them
 
+	// Reservoirs survive camera moves, that's where reuse helps most. Scene changes and resizes drop them
+	void setRestir(const RestirSettings& settings);
+	const RestirSettings& getRestir() const;
+
+	// Guides are in world space, so they survive camera moves. Scene changes restart training
+	void setGuiding(const GuidingSettings& settings);
+	const GuidingSettings& getGuiding() const;
+	bool isGuideTrained() const;  // All training iterations have finished
+
+	// The cache is in world space, so it survives camera moves. Scene changes clear it
+	void setRadianceCache(const RadianceCacheSettings& settings);
+	const RadianceCacheSettings& getRadianceCache() const;
+
+	// Uploads the scene to the shared resources and takes its samples per pixel
 	void loadScene(const Scene& scene);
 
+	// Applies an edit of the loaded scene, see SceneDiff::compare. Keeps the accumulation unless the image changes
+	void updateScene(const Scene& scene, const SceneChanges& changes);
+
 	void onResize(uint32_t width, uint32_t height);
-	void render(const Camera& camera);
+	bool render(const Camera& camera);  // False if nothing could be drawn
+
+	// Reads the display texture back now and writes the PNG on the job system
+	Task<bool> saveRenderedImage(const std::string& filepath, int textureWidth, int textureHeight);
+	void readAccumulation(std::vector<float>& pixels);
+
+	// Copies the accumulation and sample state, see renderer/checkpoint.hpp. Reads back, so call it sparingly
+	void captureCheckpoint(const Camera& camera, RenderCheckpoint& checkpoint);
 
-	void saveRenderedImage(const std::string& filepath, int textureWidth, int textureHeight);
+	// Continues a checkpoint's sample stream. Render with Checkpoint::getCamera() afterwards.
+	// False if the checkpoint is for another resolution
+	bool restoreCheckpoint(const RenderCheckpoint& checkpoint);
 };
\ No newline at end of file
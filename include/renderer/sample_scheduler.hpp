@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+enum class BudgetMode {
+	Fixed,        // Samples per pixel as set by the user
+	Interactive,  // Fit each frame into a GPU time budget
+	Throughput    // Large frames for final renders, still short enough to keep the UI alive
+};
+
+// Chooses samples per pixel for the next frame from measured GPU frame times,
+// so the same settings suit both small and heavy scenes.
+class SampleScheduler {
+public:
+	static constexpr uint32_t MAX_SAMPLES_PER_PIXEL = 1024;  // Most getSamplesPerPixel() returns
+
+	void setMode(BudgetMode mode);
+	BudgetMode getMode() const;
+	void setBudget(float milliseconds);  // Interactive frame budget
+	float getBudget() const;             // Budget in effect for the current mode
+
+	// Feed a finished GPU timing. pixelCount is the render resolution, so resizes rescale the estimate
+	void addTiming(float milliseconds, uint32_t samplesPerPixel, uint64_t pixelCount);
+	void reset();
+
+	uint32_t getSamplesPerPixel() const;
+	float getFrameTime() const;         // Smoothed GPU milliseconds per frame
+	float getSamplesPerSecond() const;  // Per pixel
+	float getPathsPerSecond() const;    // Over the whole image
+
+private:
+	BudgetMode m_mode = BudgetMode::Fixed;
+	float m_budget = 16.0f;
+	float m_costPerSample = -1.0f;  // Smoothed milliseconds per sample per pixel, negative until measured
+	float m_frameTime = 0.0f;
+	uint64_t m_pixelCount = 0;
+	uint32_t m_samplesPerPixel = 1;
+
+	static constexpr float THROUGHPUT_BUDGET = 100.0f;  // Well under the Windows GPU watchdog (2 s)
+	static constexpr float SMOOTHING = 0.25f;  // Weight of the newest measurement
+};
\ No newline at end of file
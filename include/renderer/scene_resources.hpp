@@ -0,0 +1,198 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "geometry/bounds.hpp"
+#include "skybox/skybox.hpp"
+#include "types.hpp"
+#include "utils/gl_resource.hpp"
+
+struct PrimitiveRange;
+struct Scene;
+struct SceneChanges;
+
+// One variant of the path tracing shader with its cached uniform locations
+struct PathTracerProgram {
+	GLProgram program;
+
+	GLint uLocResolution;
+	GLint uLocCameraPos;
+	GLint uLocCameraForward;
+	GLint uLocCameraRight;
+	GLint uLocCameraUp;
+	GLint uLocGamma;
+	GLint uLocMaxBounces;
+	GLint uLocSamplesPerPixel;
+	GLint uLocFrame;
+	GLint uLocFrameOffset;
+	GLint uLocSampleCount;
+	GLint uLocSkyboxTexture;
+	GLint uLocHasSkybox;
+	GLint uLocSkyboxExposure;
+	GLint uLocSunDirection;
+	GLint uLocSunColour;
+	GLint uLocSunIntensity;
+	GLint uLocSunFocus;
+	GLint uLocNumSpheres;
+	GLint uLocNumPlanes;
+	GLint uLocNumQuads;
+	GLint uLocNumBoxes;
+	GLint uLocNumDiscs;
+	GLint uLocNumCylinders;
+	GLint uLocShowHeatmap;
+	GLint uLocHeatmapScale;
+	GLint uLocNumLights;
+	GLint uLocSampledLightEnds;
+	GLint uLocRestirUnbiased;
+	GLint uLocRestirCandidates;
+	GLint uLocRestirSpatialSamples;
+	GLint uLocRestirSpatialRadius;
+	GLint uLocRestirMaxHistory;
+	GLint uLocRestirHistory;
+	GLint uLocGuideBoundsMin;
+	GLint uLocGuideBoundsSize;
+	GLint uLocGuideSamplingTree;
+	GLint uLocGuideTrainingTree;
+	GLint uLocGuideMixing;
+	GLint uLocGuideTraining;
+	GLint uLocCacheEntryCount;
+	GLint uLocCacheCellSize;
+	GLint uLocCacheTerminationBounce;
+	GLint uLocCacheUpdateFraction;
+};
+
+// Compute pass that folds a frame's radiance cache updates into the cache, see radiance_cache.glsl
+struct CacheResolveProgram {
+	GLProgram program;
+
+	GLint uLocEntryCount;
+	GLint uLocMaxSamples;
+	GLint uLocMaxAge;
+};
+
+// GPU data for one scene: geometry, materials, environment and the shaders that trace them.
+// Any number of Renderer views can share an instance, each with its own camera and accumulation.
+// Changes bump the revision, which restarts accumulation in every view on its next frame.
+class SceneResources {
+private:
+	// Built on first use, indexed by variant: 1 if the shader is instrumented, plus 2 for reservoir direct lighting,
+	// plus 4 for path guiding, plus 8 for the radiance cache
+	std::unique_ptr<PathTracerProgram> m_programs[16];
+	std::unique_ptr<CacheResolveProgram> m_cacheResolveProgram;
+
+	GLVertexArray m_VAO;
+	GLBuffer m_VBO;
+
+	GLBuffer m_sphereSSBO;
+	GLBuffer m_planeSSBO;
+	GLBuffer m_quadSSBO;
+	GLBuffer m_boxSSBO;
+	GLBuffer m_discSSBO;
+	GLBuffer m_cylinderSSBO;
+	GLint m_numSpheres = 0;
+	GLint m_numPlanes = 0;
+	GLint m_numQuads = 0;
+	GLint m_numBoxes = 0;
+	GLint m_numDiscs = 0;
+	GLint m_numCylinders = 0;
+
+	// Emissive spheres, quads and discs for direct lighting, picked in proportion to their power. Emissive boxes
+	// and cylinders only light what paths find them from
+	GLBuffer m_lightSSBO;
+	GLint m_numLights = 0;
+	glm::ivec3 m_sampledLightEnds = glm::ivec3(0);  // Sphere, quad and disc indices below these are in the list
+	std::vector<float> m_spherePower;  // Per primitive, zero if it doesn't emit
+	std::vector<float> m_quadPower;
+	std::vector<float> m_discPower;
+
+	Bounds m_sphereBounds;
+	Bounds m_quadBounds;
+	Bounds m_boxBounds;
+	Bounds m_discBounds;
+	Bounds m_cylinderBounds;
+
+	float m_gamma = 2.2f;
+	uint32_t m_maxBounces = 2;
+
+	// Loaded skyboxes, most recently used first. The front entry is the active one.
+	std::vector<std::pair<std::string, std::unique_ptr<Skybox>>> m_skyboxCache;
+	size_t m_skyboxCacheCapacity = 1;
+	SkyboxFormat m_skyboxFormat = SkyboxFormat::RGB32F;
+	bool m_hasSkybox = false;
+	float m_skyboxExposure = 1.0f;
+
+	glm::vec3 m_sunDirection = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 m_sunColour = glm::vec3(1.0f);
+	float m_sunIntensity = 0.0f;
+	float m_sunFocus = 1.0f;
+
+	uint64_t m_revision = 1;
+
+	void setupQuad();
+	void uploadBuffer(GLBuffer& buffer, const char* label, GLuint binding, const void* data, size_t bytes);
+	void updateBuffer(const GLBuffer& buffer, const void* data, size_t stride, const std::vector<PrimitiveRange>& ranges);
+	void uploadLights();
+
+public:
+	// Reservoirs store a light index in 16 bits, the last value stands for the sun
+	static const size_t MAX_LIGHTS = 0xFFFF;
+
+	SceneResources();
+
+	SceneResources(const SceneResources&) = delete;
+	SceneResources& operator=(const SceneResources&) = delete;
+
+	void loadScene(const Scene& scene);
+
+	// Applies only what changed, see SceneDiff::compare. Restarts accumulation only if the image changes
+	void updateScene(const Scene& scene, const SceneChanges& changes);
+
+	void uploadSpheres(const std::vector<Sphere>& spheres);
+	void uploadPlanes(const std::vector<Plane>& planes);
+	void uploadQuads(const std::vector<Quad>& quads);
+	void uploadBoxes(const std::vector<Box>& boxes);
+	void uploadDiscs(const std::vector<Disc>& discs);
+	void uploadCylinders(const std::vector<Cylinder>& cylinders);
+
+	// Rewrites the given elements in place, the array length must match the last upload
+	void updateSpheres(const std::vector<Sphere>& spheres, const std::vector<PrimitiveRange>& ranges);
+	void updatePlanes(const std::vector<Plane>& planes, const std::vector<PrimitiveRange>& ranges);
+	void updateQuads(const std::vector<Quad>& quads, const std::vector<PrimitiveRange>& ranges);
+	void updateBoxes(const std::vector<Box>& boxes, const std::vector<PrimitiveRange>& ranges);
+	void updateDiscs(const std::vector<Disc>& discs, const std::vector<PrimitiveRange>& ranges);
+	void updateCylinders(const std::vector<Cylinder>& cylinders, const std::vector<PrimitiveRange>& ranges);
+
+	void setGamma(float gamma);
+	void setMaxBounces(uint32_t bounces);
+	void setSkybox(const std::string& filepath);  // Decodes on this thread unless cached
+	void setSkybox(const SkyboxData& data);       // Uploads a skybox decoded elsewhere, see Skybox::decode
+	void setSkyboxCacheCapacity(size_t capacity);
+	void setSkyboxFormat(SkyboxFormat format);
+	void setSkyboxExposure(float exposure);
+	void setSunDirection(glm::vec3 direction);
+	void setSunColour(glm::vec3 colour);
+	void setSunIntensity(float intensity);
+	void setSunFocus(float focus);
+
+	bool isSkyboxCached(const std::string& filepath) const;
+	std::vector<std::string> getCachedSkyboxes() const;  // Most recently used first
+	SkyboxFormat getSkyboxFormat() const;
+	const Skybox* getActiveSkybox() const;
+	uint64_t getRevision() const;  // Changes whenever anything that affects the image does
+	GLint getLightCount() const;
+	Bounds getBounds() const;  // Everything but planes, empty if the scene only has planes
+
+	// Null if the shader failed to build
+	const PathTracerProgram* getProgram(bool stats, bool restir = false, bool guiding = false, bool cache = false);
+	const CacheResolveProgram* getCacheResolveProgram();
+
+	// Binds the scene buffers and skybox and sets the scene uniforms of the program in use
+	void bind(const PathTracerProgram& program) const;
+	void drawQuad() const;
+};
\ No newline at end of file
@@ -23,18 +23,25 @@ struct alignas(16) Material {
 	float _pad2;
 };
 
+// Derived fields are filled by SceneCompiler::compile, so the shader doesn't recompute them per ray
+
 struct alignas(16) Sphere {
 	glm::vec3 position;
 	float radius;
 
+	float radiusSquared;  // Derived
+	float inverseRadius;  // Derived, turns the hit offset into the normal
+	float _pad0;
+	float _pad1;
+
 	Material material;
 };
 
 struct alignas(16) Plane {
 	glm::vec3 position;
-	float _pad0;
+	float offset;  // Derived, dot(normal, position)
 
-	glm::vec3 normal;
+	glm::vec3 normal;  // Unit length
 	float _pad1;
 
 	Material material;
@@ -44,14 +51,86 @@ struct alignas(16) Quad {
 	glm::vec3 position;
 	float width;
 
-	glm::vec3 normal;
+	glm::vec3 normal;  // normal, right and up are orthonormal
 	float height;
 
 	glm::vec3 right;
-	float _pad0;
+	float halfWidth;  // Derived
 
 	glm::vec3 up;
+	float halfHeight;  // Derived
+
+	Material material;
+};
+
+// Box faces, in the order of Box::materials
+enum BoxFace {
+	BOX_LEFT,    // -right
+	BOX_RIGHT,   // +right
+	BOX_BOTTOM,  // -up
+	BOX_TOP,     // +up
+	BOX_BACK,    // -forward
+	BOX_FRONT,   // +forward
+	BOX_FACE_COUNT
+};
+
+// Faces are one-sided like quads. They point out of the box, or into it for rooms seen from inside
+struct alignas(16) Box {
+	glm::vec3 position;  // Centre
+	int inward;  // 1 if the faces point into the box
+
+	glm::vec3 right;  // right, up and forward are orthonormal
+	float width;
+
+	glm::vec3 up;
+	float height;
+
+	glm::vec3 forward;  // Derived, cross(right, up)
+	float depth;
+
+	glm::vec3 halfSize;  // Derived
+	float _pad0;
+
+	Material materials[BOX_FACE_COUNT];  // One per face, see BoxFace
+};
+
+// One-sided like quads
+struct alignas(16) Disc {
+	glm::vec3 position;  // Centre
+	float radius;
+
+	glm::vec3 normal;  // Unit length
+	float radiusSquared;  // Derived
+
+	Material material;
+};
+
+// Closed, seen from outside like spheres
+struct alignas(16) Cylinder {
+	glm::vec3 position;  // Centre of the axis
+	float radius;
+
+	glm::vec3 axis;  // Unit length
+	float height;
+
+	float radiusSquared;  // Derived
+	float halfHeight;  // Derived
+	float _pad0;
 	float _pad1;
 
 	Material material;
+};
+
+enum LightType {
+	LIGHT_SPHERE = 1,  // Same values as the shader's hit types
+	LIGHT_QUAD = 3,
+	LIGHT_DISC = 5
+};
+
+// Emissive sphere, quad or disc that direct lighting samples explicitly, built by SceneResources
+struct alignas(16) Light {
+	int type;
+	int index;  // Into the sphere, quad or disc buffer
+	float probability;  // Of picking this light, proportional to its emitted power
+	float cdf;  // Sum of the probabilities up to and including this light
 };
\ No newline at end of file
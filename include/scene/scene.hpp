@@ -7,6 +7,7 @@
 
 #include "../renderer/types.hpp"
 #include "../camera/camera.hpp"
+#include "../camera/camera_animation.hpp"
 
 struct Scene {
     std::string name = "Default Scene";
@@ -14,12 +15,16 @@ struct Scene {
     std::vector<Sphere> spheres;
     std::vector<Plane> planes;
     std::vector<Quad> quads;
+    std::vector<Box> boxes;
+    std::vector<Disc> discs;
+    std::vector<Cylinder> cylinders;
 
     float gamma = 2.2f;
     int maxBounces = 2;
     int samplesPerPixel = 1;
 
     Camera camera;
+    CameraTrack cameraTrack;
 
     std::string skyboxPath = "";
     float skyboxExposureEV = 0.0f;
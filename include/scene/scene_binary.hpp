@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "scene.hpp"
+
+// Binary scene format (".rtscene"). Primitive arrays are stored with exactly the GPU layout from
+// types.hpp, so loading is a memory map plus one bulk copy per array instead of per-element parsing.
+//
+// Layout: FileHeader, then a table of Sections, then 16-byte aligned section payloads.
+// Unknown section types are skipped, a stride that does not match sizeof() rejects the file.
+namespace SceneBinary {
+	const uint32_t MAGIC = 0x43535452;  // "RTSC"
+	const uint32_t VERSION = 2;  // 2: primitives carry the derived fields from SceneCompiler
+	const char* const EXTENSION = ".rtscene";
+
+	enum SectionType : uint32_t {
+		SECTION_NAME = 1,         // char[count]
+		SECTION_SKYBOX_PATH = 2,  // char[count]
+		SECTION_SPHERES = 3,      // Sphere[count]
+		SECTION_PLANES = 4,       // Plane[count]
+		SECTION_QUADS = 5,        // Quad[count]
+		SECTION_ANIMATION = 6,    // AnimationSettings[1]
+		SECTION_KEYFRAMES = 7,    // CameraKeyframe[count]
+		SECTION_BOXES = 8,        // Box[count]
+		SECTION_DISCS = 9,        // Disc[count]
+		SECTION_CYLINDERS = 10    // Cylinder[count]
+	};
+
+	struct Settings {
+		float gamma;
+		int32_t maxBounces;
+		int32_t samplesPerPixel;
+
+		float cameraPosition[3];
+		float cameraYaw;
+		float cameraPitch;
+
+		float skyboxExposureEV;
+		float sunPitch;
+		float sunYaw;
+		float sunColour[3];
+		float sunIntensity;
+		float sunFocus;
+	};
+
+	struct AnimationSettings {
+		float fps;
+		float duration;
+		int32_t interpolation;
+		int32_t _pad0;
+	};
+
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t sectionCount;
+		uint32_t _pad0;
+		uint64_t sectionTableOffset;
+		Settings settings;
+	};
+
+	struct Section {
+		uint32_t type;
+		uint32_t stride;  // Bytes per element
+		uint64_t offset;  // From the start of the file
+		uint64_t count;
+	};
+
+	bool isBinaryScene(const std::string& filename);
+
+	bool saveScene(const std::string& filename, const Scene& scene);
+	bool loadScene(const std::string& filename, Scene& scene);
+}
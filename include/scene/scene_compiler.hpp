@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+#include "geometry/bounds.hpp"
+#include "scene.hpp"
+
+// Prepares loaded primitives for the GPU. Normalizes directions, orthonormalizes quad and box bases, fills the
+// derived fields in types.hpp and drops degenerate primitives. Runs after every load and is idempotent
+namespace SceneCompiler {
+	struct Report {
+		size_t removedSpheres = 0;
+		size_t removedPlanes = 0;
+		size_t removedQuads = 0;
+		size_t removedBoxes = 0;
+		size_t removedDiscs = 0;
+		size_t removedCylinders = 0;
+		Bounds bounds;  // Everything but planes, which are unbounded
+	};
+
+	// False if the primitive is degenerate: non-finite values, no size or a basis that can't be fixed
+	bool compileSphere(Sphere& sphere);
+	bool compilePlane(Plane& plane);
+	bool compileQuad(Quad& quad);
+	bool compileBox(Box& box);
+	bool compileDisc(Disc& disc);
+	bool compileCylinder(Cylinder& cylinder);
+
+	Bounds getBounds(const Sphere& sphere);
+	Bounds getBounds(const Quad& quad);
+	Bounds getBounds(const Box& box);
+	Bounds getBounds(const Disc& disc);
+	Bounds getBounds(const Cylinder& cylinder);
+
+	// Logs a warning per primitive type with removals
+	Report compile(Scene& scene);
+}
\ No newline at end of file
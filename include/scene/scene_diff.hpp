@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "scene.hpp"
+
+// Elements [first, first + count) of a primitive array
+struct PrimitiveRange {
+	size_t first = 0;
+	size_t count = 0;
+};
+
+// What differs between two compiled scenes, grouped by how the GPU copy has to be updated
+struct SceneChanges {
+	struct Primitives {
+		std::vector<PrimitiveRange> ranges;  // Changed elements, in order
+		bool resized = false;                // Length changed, the whole array is replaced
+
+		bool any() const;
+	};
+
+	Primitives spheres;
+	Primitives planes;
+	Primitives quads;
+	Primitives boxes;
+	Primitives discs;
+	Primitives cylinders;
+
+	bool tracing = false;          // Gamma or max bounces
+	bool samplesPerPixel = false;  // Doesn't affect the image, accumulation is weighted by sample count
+	bool skybox = false;           // Skybox path
+	bool environment = false;      // Skybox exposure or sun
+	bool camera = false;
+	bool cameraTrack = false;
+	bool name = false;
+
+	bool isEmpty() const;
+	bool affectsImage() const;
+};
+
+namespace SceneDiff {
+	// Changed elements closer than this are sent as one range, fewer uploads outweigh the extra bytes
+	constexpr size_t MERGE_GAP = 8;
+
+	// Both scenes must be compiled, primitives are compared byte for byte
+	SceneChanges compare(const Scene& before, const Scene& after);
+
+	// One line for logs, e.g. "2 sphere ranges, sun"
+	std::string describe(const SceneChanges& changes);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/bounds.hpp"
+#include "geometry/intersection.hpp"
+#include "scene.hpp"
+#include "scene_diff.hpp"
+
+// Bounding volume hierarchy over a scene's primitives for CPU ray queries such as picking. Planes are unbounded,
+// they are tested one by one. Edits that keep the array lengths refit the changed leaves and their ancestors.
+// The tree's shape stays, so it loosens as primitives move far from where they were built; build again to tighten it
+class SceneIndex {
+private:
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+	static constexpr size_t TYPE_COUNT = 7;  // Intersection::HitType values
+
+	struct Node {
+		Bounds bounds;
+		uint32_t first = 0;  // Leaves: first entry. Interior nodes: left child, the right child follows it
+		uint32_t count = 0;  // Entries in a leaf, zero for interior nodes
+	};
+
+	struct Entry {
+		Intersection::HitType type;
+		uint32_t index;  // Into the scene's array of that type
+	};
+
+	std::vector<Node> m_nodes;  // Root first
+	std::vector<uint32_t> m_parents;
+	std::vector<Entry> m_entries;  // In leaf order
+	std::vector<uint32_t> m_leaves[TYPE_COUNT];  // Leaf of each primitive, by type
+
+	void refit(const Scene& scene, uint32_t leaf);
+
+public:
+	// Median split on the longest axis of the primitives' centres, a few primitives per leaf
+	void build(const Scene& scene);
+
+	// After the scene changed as described, see SceneDiff::compare. A resized array rebuilds the tree
+	void update(const Scene& scene, const SceneChanges& changes);
+
+	// After one primitive was edited in place
+	void update(const Scene& scene, Intersection::HitType type, size_t index);
+
+	// Closest hit in front of the ray's origin. The scene must be the one last built or updated
+	Intersection::Hit intersect(const Intersection::Ray& ray, const Scene& scene) const;
+
+	static Bounds getBounds(const Scene& scene, Intersection::HitType type, size_t index);  // Empty for planes
+
+	size_t getNodeCount() const;
+	size_t getPrimitiveCount() const;  // Indexed primitives, planes aren't
+};
\ No newline at end of file
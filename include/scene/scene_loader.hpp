@@ -1,9 +1,14 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "scene.hpp"
+#include "utils/job_system.hpp"
 
 namespace SceneLoader {
     bool loadScene(const std::string& filename, Scene& scene);
+
+    // Loads on the job system. The result is null if the scene failed to load
+    Task<std::shared_ptr<Scene>> loadSceneAsync(const std::string& filename);
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Sequence {
+	struct SequenceSettings {
+		std::string scenePath;
+		std::string outputPattern;  // One %d or %0Nd frame number, e.g. "exports/frame_%04d.png"
+		std::string videoPath;      // When set, frames are piped to ffmpeg instead of written as images
+		std::string ffmpegPath;
+		uint32_t width;
+		uint32_t height;
+		uint32_t samplesPerFrame;   // Sample budget per frame
+		uint32_t samplesPerPixel;   // Per dispatch, 0 uses the scene value
+		int firstFrame;
+		int lastFrame;              // Negative renders to the end of the camera track
+		uint32_t writerThreads;
+	};
+
+	// Renders the scene's camera track frame by frame. Readback of frame N overlaps rendering of
+	// frame N + 1, and encoding happens on writer threads, so export I/O does not stall the GPU.
+	int runSequence(const SequenceSettings& settings);
+}
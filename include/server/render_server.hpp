@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/socket.hpp"
+#include "skybox/skybox.hpp"
+
+class Renderer;
+
+namespace Server {
+	const uint16_t DEFAULT_PORT = 47810;
+	const uint32_t MAX_JOB_SIZE = 16384;  // Width or height
+	const size_t MAX_LINE_LENGTH = 64 * 1024;
+
+	struct ServerSettings {
+		uint16_t port;
+		std::string bindAddress;  // Loopback by default. Requests aren't authenticated, widen it on trusted networks only
+		size_t skyboxCacheCapacity;
+		SkyboxFormat skyboxFormat;  // Compact formats let more skyboxes stay resident
+	};
+
+	// A client connection, jobs keep it alive until their final event has been sent
+	struct Connection {
+		Socket socket;
+		std::mutex sendMutex;
+		std::atomic<bool> closed{ false };  // The reader has stopped, its thread can be joined
+
+		bool sendLine(const std::string& line);
+	};
+
+	struct Job {
+		uint32_t id = 0;
+		int priority = 0;  // Higher runs first, equal priorities run in submission order
+		std::string scenePath;
+		std::string outputPath;
+		uint32_t width = 0;   // 0 keeps the previous resolution
+		uint32_t height = 0;
+		uint32_t samplesPerPixel = 0;  // Per frame, 0 uses the scene value
+		uint64_t targetSamples = 0;    // 0 uses one frame's worth of samples, unless noise or time is set
+		float targetNoise = 0.0f;      // Stop once the mean relative error is below this, 0 disables
+		float timeLimit = 0.0f;        // Seconds of tracing, 0 disables
+		double submitTime = 0.0;
+
+		std::shared_ptr<Connection> connection;
+	};
+
+	// Long-running renderer. Jobs arrive as JSON lines on a TCP port and are rendered back to back
+	// on one GL context, so shader programs, buffers and recently used skyboxes stay resident.
+	class RenderServer {
+	public:
+		explicit RenderServer(const ServerSettings& settings);
+		~RenderServer();
+
+		int run();
+
+	private:
+		struct JobOrder {
+			bool operator()(const Job& a, const Job& b) const;
+		};
+
+		ServerSettings m_settings;
+
+		std::mutex m_queueMutex;
+		std::condition_variable m_queueCondition;
+		std::priority_queue<Job, std::vector<Job>, JobOrder> m_queue;
+		uint32_t m_nextJobId = 1;
+
+		std::atomic<bool> m_running{ true };
+		Socket m_listener;
+		std::thread m_acceptThread;
+		struct Reader {
+			std::shared_ptr<Connection> connection;
+			std::thread thread;
+		};
+		std::mutex m_readersMutex;
+		std::vector<Reader> m_readers;
+
+		void acceptLoop();
+		void reapReaders();  // Joins the readers of closed connections
+		void readConnection(std::shared_ptr<Connection> connection);
+		void handleRequest(const std::string& line, const std::shared_ptr<Connection>& connection);
+
+		bool popJob(Job& job);
+		void renderJob(Renderer& renderer, Job& job);
+		void stop();
+	};
+
+	int runServer(const ServerSettings& settings);
+
+	// Client stand-in: submits a job line and prints events until the job finishes
+	int submitJob(const std::string& host, uint16_t port, const std::string& jobJson);
+}
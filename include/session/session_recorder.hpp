@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera/camera.hpp"
+#include "renderer/renderer.hpp"
+#include "renderer/sample_scheduler.hpp"
+#include "skybox/skybox.hpp"
+
+namespace Session {
+	// The Settings window's values that change what the renderer traces or how long a frame takes
+	struct SessionSettings {
+		float gamma = 2.2f;
+		int maxBounces = 5;
+		int samplesPerPixel = 1;  // Fixed budget only
+		BudgetMode budgetMode = BudgetMode::Fixed;
+		float frameBudget = 16.0f;
+		std::string skyboxPath;
+		SkyboxFormat skyboxFormat = SkyboxFormat::RGB32F;
+		float skyboxExposureEV = 0.0f;
+		float sunPitch = 0.0f;
+		float sunYaw = 0.0f;
+		glm::vec3 sunColour = glm::vec3(1.0f);
+		float sunIntensity = 0.0f;
+		float sunFocus = 0.0f;
+		bool statsEnabled = false;
+		RestirSettings restir;
+		GuidingSettings guiding;
+		RadianceCacheSettings radianceCache;
+	};
+
+	enum class EventType {
+		Scene,     // scenePath was loaded, replacing the camera and the scene's settings
+		Viewport,  // The main view was resized
+		Settings   // Any of the settings changed, the event holds all of them
+	};
+
+	struct SessionEvent {
+		double time = 0.0;  // Seconds since recording started
+		EventType type = EventType::Settings;
+		std::string scenePath;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		SessionSettings settings;
+	};
+
+	// The camera is sampled rather than evented, replay interpolates between samples
+	struct CameraSample {
+		double time = 0.0;
+		glm::vec3 position = glm::vec3(0.0f);
+		float yaw = 0.0f;
+		float pitch = 0.0f;
+	};
+
+	struct Recording {
+		double duration = 0.0;
+		std::vector<SessionEvent> events;  // In time order
+		std::vector<CameraSample> cameras;  // In time order
+	};
+
+	bool saveRecording(const std::string& filepath, const Recording& recording);
+	bool loadRecording(const std::string& filepath, Recording& recording);
+
+	// Camera at a time between samples, the first or last sample outside them. Yaw takes the shorter way round
+	Camera evaluateCamera(const std::vector<CameraSample>& cameras, double time);
+
+	// Logs what the user does during an interactive session: scene loads, viewport sizes, settings and camera moves.
+	// Only changes are kept, so an idle session costs nothing. Times are passed in, in seconds on any steady clock
+	class SessionRecorder {
+	private:
+		std::string m_filepath;
+		bool m_active = false;
+		double m_startTime = 0.0;
+		double m_lastUpdate = 0.0;  // Since start, of the previous update
+		Recording m_recording;
+
+		bool m_hasState = false;  // The fields below hold the last recorded state
+		CameraSample m_camera;
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		std::string m_settings;  // Serialised, compared as a whole
+
+	public:
+		void start(const std::string& filepath, double time, const std::string& scenePath);
+		bool stop(double time);  // Writes the recording
+		bool isRecording() const;
+		const std::string& getFilepath() const;
+		double getDuration(double time) const;
+		size_t getEventCount() const;  // Events and camera samples
+
+		void recordScene(double time, const std::string& scenePath);
+
+		// Once per UI frame, after input and scene loads for the frame are applied
+		void update(double time, const Camera& camera, const SessionSettings& settings, uint32_t width, uint32_t height);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Session {
+	struct ReplaySettings {
+		std::string recordingPath;
+		std::string reportPath;  // Per-frame timings as CSV, empty skips it
+		float fps;               // Fixed timestep, frames are rendered at multiples of 1 / fps
+		uint32_t width;          // 0 follows the recorded viewport
+		uint32_t height;
+	};
+
+	// Renders a recorded session at a fixed timestep, whatever the machine's speed, so two runs see the same
+	// frames: events are applied on the frame their time falls in and the camera is interpolated between samples.
+	// Each frame waits for the GPU, so CPU and GPU times are the frame's own. Prints percentiles of both
+	int runReplay(const ReplaySettings& settings);
+}
\ No newline at end of file
@@ -1,24 +1,65 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "utils/gl_resource.hpp"
+
+// GPU storage for the environment map
+enum class SkyboxFormat {
+	RGB32F,   // 12 bytes per texel, the reference
+	RGB16F,   // 6 bytes per texel
+	RGB9_E5,  // 4 bytes per texel, shared exponent
+	BC6H      // 1 byte per texel, block compressed (cached next to the source as .bc6h)
+};
+
+const char* getSkyboxFormatName(SkyboxFormat format);
+bool parseSkyboxFormat(const std::string& name, SkyboxFormat& format);  // Case insensitive
+
+// A decoded skybox ready for upload, produced by Skybox::decode on any thread
+struct SkyboxData {
+	std::string filepath;
+	SkyboxFormat format = SkyboxFormat::RGB32F;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	bool fromCache = false;                    // Read from the .bc6h cache instead of decoded
+	std::vector<float> pixels;                 // RGB32F base level, mipmaps are generated on the GPU
+	std::vector<std::vector<uint8_t>> levels;  // Encoded mip chain of the compact formats
+};
+
 class Skybox {
 public:
 	Skybox();
 	~Skybox();
 
-	bool load(const std::string& filepath);
+	// Decodes the HDR and encodes the mip chain without touching GL, so it can run on the job system.
+	// Also writes the BC6H cache
+	static bool decode(const std::string& filepath, SkyboxFormat format, SkyboxData& data);
+
+	// Creates the texture, on the thread that owns the GL context
+	bool upload(const SkyboxData& data);
+
+	bool load(const std::string& filepath, SkyboxFormat format = SkyboxFormat::RGB32F);  // decode() then upload()
 	void cleanup();
 
 	GLuint getTextureID() const;
 	int getWidth() const;
 	int getHeight() const;
+	SkyboxFormat getFormat() const;
+	size_t getMemoryUsage() const;  // Bytes including mipmaps
 
 private:
-	GLuint m_textureId = 0;
+	GLTexture m_texture;
 	int m_width = 0;
 	int m_height = 0; 
 	int m_channels = 0;
+	SkyboxFormat m_format = SkyboxFormat::RGB32F;
+	size_t m_memoryUsage = 0;
+
+	void uploadFloat(const SkyboxData& data);
+	void uploadCompact(const SkyboxData& data);
 };
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// CPU encoders for compact environment map storage
+namespace SkyboxEncoding {
+	// One mip level of RGB float data
+	struct FloatImage {
+		int width = 0;
+		int height = 0;
+		std::vector<float> rgb;
+	};
+
+	// Full mip chain down to 1x1, box filtered
+	std::vector<FloatImage> buildMipChain(const float* rgb, int width, int height);
+
+	uint16_t floatToHalf(float value);
+	float halfToFloat(uint16_t value);
+
+	// GL_RGB16F, 3 halfs per texel
+	std::vector<uint16_t> encodeRGB16F(const FloatImage& image);
+
+	// GL_RGB9_E5, packed as GL_UNSIGNED_INT_5_9_9_9_REV
+	uint32_t packRGB9E5(float r, float g, float b);
+	std::vector<uint32_t> encodeRGB9E5(const FloatImage& image);
+
+	// GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT (BC6H UF16), 16 bytes per 4x4 block.
+	// Uses single-region mode 11 with a full index search per texel
+	size_t bc6hSize(int width, int height);
+	std::vector<uint8_t> encodeBC6H(const FloatImage& image);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "utils/gl_resource.hpp"
+
+// Ring of pixel pack buffers for non-blocking texture readback. A read issued with begin()
+// is copied by the GPU in the background, and fetched a frame or two later once its fence signals.
+class AsyncReadback {
+public:
+	explicit AsyncReadback(size_t slotCount = 3);
+	~AsyncReadback();
+
+	AsyncReadback(const AsyncReadback&) = delete;
+	AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+	// Queues an RGBA8 read of the texture, returns false if every slot is still in flight
+	bool begin(GLuint texture, uint32_t width, uint32_t height, uint64_t tag);
+
+	// Copies out the oldest finished read. With wait = false, returns false if it is not ready yet.
+	// Returns false for good once a wait or map fails, check hasFailed() to leave a fetch loop
+	bool fetch(std::vector<unsigned char>& pixels, uint64_t& tag, bool wait);
+
+	size_t getPendingCount() const;
+	bool hasFailed() const;
+
+private:
+	struct Slot {
+		GLBuffer pbo;
+		GLsync fence = nullptr;
+		size_t size = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint64_t tag = 0;
+	};
+
+	std::vector<Slot> m_slots;
+	size_t m_head = 0;     // Next slot to fetch
+	size_t m_pending = 0;
+	bool m_failed = false;
+	GLFramebuffer m_fbo;
+
+	void fail(const char* reason);  // Drops every read in flight
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Simple "--flag value" command line lookup
+class CommandLine {
+public:
+	CommandLine(int argc, char** argv);
+
+	bool has(const std::string& flag) const;
+	std::string get(const std::string& flag, const std::string& fallback = "") const;
+	int getInt(const std::string& flag, int fallback) const;
+	float getFloat(const std::string& flag, float fallback) const;
+
+private:
+	std::vector<std::string> m_args;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#ifndef __linux__
+#include <filesystem>
+#endif
+
+// Reports when a file on disk changes. Uses inotify on Linux and polls the modification time elsewhere.
+// The parent directory is watched, so editors that save by replacing the file are still seen
+class FileWatcher {
+public:
+	// Changes are reported once the file has been quiet this long, so a save in several writes reloads once
+	static constexpr int SETTLE_MILLISECONDS = 100;
+
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Replaces the watched file. False if it can't be watched
+	bool watch(const std::string& filepath);
+	void stop();
+
+	// Non-blocking, true once per settled change
+	bool poll();
+
+	bool isWatching() const;
+	const std::string& getPath() const;
+
+private:
+	std::string m_path;
+	std::string m_filename;
+	bool m_pending = false;
+	std::chrono::steady_clock::time_point m_lastChange;
+
+#ifdef __linux__
+	int m_fd = -1;
+	int m_watch = -1;
+#else
+	std::filesystem::file_time_type m_lastWriteTime;
+	std::chrono::steady_clock::time_point m_lastCheck;
+#endif
+
+	bool readChanges();  // True if the file changed since the last call
+};
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+struct GLFWwindow;
+
+// Creates an invisible window with a current OpenGL 4.4 context, for rendering without the UI
+GLFWwindow* createHeadlessContext(uint32_t width, uint32_t height);
+void destroyHeadlessContext(GLFWwindow* window);
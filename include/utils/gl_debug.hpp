@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Driver messages through KHR_debug, core since OpenGL 4.3. Errors, undefined behaviour and performance warnings
+// (implicit syncs, shader recompiles, slow paths) go to the log. Notifications and debug groups don't
+namespace GLDebug {
+	// Context creation asks for a debug context when set, drivers report more in one, e.g. performance warnings.
+	// Messages then arrive during the call that caused them, which slows GL down but keeps them in order
+	void setDebugContext(bool enabled);
+	bool isDebugContext();
+
+	// Installs the message callback on the current context. A message that keeps repeating is logged a few times,
+	// then only counted
+	void install();
+}
+
+// Names a pass in RenderDoc, apitrace, driver messages and GPU profilers for as long as it lives
+class GLDebugGroup {
+public:
+	explicit GLDebugGroup(const char* name);
+	~GLDebugGroup();
+
+	GLDebugGroup(const GLDebugGroup&) = delete;
+	GLDebugGroup& operator=(const GLDebugGroup&) = delete;
+};
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+#include "utils/gpu_memory.hpp"
+
+// Move-only owner of one GL object name. The object is registered with GpuMemory
+// on creation and deleted and unregistered when the handle is reset or destroyed.
+// The GpuMemory label is also given to GL, so captures and driver messages name it.
+template <GpuResourceKind Kind>
+class GLHandle {
+public:
+	GLHandle() = default;
+	~GLHandle() { reset(); }
+
+	GLHandle(const GLHandle&) = delete;
+	GLHandle& operator=(const GLHandle&) = delete;
+
+	GLHandle(GLHandle&& other) noexcept : m_id(other.m_id), m_labelled(other.m_labelled) {
+		other.m_id = 0;
+		other.m_labelled = false;
+	}
+	GLHandle& operator=(GLHandle&& other) noexcept {
+		if (this != &other) {
+			reset();
+			m_id = other.m_id;
+			m_labelled = other.m_labelled;
+			other.m_id = 0;
+			other.m_labelled = false;
+		}
+		return *this;
+	}
+
+	void create(const std::string& label);         // Generates a new object, releasing any previous one
+	void adopt(GLuint id, const std::string& label);  // Takes ownership of an existing object
+	void reset();
+
+	void setSize(size_t bytes);  // Records the object's storage size, and labels textures which exist by then
+
+	// Passes the label to GL once the object exists, i.e. has been bound or used. create() does this where it can,
+	// textures are labelled by setSize() and queries need a call after their first use
+	void label();
+
+	GLuint get() const { return m_id; }
+	explicit operator bool() const { return m_id != 0; }
+
+private:
+	GLuint m_id = 0;
+	bool m_labelled = false;
+};
+
+using GLBuffer = GLHandle<GpuResourceKind::Buffer>;
+using GLTexture = GLHandle<GpuResourceKind::Texture>;
+using GLFramebuffer = GLHandle<GpuResourceKind::Framebuffer>;
+using GLProgram = GLHandle<GpuResourceKind::Program>;
+using GLVertexArray = GLHandle<GpuResourceKind::VertexArray>;
+using GLQuery = GLHandle<GpuResourceKind::Query>;
+
+// Approximate storage of one level of an uncompressed texture
+size_t getTextureLevelSize(GLenum internalFormat, uint32_t width, uint32_t height);
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+enum class GpuResourceKind {
+	Buffer,
+	Texture,
+	Framebuffer,
+	Program,
+	VertexArray,
+	Query
+};
+
+const char* getGpuResourceKindName(GpuResourceKind kind);
+
+// Registry of live GL objects with their purpose and approximate size. The handles in
+// gl_resource.hpp keep it up to date, so totals reflect what is actually allocated.
+namespace GpuMemory {
+	struct Allocation {
+		GpuResourceKind kind;
+		GLuint id;
+		size_t bytes;
+		std::string label;
+	};
+
+	void track(GpuResourceKind kind, GLuint id, const std::string& label);
+	void setSize(GpuResourceKind kind, GLuint id, size_t bytes);
+	void untrack(GpuResourceKind kind, GLuint id);
+	std::string getLabel(GpuResourceKind kind, GLuint id);  // Empty for untracked objects
+
+	size_t getTotal();
+	size_t getTotal(GpuResourceKind kind);
+	size_t getObjectCount();
+	std::vector<Allocation> getAllocations();  // Largest first
+
+	// 0 disables the budget. Exceeding it logs a warning once per crossing
+	void setBudget(size_t bytes);
+	size_t getBudget();
+	bool isOverBudget();
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Writes a bottom-up RGBA32F buffer (as read back from GL). ".hdr" paths keep linear floats,
+// anything else is gamma corrected and written as PNG.
+bool saveFloatImage(const std::string& filepath, const float* pixels, int width, int height, float gamma);
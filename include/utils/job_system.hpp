@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class JobSystem;
+
+// Where a job runs. Main is the thread registered with setMainThread, for work on state it owns such as UI or GL state
+enum class JobThread {
+	Worker,
+	Main
+};
+
+namespace JobDetail {
+	struct Job;
+}
+
+// Type-erased reference to a submitted job, used to express dependencies
+class JobHandle {
+public:
+	bool valid() const { return m_job != nullptr; }
+	bool isReady() const;
+
+	// Runs other queued jobs while waiting, so it is safe to call from workers and the main thread
+	void wait() const;
+
+protected:
+	std::shared_ptr<JobDetail::Job> m_job;
+
+	friend class JobSystem;
+};
+
+// Result of a job. get() waits and rethrows anything the job threw
+template <typename T>
+class Task : public JobHandle {
+public:
+	decltype(auto) get() const {
+		wait();
+		return m_future.get();
+	}
+
+private:
+	std::shared_future<T> m_future;
+
+	friend class JobSystem;
+};
+
+// Shared pool of worker threads for CPU-side work such as decoding, encoding and parsing.
+// Every worker owns a deque: it pushes and pops its own jobs at the back and idle workers
+// steal from the front of the others. A job starts once all of its dependencies have
+// finished. Main thread jobs are queued until the main loop calls runMainThreadJobs().
+class JobSystem {
+public:
+	// Process-wide instance with one worker per hardware thread, minus the main thread
+	static JobSystem& get();
+
+	explicit JobSystem(unsigned workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	template <typename F>
+	auto run(F&& function, const std::vector<JobHandle>& dependencies = {}, JobThread thread = JobThread::Worker)
+		-> Task<std::invoke_result_t<std::decay_t<F>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<F>>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+
+		Task<Result> result;
+		result.m_future = task->get_future().share();
+		result.m_job = submit([task]() { (*task)(); }, dependencies, thread);
+		return result;
+	}
+
+	// Splits [begin, end) into chunks of at least `grain` items, runs them across the workers and
+	// the calling thread and returns once all are done. body(chunkBegin, chunkEnd) must be thread safe
+	void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+	// Runs the queued main thread jobs, returns how many ran. Call once per frame from the main thread
+	size_t runMainThreadJobs();
+	bool hasMainThreadJobs() const;
+
+	// The thread that may run main thread jobs, by default the one that created the instance
+	void setMainThread();
+	bool isMainThread() const;
+
+	// Called from any thread when a main thread job is queued, e.g. to wake an idle event loop
+	void setMainThreadWakeCallback(std::function<void()> callback);
+
+	// Waits for every submitted job, including main thread jobs when called from the main thread
+	void waitForIdle();
+
+	unsigned getWorkerCount() const;
+	size_t getPendingJobCount() const;  // Submitted and not finished yet
+
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::shared_ptr<JobDetail::Job>> jobs;
+	};
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::atomic<size_t> m_nextQueue{ 0 };
+	std::atomic<size_t> m_queuedJobs{ 0 };
+	std::atomic<size_t> m_pendingJobs{ 0 };
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+	bool m_stopping = false;
+
+	mutable std::mutex m_mainMutex;
+	std::deque<std::shared_ptr<JobDetail::Job>> m_mainJobs;
+	std::function<void()> m_wakeMainThread;
+	std::thread::id m_mainThread;
+
+	std::shared_ptr<JobDetail::Job> submit(std::function<void()> function, const std::vector<JobHandle>& dependencies, JobThread thread);
+	void enqueue(std::shared_ptr<JobDetail::Job> job);
+	void execute(const std::shared_ptr<JobDetail::Job>& job);
+	bool runWorkerJob();
+	void workerLoop(size_t index);
+	void waitFor(JobDetail::Job& job);
+
+	friend class JobHandle;
+};
\ No newline at end of file
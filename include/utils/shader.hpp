@@ -4,4 +4,10 @@
 
 #include <GLFW/glfw3.h>
 
-GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
\ No newline at end of file
+// Where the renderer's shaders are loaded from, "shaders" relative to the working directory by default
+void setShaderDirectory(const std::string& directory);
+std::string getShaderPath(const std::string& filename);
+
+// defines are inserted after the #version line, e.g. "#define RT_STATS\n"
+GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
+GLuint createComputeProgram(const std::string& computePath, const std::string& defines = "");
\ No newline at end of file
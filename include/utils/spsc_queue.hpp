@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+// Each index is written by one side only, so pushing and popping never wait on each other
+template <typename T>
+class SpscQueue {
+public:
+	// Rounded up to a power of two
+	explicit SpscQueue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+		m_slots.resize(size);
+		m_mask = size - 1;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer only. False if the queue is full
+	bool tryPush(T&& value) {
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+			return false;
+
+		m_slots[tail & m_mask] = std::move(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. False if the queue is empty
+	bool tryPop(T& value) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+
+		value = std::move(m_slots[head & m_mask]);
+		m_slots[head & m_mask] = T();  // Releases anything the value owned on the consumer's side
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool isEmpty() const {
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<T> m_slots;
+	size_t m_mask = 0;
+
+	// Separate cache lines, each side only writes its own index
+	alignas(64) std::atomic<size_t> m_head{ 0 };  // Next slot to pop
+	alignas(64) std::atomic<size_t> m_tail{ 0 };  // Next slot to push
+};
\ No newline at end of file
@@ -16,6 +16,8 @@ uniform float uGamma;
 uniform uint uMaxBounces;
 uniform uint uSamplesPerPixel;
 uniform uint uFrame;
+uniform uint uFrameOffset;  // RNG stream offset, lets separate processes draw disjoint samples
+uniform float uSampleCount;  // Samples already accumulated, frames may use different sample counts
 
 layout(rgba32f, binding = 0) uniform image2D uAccumulatedImage;
 
@@ -51,16 +53,23 @@ struct Material {
 	float _pad2;
 };
 
+// Derived fields are precomputed on load, see SceneCompiler
+
 struct Sphere {
 	vec3 position;
 	float radius;
 
+	float radiusSquared;
+	float inverseRadius;
+	float _pad0;
+	float _pad1;
+
 	Material material;
 };
 
 struct Plane {
 	vec3 position;
-	float _pad0;
+	float offset;  // dot(normal, position)
 
 	vec3 normal;
 	float _pad1;
@@ -76,9 +85,55 @@ struct Quad {
 	float height;
 	
 	vec3 right;
-	float _pad0;
+	float halfWidth;
 
 	vec3 up;
+	float halfHeight;
+
+	Material material;
+};
+
+const int BOX_FACE_COUNT = 6;
+
+struct Box {
+	vec3 position;
+	int inward;  // The faces point into the box
+
+	vec3 right;
+	float width;
+
+	vec3 up;
+	float height;
+
+	vec3 forward;  // cross(right, up)
+	float depth;
+
+	vec3 halfSize;
+	float _pad0;
+
+	Material materials[BOX_FACE_COUNT];  // Left, right, bottom, top, back, front
+};
+
+struct Disc {
+	vec3 position;
+	float radius;
+
+	vec3 normal;
+	float radiusSquared;
+
+	Material material;
+};
+
+struct Cylinder {
+	vec3 position;  // Centre of the axis
+	float radius;
+
+	vec3 axis;
+	float height;
+
+	float radiusSquared;
+	float halfHeight;
+	float _pad0;
 	float _pad1;
 
 	Material material;
@@ -91,6 +146,7 @@ struct HitInfo {
 	vec3 normal;
 	Material material;
 	int hitType;
+	int index;  // Into the hit type's buffer
 	vec2 uv;
 };
 
@@ -98,14 +154,139 @@ const int HIT_TYPE_NONE = 0;
 const int HIT_TYPE_SPHERE = 1;
 const int HIT_TYPE_PLANE = 2;
 const int HIT_TYPE_QUAD = 3;
+const int HIT_TYPE_BOX = 4;
+const int HIT_TYPE_DISC = 5;
+const int HIT_TYPE_CYLINDER = 6;
 
 layout(std430, binding = 0) readonly buffer Spheres { Sphere spheres[]; };
 layout(std430, binding = 1) readonly buffer Planes { Plane planes[]; };
 layout(std430, binding = 2) readonly buffer Quads { Quad _quads[]; };
+layout(std430, binding = 7) readonly buffer Boxes { Box boxes[]; };
+layout(std430, binding = 8) readonly buffer Discs { Disc discs[]; };
+layout(std430, binding = 9) readonly buffer Cylinders { Cylinder cylinders[]; };
 
 uniform int uNumSpheres;
 uniform int uNumPlanes;
 uniform int uNumQuads;
+uniform int uNumBoxes;
+uniform int uNumDiscs;
+uniform int uNumCylinders;
+
+// Built with RT_RESTIR defined, direct light at primary hits is resampled from reservoirs, see Renderer::setRestir
+#ifdef RT_RESTIR
+const int LIGHT_SPHERE = 1;
+const int LIGHT_QUAD = 3;
+const int LIGHT_DISC = 5;
+const uint LIGHT_SUN = 0xFFFFu;  // Light index of the sun, after the largest list index, see SceneResources::MAX_LIGHTS
+
+struct Light {
+	int type;
+	int index;
+	float probability;
+	float cdf;
+};
+
+layout(std430, binding = 4) readonly buffer Lights { Light lights[]; };
+uniform int uNumLights;
+uniform ivec3 uSampledLightEnds;  // Sphere, quad and disc indices below these are in the list, the rest didn't fit
+
+// The previous frame's reservoirs and this frame's. Layer 0: light index and sample count (low and high 16 bits),
+// sample coordinates, contribution weight. Layer 1: the shading point and normal the sample was chosen for
+layout(rgba32ui, binding = 2) uniform readonly uimage2DArray uPrevReservoirs;
+layout(rgba32ui, binding = 3) uniform writeonly uimage2DArray uReservoirs;
+
+uniform int uRestirUnbiased;
+uniform uint uRestirCandidates;
+uniform uint uRestirSpatialSamples;
+uniform float uRestirSpatialRadius;
+uniform uint uRestirMaxHistory;
+uniform int uRestirHistory;  // 0 if uPrevReservoirs holds nothing usable
+
+ivec2 gPixel;
+bool gStoreReservoir;  // Only the first sample of a pixel writes its reservoir
+#endif
+
+// Built with RT_GUIDING defined, diffuse bounces partly follow learned incident radiance, see Renderer::setGuiding
+#ifdef RT_GUIDING
+// SD-trees, laid out by PathGuide: a spatial binary tree over the scene bounds, splitting x, y and z in turn, with a
+// quadtree over the sphere of directions per leaf. Quadtree nodes hold the radiance of each quadrant as float bits
+const uint GUIDE_HEADER_SIZE = 4u;  // Offsets of the quadtree nodes, their sums and the sample counts, spatial nodes
+const uint GUIDE_MAX_DEPTH = 20u;  // Must match PathGuide::MAX_QUAD_DEPTH
+const uint GUIDE_MAX_SPATIAL_DEPTH = 64u;
+const uint GUIDE_MAX_SAMPLES = 0x7FFFFFFFu;  // Counts stop here rather than wrap
+const uint MAX_GUIDE_VERTICES = 8u;  // Bounces per path that train the guide
+
+// The tree from the finished iteration, then the one being trained
+layout(std430, binding = 5) buffer GuideTrees { uint guideTrees[]; };
+
+uniform vec3 uGuideBoundsMin;
+uniform vec3 uGuideBoundsSize;
+uniform uint uGuideSamplingTree;  // Offsets into guideTrees
+uniform uint uGuideTrainingTree;
+uniform float uGuideMixing;  // 0 while there is nothing to sample
+uniform int uGuideTraining;
+#endif
+
+// Built with RT_CACHE defined, paths end in a world-space cache of surface radiance, see Renderer::setRadianceCache
+#ifdef RT_CACHE
+// Hash grid entries: checksum of the cell (0 while free), this frame's radiance sums (fixed point) and sample count,
+// then the cached radiance (float bits), the samples it averages and the frames since its last update. The
+// radiance_cache.glsl pass folds the sums in after every frame
+const uint CACHE_ENTRY_SIZE = 10u;  // Must match radiance_cache.glsl
+const float CACHE_SCALE = 256.0;
+const float CACHE_MAX_RADIANCE = 4096.0;  // Keeps a frame's sums within a uint
+const uint CACHE_PROBES = 8u;  // Slots tried after the hashed one before a cell gives up
+const uint CACHE_MIN_SAMPLES = 4u;  // Entries with fewer are too noisy to end paths in
+const uint MAX_CACHE_VERTICES = 8u;
+
+layout(std430, binding = 6) buffer RadianceCache { uint cache[]; };
+
+uniform uint uCacheEntryCount;  // Power of two
+uniform float uCacheCellSize;  // World units, the same everywhere so cells don't depend on the view
+uniform uint uCacheTerminationBounce;
+uniform float uCacheUpdateFraction;
+
+bool gCacheUpdate;  // This sample traces a full path and trains the cache
+#endif
+
+// === INSTRUMENTATION ===
+
+// Built with RT_STATS defined, counters are summed per pixel then added to 64-bit (lo, hi) pairs
+#ifdef RT_STATS
+const int STAT_RAYS = 0;
+const int STAT_BOUNCES = 1;
+const int STAT_PRIMITIVE_TESTS = 2;
+const int STAT_MISS = 3;
+const int STAT_ROULETTE = 4;
+const int STAT_MAX_BOUNCES = 5;
+const int STAT_COUNT = 6;
+
+layout(std430, binding = 3) buffer RayStats { uint statCounters[]; };
+layout(r32f, binding = 1) uniform image2D uCostImage;
+
+uniform int uShowHeatmap;
+uniform float uHeatmapScale;  // Primitive tests per sample mapped to the top of the heatmap
+
+uint gStats[STAT_COUNT] = uint[STAT_COUNT](0u, 0u, 0u, 0u, 0u, 0u);
+
+#define STAT_ADD(index, n) gStats[index] += uint(n)
+
+void FlushStat(int index) {
+	uint value = gStats[index];
+	if (value == 0u)
+		return;
+	uint old = atomicAdd(statCounters[index * 2], value);
+	if (old + value < old)
+		atomicAdd(statCounters[index * 2 + 1], 1u);  // Carry
+}
+
+vec3 Heatmap(float t) {
+	t = clamp(t, 0.0, 1.0);
+	return clamp(vec3(1.5) - abs(4.0 * t - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);
+}
+#else
+#define STAT_ADD(index, n)
+#endif
 
 vec2 calculateEquirectangularUV(vec3 dir) {
 	dir = normalize(dir);
@@ -119,6 +300,10 @@ vec2 calculateEquirectangularUV(vec3 dir) {
 	return vec2(u, v);
 }
 
+float Luminance(vec3 colour) {
+	return dot(colour, vec3(0.2126, 0.7152, 0.0722));
+}
+
 // === RANDOMNESS ===
 
 // PCG (permuted congruential generator). Thanks to:
@@ -161,17 +346,17 @@ HitInfo RaySphereIntersect(Ray ray, Sphere sphere) {
     hit.dst = 1e20;
 	hit.hitType = HIT_TYPE_NONE;
 
+	// Ray directions are unit length, so with the half b form a = 1 and the factors of 2 and 4 cancel
 	vec3 oc = ray.origin - sphere.position;
-	float a = dot(ray.dir, ray.dir);
-	float b = 2.0 * dot(oc, ray.dir);
-	float c = dot(oc, oc) - sphere.radius * sphere.radius;
-	float discriminant = b * b - 4.0 * a * c;
+	float b = dot(oc, ray.dir);
+	float c = dot(oc, oc) - sphere.radiusSquared;
+	float discriminant = b * b - c;
 
 	if (discriminant >= 0.0) {
 		hit.hit = true;
-		hit.dst = (-b - sqrt(discriminant)) / (2.0 * a);
+		hit.dst = -b - sqrt(discriminant);
 		hit.hitPoint = ray.origin + ray.dir * hit.dst;
-		hit.normal = normalize(hit.hitPoint - sphere.position);
+		hit.normal = (hit.hitPoint - sphere.position) * sphere.inverseRadius;
 		hit.material = sphere.material;
 		hit.hitType = HIT_TYPE_SPHERE;
 	}
@@ -188,7 +373,7 @@ HitInfo RayPlaneIntersect(Ray ray, Plane plane) {
 	float denominator = dot(plane.normal, ray.dir);
 	if (denominator < 0.0) {
 		hit.hit = true;
-		hit.dst = dot(plane.normal, plane.position - ray.origin) / denominator;
+		hit.dst = (plane.offset - dot(plane.normal, ray.origin)) / denominator;
 		hit.hitPoint = ray.origin + ray.dir * hit.dst;
 		hit.normal = plane.normal;
 		hit.material = plane.material;
@@ -215,40 +400,176 @@ HitInfo RayQuadIntersect(Ray ray, Quad quad) {
 
 		vec3 localHitPoint =  hit.hitPoint - quad.position;
 
+		// The basis is orthonormal, so the projections are distances along the edges
 		float u = dot(localHitPoint, quad.right);
 		float v = dot(localHitPoint, quad.up);
 
-		float halfWidth = quad.width * 0.5;
-		float halfHeight = quad.height * 0.5;
-
-		if (u < -halfWidth || u > halfWidth || v < -halfHeight || v > halfHeight) 
+		if (abs(u) > quad.halfWidth || abs(v) > quad.halfHeight)
 			hit.hit = false;
 	}
 
 	return hit;
 }
 
+// Slab test in the box's frame. Only the hit face's material is read, boxes are large
+HitInfo RayBoxIntersect(Ray ray, int index) {
+	HitInfo hit;
+	hit.hit = false;
+	hit.dst = 1e20;
+	hit.hitType = HIT_TYPE_NONE;
+
+	vec3 offset = ray.origin - boxes[index].position;
+	mat3 basis = mat3(boxes[index].right, boxes[index].up, boxes[index].forward);
+	vec3 origin = offset * basis;
+	vec3 dir = ray.dir * basis;
+
+	vec3 invDir = 1.0 / dir;
+	vec3 t0 = (-boxes[index].halfSize - origin) * invDir;
+	vec3 t1 = (boxes[index].halfSize - origin) * invDir;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+	float entry = max(tMin.x, max(tMin.y, tMin.z));
+	float exit = min(tMax.x, min(tMax.y, tMax.z));
+	if (entry > exit)
+		return hit;
+
+	// Outward faces are seen where the ray enters, inward faces where it leaves. The face's outward normal
+	// points against the ray on entry and along it on exit
+	bool inward = boxes[index].inward != 0;
+	hit.dst = inward ? exit : entry;
+	vec3 tFace = inward ? tMax : tMin;
+	int axis = hit.dst == tFace.x ? 0 : (hit.dst == tFace.y ? 1 : 2);
+	float side = (dir[axis] < 0.0) == inward ? -1.0 : 1.0;
+
+	hit.hit = true;
+	hit.hitPoint = ray.origin + ray.dir * hit.dst;
+	hit.normal = basis[axis] * (inward ? -side : side);
+	hit.material = boxes[index].materials[axis * 2 + (side > 0.0 ? 1 : 0)];
+	hit.hitType = HIT_TYPE_BOX;
+	return hit;
+}
+
+HitInfo RayDiscIntersect(Ray ray, Disc disc) {
+	HitInfo hit;
+	hit.hit = false;
+	hit.dst = 1e20;
+	hit.hitType = HIT_TYPE_NONE;
+
+	float denominator = dot(disc.normal, ray.dir);
+	if (denominator < 0.0) {
+		hit.dst = dot(disc.normal, disc.position - ray.origin) / denominator;
+		hit.hitPoint = ray.origin + ray.dir * hit.dst;
+		vec3 local = hit.hitPoint - disc.position;
+		hit.hit = dot(local, local) <= disc.radiusSquared;
+		hit.normal = disc.normal;
+		hit.material = disc.material;
+		hit.hitType = HIT_TYPE_DISC;
+	}
+
+	return hit;
+}
+
+// The side where the ray enters it, or the cap facing the ray
+HitInfo RayCylinderIntersect(Ray ray, Cylinder cylinder) {
+	HitInfo hit;
+	hit.hit = false;
+	hit.dst = 1e20;
+	hit.hitType = HIT_TYPE_NONE;
+
+	vec3 offset = ray.origin - cylinder.position;
+	float offsetAlong = dot(offset, cylinder.axis);
+	float dirAlong = dot(ray.dir, cylinder.axis);
+	vec3 offsetAcross = offset - cylinder.axis * offsetAlong;
+	vec3 dirAcross = ray.dir - cylinder.axis * dirAlong;
+
+	float a = dot(dirAcross, dirAcross);
+	float b = dot(offsetAcross, dirAcross);
+	float c = dot(offsetAcross, offsetAcross) - cylinder.radiusSquared;
+	float discriminant = b * b - a * c;
+	if (a > 0.0 && discriminant >= 0.0) {
+		float t = (-b - sqrt(discriminant)) / a;
+		if (t > 0.0 && abs(offsetAlong + dirAlong * t) <= cylinder.halfHeight) {
+			hit.hit = true;
+			hit.dst = t;
+			hit.normal = (offsetAcross + dirAcross * t) / cylinder.radius;
+		}
+	}
+
+	// Only the cap facing the ray can be hit, and only where the side isn't
+	if (!hit.hit && dirAlong != 0.0) {
+		float side = dirAlong < 0.0 ? 1.0 : -1.0;
+		float t = (side * cylinder.halfHeight - offsetAlong) / dirAlong;
+		vec3 across = offsetAcross + dirAcross * t;
+		if (t > 0.0 && dot(across, across) <= cylinder.radiusSquared) {
+			hit.hit = true;
+			hit.dst = t;
+			hit.normal = cylinder.axis * side;
+		}
+	}
+
+	if (hit.hit) {
+		hit.hitPoint = ray.origin + ray.dir * hit.dst;
+		hit.material = cylinder.material;
+		hit.hitType = HIT_TYPE_CYLINDER;
+	}
+	return hit;
+}
+
 HitInfo CalculateRayCollision(Ray ray) {
 	HitInfo closestHit;
 	closestHit.hit = false;
 	closestHit.dst = 1e20;
+	closestHit.hitType = HIT_TYPE_NONE;
+	closestHit.index = -1;
+
+	STAT_ADD(STAT_PRIMITIVE_TESTS, uNumSpheres + uNumPlanes + uNumQuads + uNumBoxes + uNumDiscs + uNumCylinders);
 
 	for (int i = 0; i < uNumSpheres; ++i) {
 		HitInfo currentHit = RaySphereIntersect(ray, spheres[i]);
-		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst)
-			closestHit = currentHit;	
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
 	}
 	
 	for (int i = 0; i < uNumPlanes; ++i) {
 		HitInfo currentHit = RayPlaneIntersect(ray, planes[i]);
-		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst)
-			closestHit = currentHit;	
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
 	}
 	
 	for (int i = 0; i < uNumQuads; ++i) {
 		HitInfo currentHit = RayQuadIntersect(ray, _quads[i]);
-		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst)
-			closestHit = currentHit;	
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
+	}
+
+	for (int i = 0; i < uNumBoxes; ++i) {
+		HitInfo currentHit = RayBoxIntersect(ray, i);
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
+	}
+
+	for (int i = 0; i < uNumDiscs; ++i) {
+		HitInfo currentHit = RayDiscIntersect(ray, discs[i]);
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
+	}
+
+	for (int i = 0; i < uNumCylinders; ++i) {
+		HitInfo currentHit = RayCylinderIntersect(ray, cylinders[i]);
+		if (currentHit.hit && currentHit.dst > 0.0 && currentHit.dst < closestHit.dst) {
+			closestHit = currentHit;
+			closestHit.index = i;
+		}
 	}
 
 	if (closestHit.hitType == HIT_TYPE_SPHERE && closestHit.material.flag != 0)
@@ -259,7 +580,7 @@ HitInfo CalculateRayCollision(Ray ray) {
 
 // === SKYBOX / ENVIRONMENT ===
 
-vec3 GetEnvironmentLight(Ray ray) {
+vec3 GetEnvironmentLight(Ray ray, bool includeSun) {
 	vec3 environmentLight = vec3(0.0);
 
 	if (uHasSkybox == 1) {
@@ -267,7 +588,7 @@ vec3 GetEnvironmentLight(Ray ray) {
 		environmentLight = texture(uSkyboxTexture, uv).rgb * uSkyboxExposure;
 	}
 
-	if (uSunIntensity > 0.0 && uSunFocus > 0.0) {
+	if (includeSun && uSunIntensity > 0.0 && uSunFocus > 0.0) {
 		float sunDot = max(0.0, dot(ray.dir, uSunDirection));
 		float sunSpot = pow(sunDot, uSunFocus);
 		environmentLight += uSunColour * uSunIntensity * sunSpot;
@@ -276,6 +597,635 @@ vec3 GetEnvironmentLight(Ray ray) {
 	return environmentLight;
 }
 
+// === DIRECT LIGHTING (ReSTIR) ===
+
+#ifdef RT_RESTIR
+// Resampled importance sampling with spatiotemporal reuse, thanks to:
+// Bitterli et al. 2020, "Spatiotemporal reservoir resampling for real-time ray tracing with dynamic direct lighting"
+// and Lin et al. 2022, "Generalized resampled importance sampling" for the unbiased weights.
+// A light sample is a light index and two coordinates on it, so it stays valid for any shading point.
+// The target function is the unshadowed diffuse contribution without albedo, one shadow ray tests the final pick
+
+// Octahedral mapping between unit vectors and [-1, 1]^2
+vec2 OctEncode(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
+
+vec3 OctDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+vec3 TangentToWorld(vec3 v, vec3 axis) {
+	vec3 helper = abs(axis.x) > 0.9 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(helper, axis));
+	vec3 bitangent = cross(axis, tangent);
+	return v.x * tangent + v.y * bitangent + v.z * axis;
+}
+
+bool HasSunLight() {
+	return uSunIntensity > 0.0 && uSunFocus > 0.0;
+}
+
+// Emitters in the light list, their emission is sampled directly. Must agree with getEmittedPower in scene_resources.cpp
+bool IsSampledLight(HitInfo hit) {
+	int end = hit.hitType == HIT_TYPE_SPHERE ? uSampledLightEnds.x
+		: hit.hitType == HIT_TYPE_QUAD ? uSampledLightEnds.y
+		: hit.hitType == HIT_TYPE_DISC ? uSampledLightEnds.z : 0;
+	return hit.index < end && hit.material.emissionStrength > 0.0 && Luminance(hit.material.emissionColour) > 0.0;
+}
+
+// Shirley and Chiu's concentric map, area preserving from [-1, 1]^2 to the unit disc
+vec2 SquareToDisc(vec2 p) {
+	if (p == vec2(0.0))
+		return p;
+	if (abs(p.x) > abs(p.y))
+		return p.x * vec2(cos(PI * 0.25 * p.y / p.x), sin(PI * 0.25 * p.y / p.x));
+	return p.y * vec2(sin(PI * 0.25 * p.x / p.y), cos(PI * 0.25 * p.x / p.y));
+}
+
+struct LightPoint {
+	vec3 position;  // Direction towards the light for the sun
+	vec3 normal;
+	vec3 radiance;
+	bool isDirectional;
+};
+
+LightPoint GetLightPoint(uint light, vec2 coords) {
+	LightPoint point;
+	point.isDirectional = false;
+	point.radiance = vec3(0.0);
+
+	if (light == LIGHT_SUN) {
+		point.isDirectional = true;
+		point.position = OctDecode(coords);
+		point.normal = -point.position;
+		if (HasSunLight())
+			point.radiance = uSunColour * uSunIntensity * pow(max(0.0, dot(point.position, uSunDirection)), uSunFocus);
+		return point;
+	}
+
+	// Empty reservoirs keep index 0 even if there are no lights
+	if (light >= uint(uNumLights)) {
+		point.position = vec3(0.0);
+		point.normal = vec3(0.0, 1.0, 0.0);
+		return point;
+	}
+
+	Light entry = lights[light];
+	if (entry.type == LIGHT_SPHERE) {
+		Sphere sphere = spheres[entry.index];
+		point.normal = OctDecode(coords);
+		point.position = sphere.position + sphere.radius * point.normal;
+		point.radiance = sphere.material.emissionColour * sphere.material.emissionStrength;
+	} else if (entry.type == LIGHT_DISC) {
+		Disc disc = discs[entry.index];
+		vec2 p = SquareToDisc(coords) * disc.radius;
+		point.normal = disc.normal;
+		point.position = disc.position + TangentToWorld(vec3(p, 0.0), disc.normal);
+		point.radiance = disc.material.emissionColour * disc.material.emissionStrength;
+	} else {
+		Quad quad = _quads[entry.index];
+		point.normal = quad.normal;
+		point.position = quad.position + coords.x * quad.halfWidth * quad.right + coords.y * quad.halfHeight * quad.up;
+		point.radiance = quad.material.emissionColour * quad.material.emissionStrength;
+	}
+	return point;
+}
+
+// Light reaching a diffuse surface from the point, cosine and distance falloff included, shadows and albedo not.
+// Area lights are in area measure, the sun in solid angle
+vec3 GetUnshadowedLight(vec3 x, vec3 n, LightPoint point, out vec3 dir, out float dist) {
+	if (point.isDirectional) {
+		dir = point.position;
+		dist = 1e20;
+		return point.radiance * max(0.0, dot(n, dir));
+	}
+
+	vec3 offset = point.position - x;
+	float dist2 = max(dot(offset, offset), 1e-12);
+	dist = sqrt(dist2);
+	dir = offset / dist;
+
+	float cosLight = dot(point.normal, -dir);
+	if (cosLight <= 0.0)
+		return vec3(0.0);
+	return point.radiance * max(0.0, dot(n, dir)) * cosLight / dist2;
+}
+
+float TargetFunction(vec3 x, vec3 n, uint light, vec2 coords) {
+	vec3 dir;
+	float dist;
+	return Luminance(GetUnshadowedLight(x, n, GetLightPoint(light, coords), dir, dist));
+}
+
+// Picks a light in proportion to its power, or the sun, then a point on it. The pdf is in the same measure as
+// GetUnshadowedLight. False if the light can't reach x
+bool SampleLight(vec3 x, inout uint rngState, out uint light, out vec2 coords, out float pdf) {
+	light = 0u;
+	coords = vec2(0.0);
+	pdf = 0.0;
+
+	float sunProbability = HasSunLight() ? (uNumLights > 0 ? 0.5 : 1.0) : 0.0;
+	if (RandomValue(rngState) < sunProbability) {
+		// Directions around the sun in proportion to its cos^focus falloff
+		float cosTheta = pow(RandomValue(rngState), 1.0 / (uSunFocus + 1.0));
+		float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+		float phi = 2.0 * PI * RandomValue(rngState);
+		vec3 dir = TangentToWorld(vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta), uSunDirection);
+
+		light = LIGHT_SUN;
+		coords = OctEncode(dir);
+		pdf = sunProbability * (uSunFocus + 1.0) / (2.0 * PI) * pow(cosTheta, uSunFocus);
+		return pdf > 0.0;
+	}
+
+	if (uNumLights == 0)
+		return false;
+
+	// Binary search of the power CDF
+	float u = RandomValue(rngState);
+	int low = 0;
+	int high = uNumLights - 1;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (lights[middle].cdf < u)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	light = uint(low);
+	Light entry = lights[low];
+	float selection = (1.0 - sunProbability) * entry.probability;
+
+	if (entry.type == LIGHT_SPHERE) {
+		Sphere sphere = spheres[entry.index];
+		vec3 toCentre = sphere.position - x;
+		float dist2 = dot(toCentre, toCentre);
+		if (dist2 <= sphere.radiusSquared)
+			return false;
+
+		// Uniform over the cone of directions that hit the sphere, written to stay accurate for distant lights
+		float sin2Max = sphere.radiusSquared / dist2;
+		float oneMinusCosMax = sin2Max / (1.0 + sqrt(1.0 - sin2Max));
+		float cosTheta = 1.0 - RandomValue(rngState) * oneMinusCosMax;
+		float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+		float phi = 2.0 * PI * RandomValue(rngState);
+		vec3 dir = TangentToWorld(vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta), toCentre / sqrt(dist2));
+
+		vec3 oc = x - sphere.position;
+		float b = dot(oc, dir);
+		float t = max(-b - sqrt(max(b * b - dot(oc, oc) + sphere.radiusSquared, 0.0)), 0.0);
+		vec3 normal = normalize(x + dir * t - sphere.position);
+
+		// Solid angle pdf to area measure
+		float cosLight = max(dot(normal, -dir), 1e-6);
+		coords = OctEncode(normal);
+		pdf = selection * cosLight / (max(t * t, 1e-12) * 2.0 * PI * oneMinusCosMax);
+		return pdf > 0.0;
+	}
+
+	// Quads and discs are sampled uniformly by area
+	coords = vec2(RandomValue(rngState), RandomValue(rngState)) * 2.0 - 1.0;
+	if (entry.type == LIGHT_DISC) {
+		pdf = selection / (PI * discs[entry.index].radiusSquared);
+		return pdf > 0.0;
+	}
+
+	Quad quad = _quads[entry.index];
+	pdf = selection / (quad.width * quad.height);
+	return pdf > 0.0;
+}
+
+struct Reservoir {
+	uint light;
+	vec2 coords;
+	float weightSum;
+	float M;  // Candidates this reservoir stands for
+	float W;  // Contribution weight of the chosen sample, an estimate of 1 / pdf
+};
+
+Reservoir EmptyReservoir() {
+	Reservoir reservoir;
+	reservoir.light = 0u;
+	reservoir.coords = vec2(0.0);
+	reservoir.weightSum = 0.0;
+	reservoir.M = 0.0;
+	reservoir.W = 0.0;
+	return reservoir;
+}
+
+void UpdateReservoir(inout Reservoir reservoir, uint light, vec2 coords, float weight, float count, inout uint rngState) {
+	reservoir.weightSum += weight;
+	reservoir.M += count;
+	if (weight > 0.0 && RandomValue(rngState) * reservoir.weightSum <= weight) {
+		reservoir.light = light;
+		reservoir.coords = coords;
+	}
+}
+
+// False for pixels that stored no reservoir last frame
+bool LoadReservoir(ivec2 pixel, out Reservoir reservoir, out vec3 position, out vec3 normal) {
+	uvec4 sampleData = imageLoad(uPrevReservoirs, ivec3(pixel, 0));
+	uvec4 surfaceData = imageLoad(uPrevReservoirs, ivec3(pixel, 1));
+
+	reservoir.light = sampleData.x & 0xFFFFu;
+	reservoir.M = float(sampleData.x >> 16);
+	reservoir.coords = uintBitsToFloat(sampleData.yz);
+	reservoir.weightSum = 0.0;
+	reservoir.W = uintBitsToFloat(sampleData.w);
+	position = uintBitsToFloat(surfaceData.xyz);
+	normal = OctDecode(unpackSnorm2x16(surfaceData.w));
+	return reservoir.M > 0.0;
+}
+
+void StoreReservoir(ivec2 pixel, Reservoir reservoir, vec3 position, vec3 normal) {
+	uint count = uint(min(reservoir.M, 65535.0));
+	imageStore(uReservoirs, ivec3(pixel, 0), uvec4(reservoir.light | (count << 16), floatBitsToUint(reservoir.coords), floatBitsToUint(reservoir.W)));
+	imageStore(uReservoirs, ivec3(pixel, 1), uvec4(floatBitsToUint(position), packSnorm2x16(OctEncode(normal))));
+}
+
+const int MAX_REUSED_RESERVOIRS = 9;  // The new candidates, this pixel's last reservoir and up to 7 neighbours
+
+// New candidates for the surface at x, merged with last frame's reservoirs of this pixel and some neighbours.
+// Reused samples are weighted by the target at x, so reuse holds up when the camera moves
+Reservoir ResampleDirectLight(vec3 x, vec3 n, inout uint rngState) {
+	Reservoir candidates = EmptyReservoir();
+	for (uint i = 0u; i < uRestirCandidates; ++i) {
+		uint light;
+		vec2 coords;
+		float pdf;
+		float weight = 0.0;
+		if (SampleLight(x, rngState, light, coords, pdf))
+			weight = TargetFunction(x, n, light, coords) / pdf;
+		UpdateReservoir(candidates, light, coords, weight, 1.0, rngState);
+	}
+
+	float target = candidates.weightSum > 0.0 ? TargetFunction(x, n, candidates.light, candidates.coords) : 0.0;
+	candidates.W = target > 0.0 ? candidates.weightSum / (candidates.M * target) : 0.0;
+	if (uRestirHistory == 0)
+		return candidates;
+
+	// Inputs to merge: the new candidates, then last frame's reservoirs with the surfaces they were chosen for
+	uint sampleLights[MAX_REUSED_RESERVOIRS];
+	vec2 sampleCoords[MAX_REUSED_RESERVOIRS];
+	float sampleWeights[MAX_REUSED_RESERVOIRS];
+	vec3 positions[MAX_REUSED_RESERVOIRS];
+	vec3 normals[MAX_REUSED_RESERVOIRS];
+	float counts[MAX_REUSED_RESERVOIRS];
+
+	sampleLights[0] = candidates.light;
+	sampleCoords[0] = candidates.coords;
+	sampleWeights[0] = candidates.W;
+	positions[0] = x;
+	normals[0] = n;
+	counts[0] = candidates.M;
+	int inputs = 1;
+
+	float maxCount = float(uRestirMaxHistory * uRestirCandidates);
+	float viewDistance = distance(x, uCameraPosition);
+	int reused = min(int(uRestirSpatialSamples) + 1, MAX_REUSED_RESERVOIRS - 1);
+
+	for (int i = 0; i < reused; ++i) {
+		ivec2 pixel = gPixel;
+		if (i > 0) {
+			float angle = 2.0 * PI * RandomValue(rngState);
+			float radius = uRestirSpatialRadius * sqrt(RandomValue(rngState));
+			pixel += ivec2(round(vec2(cos(angle), sin(angle)) * radius));
+			pixel = clamp(pixel, ivec2(0), ivec2(uResolution) - 1);
+		}
+
+		Reservoir previous;
+		vec3 position;
+		vec3 normal;
+		if (!LoadReservoir(pixel, previous, position, normal))
+			continue;
+
+		// Samples rarely suit a different surface, skip those
+		if (dot(normal, n) < 0.9 || abs(distance(position, uCameraPosition) - viewDistance) > 0.1 * viewDistance)
+			continue;
+
+		sampleLights[inputs] = previous.light;
+		sampleCoords[inputs] = previous.coords;
+		sampleWeights[inputs] = previous.W;
+		positions[inputs] = position;
+		normals[inputs] = normal;
+		counts[inputs] = min(previous.M, maxCount);
+		inputs++;
+	}
+
+	Reservoir merged = EmptyReservoir();
+	for (int i = 0; i < inputs; ++i) {
+		float weight = 0.0;
+		if (sampleWeights[i] > 0.0) {
+			weight = TargetFunction(x, n, sampleLights[i], sampleCoords[i]) * sampleWeights[i];
+
+			// Biased: weight by sample count and divide by the total below, as if every surface could have
+			// produced every sample. Unbiased: balance heuristic over the surfaces that actually could
+			if (uRestirUnbiased == 1) {
+				float own = 0.0;
+				float total = 0.0;
+				for (int j = 0; j < inputs; ++j) {
+					float target = TargetFunction(positions[j], normals[j], sampleLights[i], sampleCoords[i]) * counts[j];
+					total += target;
+					if (j == i)
+						own = target;
+				}
+				weight *= total > 0.0 ? own / total : 0.0;
+			} else {
+				weight *= counts[i];
+			}
+		}
+		UpdateReservoir(merged, sampleLights[i], sampleCoords[i], weight, counts[i], rngState);
+	}
+
+	target = TargetFunction(x, n, merged.light, merged.coords);
+	float normalization = uRestirUnbiased == 1 ? 1.0 : merged.M;
+	merged.W = target > 0.0 ? merged.weightSum / (normalization * target) : 0.0;
+	return merged;
+}
+
+// Diffuse direct light from the reservoir's sample, without albedo
+vec3 ShadeDirectLight(vec3 x, vec3 n, Reservoir reservoir) {
+	if (reservoir.W <= 0.0)
+		return vec3(0.0);
+
+	vec3 dir;
+	float dist;
+	vec3 light = GetUnshadowedLight(x, n, GetLightPoint(reservoir.light, reservoir.coords), dir, dist);
+	if (light == vec3(0.0))
+		return vec3(0.0);
+
+	Ray shadowRay;
+	shadowRay.origin = x + n * 1e-4;
+	shadowRay.dir = dir;
+	HitInfo blocker = CalculateRayCollision(shadowRay);
+	if (blocker.hit && blocker.dst < dist * (1.0 - 1e-3) - 1e-4)
+		return vec3(0.0);
+
+	return light * reservoir.W / PI;
+}
+#endif
+
+// === PATH GUIDING ===
+
+#ifdef RT_GUIDING
+// "Practical path guiding for efficient light-transport simulation" (Mueller et al. 2017). Training adds each
+// vertex's radiance to the current tree with atomics, PathGuide refines the tree between iterations on the CPU.
+// Diffuse bounces pick the learned distribution or the cosine lobe and weight by the mixture's pdf
+
+// Cylindrical mapping between directions and [0, 1]^2, area preserving so a quadrant's solid angle is 4 pi / 4^depth
+vec2 GuideDirToSquare(vec3 dir) {
+	float phi = atan(dir.z, dir.x) / (2.0 * PI) + 0.5;
+	return clamp(vec2(dir.y * 0.5 + 0.5, phi), vec2(0.0), vec2(0.99999));
+}
+
+vec3 GuideSquareToDir(vec2 p) {
+	float cosTheta = p.x * 2.0 - 1.0;
+	float sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+	float phi = (p.y - 0.5) * 2.0 * PI;
+	return vec3(sinTheta * cos(phi), cosTheta, sinTheta * sin(phi));
+}
+
+// Spatial leaf containing position, surfaces outside the bounds use the nearest leaf. extent is the leaf's size
+// relative to the bounds
+uint GuideSpatialLeaf(uint tree, vec3 position, out vec3 extent) {
+	vec3 local = clamp((position - uGuideBoundsMin) / uGuideBoundsSize, vec3(0.0), vec3(0.99999));
+	extent = vec3(1.0);
+
+	uint node = 0u;
+	for (uint depth = 0u; depth < GUIDE_MAX_SPATIAL_DEPTH; depth++) {
+		uint firstChild = guideTrees[tree + GUIDE_HEADER_SIZE + node * 2u];
+		if (firstChild == 0u)
+			break;
+
+		uint axis = depth % 3u;
+		local[axis] *= 2.0;
+		extent[axis] *= 0.5;
+		uint child = local[axis] >= 1.0 ? 1u : 0u;
+		local[axis] -= float(child);
+		node = firstChild + child;
+	}
+	return node;
+}
+
+uint GuideQuadRoot(uint tree, uint leaf) {
+	return guideTrees[tree + GUIDE_HEADER_SIZE + leaf * 2u + 1u];
+}
+
+float GuideQuadrants(uint tree, uint node, out float sums[4]) {
+	uint first = tree + guideTrees[tree + 1u] + node * 4u;
+	float total = 0.0;
+	for (uint quadrant = 0u; quadrant < 4u; quadrant++) {
+		sums[quadrant] = uintBitsToFloat(guideTrees[first + quadrant]);
+		total += sums[quadrant];
+	}
+	return total;
+}
+
+uint GuideQuadChild(uint tree, uint node, uint quadrant) {
+	return guideTrees[tree + guideTrees[tree] + node * 4u + quadrant];
+}
+
+// Quadrants are picked in proportion to their radiance relative to the node's sum, so sampling and GuidePdf agree.
+// A node with no radiance at all stops the descent, its whole square is sampled uniformly
+float GuidePdf(uint tree, uint root, vec3 dir) {
+	vec2 p = GuideDirToSquare(dir);
+	float pdf = 1.0 / (4.0 * PI);
+
+	uint node = root;
+	for (uint depth = 0u; depth < GUIDE_MAX_DEPTH; depth++) {
+		float sums[4];
+		float total = GuideQuadrants(tree, node, sums);
+		if (!(total > 0.0))
+			break;
+		uvec2 side = uvec2(min(p * 2.0, vec2(1.0)));
+		uint quadrant = side.y * 2u + side.x;
+		if (!(sums[quadrant] > 0.0))
+			return 0.0;
+
+		pdf *= 4.0 * sums[quadrant] / total;
+		node = GuideQuadChild(tree, node, quadrant);
+		if (node == 0u)
+			break;
+		p = p * 2.0 - vec2(side);
+	}
+	return pdf;
+}
+
+// Descends to a leaf quadrant, then picks a uniform point in it
+vec3 SampleGuide(uint tree, uint root, inout uint rngState) {
+	vec2 origin = vec2(0.0);
+	float size = 1.0;
+
+	uint node = root;
+	for (uint depth = 0u; depth < GUIDE_MAX_DEPTH; depth++) {
+		float sums[4];
+		float total = GuideQuadrants(tree, node, sums);
+		if (!(total > 0.0))
+			break;
+		float target = RandomValue(rngState) * total;
+
+		uint quadrant = 0u;
+		for (; quadrant < 3u; quadrant++) {
+			if (target < sums[quadrant])
+				break;
+			target -= sums[quadrant];
+		}
+		// Rounding can run past the last quadrant with radiance. The total is positive, so one before it has some
+		while (quadrant > 0u && !(sums[quadrant] > 0.0))
+			quadrant--;
+
+		size *= 0.5;
+		origin += vec2(quadrant & 1u, quadrant >> 1u) * size;
+		node = GuideQuadChild(tree, node, quadrant);
+		if (node == 0u)
+			break;
+	}
+
+	return GuideSquareToDir(origin + vec2(RandomValue(rngState), RandomValue(rngState)) * size);
+}
+
+// Diffuse bounce from the guide/cosine mixture. Weight is the cosine lobe's pdf over the mixture's, false if the
+// direction is below the surface
+bool SampleGuidedDiffuse(vec3 position, vec3 normal, inout uint rngState, out vec3 dir, out float weight, out float pdf) {
+	vec3 extent;
+	uint root = GuideQuadRoot(uGuideSamplingTree, GuideSpatialLeaf(uGuideSamplingTree, position, extent));
+	float sums[4];
+	float mixing = uGuideMixing > 0.0 && GuideQuadrants(uGuideSamplingTree, root, sums) > 0.0 ? uGuideMixing : 0.0;
+
+	if (RandomValue(rngState) < mixing) {
+		dir = SampleGuide(uGuideSamplingTree, root, rngState);
+	}
+	else {
+		dir = normalize(normal + RandomUnitVector(rngState));
+		if (dot(dir, normal) < 0.0) dir = -dir;
+	}
+
+	float cosTheta = dot(dir, normal);
+	if (cosTheta <= 0.0)
+		return false;
+
+	float cosinePdf = cosTheta / PI;
+	pdf = mixing > 0.0 ? mixing * GuidePdf(uGuideSamplingTree, root, dir) + (1.0 - mixing) * cosinePdf : cosinePdf;
+	weight = mixing > 0.0 ? cosinePdf / pdf : 1.0;
+	return true;
+}
+
+// GLSL has no float atomics, retry until no other invocation wrote in between
+void AtomicAddGuide(uint index, float value) {
+	uint expected = guideTrees[index];
+	while (true) {
+		uint previous = atomicCompSwap(guideTrees[index], expected, floatBitsToUint(uintBitsToFloat(expected) + value));
+		if (previous == expected)
+			break;
+		expected = previous;
+	}
+}
+
+// Adds radiance arriving at position from dir, as an estimate over the sphere (radiance / pdf), to every quadrant
+// containing dir. Jittering the position by up to half its leaf spreads samples into neighbouring leaves, which
+// smooths the boundaries between them
+void TrainGuide(vec3 position, vec3 dir, float radiance, inout uint rngState) {
+	if (isnan(radiance) || isinf(radiance))
+		return;
+
+	uint tree = uGuideTrainingTree;
+	vec3 extent;
+	GuideSpatialLeaf(tree, position, extent);
+	vec3 jitter = (vec3(RandomValue(rngState), RandomValue(rngState), RandomValue(rngState)) - 0.5) * extent;
+	uint leaf = GuideSpatialLeaf(tree, position + jitter * uGuideBoundsSize, extent);
+
+	uint count = tree + guideTrees[tree + 2u] + leaf;
+	if (guideTrees[count] < GUIDE_MAX_SAMPLES)
+		atomicAdd(guideTrees[count], 1u);
+	if (radiance <= 0.0)
+		return;
+
+	vec2 p = GuideDirToSquare(dir);
+	uint sums = tree + guideTrees[tree + 1u];
+	uint node = GuideQuadRoot(tree, leaf);
+	for (uint depth = 0u; depth < GUIDE_MAX_DEPTH; depth++) {
+		uvec2 side = uvec2(min(p * 2.0, vec2(1.0)));
+		uint quadrant = side.y * 2u + side.x;
+		AtomicAddGuide(sums + node * 4u + quadrant, radiance);
+
+		node = GuideQuadChild(tree, node, quadrant);
+		if (node == 0u)
+			break;
+		p = p * 2.0 - vec2(side);
+	}
+}
+#endif
+
+// === RADIANCE CACHE ===
+
+#ifdef RT_CACHE
+// Keyed on world position and normal only, so entries stay put when the camera moves. The normal's dominant axis and
+// sign keep the two sides of a wall, and differently facing surfaces in one cell, from sharing light
+void GetCacheKey(vec3 position, vec3 normal, out uint slot, out uint checksum) {
+	ivec3 cell = ivec3(floor(position / uCacheCellSize));
+
+	vec3 a = abs(normal);
+	uint axis = a.x > a.y ? (a.x > a.z ? 0u : 2u) : (a.y > a.z ? 1u : 2u);
+	uint side = normal[axis] < 0.0 ? 1u : 0u;
+	uint face = (axis << 1u) | side;
+
+	uint hash = PCG_Hash(uint(cell.x) ^ PCG_Hash(uint(cell.y) ^ PCG_Hash(uint(cell.z) ^ PCG_Hash(face))));
+	slot = hash & (uCacheEntryCount - 1u);
+	checksum = max(PCG_Hash(hash ^ 0x9E3779B9u), 1u);
+}
+
+bool QueryRadianceCache(vec3 position, vec3 normal, out vec3 radiance) {
+	uint slot, checksum;
+	GetCacheKey(position, normal, slot, checksum);
+
+	for (uint i = 0u; i <= CACHE_PROBES; i++) {
+		uint base = ((slot + i) & (uCacheEntryCount - 1u)) * CACHE_ENTRY_SIZE;
+		uint stored = cache[base];
+		if (stored == 0u)
+			break;
+		if (stored == checksum) {
+			if (cache[base + 8u] < CACHE_MIN_SAMPLES)
+				break;
+			radiance = vec3(uintBitsToFloat(cache[base + 5u]), uintBitsToFloat(cache[base + 6u]), uintBitsToFloat(cache[base + 7u]));
+			return true;
+		}
+	}
+	return false;
+}
+
+// Claims the cell's entry on first use. Dropped if its slots are all taken by other cells
+void UpdateRadianceCache(vec3 position, vec3 normal, vec3 radiance, inout uint rngState) {
+	if (any(isnan(radiance)) || any(isinf(radiance)))
+		return;
+
+	uint slot, checksum;
+	GetCacheKey(position, normal, slot, checksum);
+
+	for (uint i = 0u; i <= CACHE_PROBES; i++) {
+		uint base = ((slot + i) & (uCacheEntryCount - 1u)) * CACHE_ENTRY_SIZE;
+		uint stored = atomicCompSwap(cache[base], 0u, checksum);
+		if (stored != 0u && stored != checksum)
+			continue;
+
+		// Rounded up at random, so dim light doesn't round away
+		vec3 scaled = clamp(radiance, vec3(0.0), vec3(CACHE_MAX_RADIANCE)) * CACHE_SCALE;
+		uvec3 fixedPoint = uvec3(scaled + vec3(RandomValue(rngState), RandomValue(rngState), RandomValue(rngState)));
+		atomicAdd(cache[base + 1u], fixedPoint.r);
+		atomicAdd(cache[base + 2u], fixedPoint.g);
+		atomicAdd(cache[base + 3u], fixedPoint.b);
+		atomicAdd(cache[base + 4u], 1u);
+		return;
+	}
+}
+#endif
+
 // === TRACE ===
 
 // Trace light-ray path (camera to light), accounting for reflections
@@ -283,11 +1233,39 @@ vec3 Trace(Ray ray, inout uint rngState) {
 	vec3 incomingLight = vec3(0.0);
 	vec3 rayColour = vec3(1.0);
 
+	bool terminated = false;
+	bool directLightSampled = false;  // The first hit sampled emitters and the sun, the next segment mustn't add them again
+
+#ifdef RT_GUIDING
+	// Diffuse vertices of this path, they learn the light that arrived through them once the path ends
+	vec3 guidePositions[MAX_GUIDE_VERTICES];
+	vec3 guideDirections[MAX_GUIDE_VERTICES];
+	vec3 guideThroughputs[MAX_GUIDE_VERTICES];  // Path weight after the bounce, divides out of what follows
+	vec3 guideLightBefore[MAX_GUIDE_VERTICES];
+	float guidePdfs[MAX_GUIDE_VERTICES];
+	uint guideVertices = 0u;
+	float guideScale = 1.0;  // Product of the guide weights in rayColour
+#endif
+
+#ifdef RT_CACHE
+	// Surfaces this path hit while training the cache, they learn the light that left them towards the path
+	vec3 cachePositions[MAX_CACHE_VERTICES];
+	vec3 cacheNormals[MAX_CACHE_VERTICES];
+	vec3 cacheThroughputs[MAX_CACHE_VERTICES];
+	vec3 cacheLightBefore[MAX_CACHE_VERTICES];
+	uint cacheVertices = 0u;
+#endif
+
 	for (uint i = 0; i < uMaxBounces; i++) {
 		HitInfo hit = CalculateRayCollision(ray);
+		STAT_ADD(STAT_BOUNCES, 1);
+
+		bool skipSampledLights = i == 1u && directLightSampled;
 
 		if (!hit.hit) {
-			incomingLight += GetEnvironmentLight(ray) * rayColour;
+			incomingLight += GetEnvironmentLight(ray, !skipSampledLights) * rayColour;
+			STAT_ADD(STAT_MISS, 1);
+			terminated = true;
 			break;
 		}
 		
@@ -309,31 +1287,120 @@ vec3 Trace(Ray ray, inout uint rngState) {
 			material.colour = isEvenSquare ? material.colour : material.emissionColour;
 		}
 		
+#ifdef RT_CACHE
+		// Emitters and mirrors aren't cached, the light leaving them depends on where they are seen from. Emitters also
+		// carry the lights that direct light sampling already added
+		vec3 cacheNormal = dot(ray.dir, hit.normal) < 0.0 ? hit.normal : -hit.normal;
+		if (material.emissionStrength <= 0.0 && material.specularProbability < 1.0) {
+			vec3 cached;
+			if (!gCacheUpdate && i >= uCacheTerminationBounce && QueryRadianceCache(hit.hitPoint, cacheNormal, cached)) {
+				incomingLight += cached * rayColour;
+				terminated = true;
+				break;
+			}
+			if (gCacheUpdate && cacheVertices < MAX_CACHE_VERTICES) {
+				cachePositions[cacheVertices] = hit.hitPoint;
+				cacheNormals[cacheVertices] = cacheNormal;
+				cacheThroughputs[cacheVertices] = rayColour;
+				cacheLightBefore[cacheVertices] = incomingLight;
+				cacheVertices++;
+			}
+		}
+#endif
+
 		// Accumulate light
+#ifdef RT_RESTIR
+		if (!(skipSampledLights && IsSampledLight(hit)))
+#endif
 		incomingLight += material.emissionColour * material.emissionStrength * rayColour;
 
 		// Calculate next ray
 		ray.origin = hit.hitPoint;
 
 		bool isSpecular = material.specularProbability >= RandomValue(rngState);
+
+#ifdef RT_RESTIR
+		// Direct light for the diffuse lobe of the first hit comes from the reservoir, the path only adds indirect light
+		if (i == 0u && material.specularProbability < 1.0) {
+			Reservoir reservoir = ResampleDirectLight(hit.hitPoint, hit.normal, rngState);
+			if (gStoreReservoir)
+				StoreReservoir(gPixel, reservoir, hit.hitPoint, hit.normal);
+
+			if (!isSpecular) {
+				incomingLight += ShadeDirectLight(hit.hitPoint, hit.normal, reservoir) * material.colour * rayColour;
+				directLightSampled = true;
+			}
+		}
+#endif
+
+#ifdef RT_GUIDING
+		float guidePdf = 0.0;
+#endif
 		if (isSpecular) {
 			vec3 specularDir = reflect(ray.dir, hit.normal);
 			ray.dir = normalize(specularDir + RandomUnitVector(rngState) * (1.0 - material.smoothness));
 			rayColour *= material.specularColour;
 		} else {
+#ifdef RT_GUIDING
+			float guideWeight;
+			if (!SampleGuidedDiffuse(hit.hitPoint, hit.normal, rngState, ray.dir, guideWeight, guidePdf)) {
+				terminated = true;
+				break;
+			}
+			rayColour *= material.colour * guideWeight;
+			guideScale *= guideWeight;
+#else
 			vec3 diffuseDir = normalize(hit.normal + RandomUnitVector(rngState));
 			if (dot(diffuseDir, hit.normal) < 0.0) diffuseDir = -diffuseDir;
 				ray.dir = diffuseDir;
 			rayColour *= material.colour;
+#endif
 		}
 
 		// "Russian roulette" to exit early if rayColour is nearly 0 (little contribution)
 		float p = max(rayColour.r, max(rayColour.g, rayColour.b));
-		if (RandomValue(rngState) >= p)
+#ifdef RT_GUIDING
+		// Guided paths towards bright light have small weights, yet they are the ones that matter. Roulette on the
+		// throughput cosine sampling would have given
+		p /= guideScale;
+#endif
+		p = min(p, 1.0);
+		if (RandomValue(rngState) >= p) {
+			STAT_ADD(STAT_ROULETTE, 1);
+			terminated = true;
 			break;
+		}
 		rayColour /= p;
+
+#ifdef RT_GUIDING
+		if (!isSpecular && uGuideTraining == 1 && guideVertices < MAX_GUIDE_VERTICES) {
+			guidePositions[guideVertices] = hit.hitPoint;
+			guideDirections[guideVertices] = ray.dir;
+			guideThroughputs[guideVertices] = rayColour;
+			guideLightBefore[guideVertices] = incomingLight;
+			guidePdfs[guideVertices] = guidePdf;
+			guideVertices++;
+		}
+#endif
 	}
 
+	if (!terminated)
+		STAT_ADD(STAT_MAX_BOUNCES, 1);
+
+#ifdef RT_GUIDING
+	for (uint v = 0u; v < guideVertices; v++) {
+		vec3 radiance = (incomingLight - guideLightBefore[v]) / max(guideThroughputs[v], vec3(1e-6));
+		TrainGuide(guidePositions[v], guideDirections[v], Luminance(radiance) / guidePdfs[v], rngState);
+	}
+#endif
+
+#ifdef RT_CACHE
+	for (uint v = 0u; v < cacheVertices; v++) {
+		vec3 radiance = (incomingLight - cacheLightBefore[v]) / max(cacheThroughputs[v], vec3(1e-6));
+		UpdateRadianceCache(cachePositions[v], cacheNormals[v], radiance, rngState);
+	}
+#endif
+
 	return incomingLight;
 }
 
@@ -341,9 +1408,19 @@ void main() {
 	// RNG seed
 	ivec2 pixelCoords = ivec2(gl_FragCoord.xy);
 	uint pixelIndex = uint(pixelCoords.y) * uint(uResolution.x) + uint(pixelCoords.x);
-    uint rngState = pixelIndex + uFrame * 719393u;
+	// Hashed rather than a linear mix of pixel and frame, which repeats a neighbouring frame's seeds once the image has
+	// more pixels than the frame multiplier. Workers of a distributed render draw from far apart frame streams
+	uint rngState = PCG_Hash(pixelIndex ^ PCG_Hash(uFrame + uFrameOffset));
 	
 	vec3 frameSampleAccumulator = vec3(0.0);
+	float frameSecondMoment = 0.0;  // Sum of squared sample luminance, for noise estimation
+
+#ifdef RT_RESTIR
+	// Cleared first, so pixels whose first sample hits nothing diffuse offer nothing to their neighbours
+	gPixel = pixelCoords;
+	imageStore(uReservoirs, ivec3(pixelCoords, 0), uvec4(0u));
+	imageStore(uReservoirs, ivec3(pixelCoords, 1), uvec4(0u));
+#endif
 
 	for (uint s = 0; s < uSamplesPerPixel; ++s) {        
 		uint sampleRngState = PCG_Hash(rngState + s * 131071u);
@@ -357,26 +1434,49 @@ void main() {
 		ray.origin = uCameraPosition;
 		ray.dir = normalize(uCameraForward + jitteredUV.x * uCameraRight + jitteredUV.y * uCameraUp);
 
+#ifdef RT_RESTIR
+		gStoreReservoir = s == 0u;
+#endif
+#ifdef RT_CACHE
+		gCacheUpdate = RandomValue(sampleRngState) < uCacheUpdateFraction;
+#endif
 		vec3 incomingLight = Trace(ray, sampleRngState);
+		STAT_ADD(STAT_RAYS, 1);
 
 		frameSampleAccumulator += incomingLight;
+
+		float luminance = dot(incomingLight, vec3(0.2126, 0.7152, 0.0722));
+		frameSecondMoment += luminance * luminance;
 	}
 	
-    vec3 currentFrameColour = frameSampleAccumulator / float(uSamplesPerPixel);
-
-    // Accumulation (progressive rendering)
+    // Accumulation (progressive rendering) weighted by sample count, alpha holds the mean squared luminance
     vec3 finalAccumulated;
+    float finalSecondMoment;
     if (uFrame == 1) {
-        finalAccumulated = currentFrameColour;
+        finalAccumulated = frameSampleAccumulator / float(uSamplesPerPixel);
+        finalSecondMoment = frameSecondMoment / float(uSamplesPerPixel);
     } else {
         vec4 prevAccumulated = imageLoad(uAccumulatedImage, pixelCoords);
-        finalAccumulated = (prevAccumulated.rgb * float(uFrame - 1) + currentFrameColour) / float(uFrame);
+        float totalSamples = uSampleCount + float(uSamplesPerPixel);
+        finalAccumulated = (prevAccumulated.rgb * uSampleCount + frameSampleAccumulator) / totalSamples;
+        finalSecondMoment = (prevAccumulated.a * uSampleCount + frameSecondMoment) / totalSamples;
     }
 
-    imageStore(uAccumulatedImage, pixelCoords, vec4(finalAccumulated, 1.0));
+    imageStore(uAccumulatedImage, pixelCoords, vec4(finalAccumulated, finalSecondMoment));
     
     // Gamma Correction
     finalAccumulated = pow(finalAccumulated, vec3(1.0 / uGamma));
 
     FragColour = vec4(finalAccumulated, 1.0);
+
+#ifdef RT_STATS
+	for (int i = 0; i < STAT_COUNT; ++i)
+		FlushStat(i);
+
+	float cost = float(gStats[STAT_PRIMITIVE_TESTS]) / float(uSamplesPerPixel);
+	imageStore(uCostImage, pixelCoords, vec4(cost, 0.0, 0.0, 0.0));
+
+	if (uShowHeatmap == 1)
+		FragColour.rgb = mix(FragColour.rgb, Heatmap(cost / uHeatmapScale), 0.75);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#version 440 core
+
+// Folds each frame's radiance cache updates into the cached radiance, one invocation per entry. See the RADIANCE
+// CACHE section of fragment.glsl for the entry layout
+
+layout(local_size_x = 64) in;
+
+const uint CACHE_ENTRY_SIZE = 10u;  // Must match fragment.glsl
+const float CACHE_SCALE = 256.0;
+
+layout(std430, binding = 6) buffer RadianceCache { uint cache[]; };
+
+uniform uint uEntryCount;
+uniform uint uMaxSamples;  // Older samples fade out once an entry holds this many, so it follows changing light
+uniform uint uMaxAge;      // Frames without updates before an entry is freed
+
+void main() {
+	uint entry = gl_GlobalInvocationID.x;
+	if (entry >= uEntryCount)
+		return;
+
+	uint base = entry * CACHE_ENTRY_SIZE;
+	if (cache[base] == 0u)
+		return;
+
+	uint count = cache[base + 4u];
+	if (count == 0u) {
+		uint age = cache[base + 9u] + 1u;
+		cache[base + 9u] = age;
+		if (age > uMaxAge) {
+			for (uint i = 0u; i < CACHE_ENTRY_SIZE; i++)
+				cache[base + i] = 0u;
+		}
+		return;
+	}
+
+	vec3 sum = vec3(cache[base + 1u], cache[base + 2u], cache[base + 3u]) / CACHE_SCALE;
+	vec3 radiance = vec3(uintBitsToFloat(cache[base + 5u]), uintBitsToFloat(cache[base + 6u]), uintBitsToFloat(cache[base + 7u]));
+	uint samples = cache[base + 8u];
+
+	radiance = (radiance * float(samples) + sum) / float(samples + count);
+	cache[base + 5u] = floatBitsToUint(radiance.r);
+	cache[base + 6u] = floatBitsToUint(radiance.g);
+	cache[base + 7u] = floatBitsToUint(radiance.b);
+	cache[base + 8u] = min(samples + count, uMaxSamples);
+	cache[base + 9u] = 0u;
+
+	for (uint i = 1u; i <= 4u; i++)
+		cache[base + i] = 0u;
+}
\ No newline at end of file
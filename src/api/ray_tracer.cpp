@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "api/ray_tracer.hpp"
+#include "camera/camera.hpp"
+#include "renderer/checkpoint.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_compiler.hpp"
+#include "scene/scene_diff.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/gl_context.hpp"
+#include "utils/image.hpp"
+#include "utils/shader.hpp"
+
+std::unique_ptr<RayTracer> RayTracer::create(const RayTracerSettings& settings) {
+    std::unique_ptr<RayTracer> tracer(new RayTracer());
+    tracer->m_samplesPerFrame = std::max(settings.samplesPerFrame, 1u);
+
+    if (settings.createContext) {
+        tracer->m_context = createHeadlessContext(settings.width, settings.height);
+        if (!tracer->m_context)
+            return nullptr;
+    }
+    else if (settings.getProcAddress) {
+        if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(settings.getProcAddress))) {
+            std::cerr << "Error (RayTracer): Failed to load GL functions" << std::endl;
+            return nullptr;
+        }
+    }
+
+    if (!glCreateProgram) {
+        std::cerr << "Error (RayTracer): No GL context, set createContext or getProcAddress" << std::endl;
+        return nullptr;
+    }
+
+    setShaderDirectory(settings.shaderDirectory);
+
+    tracer->m_scene = std::make_unique<Scene>();
+    tracer->m_renderer = std::make_unique<Renderer>(settings.width, settings.height);
+    if (!tracer->m_renderer->getResources().getProgram(false)) {
+        std::cerr << "Error (RayTracer): Failed to build the shaders in " << settings.shaderDirectory << std::endl;
+        return nullptr;
+    }
+
+    return tracer;
+}
+
+RayTracer::~RayTracer() {
+    // GL objects go before the context that owns them
+    makeCurrent();
+    m_renderer.reset();
+    if (m_context)
+        destroyHeadlessContext(m_context);
+}
+
+void RayTracer::makeCurrent() {
+    // Several tracers can live in one process, each with its own context
+    if (m_context && glfwGetCurrentContext() != m_context)
+        glfwMakeContextCurrent(m_context);
+}
+
+bool RayTracer::loadScene(const std::string& filepath) {
+    Scene scene;
+    if (!SceneLoader::loadScene(filepath, scene))
+        return false;
+
+    setScene(scene);
+    return true;
+}
+
+void RayTracer::setScene(const Scene& scene) {
+    makeCurrent();
+    *m_scene = scene;
+    SceneCompiler::compile(*m_scene);  // Scenes built in code haven't been through the loader
+    m_renderer->loadScene(*m_scene);
+}
+
+void RayTracer::updateScene(const Scene& scene) {
+    makeCurrent();
+    Scene compiled = scene;
+    SceneCompiler::compile(compiled);
+
+    SceneChanges changes = SceneDiff::compare(*m_scene, compiled);
+    *m_scene = std::move(compiled);
+    m_renderer->updateScene(*m_scene, changes);
+}
+
+void RayTracer::updateScene(const Scene& scene, const SceneChanges& changes) {
+    makeCurrent();
+    *m_scene = scene;
+    m_renderer->updateScene(*m_scene, changes);
+}
+
+void RayTracer::editScene(const std::function<void(Scene&)>& edit, const SceneChanges& changes) {
+    makeCurrent();
+    edit(*m_scene);
+    m_renderer->updateScene(*m_scene, changes);
+}
+
+const Scene& RayTracer::getScene() const {
+    return *m_scene;
+}
+
+void RayTracer::setCamera(const Camera& camera) {
+    m_scene->camera = camera;
+}
+
+void RayTracer::setResolution(uint32_t width, uint32_t height) {
+    makeCurrent();
+    m_renderer->onResize(width, height);
+}
+
+uint64_t RayTracer::render(uint32_t samples) {
+    makeCurrent();
+
+    // A new camera or scene restarts accumulation on the first dispatch, the total then only counts these
+    uint32_t rendered = 0;
+    while (rendered < samples) {
+        uint32_t dispatch = std::min(samples - rendered, m_samplesPerFrame);
+        m_renderer->setSamplesPerPixel(dispatch);
+        if (!m_renderer->render(m_scene->camera))
+            break;
+        rendered += dispatch;
+    }
+
+    return m_renderer->getSampleCount();
+}
+
+uint64_t RayTracer::getSampleCount() const {
+    return m_renderer->getSampleCount();
+}
+
+uint32_t RayTracer::getWidth() const {
+    return m_renderer->getWidth();
+}
+
+uint32_t RayTracer::getHeight() const {
+    return m_renderer->getHeight();
+}
+
+void RayTracer::readPixels(std::vector<float>& rgb) {
+    makeCurrent();
+
+    std::vector<float> rgba;
+    m_renderer->readAccumulation(rgba);
+
+    // GL rows are bottom-up and alpha holds the second moment, keep the colour only
+    uint32_t width = m_renderer->getWidth();
+    uint32_t height = m_renderer->getHeight();
+    rgb.resize(static_cast<size_t>(width) * height * 3);
+    for (uint32_t y = 0; y < height; ++y) {
+        const float* source = &rgba[static_cast<size_t>(height - 1 - y) * width * 4];
+        float* destination = &rgb[static_cast<size_t>(y) * width * 3];
+        for (uint32_t x = 0; x < width; ++x) {
+            destination[x * 3 + 0] = source[x * 4 + 0];
+            destination[x * 3 + 1] = source[x * 4 + 1];
+            destination[x * 3 + 2] = source[x * 4 + 2];
+        }
+    }
+}
+
+bool RayTracer::saveImage(const std::string& filepath) {
+    makeCurrent();
+
+    std::vector<float> rgba;
+    m_renderer->readAccumulation(rgba);
+    return saveFloatImage(filepath, rgba.data(), static_cast<int>(m_renderer->getWidth()), static_cast<int>(m_renderer->getHeight()), m_scene->gamma);
+}
+
+Task<bool> RayTracer::saveImageAsync(const std::string& filepath) {
+    makeCurrent();
+
+    auto rgba = std::make_shared<std::vector<float>>();
+    m_renderer->readAccumulation(*rgba);
+    int width = static_cast<int>(m_renderer->getWidth());
+    int height = static_cast<int>(m_renderer->getHeight());
+    float gamma = m_scene->gamma;
+    return JobSystem::get().run([filepath, rgba, width, height, gamma]() {
+        return saveFloatImage(filepath, rgba->data(), width, height, gamma);
+    });
+}
+
+bool RayTracer::saveCheckpoint(const std::string& filepath) {
+    makeCurrent();
+
+    RenderCheckpoint checkpoint;
+    m_renderer->captureCheckpoint(m_scene->camera, checkpoint);
+    checkpoint.settingsHash = getSettingsHash();
+    return Checkpoint::save(filepath, checkpoint);
+}
+
+bool RayTracer::resumeCheckpoint(const std::string& filepath) {
+    RenderCheckpoint checkpoint;
+    if (!Checkpoint::load(filepath, checkpoint, m_renderer->getWidth(), m_renderer->getHeight()))
+        return false;
+
+    if (checkpoint.settingsHash != getSettingsHash()) {
+        std::cerr << "Error (RayTracer): " << filepath << " was rendered with a different scene, settings or resolution" << std::endl;
+        return false;
+    }
+
+    makeCurrent();
+    if (!m_renderer->restoreCheckpoint(checkpoint))
+        return false;
+    m_scene->camera = Checkpoint::getCamera(checkpoint);
+    return true;
+}
+
+uint64_t RayTracer::getSettingsHash() const {
+    return Checkpoint::hashSettings(*m_scene, m_renderer->getResources().getSkyboxFormat(), m_renderer->getRestir(),
+        m_renderer->getGuiding(), m_renderer->getRadianceCache(), m_renderer->getWidth(), m_renderer->getHeight());
+}
+
+Renderer& RayTracer::getRenderer() {
+    return *m_renderer;
+}
\ No newline at end of file
@@ -19,4 +19,8 @@ void Camera::updateOrientation() {
 
     right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
     up = glm::normalize(glm::cross(right, forward));
+}
+
+glm::vec3 Camera::getRayDirection(float x, float y, float aspectRatio) const {
+    return glm::normalize(forward + x * aspectRatio * right + y * up);
 }
\ No newline at end of file
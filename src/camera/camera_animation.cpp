@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cmath>
+
+#include "camera/camera_animation.hpp"
+
+template <typename T>
+static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+bool CameraTrack::isEmpty() const {
+    return keyframes.empty();
+}
+
+float CameraTrack::getDuration() const {
+    if (duration > 0.0f)
+        return duration;
+    return keyframes.empty() ? 0.0f : keyframes.back().time;
+}
+
+uint32_t CameraTrack::getFrameCount() const {
+    if (keyframes.empty())
+        return 0;
+    return static_cast<uint32_t>(std::floor(getDuration() * fps)) + 1;
+}
+
+Camera CameraTrack::evaluate(float time) const {
+    Camera camera;
+    if (keyframes.empty())
+        return camera;
+
+    // Find the segment [i, i + 1] containing time, clamping outside the track
+    size_t i = 0;
+    float t = 0.0f;
+    if (time <= keyframes.front().time || keyframes.size() == 1) {
+        i = 0;
+    }
+    else if (time >= keyframes.back().time) {
+        i = keyframes.size() - 2;
+        t = 1.0f;
+    }
+    else {
+        auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+            [](float value, const CameraKeyframe& key) { return value < key.time; });
+        i = static_cast<size_t>(next - keyframes.begin()) - 1;
+        float span = keyframes[i + 1].time - keyframes[i].time;
+        t = span > 0.0f ? (time - keyframes[i].time) / span : 0.0f;
+    }
+
+    const CameraKeyframe& k1 = keyframes[i];
+    const CameraKeyframe& k2 = keyframes[std::min(i + 1, keyframes.size() - 1)];
+
+    if (interpolation == CameraInterpolation::Smooth) {
+        const CameraKeyframe& k0 = keyframes[i > 0 ? i - 1 : i];
+        const CameraKeyframe& k3 = keyframes[std::min(i + 2, keyframes.size() - 1)];
+        camera.position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+        camera.yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+        camera.pitch = catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    }
+    else {
+        camera.position = k1.position + (k2.position - k1.position) * t;
+        camera.yaw = k1.yaw + (k2.yaw - k1.yaw) * t;
+        camera.pitch = k1.pitch + (k2.pitch - k1.pitch) * t;
+    }
+
+    camera.pitch = std::clamp(camera.pitch, -89.0f, 89.0f);
+    camera.updateOrientation();
+    return camera;
+}
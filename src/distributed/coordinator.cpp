@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "distributed/coordinator.hpp"
+#include "distributed/protocol.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/image.hpp"
+
+namespace Distributed {
+    Coordinator::Coordinator(const CoordinatorSettings& settings)
+        : m_settings(settings) {}
+
+    Coordinator::~Coordinator() {
+        stopWorkers();
+    }
+
+    bool Coordinator::run() {
+        // Only tracing settings are needed here, workers load the scene themselves
+        Scene scene;
+        if (!SceneLoader::loadScene(m_settings.scenePath, scene))
+            return false;
+        m_gamma = scene.gamma;
+        if (m_settings.samplesPerPixel == 0)
+            m_settings.samplesPerPixel = static_cast<uint32_t>(scene.samplesPerPixel);
+
+        Socket listener = Socket::listen(m_settings.port, m_settings.bindAddress);
+        if (!listener.isValid())
+            return false;
+
+        std::cout << "Coordinator listening on " << m_settings.bindAddress << ":" << m_settings.port << ", target " << m_settings.targetSamples << " spp" << std::endl;
+
+        auto lastReport = std::chrono::steady_clock::now();
+        while (!m_finished) {
+            if (listener.waitReadable(100))
+                acceptWorker(listener.accept());
+
+            uint64_t totalSamples = getTotalSamples();
+            if (totalSamples >= m_settings.targetSamples)
+                m_finished = true;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport > std::chrono::seconds(1) || m_finished) {
+                lastReport = now;
+
+                size_t connected = 0;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    for (const auto& worker : m_workers)
+                        connected += worker->connected ? 1 : 0;
+                }
+                std::cout << "Samples: " << totalSamples << "/" << m_settings.targetSamples << " (" << connected << " workers)" << std::endl;
+            }
+        }
+
+        stopWorkers();
+
+        std::vector<float> merged;
+        uint64_t mergedSamples = mergeBuffers(merged);
+        if (mergedSamples == 0) {
+            std::cerr << "Error (Coordinator): No samples received from workers" << std::endl;
+            return false;
+        }
+
+        std::cout << "Merged " << mergedSamples << " samples per pixel" << std::endl;
+        return saveFloatImage(m_settings.outputPath, merged.data(), (int)m_settings.width, (int)m_settings.height, m_gamma);
+    }
+
+    void Coordinator::acceptWorker(Socket socket) {
+        if (!socket.isValid())
+            return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_nextWorkerId >= MAX_WORKERS) {
+            std::cerr << "Error (Coordinator): Out of frame streams, refusing worker" << std::endl;
+            return;
+        }
+
+        auto worker = std::make_unique<WorkerState>();
+        worker->id = m_nextWorkerId++;
+        worker->socket = std::move(socket);
+
+        WorkerState* state = worker.get();
+        worker->thread = std::thread(&Coordinator::serviceWorker, this, state);
+        m_workers.push_back(std::move(worker));
+    }
+
+    void Coordinator::serviceWorker(WorkerState* worker) {
+        MessageHeader header;
+        std::vector<char> payload;
+
+        // Handshake: HELLO -> JOB
+        if (!receiveMessage(worker->socket, header, payload, MAX_CONTROL_PAYLOAD) || header.type != MSG_HELLO) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            worker->connected = false;
+            return;
+        }
+
+        JobMessage job = {};
+        job.workerId = worker->id;
+        job.frameOffset = worker->id * FRAME_OFFSET_STRIDE;
+        job.width = m_settings.width;
+        job.height = m_settings.height;
+        job.samplesPerPixel = m_settings.samplesPerPixel;
+        job.reportInterval = m_settings.reportInterval;
+
+        if (!sendMessage(worker->socket, MSG_JOB, &job, sizeof(job), m_settings.scenePath.data(), m_settings.scenePath.size())) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            worker->connected = false;
+            return;
+        }
+
+        std::cout << "Worker " << worker->id << " joined" << std::endl;
+
+        const size_t expectedFloats = static_cast<size_t>(m_settings.width) * m_settings.height * 4;
+        const uint64_t maxPayload = std::max<uint64_t>(sizeof(ResultMessage) + expectedFloats * sizeof(float), MAX_CONTROL_PAYLOAD);
+        while (receiveMessage(worker->socket, header, payload, maxPayload)) {
+            if (header.type != MSG_RESULT || payload.size() != sizeof(ResultMessage) + expectedFloats * sizeof(float))
+                continue;
+
+            ResultMessage result;
+            std::memcpy(&result, payload.data(), sizeof(result));
+            if (result.width != m_settings.width || result.height != m_settings.height)
+                continue;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            worker->buffer.resize(expectedFloats);
+            std::memcpy(worker->buffer.data(), payload.data() + sizeof(result), expectedFloats * sizeof(float));
+            worker->sampleCount = result.sampleCount;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        worker->connected = false;
+        if (!m_finished)
+            std::cout << "Worker " << worker->id << " left with " << worker->sampleCount << " samples" << std::endl;
+    }
+
+    uint64_t Coordinator::getTotalSamples() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t total = 0;
+        for (const auto& worker : m_workers)
+            total += worker->sampleCount;
+        return total;
+    }
+
+    uint64_t Coordinator::mergeBuffers(std::vector<float>& merged) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const size_t count = static_cast<size_t>(m_settings.width) * m_settings.height * 4;
+        std::vector<double> sum(count, 0.0);
+        uint64_t totalSamples = 0;
+
+        // Each buffer is a mean over its own samples, weight by sample count
+        for (const auto& worker : m_workers) {
+            if (worker->sampleCount == 0 || worker->buffer.size() != count)
+                continue;
+
+            double weight = static_cast<double>(worker->sampleCount);
+            for (size_t i = 0; i < count; ++i)
+                sum[i] += worker->buffer[i] * weight;
+            totalSamples += worker->sampleCount;
+        }
+
+        merged.resize(count);
+        double invTotal = totalSamples > 0 ? 1.0 / static_cast<double>(totalSamples) : 0.0;
+        for (size_t i = 0; i < count; ++i)
+            merged[i] = static_cast<float>(sum[i] * invTotal);
+
+        return totalSamples;
+    }
+
+    void Coordinator::stopWorkers() {
+        m_finished = true;
+
+        // Sends can block on a slow worker, so they happen after the lock is released. Workers are never removed,
+        // the pointers stay valid
+        std::vector<WorkerState*> connected;
+        std::vector<WorkerState*> workers;
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& worker : m_workers) {
+                if (worker->connected)
+                    connected.push_back(worker.get());
+                workers.push_back(worker.get());
+                if (worker->thread.joinable())
+                    threads.push_back(std::move(worker->thread));
+            }
+        }
+
+        for (WorkerState* worker : connected)
+            sendMessage(worker->socket, MSG_STOP);
+        for (WorkerState* worker : workers)
+            worker->socket.shutdown();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    int runCoordinator(const CoordinatorSettings& settings) {
+        if (!Net::initialise())
+            return EXIT_FAILURE;
+
+        bool success;
+        {
+            Coordinator coordinator(settings);
+            success = coordinator.run();
+        }
+
+        Net::shutdown();
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
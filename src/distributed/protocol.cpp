@@ -0,0 +1,39 @@
+#include <iostream>
+
+#include "distributed/protocol.hpp"
+
+namespace Distributed {
+    bool sendMessage(Socket& socket, MessageType type, const void* payload, uint64_t payloadSize) {
+        return sendMessage(socket, type, payload, payloadSize, nullptr, 0);
+    }
+
+    bool sendMessage(Socket& socket, MessageType type, const void* head, uint64_t headSize, const void* body, uint64_t bodySize) {
+        MessageHeader header = { MESSAGE_MAGIC, type, headSize + bodySize };
+        if (!socket.sendAll(&header, sizeof(header)))
+            return false;
+        if (headSize > 0 && !socket.sendAll(head, headSize))
+            return false;
+        if (bodySize > 0 && !socket.sendAll(body, bodySize))
+            return false;
+        return true;
+    }
+
+    bool receiveMessage(Socket& socket, MessageHeader& header, std::vector<char>& payload, uint64_t maxPayloadSize) {
+        if (!socket.recvAll(&header, sizeof(header)))
+            return false;
+
+        if (header.magic != MESSAGE_MAGIC) {
+            std::cerr << "Error (Distributed): Invalid message header" << std::endl;
+            return false;
+        }
+
+        if (header.payloadSize > maxPayloadSize) {
+            std::cerr << "Error (Distributed): Message payload of " << header.payloadSize << " bytes exceeds the limit of "
+                << maxPayloadSize << std::endl;
+            return false;
+        }
+
+        payload.resize(header.payloadSize);
+        return header.payloadSize == 0 || socket.recvAll(payload.data(), payload.size());
+    }
+}
@@ -0,0 +1,99 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "distributed/protocol.hpp"
+#include "distributed/worker.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "utils/gl_context.hpp"
+
+namespace Distributed {
+    static bool sendResult(Socket& socket, Renderer& renderer, std::vector<float>& pixels) {
+        renderer.readAccumulation(pixels);
+
+        ResultMessage result = {};
+        result.width = renderer.getWidth();
+        result.height = renderer.getHeight();
+        result.sampleCount = renderer.getSampleCount();
+
+        return sendMessage(socket, MSG_RESULT, &result, sizeof(result), pixels.data(), pixels.size() * sizeof(float));
+    }
+
+    static bool renderJob(Socket& socket, const JobMessage& job, const std::string& scenePath) {
+        Scene scene;
+        if (!SceneLoader::loadScene(scenePath, scene))
+            return false;
+
+        Renderer renderer(job.width, job.height);
+        renderer.loadScene(scene);
+        renderer.setSamplesPerPixel(job.samplesPerPixel);
+        renderer.setFrameOffset(job.frameOffset);
+
+        uint32_t reportInterval = job.reportInterval > 0 ? job.reportInterval : 1;
+        std::vector<float> pixels;
+
+        while (true) {
+            renderer.render(scene.camera);
+
+            uint32_t framesRendered = renderer.getFrame() - 1;
+            if (framesRendered % reportInterval == 0 && !sendResult(socket, renderer, pixels))
+                return false;
+
+            if (framesRendered + 1 >= FRAME_OFFSET_STRIDE) {
+                std::cerr << "Warning (Worker): Frame stream exhausted, stopping" << std::endl;
+                return true;
+            }
+
+            if (socket.waitReadable(0)) {
+                MessageHeader header;
+                std::vector<char> payload;
+                if (!receiveMessage(socket, header, payload, MAX_CONTROL_PAYLOAD) || header.type == MSG_STOP)
+                    return true;
+            }
+        }
+    }
+
+    int runWorker(const WorkerSettings& settings) {
+        if (!Net::initialise())
+            return EXIT_FAILURE;
+
+        Socket socket = Socket::connect(settings.host, settings.port);
+        if (!socket.isValid() || !sendMessage(socket, MSG_HELLO)) {
+            Net::shutdown();
+            return EXIT_FAILURE;
+        }
+
+        MessageHeader header;
+        std::vector<char> payload;
+        if (!receiveMessage(socket, header, payload, MAX_CONTROL_PAYLOAD) || header.type != MSG_JOB || payload.size() < sizeof(JobMessage)) {
+            std::cerr << "Error (Worker): Did not receive a job from coordinator" << std::endl;
+            Net::shutdown();
+            return EXIT_FAILURE;
+        }
+
+        JobMessage job;
+        std::memcpy(&job, payload.data(), sizeof(job));
+        std::string scenePath(payload.begin() + sizeof(job), payload.end());
+
+        std::cout << "Worker " << job.workerId << ": " << scenePath << " at " << job.width << "x" << job.height
+            << ", frame offset " << job.frameOffset << std::endl;
+
+        GLFWwindow* context = createHeadlessContext(job.width, job.height);
+        if (!context) {
+            Net::shutdown();
+            return EXIT_FAILURE;
+        }
+
+        bool success = renderJob(socket, job, scenePath);
+
+        destroyHeadlessContext(context);
+        Net::shutdown();
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
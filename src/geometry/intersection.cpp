@@ -0,0 +1,635 @@
+#include <cmath>
+#include <utility>
+
+#include "geometry/intersection.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RT_INTERSECTION_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RT_TARGET_SSE
+#define RT_TARGET_AVX2
+#else
+#define RT_TARGET_SSE __attribute__((target("sse2")))
+#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Intersection {
+
+    namespace {
+        // Shared by the AoS, scalar SoA and tail paths, the SIMD kernels repeat the same operations
+        // in the same order so every path returns bit-identical distances
+        inline float dot3(float ax, float ay, float az, float bx, float by, float bz) {
+            return ax * bx + ay * by + az * bz;
+        }
+
+        // The shader's half b form. Its rays are unit length so it drops a, here a divides so any length works
+        inline bool sphereDistance(const Ray& ray, float cx, float cy, float cz, float radiusSquared, float& distance) {
+            float ocx = ray.origin.x - cx;
+            float ocy = ray.origin.y - cy;
+            float ocz = ray.origin.z - cz;
+            float a = dot3(ray.dir.x, ray.dir.y, ray.dir.z, ray.dir.x, ray.dir.y, ray.dir.z);
+            float b = dot3(ocx, ocy, ocz, ray.dir.x, ray.dir.y, ray.dir.z);
+            float c = dot3(ocx, ocy, ocz, ocx, ocy, ocz) - radiusSquared;
+            float discriminant = b * b - a * c;
+            if (!(discriminant >= 0.0f))
+                return false;
+
+            distance = (-b - std::sqrt(discriminant)) / a;
+            return distance > 0.0f;
+        }
+
+        inline bool planeDistance(const Ray& ray, float px, float py, float pz, float nx, float ny, float nz, float& distance) {
+            float denominator = dot3(nx, ny, nz, ray.dir.x, ray.dir.y, ray.dir.z);
+            if (!(denominator < 0.0f))  // Back faces are not hit
+                return false;
+
+            distance = dot3(nx, ny, nz, px - ray.origin.x, py - ray.origin.y, pz - ray.origin.z) / denominator;
+            return distance > 0.0f;
+        }
+
+        inline bool quadDistance(const Ray& ray, const QuadSoA& q, size_t i, float& distance) {
+            if (!planeDistance(ray, q.x[i], q.y[i], q.z[i], q.nx[i], q.ny[i], q.nz[i], distance))
+                return false;
+
+            float lx = (ray.origin.x + ray.dir.x * distance) - q.x[i];
+            float ly = (ray.origin.y + ray.dir.y * distance) - q.y[i];
+            float lz = (ray.origin.z + ray.dir.z * distance) - q.z[i];
+            float u = dot3(lx, ly, lz, q.rx[i], q.ry[i], q.rz[i]);
+            float v = dot3(lx, ly, lz, q.ux[i], q.uy[i], q.uz[i]);
+            return u >= -q.halfWidth[i] && u <= q.halfWidth[i] && v >= -q.halfHeight[i] && v <= q.halfHeight[i];
+        }
+
+        // Kernels update best/index when a primitive from `begin` on is strictly closer
+        using SphereKernel = void (*)(const Ray&, const SphereSoA&, size_t, float&, int&);
+        using PlaneKernel = void (*)(const Ray&, const PlaneSoA&, size_t, float&, int&);
+        using QuadKernel = void (*)(const Ray&, const QuadSoA&, size_t, float&, int&);
+
+        void spheresScalar(const Ray& ray, const SphereSoA& s, size_t begin, float& best, int& index) {
+            for (size_t i = begin; i < s.size(); ++i) {
+                float distance;
+                if (sphereDistance(ray, s.x[i], s.y[i], s.z[i], s.radiusSquared[i], distance) && distance < best) {
+                    best = distance;
+                    index = static_cast<int>(i);
+                }
+            }
+        }
+
+        void planesScalar(const Ray& ray, const PlaneSoA& p, size_t begin, float& best, int& index) {
+            for (size_t i = begin; i < p.size(); ++i) {
+                float distance;
+                if (planeDistance(ray, p.x[i], p.y[i], p.z[i], p.nx[i], p.ny[i], p.nz[i], distance) && distance < best) {
+                    best = distance;
+                    index = static_cast<int>(i);
+                }
+            }
+        }
+
+        void quadsScalar(const Ray& ray, const QuadSoA& q, size_t begin, float& best, int& index) {
+            for (size_t i = begin; i < q.size(); ++i) {
+                float distance;
+                if (quadDistance(ray, q, i, distance) && distance < best) {
+                    best = distance;
+                    index = static_cast<int>(i);
+                }
+            }
+        }
+
+#ifdef RT_INTERSECTION_X86
+        // Each lane keeps its own closest hit, the lanes are merged once at the end.
+        // Equal distances resolve to the lower index, as a sequential loop would
+        void reduceLanes(const float* distances, const int* indices, int lanes, float& best, int& index) {
+            for (int lane = 0; lane < lanes; ++lane) {
+                if (indices[lane] < 0)
+                    continue;
+                if (distances[lane] < best || (distances[lane] == best && indices[lane] < index)) {
+                    best = distances[lane];
+                    index = indices[lane];
+                }
+            }
+        }
+
+        RT_TARGET_SSE inline __m128 selectSSE(__m128 mask, __m128 a, __m128 b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        RT_TARGET_SSE inline __m128i selectSSE(__m128 mask, __m128i a, __m128i b) {
+            __m128i m = _mm_castps_si128(mask);
+            return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+        }
+
+        RT_TARGET_SSE inline __m128 dot3SSE(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        }
+
+        RT_TARGET_SSE void spheresSSE(const Ray& ray, const SphereSoA& s, size_t begin, float& best, int& index) {
+            const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+            const __m128 dx = _mm_set1_ps(ray.dir.x), dy = _mm_set1_ps(ray.dir.y), dz = _mm_set1_ps(ray.dir.z);
+            const float a = dot3(ray.dir.x, ray.dir.y, ray.dir.z, ray.dir.x, ray.dir.y, ray.dir.z);
+            const __m128 aa = _mm_set1_ps(a);
+            const __m128 zero = _mm_setzero_ps(), sign = _mm_set1_ps(-0.0f);
+
+            __m128 bestDistance = _mm_set1_ps(best);
+            __m128i bestIndex = _mm_set1_epi32(-1);
+            __m128i laneIndex = _mm_setr_epi32(static_cast<int>(begin), static_cast<int>(begin) + 1, static_cast<int>(begin) + 2, static_cast<int>(begin) + 3);
+
+            size_t i = begin;
+            for (; i + 4 <= s.size(); i += 4) {
+                __m128 ocx = _mm_sub_ps(ox, _mm_loadu_ps(&s.x[i]));
+                __m128 ocy = _mm_sub_ps(oy, _mm_loadu_ps(&s.y[i]));
+                __m128 ocz = _mm_sub_ps(oz, _mm_loadu_ps(&s.z[i]));
+                __m128 b = dot3SSE(ocx, ocy, ocz, dx, dy, dz);
+                __m128 c = _mm_sub_ps(dot3SSE(ocx, ocy, ocz, ocx, ocy, ocz), _mm_loadu_ps(&s.radiusSquared[i]));
+                __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(aa, c));
+                __m128 distance = _mm_div_ps(_mm_sub_ps(_mm_xor_ps(b, sign), _mm_sqrt_ps(discriminant)), aa);
+
+                __m128 valid = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_and_ps(_mm_cmpgt_ps(distance, zero), _mm_cmplt_ps(distance, bestDistance)));
+                bestDistance = selectSSE(valid, distance, bestDistance);
+                bestIndex = selectSSE(valid, laneIndex, bestIndex);
+                laneIndex = _mm_add_epi32(laneIndex, _mm_set1_epi32(4));
+            }
+
+            alignas(16) float distances[4];
+            alignas(16) int indices[4];
+            _mm_store_ps(distances, bestDistance);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 4, best, index);
+
+            spheresScalar(ray, s, i, best, index);
+        }
+
+        RT_TARGET_SSE inline __m128 planeDistanceSSE(const __m128 o[3], const __m128 d[3], __m128 px, __m128 py, __m128 pz,
+            __m128 nx, __m128 ny, __m128 nz, __m128& valid) {
+            __m128 denominator = dot3SSE(nx, ny, nz, d[0], d[1], d[2]);
+            __m128 distance = _mm_div_ps(dot3SSE(nx, ny, nz, _mm_sub_ps(px, o[0]), _mm_sub_ps(py, o[1]), _mm_sub_ps(pz, o[2])), denominator);
+            valid = _mm_and_ps(_mm_cmplt_ps(denominator, _mm_setzero_ps()), _mm_cmpgt_ps(distance, _mm_setzero_ps()));
+            return distance;
+        }
+
+        RT_TARGET_SSE void planesSSE(const Ray& ray, const PlaneSoA& p, size_t begin, float& best, int& index) {
+            const __m128 o[3] = { _mm_set1_ps(ray.origin.x), _mm_set1_ps(ray.origin.y), _mm_set1_ps(ray.origin.z) };
+            const __m128 d[3] = { _mm_set1_ps(ray.dir.x), _mm_set1_ps(ray.dir.y), _mm_set1_ps(ray.dir.z) };
+
+            __m128 bestDistance = _mm_set1_ps(best);
+            __m128i bestIndex = _mm_set1_epi32(-1);
+            __m128i laneIndex = _mm_setr_epi32(static_cast<int>(begin), static_cast<int>(begin) + 1, static_cast<int>(begin) + 2, static_cast<int>(begin) + 3);
+
+            size_t i = begin;
+            for (; i + 4 <= p.size(); i += 4) {
+                __m128 valid;
+                __m128 distance = planeDistanceSSE(o, d, _mm_loadu_ps(&p.x[i]), _mm_loadu_ps(&p.y[i]), _mm_loadu_ps(&p.z[i]),
+                    _mm_loadu_ps(&p.nx[i]), _mm_loadu_ps(&p.ny[i]), _mm_loadu_ps(&p.nz[i]), valid);
+
+                valid = _mm_and_ps(valid, _mm_cmplt_ps(distance, bestDistance));
+                bestDistance = selectSSE(valid, distance, bestDistance);
+                bestIndex = selectSSE(valid, laneIndex, bestIndex);
+                laneIndex = _mm_add_epi32(laneIndex, _mm_set1_epi32(4));
+            }
+
+            alignas(16) float distances[4];
+            alignas(16) int indices[4];
+            _mm_store_ps(distances, bestDistance);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 4, best, index);
+
+            planesScalar(ray, p, i, best, index);
+        }
+
+        RT_TARGET_SSE void quadsSSE(const Ray& ray, const QuadSoA& q, size_t begin, float& best, int& index) {
+            const __m128 o[3] = { _mm_set1_ps(ray.origin.x), _mm_set1_ps(ray.origin.y), _mm_set1_ps(ray.origin.z) };
+            const __m128 d[3] = { _mm_set1_ps(ray.dir.x), _mm_set1_ps(ray.dir.y), _mm_set1_ps(ray.dir.z) };
+            const __m128 sign = _mm_set1_ps(-0.0f);
+
+            __m128 bestDistance = _mm_set1_ps(best);
+            __m128i bestIndex = _mm_set1_epi32(-1);
+            __m128i laneIndex = _mm_setr_epi32(static_cast<int>(begin), static_cast<int>(begin) + 1, static_cast<int>(begin) + 2, static_cast<int>(begin) + 3);
+
+            size_t i = begin;
+            for (; i + 4 <= q.size(); i += 4) {
+                __m128 px = _mm_loadu_ps(&q.x[i]), py = _mm_loadu_ps(&q.y[i]), pz = _mm_loadu_ps(&q.z[i]);
+                __m128 valid;
+                __m128 distance = planeDistanceSSE(o, d, px, py, pz, _mm_loadu_ps(&q.nx[i]), _mm_loadu_ps(&q.ny[i]), _mm_loadu_ps(&q.nz[i]), valid);
+
+                __m128 lx = _mm_sub_ps(_mm_add_ps(o[0], _mm_mul_ps(d[0], distance)), px);
+                __m128 ly = _mm_sub_ps(_mm_add_ps(o[1], _mm_mul_ps(d[1], distance)), py);
+                __m128 lz = _mm_sub_ps(_mm_add_ps(o[2], _mm_mul_ps(d[2], distance)), pz);
+                __m128 u = dot3SSE(lx, ly, lz, _mm_loadu_ps(&q.rx[i]), _mm_loadu_ps(&q.ry[i]), _mm_loadu_ps(&q.rz[i]));
+                __m128 v = dot3SSE(lx, ly, lz, _mm_loadu_ps(&q.ux[i]), _mm_loadu_ps(&q.uy[i]), _mm_loadu_ps(&q.uz[i]));
+                __m128 halfWidth = _mm_loadu_ps(&q.halfWidth[i]);
+                __m128 halfHeight = _mm_loadu_ps(&q.halfHeight[i]);
+
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(u, _mm_xor_ps(halfWidth, sign)), _mm_cmple_ps(u, halfWidth)),
+                    _mm_and_ps(_mm_cmpge_ps(v, _mm_xor_ps(halfHeight, sign)), _mm_cmple_ps(v, halfHeight)));
+                valid = _mm_and_ps(_mm_and_ps(valid, inside), _mm_cmplt_ps(distance, bestDistance));
+                bestDistance = selectSSE(valid, distance, bestDistance);
+                bestIndex = selectSSE(valid, laneIndex, bestIndex);
+                laneIndex = _mm_add_epi32(laneIndex, _mm_set1_epi32(4));
+            }
+
+            alignas(16) float distances[4];
+            alignas(16) int indices[4];
+            _mm_store_ps(distances, bestDistance);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 4, best, index);
+
+            quadsScalar(ray, q, i, best, index);
+        }
+
+        RT_TARGET_AVX2 inline __m256 selectAVX2(__m256 mask, __m256 a, __m256 b) {
+            return _mm256_blendv_ps(b, a, mask);
+        }
+
+        RT_TARGET_AVX2 inline __m256i selectAVX2(__m256 mask, __m256i a, __m256i b) {
+            return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), mask));
+        }
+
+        RT_TARGET_AVX2 inline __m256 dot3AVX2(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+            return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+        }
+
+        RT_TARGET_AVX2 inline __m256i firstLanesAVX2(size_t begin) {
+            return _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        }
+
+        RT_TARGET_AVX2 void spheresAVX2(const Ray& ray, const SphereSoA& s, size_t begin, float& best, int& index) {
+            const __m256 ox = _mm256_set1_ps(ray.origin.x), oy = _mm256_set1_ps(ray.origin.y), oz = _mm256_set1_ps(ray.origin.z);
+            const __m256 dx = _mm256_set1_ps(ray.dir.x), dy = _mm256_set1_ps(ray.dir.y), dz = _mm256_set1_ps(ray.dir.z);
+            const float a = dot3(ray.dir.x, ray.dir.y, ray.dir.z, ray.dir.x, ray.dir.y, ray.dir.z);
+            const __m256 aa = _mm256_set1_ps(a);
+            const __m256 zero = _mm256_setzero_ps(), sign = _mm256_set1_ps(-0.0f);
+
+            __m256 bestDistance = _mm256_set1_ps(best);
+            __m256i bestIndex = _mm256_set1_epi32(-1);
+            __m256i laneIndex = firstLanesAVX2(begin);
+
+            size_t i = begin;
+            for (; i + 8 <= s.size(); i += 8) {
+                __m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(&s.x[i]));
+                __m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(&s.y[i]));
+                __m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(&s.z[i]));
+                __m256 b = dot3AVX2(ocx, ocy, ocz, dx, dy, dz);
+                __m256 c = _mm256_sub_ps(dot3AVX2(ocx, ocy, ocz, ocx, ocy, ocz), _mm256_loadu_ps(&s.radiusSquared[i]));
+                __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(aa, c));
+                __m256 distance = _mm256_div_ps(_mm256_sub_ps(_mm256_xor_ps(b, sign), _mm256_sqrt_ps(discriminant)), aa);
+
+                __m256 valid = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ),
+                    _mm256_and_ps(_mm256_cmp_ps(distance, zero, _CMP_GT_OQ), _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ)));
+                bestDistance = selectAVX2(valid, distance, bestDistance);
+                bestIndex = selectAVX2(valid, laneIndex, bestIndex);
+                laneIndex = _mm256_add_epi32(laneIndex, _mm256_set1_epi32(8));
+            }
+
+            alignas(32) float distances[8];
+            alignas(32) int indices[8];
+            _mm256_store_ps(distances, bestDistance);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 8, best, index);
+
+            spheresScalar(ray, s, i, best, index);
+        }
+
+        RT_TARGET_AVX2 inline __m256 planeDistanceAVX2(const __m256 o[3], const __m256 d[3], __m256 px, __m256 py, __m256 pz,
+            __m256 nx, __m256 ny, __m256 nz, __m256& valid) {
+            __m256 denominator = dot3AVX2(nx, ny, nz, d[0], d[1], d[2]);
+            __m256 distance = _mm256_div_ps(dot3AVX2(nx, ny, nz, _mm256_sub_ps(px, o[0]), _mm256_sub_ps(py, o[1]), _mm256_sub_ps(pz, o[2])), denominator);
+            valid = _mm256_and_ps(_mm256_cmp_ps(denominator, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GT_OQ));
+            return distance;
+        }
+
+        RT_TARGET_AVX2 void planesAVX2(const Ray& ray, const PlaneSoA& p, size_t begin, float& best, int& index) {
+            const __m256 o[3] = { _mm256_set1_ps(ray.origin.x), _mm256_set1_ps(ray.origin.y), _mm256_set1_ps(ray.origin.z) };
+            const __m256 d[3] = { _mm256_set1_ps(ray.dir.x), _mm256_set1_ps(ray.dir.y), _mm256_set1_ps(ray.dir.z) };
+
+            __m256 bestDistance = _mm256_set1_ps(best);
+            __m256i bestIndex = _mm256_set1_epi32(-1);
+            __m256i laneIndex = firstLanesAVX2(begin);
+
+            size_t i = begin;
+            for (; i + 8 <= p.size(); i += 8) {
+                __m256 valid;
+                __m256 distance = planeDistanceAVX2(o, d, _mm256_loadu_ps(&p.x[i]), _mm256_loadu_ps(&p.y[i]), _mm256_loadu_ps(&p.z[i]),
+                    _mm256_loadu_ps(&p.nx[i]), _mm256_loadu_ps(&p.ny[i]), _mm256_loadu_ps(&p.nz[i]), valid);
+
+                valid = _mm256_and_ps(valid, _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ));
+                bestDistance = selectAVX2(valid, distance, bestDistance);
+                bestIndex = selectAVX2(valid, laneIndex, bestIndex);
+                laneIndex = _mm256_add_epi32(laneIndex, _mm256_set1_epi32(8));
+            }
+
+            alignas(32) float distances[8];
+            alignas(32) int indices[8];
+            _mm256_store_ps(distances, bestDistance);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 8, best, index);
+
+            planesScalar(ray, p, i, best, index);
+        }
+
+        RT_TARGET_AVX2 void quadsAVX2(const Ray& ray, const QuadSoA& q, size_t begin, float& best, int& index) {
+            const __m256 o[3] = { _mm256_set1_ps(ray.origin.x), _mm256_set1_ps(ray.origin.y), _mm256_set1_ps(ray.origin.z) };
+            const __m256 d[3] = { _mm256_set1_ps(ray.dir.x), _mm256_set1_ps(ray.dir.y), _mm256_set1_ps(ray.dir.z) };
+            const __m256 sign = _mm256_set1_ps(-0.0f);
+
+            __m256 bestDistance = _mm256_set1_ps(best);
+            __m256i bestIndex = _mm256_set1_epi32(-1);
+            __m256i laneIndex = firstLanesAVX2(begin);
+
+            size_t i = begin;
+            for (; i + 8 <= q.size(); i += 8) {
+                __m256 px = _mm256_loadu_ps(&q.x[i]), py = _mm256_loadu_ps(&q.y[i]), pz = _mm256_loadu_ps(&q.z[i]);
+                __m256 valid;
+                __m256 distance = planeDistanceAVX2(o, d, px, py, pz, _mm256_loadu_ps(&q.nx[i]), _mm256_loadu_ps(&q.ny[i]), _mm256_loadu_ps(&q.nz[i]), valid);
+
+                __m256 lx = _mm256_sub_ps(_mm256_add_ps(o[0], _mm256_mul_ps(d[0], distance)), px);
+                __m256 ly = _mm256_sub_ps(_mm256_add_ps(o[1], _mm256_mul_ps(d[1], distance)), py);
+                __m256 lz = _mm256_sub_ps(_mm256_add_ps(o[2], _mm256_mul_ps(d[2], distance)), pz);
+                __m256 u = dot3AVX2(lx, ly, lz, _mm256_loadu_ps(&q.rx[i]), _mm256_loadu_ps(&q.ry[i]), _mm256_loadu_ps(&q.rz[i]));
+                __m256 v = dot3AVX2(lx, ly, lz, _mm256_loadu_ps(&q.ux[i]), _mm256_loadu_ps(&q.uy[i]), _mm256_loadu_ps(&q.uz[i]));
+                __m256 halfWidth = _mm256_loadu_ps(&q.halfWidth[i]);
+                __m256 halfHeight = _mm256_loadu_ps(&q.halfHeight[i]);
+
+                __m256 inside = _mm256_and_ps(
+                    _mm256_and_ps(_mm256_cmp_ps(u, _mm256_xor_ps(halfWidth, sign), _CMP_GE_OQ), _mm256_cmp_ps(u, halfWidth, _CMP_LE_OQ)),
+                    _mm256_and_ps(_mm256_cmp_ps(v, _mm256_xor_ps(halfHeight, sign), _CMP_GE_OQ), _mm256_cmp_ps(v, halfHeight, _CMP_LE_OQ)));
+                valid = _mm256_and_ps(_mm256_and_ps(valid, inside), _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ));
+                bestDistance = selectAVX2(valid, distance, bestDistance);
+                bestIndex = selectAVX2(valid, laneIndex, bestIndex);
+                laneIndex = _mm256_add_epi32(laneIndex, _mm256_set1_epi32(8));
+            }
+
+            alignas(32) float distances[8];
+            alignas(32) int indices[8];
+            _mm256_store_ps(distances, bestDistance);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+            reduceLanes(distances, indices, 8, best, index);
+
+            quadsScalar(ray, q, i, best, index);
+        }
+
+        bool cpuSupportsAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)  // The OS must save the YMM registers
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        bool cpuSupportsSSE() {
+#if defined(_M_X64) || defined(__x86_64__)
+            return true;  // Part of the x86-64 baseline
+#elif defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+#endif
+
+        SimdLevel detectSimdLevel() {
+#ifdef RT_INTERSECTION_X86
+            if (cpuSupportsAVX2())
+                return SimdLevel::AVX2;
+            if (cpuSupportsSSE())
+                return SimdLevel::SSE;
+#endif
+            return SimdLevel::Scalar;
+        }
+
+        struct Kernels {
+            SphereKernel spheres;
+            PlaneKernel planes;
+            QuadKernel quads;
+        };
+
+        Kernels getKernels(SimdLevel level) {
+            switch (level) {
+#ifdef RT_INTERSECTION_X86
+            case SimdLevel::AVX2: return { spheresAVX2, planesAVX2, quadsAVX2 };
+            case SimdLevel::SSE: return { spheresSSE, planesSSE, quadsSSE };
+#endif
+            default: return { spheresScalar, planesScalar, quadsScalar };
+            }
+        }
+
+        const SimdLevel s_supportedLevel = detectSimdLevel();
+        SimdLevel s_level = s_supportedLevel;
+        Kernels s_kernels = getKernels(s_level);
+
+        template <typename Primitives, typename Kernel>
+        void closest(const Ray& ray, const Primitives& primitives, Kernel kernel, HitType type, Hit& hit) {
+            float best = hit.distance;
+            int index = -1;
+            kernel(ray, primitives, 0, best, index);
+            if (index >= 0) {
+                hit.type = type;
+                hit.index = index;
+                hit.distance = best;
+            }
+        }
+    }
+
+    bool intersectSphere(const Ray& ray, const Sphere& sphere, float& distance) {
+        return sphereDistance(ray, sphere.position.x, sphere.position.y, sphere.position.z, sphere.radiusSquared, distance);
+    }
+
+    bool intersectPlane(const Ray& ray, const Plane& plane, float& distance) {
+        return planeDistance(ray, plane.position.x, plane.position.y, plane.position.z, plane.normal.x, plane.normal.y, plane.normal.z, distance);
+    }
+
+    bool intersectQuad(const Ray& ray, const Quad& quad, float& distance) {
+        if (!planeDistance(ray, quad.position.x, quad.position.y, quad.position.z, quad.normal.x, quad.normal.y, quad.normal.z, distance))
+            return false;
+
+        float lx = (ray.origin.x + ray.dir.x * distance) - quad.position.x;
+        float ly = (ray.origin.y + ray.dir.y * distance) - quad.position.y;
+        float lz = (ray.origin.z + ray.dir.z * distance) - quad.position.z;
+        float u = dot3(lx, ly, lz, quad.right.x, quad.right.y, quad.right.z);
+        float v = dot3(lx, ly, lz, quad.up.x, quad.up.y, quad.up.z);
+        float halfWidth = quad.width * 0.5f;
+        float halfHeight = quad.height * 0.5f;
+        return u >= -halfWidth && u <= halfWidth && v >= -halfHeight && v <= halfHeight;
+    }
+
+    bool intersectBox(const Ray& ray, const Box& box, float& distance, int& face) {
+        // Slabs in the box's own frame
+        glm::vec3 offset = ray.origin - box.position;
+        glm::vec3 origin(glm::dot(offset, box.right), glm::dot(offset, box.up), glm::dot(offset, box.forward));
+        glm::vec3 dir(glm::dot(ray.dir, box.right), glm::dot(ray.dir, box.up), glm::dot(ray.dir, box.forward));
+
+        float tEntry = -1e30f, tExit = 1e30f;
+        int entryFace = 0, exitFace = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            float inverse = 1.0f / dir[axis];
+            float t0 = (-box.halfSize[axis] - origin[axis]) * inverse;
+            float t1 = (box.halfSize[axis] - origin[axis]) * inverse;
+            int face0 = axis * 2, face1 = axis * 2 + 1;
+            if (t0 > t1) {
+                std::swap(t0, t1);
+                std::swap(face0, face1);
+            }
+            if (t0 > tEntry) {
+                tEntry = t0;
+                entryFace = face0;
+            }
+            if (t1 < tExit) {
+                tExit = t1;
+                exitFace = face1;
+            }
+        }
+        if (!(tEntry <= tExit))
+            return false;
+
+        // Outward faces are seen where the ray enters, inward faces where it leaves
+        distance = box.inward != 0 ? tExit : tEntry;
+        face = box.inward != 0 ? exitFace : entryFace;
+        return distance > 0.0f;
+    }
+
+    bool intersectDisc(const Ray& ray, const Disc& disc, float& distance) {
+        if (!planeDistance(ray, disc.position.x, disc.position.y, disc.position.z, disc.normal.x, disc.normal.y, disc.normal.z, distance))
+            return false;
+
+        glm::vec3 local = ray.origin + ray.dir * distance - disc.position;
+        return glm::dot(local, local) <= disc.radiusSquared;
+    }
+
+    bool intersectCylinder(const Ray& ray, const Cylinder& cylinder, float& distance) {
+        glm::vec3 offset = ray.origin - cylinder.position;
+        float offsetAlong = glm::dot(offset, cylinder.axis);
+        float dirAlong = glm::dot(ray.dir, cylinder.axis);
+        glm::vec3 offsetAcross = offset - cylinder.axis * offsetAlong;
+        glm::vec3 dirAcross = ray.dir - cylinder.axis * dirAlong;
+
+        // Side, where the ray enters the infinite cylinder
+        float a = glm::dot(dirAcross, dirAcross);
+        float b = glm::dot(offsetAcross, dirAcross);
+        float c = glm::dot(offsetAcross, offsetAcross) - cylinder.radiusSquared;
+        float discriminant = b * b - a * c;
+        if (a > 0.0f && discriminant >= 0.0f) {
+            float t = (-b - std::sqrt(discriminant)) / a;
+            if (t > 0.0f && std::abs(offsetAlong + dirAlong * t) <= cylinder.halfHeight) {
+                distance = t;
+                return true;
+            }
+        }
+
+        // Only the cap facing the ray can be hit, and only where the side isn't
+        if (dirAlong != 0.0f) {
+            float side = dirAlong < 0.0f ? 1.0f : -1.0f;
+            float t = (side * cylinder.halfHeight - offsetAlong) / dirAlong;
+            glm::vec3 across = offsetAcross + dirAcross * t;
+            if (t > 0.0f && glm::dot(across, across) <= cylinder.radiusSquared) {
+                distance = t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    PrimitiveSoA buildPrimitiveSoA(const std::vector<Sphere>& spheres, const std::vector<Plane>& planes, const std::vector<Quad>& quads) {
+        PrimitiveSoA soa;
+
+        SphereSoA& s = soa.spheres;
+        for (const Sphere& sphere : spheres) {
+            s.x.push_back(sphere.position.x);
+            s.y.push_back(sphere.position.y);
+            s.z.push_back(sphere.position.z);
+            s.radiusSquared.push_back(sphere.radiusSquared);
+        }
+
+        PlaneSoA& p = soa.planes;
+        for (const Plane& plane : planes) {
+            p.x.push_back(plane.position.x);
+            p.y.push_back(plane.position.y);
+            p.z.push_back(plane.position.z);
+            p.nx.push_back(plane.normal.x);
+            p.ny.push_back(plane.normal.y);
+            p.nz.push_back(plane.normal.z);
+        }
+
+        QuadSoA& q = soa.quads;
+        for (const Quad& quad : quads) {
+            q.x.push_back(quad.position.x);
+            q.y.push_back(quad.position.y);
+            q.z.push_back(quad.position.z);
+            q.nx.push_back(quad.normal.x);
+            q.ny.push_back(quad.normal.y);
+            q.nz.push_back(quad.normal.z);
+            q.rx.push_back(quad.right.x);
+            q.ry.push_back(quad.right.y);
+            q.rz.push_back(quad.right.z);
+            q.ux.push_back(quad.up.x);
+            q.uy.push_back(quad.up.y);
+            q.uz.push_back(quad.up.z);
+            q.halfWidth.push_back(quad.width * 0.5f);
+            q.halfHeight.push_back(quad.height * 0.5f);
+        }
+
+        return soa;
+    }
+
+    const char* getSimdLevelName(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::Scalar: return "Scalar";
+        case SimdLevel::SSE: return "SSE";
+        case SimdLevel::AVX2: return "AVX2";
+        }
+        return "Unknown";
+    }
+
+    SimdLevel getSupportedSimdLevel() {
+        return s_supportedLevel;
+    }
+
+    SimdLevel getSimdLevel() {
+        return s_level;
+    }
+
+    void setSimdLevel(SimdLevel level) {
+        s_level = static_cast<int>(level) > static_cast<int>(s_supportedLevel) ? s_supportedLevel : level;
+        s_kernels = getKernels(s_level);
+    }
+
+    Hit intersectClosest(const Ray& ray, const PrimitiveSoA& primitives) {
+        // Same order as CalculateRayCollision, so equal distances resolve the same way
+        Hit hit;
+        closest(ray, primitives.spheres, s_kernels.spheres, HitType::Sphere, hit);
+        closest(ray, primitives.planes, s_kernels.planes, HitType::Plane, hit);
+        closest(ray, primitives.quads, s_kernels.quads, HitType::Quad, hit);
+        return hit;
+    }
+
+    Hit intersectClosest(const Ray& ray, const SphereSoA& spheres) {
+        Hit hit;
+        closest(ray, spheres, s_kernels.spheres, HitType::Sphere, hit);
+        return hit;
+    }
+
+    Hit intersectClosest(const Ray& ray, const PlaneSoA& planes) {
+        Hit hit;
+        closest(ray, planes, s_kernels.planes, HitType::Plane, hit);
+        return hit;
+    }
+
+    Hit intersectClosest(const Ray& ray, const QuadSoA& quads) {
+        Hit hit;
+        closest(ray, quads, s_kernels.quads, HitType::Quad, hit);
+        return hit;
+    }
+}
\ No newline at end of file
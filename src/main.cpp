@@ -1,7 +1,16 @@
 ﻿#define IMGUI_ENABLE_DOCKING
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
@@ -15,10 +24,35 @@
 
 #include "ImGuiFileDialog.h"
 
+#include "json.hpp"
+
+#include "api\ray_tracer.hpp"
 #include "camera\camera.hpp"
+#include "distributed\coordinator.hpp"
+#include "distributed\protocol.hpp"
+#include "distributed\worker.hpp"
+#include "geometry\intersection.hpp"
+#include "renderer\checkpoint.hpp"
+#include "renderer\convergence.hpp"
+#include "renderer\display_buffer.hpp"
+#include "renderer\render_thread.hpp"
 #include "renderer\renderer.hpp"
+#include "renderer\sample_scheduler.hpp"
 #include "scene\scene.hpp"
+#include "scene\scene_binary.hpp"
+#include "scene\scene_compiler.hpp"
+#include "scene\scene_diff.hpp"
+#include "scene\scene_index.hpp"
 #include "scene\scene_loader.hpp"
+#include "sequence\sequence_renderer.hpp"
+#include "server\render_server.hpp"
+#include "session\session_recorder.hpp"
+#include "session\session_replay.hpp"
+#include "utils\cli.hpp"
+#include "utils\file_watcher.hpp"
+#include "utils\gl_debug.hpp"
+#include "utils\gpu_memory.hpp"
+#include "utils\job_system.hpp"
 
 // === GLOBALS ===
 const std::string WINDOW_TITLE = "Ray Tracer v1.0.1";
@@ -57,15 +91,195 @@ float& g_sunIntensity = g_scene.sunIntensity;
 float& g_sunFocus = g_scene.sunFocus;
 
 float& g_skyboxExposureEV = g_scene.skyboxExposureEV;
+int g_skyboxFormat = static_cast<int>(SkyboxFormat::RGB32F);
+
+// Render Thread, path tracing runs there so a slow frame never blocks input or the UI. It owns the
+// state marked (render thread), which the UI only changes by posting commands and reads through g_status
+RenderThread g_renderThread;
 
-// Renderer Instance
-Renderer* g_renderer = nullptr;
+// Path tracer of the main view (render thread), in the render thread's context. Scene loads and edits, rendering,
+// resizes and exports go through the RayTracer API, statistics and integrator settings through its Renderer
+std::unique_ptr<RayTracer> g_tracer;
+Camera g_renderCamera;
 float g_lastRenderTime = 0.0f;
+uint32_t g_renderSamplesPerPixel = 1;  // Fixed budget samples, also used by the extra views
+double g_lastRenderEnd = -1.0;         // Negative after an idle spell, sleeping isn't tracing time
+DisplayBuffer g_display;               // Finished frames of the main view, shown by the UI
+Camera g_postedCamera;                 // UI thread, the camera last sent to the render thread
+
+// Frame Budget
+SampleScheduler g_scheduler;  // Render thread
+int g_budgetMode = static_cast<int>(BudgetMode::Fixed);
+float g_frameBudget = 16.0f;
+
+// Stop Conditions
+ConvergenceMonitor g_convergence;  // Render thread
+int g_targetSamples = 0;
+float g_targetNoisePercent = 0.0f;
+float g_timeLimit = 0.0f;
+
+// Ray Statistics
+bool g_statsEnabled = false;
+bool g_showHeatmap = false;
+float g_heatmapScale = 64.0f;
+
+// Direct Lighting, applied to every view
+RestirSettings g_restir;
+
+// Path Guiding, applied to every view
+GuidingSettings g_guiding;
+
+// Radiance Cache, applied to every view
+RadianceCacheSettings g_radianceCache;
+
+// GPU Memory
+int g_vramBudgetMB = 0;
+
+// Render Status, copied out by the render thread after every frame
+struct RenderStatus {
+    uint32_t frame = 1;
+    uint64_t sampleCount = 0;
+    float lastRenderTime = 0.0f;
+    float gpuFrameTime = 0.0f;
+    float samplesPerSecond = 0.0f;
+    float pathsPerSecond = 0.0f;
+    uint32_t scheduledSamplesPerPixel = 1;
+    float budget = 16.0f;
+    bool converged = false;
+    StopReason stopReason = StopReason::None;
+    double elapsed = 0.0;
+    float noise = -1.0f;
+    RayStats rayStats;
+    bool hasSkybox = false;
+    int skyboxWidth = 0;
+    int skyboxHeight = 0;
+    size_t skyboxMemory = 0;
+    std::vector<std::string> cachedSkyboxes;
+    int lightCount = 0;
+    bool guideTrained = false;
+};
+std::mutex g_statusMutex;
+RenderStatus g_renderStatus;             // Written by the render thread under g_statusMutex
+RenderStatus g_status;                   // UI thread copy, taken once per frame
+std::atomic<bool> g_uiWaiting{ false };  // The UI is blocked on events, a new frame should wake it
+
+// Extra Views, each with its own camera and accumulation, sharing the main view's scene resources.
+// The renderer lives in a target owned by the render thread, the window state in SceneView
+struct ViewTarget {
+    std::unique_ptr<Renderer> renderer;  // Render thread
+    Camera camera;                       // Render thread
+    DisplayBuffer display;
+    std::atomic<uint64_t> sampleCount{ 0 };
+};
+std::vector<std::shared_ptr<ViewTarget>> g_viewTargets;  // Render thread
+
+struct SceneView {
+    std::string name;
+    std::shared_ptr<ViewTarget> target;
+    Camera camera;
+    Camera postedCamera;
+    uint32_t width = 0;   // Last size sent to the render thread
+    uint32_t height = 0;
+    bool open = true;
+    bool turntable = false;
+    float turntableSpeed = 20.0f;  // Degrees per second around the pivot
+    float pivotDistance = 5.0f;    // Pivot is this far along the camera's forward when the turntable starts
+    glm::vec3 pivot = glm::vec3(0.0f);
+};
+std::vector<SceneView> g_views;
+int g_nextViewId = 1;
+
+// Scene and skybox loads run on the job system, a newer request of the same kind discards older results.
+// Scene loads and hot reloads share a counter, skyboxes picked in the UI have their own
+uint64_t g_sceneRequest = 0;
+uint64_t g_skyboxRequest = 0;
+bool g_sceneLoading = false;  // Cleared by the newest scene load when it finishes or fails
+
+// Hot Reload, edits to the scene file are applied as a diff against the version last loaded
+bool g_hotReload = true;
+std::string g_scenePath;
+Scene g_sceneFile;  // As loaded, without the edits made in the UI
+FileWatcher g_sceneWatcher;
+
+// Picking and Inspector. The index follows g_scene through loads, reloads and inspector edits
+const double PICK_DRAG_THRESHOLD = 3.0;  // Pixels the mouse may move during a click that still picks
+SceneIndex g_sceneIndex;
+Intersection::Hit g_selection;            // Type None while nothing is selected
+int g_selectedFace = 0;                   // Box face whose material the inspector edits
+float g_pickTime = 0.0f;                  // ms, for the last pick
+glm::vec2 g_viewportMouse = glm::vec2(0.0f);  // Pixels from the viewport's top left, while hovered
+bool g_pickPending = false;               // Picks on release unless the press turns into a camera drag
+glm::vec2 g_pickPosition = glm::vec2(0.0f);
+double g_dragDistance = 0.0;
+SceneChanges g_inspectorEdits;            // Primitives edited since the scene file was last applied
+
+// Session Recording, camera moves, settings and scene loads for --replay
+Session::SessionRecorder g_sessionRecorder;
 
 // ImGui State
 bool g_firstFrame = true;
 char g_skyboxPathBuffer[256] = "";
 
+// === PICKING ===
+size_t getPrimitiveCount(const Scene& scene, Intersection::HitType type) {
+    switch (type) {
+    case Intersection::HitType::Sphere: return scene.spheres.size();
+    case Intersection::HitType::Plane: return scene.planes.size();
+    case Intersection::HitType::Quad: return scene.quads.size();
+    case Intersection::HitType::Box: return scene.boxes.size();
+    case Intersection::HitType::Disc: return scene.discs.size();
+    case Intersection::HitType::Cylinder: return scene.cylinders.size();
+    default: return 0;
+    }
+}
+
+// Casts the camera ray through a point of the viewport, in pixels from its top left, and selects what it hits first
+void pickObject(glm::vec2 position) {
+    if (g_viewportWidth == 0 || g_viewportHeight == 0)
+        return;
+
+    float x = position.x / g_viewportWidth * 2.0f - 1.0f;
+    float y = 1.0f - position.y / g_viewportHeight * 2.0f;
+    Intersection::Ray ray;
+    ray.origin = g_camera.position;
+    ray.dir = g_camera.getRayDirection(x, y, static_cast<float>(g_viewportWidth) / g_viewportHeight);
+
+    double start = glfwGetTime();
+    g_selection = g_sceneIndex.intersect(ray, g_scene);
+    g_pickTime = static_cast<float>((glfwGetTime() - start) * 1000.0);
+    g_selectedFace = std::max(g_selection.face, 0);
+}
+
+// Keeps the selection only while its primitive still exists
+void validateSelection() {
+    if (g_selection.index >= 0 && static_cast<size_t>(g_selection.index) >= getPrimitiveCount(g_scene, g_selection.type))
+        g_selection = Intersection::Hit();
+}
+
+// Writes one edited primitive into the render thread's copy of the scene, which uploads only that element
+template <typename T>
+void postPrimitiveEdit(Intersection::HitType type, std::vector<T> Scene::* primitives, SceneChanges::Primitives SceneChanges::* changed, size_t index) {
+    SceneChanges::Primitives& edits = g_inspectorEdits.*changed;
+    if (edits.ranges.empty() || edits.ranges.back().first != index)
+        edits.ranges.push_back({ index, 1 });
+    g_sceneIndex.update(g_scene, type, index);
+
+    g_renderThread.post([primitives, changed, index, primitive = (g_scene.*primitives)[index]]() {
+        SceneChanges changes;
+        (changes.*changed).ranges.push_back({ index, 1 });
+        g_tracer->editScene([&](Scene& scene) { (scene.*primitives)[index] = primitive; }, changes);
+    });
+}
+
+// Where the file replaces an array, inspector edits to it are lost and those elements are uploaded again too
+void mergeInspectorEdits(SceneChanges::Primitives& changes, SceneChanges::Primitives& edits) {
+    if (!changes.any())
+        return;
+    if (!changes.resized)
+        changes.ranges.insert(changes.ranges.end(), edits.ranges.begin(), edits.ranges.end());
+    edits = SceneChanges::Primitives();
+}
+
 // === INPUT HANDLING ===
 void processInput(GLFWwindow* window) {
     if (!g_viewportFocused) return;
@@ -111,6 +325,10 @@ void cursorPosCallback(GLFWwindow* window, double x, double y) {
         g_lastX = x;
         g_lastY = y;
 
+        g_dragDistance += std::abs(xOffset) + std::abs(yOffset);
+        if (g_dragDistance > PICK_DRAG_THRESHOLD)
+            g_pickPending = false;
+
         g_camera.yaw += static_cast<float>(xOffset * g_mouseSensitivity);
         g_camera.pitch -= static_cast<float>(yOffset * g_mouseSensitivity);
 
@@ -134,31 +352,366 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
                 g_mouseHeld = true;
                 glfwGetCursorPos(window, &g_lastX, &g_lastY);
                 glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+                g_pickPending = true;
+                g_pickPosition = g_viewportMouse;
+                g_dragDistance = 0.0;
             }
         }
         else if (action == GLFW_RELEASE) {
             g_mouseHeld = false;
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+
+            if (g_pickPending) {
+                g_pickPending = false;
+                pickObject(g_pickPosition);
+            }
         }
     }
 }
 
+void applyScene(const Scene& scene, const std::string& filepath, GLFWwindow* window) {
+    g_scene = scene;
+    if (g_scene.name.size() > 0)
+        glfwSetWindowTitle(window, (WINDOW_TITLE + " - " + g_scene.name).c_str());
+    g_renderThread.post([scene = std::make_shared<Scene>(g_scene)]() {
+        g_tracer->setScene(*scene);
+        g_renderSamplesPerPixel = static_cast<uint32_t>(std::max(scene->samplesPerPixel, 1));
+        g_renderCamera = scene->camera;
+    });
+    g_postedCamera = g_camera;
+    g_sceneLoading = false;
+
+    g_sceneIndex.build(g_scene);
+    g_selection = Intersection::Hit();
+    g_inspectorEdits = SceneChanges();
+
+    g_sceneFile = scene;
+    g_scenePath = filepath;
+    if (g_hotReload)
+        g_sceneWatcher.watch(filepath);
+
+    g_sessionRecorder.recordScene(glfwGetTime(), filepath);
+}
+
+void applySceneChanges(const Scene& scene, const SceneChanges& changes, GLFWwindow* window) {
+    // Only what the file changed is taken, everything else keeps its edits from the UI
+    if (changes.spheres.any())
+        g_scene.spheres = scene.spheres;
+    if (changes.planes.any())
+        g_scene.planes = scene.planes;
+    if (changes.quads.any())
+        g_scene.quads = scene.quads;
+    if (changes.boxes.any())
+        g_scene.boxes = scene.boxes;
+    if (changes.discs.any())
+        g_scene.discs = scene.discs;
+    if (changes.cylinders.any())
+        g_scene.cylinders = scene.cylinders;
+    if (changes.tracing) {
+        g_scene.gamma = scene.gamma;
+        g_scene.maxBounces = scene.maxBounces;
+    }
+    if (changes.samplesPerPixel)
+        g_scene.samplesPerPixel = scene.samplesPerPixel;
+    if (changes.skybox)
+        g_scene.skyboxPath = scene.skyboxPath;
+    if (changes.environment) {
+        g_scene.skyboxExposureEV = scene.skyboxExposureEV;
+        g_scene.sunPitch = scene.sunPitch;
+        g_scene.sunYaw = scene.sunYaw;
+        g_scene.sunColour = scene.sunColour;
+        g_scene.sunIntensity = scene.sunIntensity;
+        g_scene.sunFocus = scene.sunFocus;
+    }
+    if (changes.camera)
+        g_scene.camera = scene.camera;
+    if (changes.cameraTrack)
+        g_scene.cameraTrack = scene.cameraTrack;
+    if (changes.name) {
+        g_scene.name = scene.name;
+        glfwSetWindowTitle(window, (WINDOW_TITLE + " - " + g_scene.name).c_str());
+    }
+
+    SceneChanges applied = changes;
+    mergeInspectorEdits(applied.spheres, g_inspectorEdits.spheres);
+    mergeInspectorEdits(applied.planes, g_inspectorEdits.planes);
+    mergeInspectorEdits(applied.quads, g_inspectorEdits.quads);
+    mergeInspectorEdits(applied.boxes, g_inspectorEdits.boxes);
+    mergeInspectorEdits(applied.discs, g_inspectorEdits.discs);
+    mergeInspectorEdits(applied.cylinders, g_inspectorEdits.cylinders);
+    g_sceneIndex.update(g_scene, applied);
+    validateSelection();
+
+    g_renderThread.post([scene = std::make_shared<Scene>(g_scene), applied]() {
+        g_tracer->updateScene(*scene, applied);
+        if (applied.samplesPerPixel)
+            g_renderSamplesPerPixel = static_cast<uint32_t>(std::max(scene->samplesPerPixel, 1));
+        if (applied.camera)
+            g_renderCamera = scene->camera;
+    });
+    if (changes.camera)
+        g_postedCamera = g_camera;
+    g_sceneFile = scene;
+    std::cout << "Reloaded " << g_scenePath << ": " << SceneDiff::describe(changes) << std::endl;
+}
+
+// The render thread's skybox cache as of its last frame
+bool isSkyboxCached(const std::string& filepath) {
+    return std::find(g_status.cachedSkyboxes.begin(), g_status.cachedSkyboxes.end(), filepath) != g_status.cachedSkyboxes.end();
+}
+
+// Decodes a skybox on the job system, then queues the upload and runs `then` on the main thread.
+// Both are skipped if `latest` has moved past `request` by then
+void loadSkyboxAsync(const std::string& filepath, const uint64_t& latest, uint64_t request, std::function<void()> then) {
+    SkyboxFormat format = static_cast<SkyboxFormat>(g_skyboxFormat);
+    Task<std::shared_ptr<SkyboxData>> decoded = JobSystem::get().run([filepath, format]() {
+        auto data = std::make_shared<SkyboxData>();
+        if (!Skybox::decode(filepath, format, *data))
+            data.reset();
+        return data;
+    });
+
+    JobSystem::get().run([decoded, &latest, request, then]() {
+        if (request != latest)
+            return;
+        if (std::shared_ptr<SkyboxData> data = decoded.get())
+            g_renderThread.post([data]() { g_tracer->getRenderer().getResources().setSkybox(*data); });
+        if (then)
+            then();
+    }, { decoded }, JobThread::Main);
+}
+
 void loadScene(const std::string& filepath, GLFWwindow* window) {
-    if (SceneLoader::loadScene(filepath, g_scene)) {
-        if (g_scene.name.size() > 0)
-            glfwSetWindowTitle(window, (WINDOW_TITLE + " - " + g_scene.name).c_str());
-        g_renderer->loadScene(g_scene);
+    // Parsing and skybox decoding happen on the job system, only the GPU upload runs here
+    uint64_t request = ++g_sceneRequest;
+    g_sceneLoading = true;
+
+    Task<std::shared_ptr<Scene>> parsed = SceneLoader::loadSceneAsync(filepath);
+    JobSystem::get().run([parsed, request, filepath, window]() {
+        if (request != g_sceneRequest)
+            return;  // The newer load owns g_sceneLoading
+
+        std::shared_ptr<Scene> scene = parsed.get();
+        if (!scene) {
+            g_sceneLoading = false;
+            return;
+        }
+
+        const std::string& skyboxPath = scene->skyboxPath;
+        if (skyboxPath.empty() || isSkyboxCached(skyboxPath))
+            applyScene(*scene, filepath, window);
+        else
+            loadSkyboxAsync(skyboxPath, g_sceneRequest, request, [scene, filepath, window]() { applyScene(*scene, filepath, window); });
+    }, { parsed }, JobThread::Main);
+}
+
+void reloadScene(GLFWwindow* window) {
+    // A full load in flight reads the file again anyway
+    if (g_sceneLoading || g_scenePath.empty())
+        return;
+
+    uint64_t request = ++g_sceneRequest;
+    Task<std::shared_ptr<Scene>> parsed = SceneLoader::loadSceneAsync(g_scenePath);
+    JobSystem::get().run([parsed, request, window]() {
+        if (request != g_sceneRequest)
+            return;
+
+        // A file caught mid-save fails to parse, keep the current scene until the next change
+        std::shared_ptr<Scene> scene = parsed.get();
+        if (!scene)
+            return;
+
+        auto changes = std::make_shared<SceneChanges>(SceneDiff::compare(g_sceneFile, *scene));
+        const std::string& skyboxPath = scene->skyboxPath;
+        if (changes->skybox && !skyboxPath.empty() && !isSkyboxCached(skyboxPath))
+            loadSkyboxAsync(skyboxPath, g_sceneRequest, request, [scene, changes, window]() { applySceneChanges(*scene, *changes, window); });
+        else
+            applySceneChanges(*scene, *changes, window);
+    }, { parsed }, JobThread::Main);
+}
+
+// === RENDER THREAD ===
+bool isViewIdle(const ViewTarget& view)
+{
+    // Extra views stop once they have caught up with the main view's samples
+    return !view.renderer->needsRestart(view.camera) && view.renderer->getSampleCount() >= g_tracer->getRenderer().getSampleCount();
+}
+
+bool isRenderIdle()
+{
+    // Converged, and nothing has asked for the accumulation to restart
+    if (!g_convergence.isConverged() || g_tracer->getRenderer().getFrame() <= 1 || g_tracer->getRenderer().needsRestart(g_renderCamera))
+        return false;
+    return std::all_of(g_viewTargets.begin(), g_viewTargets.end(), [](const auto& view) { return isViewIdle(*view); });
+}
+
+void publishStatus()
+{
+    std::lock_guard<std::mutex> lock(g_statusMutex);
+    RenderStatus& status = g_renderStatus;
+    status.frame = g_tracer->getRenderer().getFrame();
+    status.lastRenderTime = g_lastRenderTime;
+    status.sampleCount = g_tracer->getRenderer().getSampleCount();
+    status.gpuFrameTime = g_scheduler.getFrameTime();
+    status.samplesPerSecond = g_scheduler.getSamplesPerSecond();
+    status.pathsPerSecond = g_scheduler.getPathsPerSecond();
+    status.scheduledSamplesPerPixel = g_scheduler.getSamplesPerPixel();
+    status.budget = g_scheduler.getBudget();
+    status.converged = g_convergence.isConverged();
+    status.stopReason = g_convergence.getReason();
+    status.elapsed = g_convergence.getElapsed();
+    status.noise = g_convergence.getNoise();
+    status.rayStats = g_tracer->getRenderer().getRayStats();
+
+    const Skybox* skybox = g_tracer->getRenderer().getResources().getActiveSkybox();
+    status.hasSkybox = skybox != nullptr;
+    status.skyboxWidth = skybox ? skybox->getWidth() : 0;
+    status.skyboxHeight = skybox ? skybox->getHeight() : 0;
+    status.skyboxMemory = skybox ? skybox->getMemoryUsage() : 0;
+    status.cachedSkyboxes = g_tracer->getRenderer().getResources().getCachedSkyboxes();
+    status.lightCount = g_tracer->getRenderer().getResources().getLightCount();
+    status.guideTrained = g_tracer->getRenderer().isGuideTrained();
+}
+
+// One frame of the main view and of any extra view still accumulating. False when all are idle
+bool renderFrame()
+{
+    if (!g_tracer)
+        return false;
+
+    bool rendered = false;
+
+    // Keep presenting the last image once converged
+    if (!isRenderIdle()) {
+        bool scheduled = g_scheduler.getMode() != BudgetMode::Fixed;
+        g_tracer->setCamera(g_renderCamera);
+
+        double renderStartTime = glfwGetTime();
+        g_tracer->render(scheduled ? g_scheduler.getSamplesPerPixel() : g_renderSamplesPerPixel);
+        double renderEndTime = glfwGetTime();
+        g_lastRenderTime = (float)((renderEndTime - renderStartTime) * 1000.0);
+
+        Renderer::GpuTiming timing;
+        if (g_tracer->getRenderer().pollGpuTiming(timing))
+            g_scheduler.addTiming(timing.milliseconds, timing.samplesPerPixel, static_cast<uint64_t>(g_tracer->getRenderer().getWidth()) * g_tracer->getRenderer().getHeight());
+
+        double frameSeconds = renderEndTime - (g_lastRenderEnd >= 0.0 ? g_lastRenderEnd : renderStartTime);
+        g_convergence.update(g_tracer->getRenderer(), frameSeconds);
+        g_display.publish(g_tracer->getRenderer());
+        rendered = true;
+    }
+    else {
+        // No more frames will poll the stats ring, collect the last frames' counts
+        g_tracer->getRenderer().flushRayStats();
     }
+
+    for (const std::shared_ptr<ViewTarget>& view : g_viewTargets) {
+        if (isViewIdle(*view))
+            continue;
+
+        bool scheduled = g_scheduler.getMode() != BudgetMode::Fixed;
+        view->renderer->setSamplesPerPixel(scheduled ? g_scheduler.getSamplesPerPixel() : g_renderSamplesPerPixel);
+        view->renderer->render(view->camera);
+        view->sampleCount = view->renderer->getSampleCount();
+        view->display.publish(*view->renderer);
+        rendered = true;
+    }
+
+    g_lastRenderEnd = rendered ? glfwGetTime() : -1.0;
+    publishStatus();
+
+    // The UI sleeps while the render thread is idle, show the new frame now rather than on the next event
+    if (rendered && g_uiWaiting.exchange(false))
+        glfwPostEmptyEvent();
+    return rendered;
 }
 
-// === RENDERER UTILITY ===
-void performRender()
+// === UI TO RENDER THREAD ===
+bool isSameCamera(const Camera& a, const Camera& b)
 {
-    if (!g_renderer) return;
+    return a.position == b.position && a.forward == b.forward && a.right == b.right && a.up == b.up;
+}
 
-    double renderStartTime = glfwGetTime();
-    g_renderer->render(g_camera);
-    g_lastRenderTime = (float)((glfwGetTime() - renderStartTime) * 1000.0);
+// Sends the camera if it moved since the last frame
+void syncCamera()
+{
+    if (isSameCamera(g_camera, g_postedCamera))
+        return;
+    g_postedCamera = g_camera;
+    g_renderThread.post([camera = g_camera]() { g_renderCamera = camera; });
+}
+
+void addSceneView()
+{
+    SceneView view;
+    view.name = "View " + std::to_string(g_nextViewId++);
+    view.target = std::make_shared<ViewTarget>();
+    view.camera = g_camera;
+    view.postedCamera = g_camera;
+
+    g_renderThread.post([target = view.target, camera = view.camera]() {
+        target->renderer = std::make_unique<Renderer>(g_tracer->getRenderer().getWidth(), g_tracer->getRenderer().getHeight(), g_tracer->getRenderer().getSharedResources());
+        target->renderer->setRestir(g_tracer->getRenderer().getRestir());
+        target->renderer->setGuiding(g_tracer->getRenderer().getGuiding());
+        target->renderer->setRadianceCache(g_tracer->getRenderer().getRadianceCache());
+        target->camera = camera;
+        g_viewTargets.push_back(target);
+    });
+    g_views.push_back(std::move(view));
+}
+
+void removeClosedViews()
+{
+    // The render thread has to drop the last reference, the renderer's GL objects belong to its context
+    std::vector<std::shared_ptr<ViewTarget>> closed;
+    for (SceneView& view : g_views)
+        if (!view.open)
+            closed.push_back(std::move(view.target));
+    g_views.erase(std::remove_if(g_views.begin(), g_views.end(), [](const SceneView& view) { return !view.open; }), g_views.end());
+
+    for (std::shared_ptr<ViewTarget>& target : closed) {
+        g_renderThread.post([target = std::move(target)]() {
+            g_viewTargets.erase(std::remove(g_viewTargets.begin(), g_viewTargets.end(), target), g_viewTargets.end());
+        });
+    }
+}
+
+void updateTurntable(SceneView& view, float deltaTime)
+{
+    view.camera.yaw += view.turntableSpeed * deltaTime;
+    view.camera.updateOrientation();
+    view.camera.position = view.pivot - view.camera.forward * view.pivotDistance;
+}
+
+// === SESSION RECORDING ===
+Session::SessionSettings getSessionSettings()
+{
+    Session::SessionSettings settings;
+    settings.gamma = g_gamma;
+    settings.maxBounces = g_maxBounces;
+    settings.samplesPerPixel = g_samplesPerPixel;
+    settings.budgetMode = static_cast<BudgetMode>(g_budgetMode);
+    settings.frameBudget = g_frameBudget;
+    settings.skyboxPath = g_scene.skyboxPath;
+    settings.skyboxFormat = static_cast<SkyboxFormat>(g_skyboxFormat);
+    settings.skyboxExposureEV = g_skyboxExposureEV;
+    settings.sunPitch = g_sunPitch;
+    settings.sunYaw = g_sunYaw;
+    settings.sunColour = g_sunColour;
+    settings.sunIntensity = g_sunIntensity;
+    settings.sunFocus = g_sunFocus;
+    settings.statsEnabled = g_statsEnabled;
+    settings.restir = g_restir;
+    settings.guiding = g_guiding;
+    settings.radianceCache = g_radianceCache;
+    return settings;
+}
+
+void startSessionRecording(const std::string& filepath)
+{
+    g_sessionRecorder.start(filepath, glfwGetTime(), g_scenePath);
+    std::cout << "Recording session to " << filepath << std::endl;
 }
 
 // == INITIALISATION FUNCTIONS ===
@@ -172,6 +725,7 @@ void initGLFW() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLDebug::isDebugContext() ? GLFW_TRUE : GLFW_FALSE);
 }
 
 GLFWwindow* createGLFWWindow() {
@@ -193,6 +747,7 @@ void initGLAD() {
     }
 
     std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
+    GLDebug::install();
     glViewport(0, 0, g_windowWidth, g_windowHeight);
 }
 
@@ -217,11 +772,28 @@ void setupImGui(GLFWwindow* window) {
     ImGui_ImplOpenGL3_Init("#version 440");
 }
 
-void setupRenderer(uint32_t initialWidth, uint32_t initialHeight) {
-    static Renderer rendererInstance(initialWidth, initialHeight);
-    g_renderer = &rendererInstance;
-    g_renderer->onResize(initialWidth, initialHeight);
-    performRender();
+void setupRenderer(GLFWwindow* window, uint32_t initialWidth, uint32_t initialHeight) {
+    // Everything the path tracer owns is created on the render thread, in its context
+    if (!g_renderThread.start(window, renderFrame))
+        exit(EXIT_FAILURE);
+
+    auto created = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = created->get_future();
+    g_renderThread.post([initialWidth, initialHeight, created]() {
+        // The render thread's context is current and GL is loaded, the tracer renders into it
+        RayTracerSettings settings;
+        settings.width = initialWidth;
+        settings.height = initialHeight;
+        settings.createContext = false;
+        settings.samplesPerFrame = SampleScheduler::MAX_SAMPLES_PER_PIXEL;  // One dispatch per frame, the scheduler sizes it
+        g_tracer = RayTracer::create(settings);
+        created->set_value(g_tracer != nullptr);
+    });
+
+    if (!result.get()) {
+        g_renderThread.stop();
+        exit(EXIT_FAILURE);
+    }
 }
 
 // === IMGUI UI DRAWING FUNCTIONS ===
@@ -233,13 +805,16 @@ void setupImGuiDockingLayout(ImGuiID dockspace_id, ImVec2 viewportSize) {
         ImGui::DockBuilderAddNode(dockspace_id, ImGuiDockNodeFlags_DockSpace | ImGuiDockNodeFlags_PassthruCentralNode); // Recreate empty node
         ImGui::DockBuilderSetNodeSize(dockspace_id, viewportSize);
 
-        // Split dockspace: 75% viewport, 25% settings
+        // Split dockspace: 75% viewport, 25% settings above the inspector
         ImGuiID dock_id_right;
         ImGuiID dock_id_main = ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Left, 0.75f, nullptr, &dock_id_right);
+        ImGuiID dock_id_settings;
+        ImGuiID dock_id_inspector = ImGui::DockBuilderSplitNode(dock_id_right, ImGuiDir_Down, 0.35f, nullptr, &dock_id_settings);
 
         // Dock windows into the created nodes
         ImGui::DockBuilderDockWindow("Viewport", dock_id_main);
-        ImGui::DockBuilderDockWindow("Settings", dock_id_right);
+        ImGui::DockBuilderDockWindow("Settings", dock_id_settings);
+        ImGui::DockBuilderDockWindow("Inspector", dock_id_inspector);
         ImGui::DockBuilderFinish(dockspace_id);
     }
 }
@@ -250,7 +825,15 @@ void renderImGuiMenuBar(GLFWwindow* window) {
             if (ImGui::MenuItem("Load Scene")) {
                 IGFD::FileDialogConfig config;
                 config.path = "./scenes";
-                ImGuiFileDialog::Instance()->OpenDialog("ChooseSceneFile", "Choose Scene", ".json", config);
+                ImGuiFileDialog::Instance()->OpenDialog("ChooseSceneFile", "Choose Scene", ".json,.rtscene", config);
+            }
+
+            if (ImGui::MenuItem("Reload Scene On Change", nullptr, &g_hotReload)) {
+                // Picks up anything saved while it was off
+                if (g_hotReload && g_sceneWatcher.watch(g_scenePath))
+                    reloadScene(window);
+                else
+                    g_sceneWatcher.stop();
             }
 
             if (ImGui::MenuItem("Export Render")) {
@@ -259,12 +842,27 @@ void renderImGuiMenuBar(GLFWwindow* window) {
                 ImGuiFileDialog::Instance()->OpenDialog("ChooseExportFile", "Choose Export File", ".png", config);
             }
 
+            if (g_sessionRecorder.isRecording()) {
+                if (ImGui::MenuItem("Stop Recording"))
+                    g_sessionRecorder.stop(glfwGetTime());
+            }
+            else if (ImGui::MenuItem("Record Session")) {
+                std::filesystem::create_directories("./sessions");
+                IGFD::FileDialogConfig config;
+                config.path = "./sessions";
+                ImGuiFileDialog::Instance()->OpenDialog("ChooseSessionFile", "Choose Session File", ".json", config);
+            }
+
             if (ImGui::MenuItem("Exit", "Alt+F4"))
                 glfwSetWindowShouldClose(window, true);
 
             ImGui::EndMenu();
         }
 
+        if (g_sessionRecorder.isRecording())
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Recording %.0fs, %zu events", g_sessionRecorder.getDuration(glfwGetTime()),
+                g_sessionRecorder.getEventCount());
+
         ImGui::EndMenuBar();
     }
 }
@@ -274,10 +872,238 @@ void renderImGuiSettingsWindow(ImGuiIO& io) {
 
     // Performance / Debug
     if (ImGui::CollapsingHeader("Performance/Debug", ImGuiTreeNodeFlags_DefaultOpen)) {
-        ImGui::Text("Last render: %.3fms", g_lastRenderTime);
-        ImGui::Text("Frame number: %.1f", (float)g_renderer->getFrame());
+        ImGui::Text("Last render: %.3fms", g_status.lastRenderTime);
+        ImGui::Text("GPU frame time: %.2fms", g_status.gpuFrameTime);
+        ImGui::Text("Samples/s: %.1f per pixel, %.1fM paths", g_status.samplesPerSecond, g_status.pathsPerSecond / 1.0e6f);
+        ImGui::Text("Frame number: %.1f", (float)g_status.frame);
         ImGui::Text("Application FPS: %.1f", io.Framerate);
         ImGui::Text("Viewport size: %dx%d", g_viewportWidth, g_viewportHeight);
+        ImGui::Text("Jobs: %zu pending on %u workers", JobSystem::get().getPendingJobCount(), JobSystem::get().getWorkerCount());
+        if (g_sceneLoading)
+            ImGui::Text("Loading scene...");
+    }
+    ImGui::Separator();
+
+    // Stop Conditions
+    if (ImGui::CollapsingHeader("Stop Conditions", ImGuiTreeNodeFlags_DefaultOpen)) {
+        bool changed = false;
+
+        ImGui::PushItemWidth(-1);
+        ImGui::Text("Target Samples (0 = off):");
+        changed |= ImGui::InputInt("##TargetSamples", &g_targetSamples, 64, 1024);
+        ImGui::Text("Target Noise %% (0 = off):");
+        changed |= ImGui::SliderFloat("##TargetNoise", &g_targetNoisePercent, 0.0f, 10.0f, "%.2f");
+        ImGui::Text("Time Limit (s, 0 = off):");
+        changed |= ImGui::InputFloat("##TimeLimit", &g_timeLimit, 10.0f, 60.0f, "%.0f");
+        ImGui::PopItemWidth();
+
+        if (changed) {
+            StopConditions conditions;
+            conditions.targetSamples = static_cast<uint64_t>(std::max(g_targetSamples, 0));
+            conditions.targetNoise = std::max(g_targetNoisePercent, 0.0f) / 100.0f;
+            conditions.timeLimit = std::max(g_timeLimit, 0.0f);
+            g_renderThread.post([conditions]() { g_convergence.setConditions(conditions); });
+        }
+
+        if (g_status.converged)
+            ImGui::Text("Stopped: %s", getStopReasonName(g_status.stopReason));
+        else
+            ImGui::Text("Tracing");
+        ImGui::Text("Samples: %llu", static_cast<unsigned long long>(g_status.sampleCount));
+        ImGui::Text("Elapsed: %.1fs", g_status.elapsed);
+        if (g_status.noise >= 0.0f)
+            ImGui::Text("Noise: %.2f%%", g_status.noise * 100.0f);
+    }
+    ImGui::Separator();
+
+    // Ray Statistics (instrumented shader)
+    if (ImGui::CollapsingHeader("Ray Statistics")) {
+        if (ImGui::Checkbox("Instrument Shader", &g_statsEnabled))
+            g_renderThread.post([enabled = g_statsEnabled]() { g_tracer->getRenderer().setStatsEnabled(enabled); });
+
+        if (g_statsEnabled) {
+            if (ImGui::Checkbox("Cost Heatmap", &g_showHeatmap))
+                g_renderThread.post([show = g_showHeatmap, scale = g_heatmapScale]() { g_tracer->getRenderer().setHeatmap(show, scale); });
+
+            ImGui::PushItemWidth(-1);
+            ImGui::Text("Heatmap Scale (tests/sample):");
+            if (ImGui::SliderFloat("##HeatmapScale", &g_heatmapScale, 1.0f, 1024.0f, "%.0f", ImGuiSliderFlags_Logarithmic))
+                g_renderThread.post([show = g_showHeatmap, scale = g_heatmapScale]() { g_tracer->getRenderer().setHeatmap(show, scale); });
+            ImGui::PopItemWidth();
+
+            const RayStats& stats = g_status.rayStats;
+            double rays = stats.rays > 0 ? static_cast<double>(stats.rays) : 1.0;
+
+            ImGui::Text("Primary rays: %llu", static_cast<unsigned long long>(stats.rays));
+            ImGui::Text("Bounces: %llu (%.2f per ray)", static_cast<unsigned long long>(stats.bounces), stats.bounces / rays);
+            ImGui::Text("Primitive tests: %.2f per ray", stats.primitiveTests / rays);
+            ImGui::Text("Terminated by:");
+            ImGui::Indent();
+            ImGui::Text("Miss: %.1f%%", 100.0 * stats.missTerminations / rays);
+            ImGui::Text("Russian roulette: %.1f%%", 100.0 * stats.rouletteTerminations / rays);
+            ImGui::Text("Max bounces: %.1f%%", 100.0 * stats.maxBounceTerminations / rays);
+            ImGui::Unindent();
+        }
+    }
+    ImGui::Separator();
+
+    // Direct Lighting (reservoir resampling of emitters and the sun)
+    if (ImGui::CollapsingHeader("Direct Lighting")) {
+        bool changed = ImGui::Checkbox("ReSTIR", &g_restir.enabled);
+
+        if (g_restir.enabled) {
+            changed |= ImGui::Checkbox("Unbiased", &g_restir.unbiased);
+
+            int candidates = static_cast<int>(g_restir.candidates);
+            int spatialSamples = static_cast<int>(g_restir.spatialSamples);
+            int maxHistory = static_cast<int>(g_restir.maxHistory);
+
+            ImGui::PushItemWidth(-1);
+            ImGui::Text("Candidates per pixel:");
+            changed |= ImGui::SliderInt("##RestirCandidates", &candidates, 1, 32);
+            ImGui::Text("Neighbours reused:");
+            changed |= ImGui::SliderInt("##RestirSpatialSamples", &spatialSamples, 0, 7);
+            ImGui::Text("Neighbour radius (px):");
+            changed |= ImGui::SliderFloat("##RestirSpatialRadius", &g_restir.spatialRadius, 1.0f, 64.0f, "%.0f");
+            ImGui::Text("History (frames):");
+            changed |= ImGui::SliderInt("##RestirMaxHistory", &maxHistory, 1, 64);
+            ImGui::PopItemWidth();
+
+            g_restir.candidates = static_cast<uint32_t>(candidates);
+            g_restir.spatialSamples = static_cast<uint32_t>(spatialSamples);
+            g_restir.maxHistory = static_cast<uint32_t>(maxHistory);
+
+            ImGui::Text("Sampled emitters: %d%s", g_status.lightCount, g_sunIntensity > 0.0f && g_sunFocus > 0.0f ? " and the sun" : "");
+        }
+
+        if (changed) {
+            g_renderThread.post([settings = g_restir]() {
+                g_tracer->getRenderer().setRestir(settings);
+                for (const std::shared_ptr<ViewTarget>& target : g_viewTargets)
+                    target->renderer->setRestir(settings);
+            });
+        }
+    }
+    ImGui::Separator();
+
+    // Path Guiding (learned sampling of diffuse bounces)
+    if (ImGui::CollapsingHeader("Path Guiding")) {
+        bool changed = ImGui::Checkbox("Guide Diffuse Bounces", &g_guiding.enabled);
+
+        if (g_guiding.enabled) {
+            int spatialThreshold = static_cast<int>(g_guiding.spatialThreshold / 1000);
+            int trainingIterations = static_cast<int>(g_guiding.trainingIterations);
+
+            ImGui::PushItemWidth(-1);
+            ImGui::Text("Guided fraction:");
+            changed |= ImGui::SliderFloat("##GuideMixing", &g_guiding.mixing, 0.05f, 0.95f, "%.2f");
+            ImGui::Text("Samples per region (thousands):");
+            changed |= ImGui::SliderInt("##GuideSpatialThreshold", &spatialThreshold, 1, 64);
+            ImGui::Text("Training iterations:");
+            changed |= ImGui::SliderInt("##GuideTrainingIterations", &trainingIterations, 1, 12);
+            ImGui::PopItemWidth();
+
+            g_guiding.spatialThreshold = static_cast<uint32_t>(spatialThreshold) * 1000;
+            g_guiding.trainingIterations = static_cast<uint32_t>(trainingIterations);
+
+            if (g_status.guideTrained)
+                ImGui::Text("Training finished");
+            else
+                ImGui::Text("Training for %u frames", (1u << g_guiding.trainingIterations) - 1);
+        }
+
+        if (changed) {
+            g_renderThread.post([settings = g_guiding]() {
+                g_tracer->getRenderer().setGuiding(settings);
+                for (const std::shared_ptr<ViewTarget>& target : g_viewTargets)
+                    target->renderer->setGuiding(settings);
+            });
+        }
+    }
+    ImGui::Separator();
+
+    // Radiance Cache (preview integrator, paths end in cached indirect light)
+    if (ImGui::CollapsingHeader("Radiance Cache")) {
+        bool changed = ImGui::Checkbox("Cache Indirect Light (preview)", &g_radianceCache.enabled);
+
+        if (g_radianceCache.enabled) {
+            int terminationBounce = static_cast<int>(g_radianceCache.terminationBounce);
+
+            ImGui::PushItemWidth(-1);
+            ImGui::Text("Cell size near the camera:");
+            changed |= ImGui::SliderFloat("##CacheCellSize", &g_radianceCache.cellSize, 0.005f, 0.5f, "%.3f", ImGuiSliderFlags_Logarithmic);
+            ImGui::Text("End paths from bounce:");
+            changed |= ImGui::SliderInt("##CacheTerminationBounce", &terminationBounce, 1, 4);
+            ImGui::Text("Full paths training the cache:");
+            changed |= ImGui::SliderFloat("##CacheUpdateFraction", &g_radianceCache.updateFraction, 0.01f, 0.5f, "%.2f");
+            ImGui::PopItemWidth();
+
+            g_radianceCache.terminationBounce = static_cast<uint32_t>(terminationBounce);
+        }
+
+        if (changed) {
+            g_renderThread.post([settings = g_radianceCache]() {
+                g_tracer->getRenderer().setRadianceCache(settings);
+                for (const std::shared_ptr<ViewTarget>& target : g_viewTargets)
+                    target->renderer->setRadianceCache(settings);
+            });
+        }
+    }
+    ImGui::Separator();
+
+    // Extra Views of the same scene
+    if (ImGui::CollapsingHeader("Views")) {
+        if (ImGui::Button("Add View From Camera"))
+            addSceneView();
+
+        for (SceneView& view : g_views) {
+            ImGui::PushID(view.name.c_str());
+            ImGui::Text("%s: %llu samples", view.name.c_str(), static_cast<unsigned long long>(view.target->sampleCount.load()));
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Close"))
+                view.open = false;
+
+            if (ImGui::Button("Use Current Camera"))
+                view.camera = g_camera;
+
+            if (ImGui::Checkbox("Turntable", &view.turntable) && view.turntable)
+                view.pivot = view.camera.position + view.camera.forward * view.pivotDistance;
+            if (view.turntable) {
+                ImGui::PushItemWidth(-1);
+                ImGui::SliderFloat("##TurntableSpeed", &view.turntableSpeed, -90.0f, 90.0f, "%.0f deg/s");
+                if (ImGui::SliderFloat("##PivotDistance", &view.pivotDistance, 0.5f, 50.0f, "Pivot %.1f"))
+                    view.pivot = view.camera.position + view.camera.forward * view.pivotDistance;
+                ImGui::PopItemWidth();
+            }
+            ImGui::Separator();
+            ImGui::PopID();
+        }
+    }
+    ImGui::Separator();
+
+    // GPU Memory (tracked GL objects)
+    if (ImGui::CollapsingHeader("GPU Memory")) {
+        const double MB = 1024.0 * 1024.0;
+        ImGui::Text("Total: %.1f MB in %zu objects", GpuMemory::getTotal() / MB, GpuMemory::getObjectCount());
+        ImGui::Indent();
+        ImGui::Text("Textures: %.1f MB", GpuMemory::getTotal(GpuResourceKind::Texture) / MB);
+        ImGui::Text("Buffers: %.1f MB", GpuMemory::getTotal(GpuResourceKind::Buffer) / MB);
+        ImGui::Unindent();
+
+        ImGui::PushItemWidth(-1);
+        ImGui::Text("Budget (MB, 0 = none):");
+        if (ImGui::InputInt("##VramBudget", &g_vramBudgetMB, 64, 256)) {
+            g_vramBudgetMB = std::max(g_vramBudgetMB, 0);
+            GpuMemory::setBudget(static_cast<size_t>(g_vramBudgetMB) * 1024 * 1024);
+        }
+        ImGui::PopItemWidth();
+        if (GpuMemory::isOverBudget())
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "Over budget!");
+
+        ImGui::Text("Largest allocations:");
+        std::vector<GpuMemory::Allocation> allocations = GpuMemory::getAllocations();
+        for (size_t i = 0; i < allocations.size() && i < 8; ++i)
+            ImGui::BulletText("%s: %.2f MB", allocations[i].label.c_str(), allocations[i].bytes / MB);
     }
     ImGui::Separator();
 
@@ -287,15 +1113,35 @@ void renderImGuiSettingsWindow(ImGuiIO& io) {
 
         ImGui::Text("Gamma:");
         if (ImGui::SliderFloat("##Gamma", &g_gamma, 1.8f, 2.8f, "%.2f"))
-            g_renderer->setGamma(g_gamma);
+            g_renderThread.post([gamma = g_gamma]() { g_tracer->getRenderer().getResources().setGamma(gamma); });
 
         ImGui::Text("Max Bounces:");
         if (ImGui::SliderInt("##Max Bounces", &g_maxBounces, 1, 64))
-            g_renderer->setMaxBounces(g_maxBounces);
+            g_renderThread.post([bounces = g_maxBounces]() { g_tracer->getRenderer().getResources().setMaxBounces(bounces); });
+
+        ImGui::Text("Frame Budget:");
+        const char* budgetModes[] = { "Fixed Samples", "Interactive", "Max Throughput" };
+        if (ImGui::Combo("##FrameBudget", &g_budgetMode, budgetModes, IM_ARRAYSIZE(budgetModes))) {
+            g_renderThread.post([mode = static_cast<BudgetMode>(g_budgetMode)]() {
+                g_scheduler.setMode(mode);
+            });
+        }
+
+        BudgetMode budgetMode = static_cast<BudgetMode>(g_budgetMode);
+        if (budgetMode == BudgetMode::Interactive) {
+            ImGui::Text("Budget (ms):");
+            if (ImGui::SliderFloat("##Budget", &g_frameBudget, 4.0f, 100.0f, "%.0f"))
+                g_renderThread.post([budget = g_frameBudget]() { g_scheduler.setBudget(budget); });
+        }
 
-        ImGui::Text("Samples Per Pixel:");
-        if (ImGui::SliderInt("##Samples Per Pixel", &g_samplesPerPixel, 1, 128))
-            g_renderer->setSamplesPerPixel(g_samplesPerPixel);
+        if (budgetMode == BudgetMode::Fixed) {
+            ImGui::Text("Samples Per Pixel:");
+            if (ImGui::SliderInt("##Samples Per Pixel", &g_samplesPerPixel, 1, 128))
+                g_renderThread.post([samples = static_cast<uint32_t>(g_samplesPerPixel)]() { g_renderSamplesPerPixel = samples; });
+        }
+        else {
+            ImGui::Text("Samples Per Pixel: %u (%.0fms budget)", g_status.scheduledSamplesPerPixel, g_status.budget);
+        }
 
         ImGui::PopItemWidth();
     }
@@ -310,37 +1156,46 @@ void renderImGuiSettingsWindow(ImGuiIO& io) {
             ImGuiFileDialog::Instance()->OpenDialog("ChooseSkyboxFile", "Choose Skybox", ".hdr", config);
         }
         ImGui::SameLine();
-        if (ImGui::Button("Clear Skybox"))
-            if (g_renderer)
-                g_renderer->setSkybox("");
+        if (ImGui::Button("Clear Skybox")) {
+            g_scene.skyboxPath.clear();
+            g_renderThread.post([]() { g_tracer->getRenderer().getResources().setSkybox(""); });
+        }
 
         ImGui::PushItemWidth(-1);
+        ImGui::Text("Skybox Format:");
+        const char* skyboxFormats[] = { "RGB32F", "RGB16F", "RGB9_E5", "BC6H" };
+        if (ImGui::Combo("##SkyboxFormat", &g_skyboxFormat, skyboxFormats, IM_ARRAYSIZE(skyboxFormats)))
+            g_renderThread.post([format = static_cast<SkyboxFormat>(g_skyboxFormat)]() { g_tracer->getRenderer().getResources().setSkyboxFormat(format); });
+
+        if (g_status.hasSkybox)
+            ImGui::Text("%dx%d, %.1f MB with mipmaps", g_status.skyboxWidth, g_status.skyboxHeight, g_status.skyboxMemory / (1024.0 * 1024.0));
+
         ImGui::Text("Skybox Exposure (EV):");
         if (ImGui::SliderFloat("##SkyboxExposureEV", &g_skyboxExposureEV, -5.0f, 5.0f, "%.2f")) {
             float linearExposure = powf(2.0f, g_skyboxExposureEV);
-            g_renderer->setSkyboxExposure(linearExposure);
+            g_renderThread.post([linearExposure]() { g_tracer->getRenderer().getResources().setSkyboxExposure(linearExposure); });
         }
 
         ImGui::Text("Sun Pitch:");
         if (ImGui::SliderFloat("##Pitch", &g_sunPitch, -180.0f, 180.0f))
-            g_renderer->setSunDirection(g_scene.getSunDirection());
+            g_renderThread.post([direction = g_scene.getSunDirection()]() { g_tracer->getRenderer().getResources().setSunDirection(direction); });
         ImGui::Text("Sun Yaw:");
         if (ImGui::SliderFloat("##Yaw", &g_sunYaw, -360.0f, 360.0f))
-            g_renderer->setSunDirection(g_scene.getSunDirection());
+            g_renderThread.post([direction = g_scene.getSunDirection()]() { g_tracer->getRenderer().getResources().setSunDirection(direction); });
 
         ImGui::PopItemWidth();
 
         ImGui::Text("Sun Colour:");
         if (ImGui::ColorEdit3("##Sun Colour", glm::value_ptr(g_sunColour)))
-            g_renderer->setSunColour(g_sunColour);
+            g_renderThread.post([colour = g_sunColour]() { g_tracer->getRenderer().getResources().setSunColour(colour); });
 
         ImGui::PushItemWidth(-1);
         ImGui::Text("Sun Intensity:");
         if (ImGui::SliderFloat("##SunIntensity", &g_sunIntensity, 0, 1000, "%.0f"))
-            g_renderer->setSunIntensity(g_sunIntensity);
+            g_renderThread.post([intensity = g_sunIntensity]() { g_tracer->getRenderer().getResources().setSunIntensity(intensity); });
         ImGui::Text("Sun Focus:");
         if (ImGui::SliderFloat("##SunFocus", &g_sunFocus, 0, 1000, "%.0f"))
-            g_renderer->setSunFocus(g_sunFocus);
+            g_renderThread.post([focus = g_sunFocus]() { g_tracer->getRenderer().getResources().setSunFocus(focus); });
         ImGui::PopItemWidth();
     }
     ImGui::Separator();
@@ -371,38 +1226,297 @@ void renderImGuiSettingsWindow(ImGuiIO& io) {
     ImGui::End();
 }
 
+// Outlines the selected primitive's bounding box over the viewport. Planes are unbounded and aren't outlined
+void drawSelectionBounds(ImVec2 origin, ImVec2 size) {
+    if (g_selection.index < 0 || g_selection.type == Intersection::HitType::Plane || size.x <= 0.0f || size.y <= 0.0f)
+        return;
+
+    // Corners to viewport pixels, the inverse of the shader's primary ray directions
+    Bounds bounds = SceneIndex::getBounds(g_scene, g_selection.type, static_cast<size_t>(g_selection.index));
+    float aspectRatio = size.x / size.y;
+    ImVec2 points[8];
+    bool visible[8];
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z);
+        glm::vec3 offset = corner - g_camera.position;
+        float depth = glm::dot(offset, g_camera.forward);
+        visible[i] = depth > 1e-3f;
+        float x = glm::dot(offset, g_camera.right) / (depth * aspectRatio);
+        float y = glm::dot(offset, g_camera.up) / depth;
+        points[i] = ImVec2(origin.x + (x + 1.0f) * 0.5f * size.x, origin.y + (1.0f - y) * 0.5f * size.y);
+    }
+
+    // Edges join corners that differ in one coordinate. Edges reaching behind the camera are left out
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    for (int i = 0; i < 8; ++i) {
+        for (int axis = 1; axis < 8; axis <<= 1) {
+            int j = i | axis;
+            if (j != i && visible[i] && visible[j])
+                drawList->AddLine(points[i], points[j], IM_COL32(255, 190, 0, 255), 1.5f);
+        }
+    }
+}
+
 void renderImGuiViewportWindow() {
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
     ImGui::Begin("Viewport");
 
     ImVec2 viewportSize = ImGui::GetContentRegionAvail(); // Get available space
+    ImVec2 viewportOrigin = ImGui::GetCursorScreenPos();
 
     // Resize renderer if viewport dimensions change
     if (g_viewportWidth != static_cast<uint32_t>(viewportSize.x) || g_viewportHeight != static_cast<uint32_t>(viewportSize.y)) {
         g_viewportWidth = static_cast<uint32_t>(viewportSize.x);
         g_viewportHeight = static_cast<uint32_t>(viewportSize.y);
 
-        if (g_renderer)
-            g_renderer->onResize(g_viewportWidth, g_viewportHeight);
+        g_renderThread.post([width = g_viewportWidth, height = g_viewportHeight]() { g_tracer->setResolution(width, height); });
     }
 
-    // Render the scene if needed and dimensions are valid
-    if (g_viewportWidth > 0 && g_viewportHeight > 0)
-        performRender();
-
-    // Display the rendered image texture
-    if (g_renderer && g_renderer->getDisplayTexture() && g_viewportWidth > 0 && g_viewportHeight > 0)
-        ImGui::Image(static_cast<ImTextureID>(g_renderer->getDisplayTexture()), viewportSize, ImVec2(0, 1), ImVec2(1, 0));
+    // Display the newest finished frame, the render thread keeps tracing meanwhile
+    const DisplayBuffer::Frame& frame = g_display.acquire();
+    if (frame.texture && g_viewportWidth > 0 && g_viewportHeight > 0) {
+        // The texture may be larger than the viewport, only show the rendered region
+        ImGui::Image(static_cast<ImTextureID>(frame.texture), viewportSize, ImVec2(0, frame.scale.y), ImVec2(frame.scale.x, 0));
+        drawSelectionBounds(viewportOrigin, viewportSize);
+    }
 
     g_viewportFocused = ImGui::IsWindowFocused();
     g_viewportHovered = ImGui::IsWindowHovered();
+    if (g_viewportHovered && !g_mouseHeld) {
+        ImVec2 mouse = ImGui::GetMousePos();
+        g_viewportMouse = glm::vec2(mouse.x - viewportOrigin.x, mouse.y - viewportOrigin.y);
+    }
 
     ImGui::End();
     ImGui::PopStyleVar();
 }
 
+// Fields as in the scene files, true if any changed
+bool editMaterial(Material& material) {
+    bool changed = false;
+
+    ImGui::Text("Colour:");
+    changed |= ImGui::ColorEdit3("##Colour", glm::value_ptr(material.colour));
+    ImGui::Text("Smoothness:");
+    changed |= ImGui::SliderFloat("##Smoothness", &material.smoothness, 0.0f, 1.0f, "%.2f");
+    ImGui::Text("Specular Colour:");
+    changed |= ImGui::ColorEdit3("##SpecularColour", glm::value_ptr(material.specularColour));
+    ImGui::Text("Specular Probability:");
+    changed |= ImGui::SliderFloat("##SpecularProbability", &material.specularProbability, 0.0f, 1.0f, "%.2f");
+    ImGui::Text("Emission Colour:");
+    changed |= ImGui::ColorEdit3("##EmissionColour", glm::value_ptr(material.emissionColour));
+    ImGui::Text("Emission Strength:");
+    changed |= ImGui::DragFloat("##EmissionStrength", &material.emissionStrength, 0.1f, 0.0f, 1000.0f, "%.1f");
+
+    bool checkerboard = (material.flag & FLAG_CHECKERBOARD) != 0;
+    if (ImGui::Checkbox("Checkerboard", &checkerboard)) {
+        material.flag = checkerboard ? (material.flag | FLAG_CHECKERBOARD) : (material.flag & ~FLAG_CHECKERBOARD);
+        changed = true;
+    }
+    return changed;
+}
+
+// The picked primitive's transform and material. Edits are compiled like a loaded scene, values that wouldn't
+// compile are dropped, and only the edited element goes to the GPU
+void renderImGuiInspectorWindow() {
+    using Intersection::HitType;
+    static const char* const TYPE_NAMES[] = { "None", "Sphere", "Plane", "Quad", "Box", "Disc", "Cylinder" };
+    static const char* const FACE_NAMES[BOX_FACE_COUNT] = { "Left", "Right", "Bottom", "Top", "Back", "Front" };
+
+    ImGui::Begin("Inspector");
+
+    if (g_selection.index < 0) {
+        ImGui::TextWrapped("Click an object in the viewport to select it, dragging still turns the camera.");
+        ImGui::Text("Index: %zu primitives, %zu nodes", g_sceneIndex.getPrimitiveCount(), g_sceneIndex.getNodeCount());
+        ImGui::End();
+        return;
+    }
+
+    size_t index = static_cast<size_t>(g_selection.index);
+    ImGui::Text("%s %zu", TYPE_NAMES[static_cast<int>(g_selection.type)], index);
+    ImGui::Text("Picked in %.3fms", g_pickTime);
+    if (ImGui::Button("Deselect")) {
+        g_selection = Intersection::Hit();
+        ImGui::End();
+        return;
+    }
+    ImGui::Separator();
+
+    ImGui::PushItemWidth(-1);
+    bool changed = false;
+    switch (g_selection.type) {
+    case HitType::Sphere: {
+        Sphere sphere = g_scene.spheres[index];
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(sphere.position), 0.05f);
+        ImGui::Text("Radius:");
+        changed |= ImGui::DragFloat("##Radius", &sphere.radius, 0.01f, 0.001f, 1000.0f);
+        changed |= editMaterial(sphere.material);
+
+        if (changed && SceneCompiler::compileSphere(sphere)) {
+            g_scene.spheres[index] = sphere;
+            postPrimitiveEdit(HitType::Sphere, &Scene::spheres, &SceneChanges::spheres, index);
+        }
+        break;
+    }
+    case HitType::Plane: {
+        Plane plane = g_scene.planes[index];
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(plane.position), 0.05f);
+        ImGui::Text("Normal:");
+        changed |= ImGui::DragFloat3("##Normal", glm::value_ptr(plane.normal), 0.01f);
+        changed |= editMaterial(plane.material);
+
+        if (changed && SceneCompiler::compilePlane(plane)) {
+            g_scene.planes[index] = plane;
+            postPrimitiveEdit(HitType::Plane, &Scene::planes, &SceneChanges::planes, index);
+        }
+        break;
+    }
+    case HitType::Quad: {
+        Quad quad = g_scene.quads[index];
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(quad.position), 0.05f);
+        ImGui::Text("Width:");
+        changed |= ImGui::DragFloat("##Width", &quad.width, 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Height:");
+        changed |= ImGui::DragFloat("##Height", &quad.height, 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Normal:");
+        changed |= ImGui::DragFloat3("##Normal", glm::value_ptr(quad.normal), 0.01f);
+        ImGui::Text("Right:");
+        changed |= ImGui::DragFloat3("##Right", glm::value_ptr(quad.right), 0.01f);
+        changed |= editMaterial(quad.material);
+
+        if (changed && SceneCompiler::compileQuad(quad)) {
+            g_scene.quads[index] = quad;
+            postPrimitiveEdit(HitType::Quad, &Scene::quads, &SceneChanges::quads, index);
+        }
+        break;
+    }
+    case HitType::Box: {
+        Box box = g_scene.boxes[index];
+        glm::vec3 size(box.width, box.height, box.depth);
+        bool inward = box.inward != 0;
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(box.position), 0.05f);
+        ImGui::Text("Size:");
+        changed |= ImGui::DragFloat3("##Size", glm::value_ptr(size), 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Right:");
+        changed |= ImGui::DragFloat3("##Right", glm::value_ptr(box.right), 0.01f);
+        ImGui::Text("Up:");
+        changed |= ImGui::DragFloat3("##Up", glm::value_ptr(box.up), 0.01f);
+        changed |= ImGui::Checkbox("Inward", &inward);
+        ImGui::Text("Face:");
+        ImGui::Combo("##Face", &g_selectedFace, FACE_NAMES, BOX_FACE_COUNT);
+        changed |= editMaterial(box.materials[g_selectedFace]);
+
+        box.width = size.x;
+        box.height = size.y;
+        box.depth = size.z;
+        box.inward = inward ? 1 : 0;
+        if (changed && SceneCompiler::compileBox(box)) {
+            g_scene.boxes[index] = box;
+            postPrimitiveEdit(HitType::Box, &Scene::boxes, &SceneChanges::boxes, index);
+        }
+        break;
+    }
+    case HitType::Disc: {
+        Disc disc = g_scene.discs[index];
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(disc.position), 0.05f);
+        ImGui::Text("Radius:");
+        changed |= ImGui::DragFloat("##Radius", &disc.radius, 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Normal:");
+        changed |= ImGui::DragFloat3("##Normal", glm::value_ptr(disc.normal), 0.01f);
+        changed |= editMaterial(disc.material);
+
+        if (changed && SceneCompiler::compileDisc(disc)) {
+            g_scene.discs[index] = disc;
+            postPrimitiveEdit(HitType::Disc, &Scene::discs, &SceneChanges::discs, index);
+        }
+        break;
+    }
+    case HitType::Cylinder: {
+        Cylinder cylinder = g_scene.cylinders[index];
+        ImGui::Text("Position:");
+        changed |= ImGui::DragFloat3("##Position", glm::value_ptr(cylinder.position), 0.05f);
+        ImGui::Text("Radius:");
+        changed |= ImGui::DragFloat("##Radius", &cylinder.radius, 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Height:");
+        changed |= ImGui::DragFloat("##Height", &cylinder.height, 0.01f, 0.001f, 1000.0f);
+        ImGui::Text("Axis:");
+        changed |= ImGui::DragFloat3("##Axis", glm::value_ptr(cylinder.axis), 0.01f);
+        changed |= editMaterial(cylinder.material);
+
+        if (changed && SceneCompiler::compileCylinder(cylinder)) {
+            g_scene.cylinders[index] = cylinder;
+            postPrimitiveEdit(HitType::Cylinder, &Scene::cylinders, &SceneChanges::cylinders, index);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    ImGui::PopItemWidth();
+
+    ImGui::End();
+}
+
+void renderImGuiSceneViews() {
+    for (SceneView& view : g_views) {
+        ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImVec2(480, 320), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin(view.name.c_str(), &view.open)) {
+            ImVec2 size = ImGui::GetContentRegionAvail();
+            uint32_t width = static_cast<uint32_t>(size.x);
+            uint32_t height = static_cast<uint32_t>(size.y);
+
+            if (width > 0 && height > 0) {
+                if (width != view.width || height != view.height) {
+                    view.width = width;
+                    view.height = height;
+                    g_renderThread.post([target = view.target, width, height]() { target->renderer->onResize(width, height); });
+                }
+
+                if (view.turntable)
+                    updateTurntable(view, g_deltaTime);
+
+                if (!isSameCamera(view.camera, view.postedCamera)) {
+                    view.postedCamera = view.camera;
+                    g_renderThread.post([target = view.target, camera = view.camera]() { target->camera = camera; });
+                }
+
+                const DisplayBuffer::Frame& frame = view.target->display.acquire();
+                if (frame.texture)
+                    ImGui::Image(static_cast<ImTextureID>(frame.texture), size, ImVec2(0, frame.scale.y), ImVec2(frame.scale.x, 0));
+            }
+        }
+        ImGui::End();
+        ImGui::PopStyleVar();
+    }
+}
+
 // === CLEANUP ===
 void cleanup(GLFWwindow* window) {
+    if (g_sessionRecorder.isRecording())
+        g_sessionRecorder.stop(glfwGetTime());
+
+    // Discard pending loads, then let in-flight jobs finish while the render thread still takes commands
+    g_sceneRequest++;
+    g_skyboxRequest++;
+    JobSystem::get().waitForIdle();
+    JobSystem::get().setMainThreadWakeCallback(nullptr);
+
+    // GL objects are released on the render thread, which created them. Stopping runs the queued commands first
+    g_views.clear();
+    g_renderThread.post([]() {
+        g_viewTargets.clear();
+        g_display.reset();
+        g_tracer.reset();
+    });
+    g_renderThread.stop();
+    JobSystem::get().waitForIdle();  // Image exports queued just before closing
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -411,8 +1525,178 @@ void cleanup(GLFWwindow* window) {
     glfwTerminate();
 }
 
+// === COMMAND LINE MODES ===
+int runCoordinatorMode(const CommandLine& args) {
+    Distributed::CoordinatorSettings settings;
+    settings.port = static_cast<uint16_t>(args.getInt("--port", Distributed::DEFAULT_PORT));
+    settings.bindAddress = args.get("--bind", "127.0.0.1");
+    settings.scenePath = args.get("--scene", "scenes/default_scene.json");
+    settings.outputPath = args.get("--output", "exports/distributed.png");
+    settings.width = static_cast<uint32_t>(args.getInt("--width", 1280));
+    settings.height = static_cast<uint32_t>(args.getInt("--height", 720));
+    settings.samplesPerPixel = static_cast<uint32_t>(args.getInt("--spp", 0));
+    settings.targetSamples = static_cast<uint64_t>(args.getInt("--samples", 1024));
+    settings.reportInterval = static_cast<uint32_t>(args.getInt("--report-interval", 8));
+    return Distributed::runCoordinator(settings);
+}
+
+int runWorkerMode(const CommandLine& args) {
+    Distributed::WorkerSettings settings;
+    settings.host = args.get("--host", "127.0.0.1");
+    settings.port = static_cast<uint16_t>(args.getInt("--port", Distributed::DEFAULT_PORT));
+    return Distributed::runWorker(settings);
+}
+
+int runServerMode(const CommandLine& args) {
+    Server::ServerSettings settings;
+    settings.port = static_cast<uint16_t>(args.getInt("--port", Server::DEFAULT_PORT));
+    settings.bindAddress = args.get("--bind", "127.0.0.1");
+    settings.skyboxCacheCapacity = static_cast<size_t>(args.getInt("--skybox-cache", 4));
+    settings.skyboxFormat = SkyboxFormat::RGB32F;
+    if (args.has("--skybox-format") && !parseSkyboxFormat(args.get("--skybox-format"), settings.skyboxFormat)) {
+        std::cerr << "Error: Unknown skybox format '" << args.get("--skybox-format") << "' (expected RGB32F, RGB16F, RGB9_E5 or BC6H)" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return Server::runServer(settings);
+}
+
+int runSubmitMode(const CommandLine& args) {
+    nlohmann::json request;
+    if (args.has("--command")) {
+        request["command"] = args.get("--command");
+    }
+    else {
+        request["scene"] = args.get("--scene", "scenes/default_scene.json");
+        request["output"] = args.get("--output", "exports/server_render.png");
+        request["width"] = args.getInt("--width", 0);
+        request["height"] = args.getInt("--height", 0);
+        request["spp"] = args.getInt("--spp", 0);
+        request["samples"] = args.getInt("--samples", 0);
+        request["noise"] = args.getFloat("--noise", 0.0f) / 100.0f;
+        request["timeLimit"] = args.getFloat("--time-limit", 0.0f);
+        request["priority"] = args.getInt("--priority", 0);
+    }
+
+    uint16_t port = static_cast<uint16_t>(args.getInt("--port", Server::DEFAULT_PORT));
+    return Server::submitJob(args.get("--host", "127.0.0.1"), port, request.dump());
+}
+
+int runConvertSceneMode(const CommandLine& args) {
+    std::string input = args.get("--convert-scene");
+    std::string output = args.get("--output");
+    if (output.empty()) {
+        size_t extension = input.find_last_of('.');
+        output = input.substr(0, extension) + SceneBinary::EXTENSION;
+    }
+
+    Scene scene;
+    if (!SceneLoader::loadScene(input, scene) || !SceneBinary::saveScene(output, scene))
+        return EXIT_FAILURE;
+
+    std::cout << "Converted " << input << " to " << output << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int runSequenceMode(const CommandLine& args) {
+    Sequence::SequenceSettings settings;
+    settings.scenePath = args.get("--sequence");
+    settings.outputPattern = args.get("--output", "exports/frame_%04d.png");
+    settings.videoPath = args.get("--video");
+    settings.ffmpegPath = args.get("--ffmpeg", "ffmpeg");
+    settings.width = static_cast<uint32_t>(args.getInt("--width", 1280));
+    settings.height = static_cast<uint32_t>(args.getInt("--height", 720));
+    settings.samplesPerFrame = static_cast<uint32_t>(args.getInt("--samples", 64));
+    settings.samplesPerPixel = static_cast<uint32_t>(args.getInt("--spp", 0));
+    settings.firstFrame = args.getInt("--first", 0);
+    settings.lastFrame = args.getInt("--last", -1);
+    settings.writerThreads = static_cast<uint32_t>(args.getInt("--writer-threads", 4));
+    return Sequence::runSequence(settings);
+}
+
+int runReplayMode(const CommandLine& args) {
+    Session::ReplaySettings settings;
+    settings.recordingPath = args.get("--replay");
+    settings.reportPath = args.get("--output");
+    settings.fps = args.getFloat("--fps", 60.0f);
+    settings.width = static_cast<uint32_t>(args.getInt("--width", 0));
+    settings.height = static_cast<uint32_t>(args.getInt("--height", 0));
+    return Session::runReplay(settings);
+}
+
+int runRenderMode(const CommandLine& args) {
+    RayTracerSettings settings;
+    settings.width = static_cast<uint32_t>(args.getInt("--width", 1280));
+    settings.height = static_cast<uint32_t>(args.getInt("--height", 720));
+    settings.samplesPerFrame = static_cast<uint32_t>(args.getInt("--spp", 16));
+
+    std::unique_ptr<RayTracer> tracer = RayTracer::create(settings);
+    if (!tracer || !tracer->loadScene(args.get("--render")))
+        return EXIT_FAILURE;
+
+    // Long renders checkpoint periodically, --resume continues from the last checkpoint after a restart
+    CheckpointSettings checkpointSettings;
+    checkpointSettings.path = args.get("--checkpoint", "");
+    checkpointSettings.intervalSeconds = args.getFloat("--checkpoint-interval", 300.0f);
+
+    if (args.has("--resume")) {
+        if (checkpointSettings.path.empty()) {
+            std::cerr << "Error: --resume needs --checkpoint <file>" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (std::filesystem::exists(checkpointSettings.path)) {
+            if (!tracer->resumeCheckpoint(checkpointSettings.path))
+                return EXIT_FAILURE;
+            std::cout << "Resuming from " << tracer->getSampleCount() << " samples" << std::endl;
+        }
+    }
+
+    uint64_t targetSamples = static_cast<uint64_t>(std::max(args.getInt("--samples", 256), 0));
+    if (checkpointSettings.path.empty()) {
+        tracer->render(static_cast<uint32_t>(targetSamples - std::min(tracer->getSampleCount(), targetSamples)));
+    }
+    else {
+        CheckpointWriter checkpoints(checkpointSettings);
+        uint64_t settingsHash = tracer->getSettingsHash();
+
+        // Render in short batches so the interval is checked regularly
+        while (tracer->getSampleCount() < targetSamples) {
+            uint64_t before = tracer->getSampleCount();
+            uint64_t batch = std::min<uint64_t>(targetSamples - before, settings.samplesPerFrame);
+            if (tracer->render(static_cast<uint32_t>(batch)) == before)
+                break;
+            checkpoints.update(tracer->getRenderer(), tracer->getScene().camera, settingsHash);
+        }
+
+        // The final state is kept too, so a later run can add more samples
+        checkpoints.flush();
+        checkpoints.write(tracer->getRenderer(), tracer->getScene().camera, settingsHash);
+    }
+
+    return tracer->saveImage(args.get("--output", "exports/render.png")) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 // === MAIN PROGRAM ===
-int main() {
+int main(int argc, char** argv) {
+    CommandLine args(argc, argv);
+    GLDebug::setDebugContext(args.has("--gl-debug"));
+
+    if (args.has("--coordinator"))
+        return runCoordinatorMode(args);
+    if (args.has("--worker"))
+        return runWorkerMode(args);
+    if (args.has("--server"))
+        return runServerMode(args);
+    if (args.has("--submit"))
+        return runSubmitMode(args);
+    if (args.has("--convert-scene"))
+        return runConvertSceneMode(args);
+    if (args.has("--sequence"))
+        return runSequenceMode(args);
+    if (args.has("--replay"))
+        return runReplayMode(args);
+    if (args.has("--render"))
+        return runRenderMode(args);
+
     initGLFW();
 
     GLFWwindow* window = createGLFWWindow();
@@ -421,21 +1705,53 @@ int main() {
 
     initGLAD();
 
+    // Loads finish on this thread, wake the event loop when one is ready
+    JobSystem::get().setMainThread();
+    JobSystem::get().setMainThreadWakeCallback(glfwPostEmptyEvent);
+
     setupImGui(window);
 
-    setupRenderer(g_windowWidth, g_windowHeight);
+    setupRenderer(window, g_windowWidth, g_windowHeight);
+
+    // Started before the first load, so the recording holds the whole session
+    if (args.has("--record"))
+        startSessionRecording(args.get("--record"));
 
     loadScene("scenes/default_scene.json", window);
 
     // Main app loop
     while (!glfwWindowShouldClose(window)) {
+        // Nothing is visible while minimized or hidden, sleep until the window comes back
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE)) {
+            glfwWaitEvents();
+            g_lastFrame = static_cast<float>(glfwGetTime());
+            continue;
+        }
+
         // Calculate delta time
         float currentFrame = static_cast<float>(glfwGetTime());
         g_deltaTime = currentFrame - g_lastFrame;
         g_lastFrame = currentFrame;
 
-        glfwPollEvents();
+        // Once the render thread is idle only the UI needs updating, so wait for input instead of spinning.
+        // A new frame from the render thread wakes the wait early
+        g_uiWaiting = true;
+        if (g_renderThread.isIdle())
+            glfwWaitEventsTimeout(0.1);
+        else
+            glfwPollEvents();
+        g_uiWaiting = false;
+        JobSystem::get().runMainThreadJobs();
+        if (g_sceneWatcher.poll())
+            reloadScene(window);
         processInput(window);
+        syncCamera();
+        g_sessionRecorder.update(glfwGetTime(), g_camera, getSessionSettings(), g_viewportWidth, g_viewportHeight);
+
+        {
+            std::lock_guard<std::mutex> lock(g_statusMutex);
+            g_status = g_renderStatus;
+        }
 
         // ImGui Frame Start
         ImGui_ImplOpenGL3_NewFrame();
@@ -480,12 +1796,13 @@ int main() {
         // Render individual UI windows
         renderImGuiSettingsWindow(io);
         renderImGuiViewportWindow();
+        renderImGuiInspectorWindow();
+        renderImGuiSceneViews();
 
         if (ImGuiFileDialog::Instance()->Display("ChooseSceneFile", ImGuiWindowFlags_NoCollapse, MIN_DIALOG_SIZE)) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string filepath = ImGuiFileDialog::Instance()->GetFilePathName();
-                if (g_renderer)
-                    loadScene(filepath, window);
+                loadScene(filepath, window);
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -493,8 +1810,7 @@ int main() {
         if (ImGuiFileDialog::Instance()->Display("ChooseExportFile", ImGuiWindowFlags_NoCollapse, MIN_DIALOG_SIZE)) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string filepath = ImGuiFileDialog::Instance()->GetFilePathName();
-                if (g_renderer)
-                    g_renderer->saveRenderedImage(filepath, g_viewportWidth, g_viewportHeight);
+                g_renderThread.post([filepath]() { g_tracer->saveImageAsync(filepath); });
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -502,12 +1818,18 @@ int main() {
         if (ImGuiFileDialog::Instance()->Display("ChooseSkyboxFile", ImGuiWindowFlags_NoCollapse, MIN_DIALOG_SIZE)) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string filepath = ImGuiFileDialog::Instance()->GetFilePathName();
-                if (g_renderer)
-                    g_renderer->setSkybox(filepath);
+                uint64_t request = ++g_skyboxRequest;
+                loadSkyboxAsync(filepath, g_skyboxRequest, request, [filepath]() { g_scene.skyboxPath = filepath; });
             }   
             ImGuiFileDialog::Instance()->Close();
         }
 
+        if (ImGuiFileDialog::Instance()->Display("ChooseSessionFile", ImGuiWindowFlags_NoCollapse, MIN_DIALOG_SIZE)) {
+            if (ImGuiFileDialog::Instance()->IsOk())
+                startSessionRecording(ImGuiFileDialog::Instance()->GetFilePathName());
+            ImGuiFileDialog::Instance()->Close();
+        }
+
         // Final ImGui render and swap buffers
         ImGui::Render();
         int display_w, display_h;
@@ -515,7 +1837,10 @@ int main() {
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            GLDebugGroup group("UI");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // Handle ImGui viewports
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -525,6 +1850,12 @@ int main() {
             glfwMakeContextCurrent(backup_current_context);
         }
 
+        // The render thread may reuse the textures shown this frame once these draws are done
+        g_display.endRead();
+        for (SceneView& view : g_views)
+            view.target->display.endRead();
+        removeClosedViews();
+
         glfwSwapBuffers(window);
     }
 
@@ -0,0 +1,209 @@
+#include <iostream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "net/socket.hpp"
+
+#ifdef _WIN32
+static const SocketHandle INVALID_HANDLE = INVALID_SOCKET;
+static void closeHandle(SocketHandle handle) { closesocket(handle); }
+#else
+static const SocketHandle INVALID_HANDLE = -1;
+static void closeHandle(SocketHandle handle) { ::close(handle); }
+#endif
+
+namespace Net {
+    bool initialise() {
+#ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            std::cerr << "Error (Net): WSAStartup failed" << std::endl;
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    void shutdown() {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+}
+
+Socket::Socket() : m_handle(INVALID_HANDLE) {}
+
+Socket::Socket(SocketHandle handle) : m_handle(handle) {}
+
+Socket::~Socket() {
+    close();
+}
+
+Socket::Socket(Socket&& other) noexcept : m_handle(other.m_handle) {
+    other.m_handle = INVALID_HANDLE;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_handle = other.m_handle;
+        other.m_handle = INVALID_HANDLE;
+    }
+    return *this;
+}
+
+Socket Socket::listen(uint16_t port, const std::string& address) {
+    SocketHandle handle = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == INVALID_HANDLE) {
+        std::cerr << "Error (Net): Failed to create socket" << std::endl;
+        return Socket();
+    }
+
+    int reuse = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Error (Net): Invalid bind address: " << address << std::endl;
+        closeHandle(handle);
+        return Socket();
+    }
+
+    if (::bind(handle, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(handle, SOMAXCONN) != 0) {
+        std::cerr << "Error (Net): Failed to listen on " << address << ":" << port << std::endl;
+        closeHandle(handle);
+        return Socket();
+    }
+
+    return Socket(handle);
+}
+
+Socket Socket::connect(const std::string& host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        std::cerr << "Error (Net): Could not resolve host: " << host << std::endl;
+        return Socket();
+    }
+
+    SocketHandle handle = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (handle == INVALID_HANDLE || ::connect(handle, result->ai_addr, (int)result->ai_addrlen) != 0) {
+        std::cerr << "Error (Net): Could not connect to " << host << ":" << port << std::endl;
+        if (handle != INVALID_HANDLE)
+            closeHandle(handle);
+        freeaddrinfo(result);
+        return Socket();
+    }
+    freeaddrinfo(result);
+
+    // Messages are small and latency sensitive
+    int noDelay = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    return Socket(handle);
+}
+
+Socket Socket::accept() {
+    SocketHandle handle = ::accept(m_handle, nullptr, nullptr);
+    if (handle == INVALID_HANDLE)
+        return Socket();
+
+    int noDelay = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    return Socket(handle);
+}
+
+bool Socket::isValid() const {
+    return m_handle != INVALID_HANDLE;
+}
+
+void Socket::close() {
+    if (m_handle != INVALID_HANDLE) {
+        closeHandle(m_handle);
+        m_handle = INVALID_HANDLE;
+    }
+}
+
+void Socket::shutdown() {
+    if (m_handle != INVALID_HANDLE) {
+#ifdef _WIN32
+        ::shutdown(m_handle, SD_BOTH);
+#else
+        ::shutdown(m_handle, SHUT_RDWR);
+#endif
+    }
+}
+
+bool Socket::waitReadable(int timeoutMs) const {
+    if (!isValid())
+        return false;
+
+#ifdef _WIN32
+    WSAPOLLFD pfd = {};
+    pfd.fd = m_handle;
+    pfd.events = POLLRDNORM;
+    return WSAPoll(&pfd, 1, timeoutMs) > 0;
+#else
+    pollfd pfd = {};
+    pfd.fd = m_handle;
+    pfd.events = POLLIN;
+    return ::poll(&pfd, 1, timeoutMs) > 0;
+#endif
+}
+
+bool Socket::sendAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        int sent = ::send(m_handle, bytes, (int)size, 0);
+#else
+        ssize_t sent = ::send(m_handle, bytes, size, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool Socket::recvAll(void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        int received = ::recv(m_handle, bytes, (int)size, 0);
+#else
+        ssize_t received = ::recv(m_handle, bytes, size, 0);
+#endif
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+
+int Socket::recvSome(void* data, size_t size) {
+#ifdef _WIN32
+    return ::recv(m_handle, static_cast<char*>(data), (int)size, 0);
+#else
+    return static_cast<int>(::recv(m_handle, data, size, 0));
+#endif
+}
\ No newline at end of file
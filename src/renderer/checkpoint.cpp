@@ -0,0 +1,329 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "camera/camera.hpp"
+#include "renderer/checkpoint.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+
+namespace {
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t frame;
+        uint32_t frameOffset;
+        uint64_t sampleCount;
+        uint64_t settingsHash;
+        float cameraPosition[3];
+        float cameraYaw;
+        float cameraPitch;
+        float cameraForward[3];
+        float cameraRight[3];
+        float cameraUp[3];
+    };
+
+    // FNV-1a over the fields, struct padding is never hashed
+    struct Hasher {
+        uint64_t value = 14695981039346656037ull;
+
+        void bytes(const void* data, size_t size) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                value ^= p[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        template <typename T>
+        void add(const T& field) {
+            bytes(&field, sizeof(field));
+        }
+
+        void add(const std::string& text) {
+            add(text.size());
+            bytes(text.data(), text.size());
+        }
+
+        void add(const Material& m) {
+            add(m.colour);
+            add(m.smoothness);
+            add(m.emissionColour);
+            add(m.emissionStrength);
+            add(m.specularColour);
+            add(m.flag);
+            add(m.specularProbability);
+        }
+    };
+
+    void copyVec3(const glm::vec3& v, float* out) {
+        out[0] = v.x;
+        out[1] = v.y;
+        out[2] = v.z;
+    }
+}
+
+namespace Checkpoint {
+    uint64_t hashSettings(const Scene& scene, SkyboxFormat skyboxFormat, const RestirSettings& restir,
+        const GuidingSettings& guiding, const RadianceCacheSettings& radianceCache, uint32_t width, uint32_t height) {
+        Hasher h;
+        h.add(VERSION);
+        h.add(width);
+        h.add(height);
+
+        h.add(scene.spheres.size());
+        for (const Sphere& s : scene.spheres) {
+            h.add(s.position);
+            h.add(s.radius);
+            h.add(s.material);
+        }
+        h.add(scene.planes.size());
+        for (const Plane& p : scene.planes) {
+            h.add(p.position);
+            h.add(p.normal);
+            h.add(p.material);
+        }
+        h.add(scene.quads.size());
+        for (const Quad& q : scene.quads) {
+            h.add(q.position);
+            h.add(q.width);
+            h.add(q.normal);
+            h.add(q.height);
+            h.add(q.right);
+            h.add(q.up);
+            h.add(q.material);
+        }
+
+        // Only scenes that use them hash these, so older checkpoints stay valid
+        if (!scene.boxes.empty()) {
+            h.add(scene.boxes.size());
+            for (const Box& b : scene.boxes) {
+                h.add(b.position);
+                h.add(b.inward);
+                h.add(b.right);
+                h.add(b.up);
+                h.add(b.width);
+                h.add(b.height);
+                h.add(b.depth);
+                for (const Material& material : b.materials)
+                    h.add(material);
+            }
+        }
+        if (!scene.discs.empty()) {
+            h.add(scene.discs.size());
+            for (const Disc& d : scene.discs) {
+                h.add(d.position);
+                h.add(d.radius);
+                h.add(d.normal);
+                h.add(d.material);
+            }
+        }
+        if (!scene.cylinders.empty()) {
+            h.add(scene.cylinders.size());
+            for (const Cylinder& c : scene.cylinders) {
+                h.add(c.position);
+                h.add(c.radius);
+                h.add(c.axis);
+                h.add(c.height);
+                h.add(c.material);
+            }
+        }
+
+        h.add(scene.gamma);
+        h.add(scene.maxBounces);
+        h.add(scene.skyboxPath);
+        h.add(static_cast<int>(skyboxFormat));
+        h.add(scene.skyboxExposureEV);
+        h.add(scene.sunPitch);
+        h.add(scene.sunYaw);
+        h.add(scene.sunColour);
+        h.add(scene.sunIntensity);
+        h.add(scene.sunFocus);
+
+        // Integrators that are off leave the hash as it was before they existed
+        if (restir.enabled) {
+            h.add(restir.unbiased);
+            h.add(restir.candidates);
+            h.add(restir.spatialSamples);
+            h.add(restir.spatialRadius);
+            h.add(restir.maxHistory);
+        }
+        if (guiding.enabled) {
+            h.add(guiding.mixing);
+            h.add(guiding.trainingIterations);
+            h.add(guiding.spatialThreshold);
+        }
+        if (radianceCache.enabled) {
+            h.add(radianceCache.cellSize);
+            h.add(radianceCache.terminationBounce);
+            h.add(radianceCache.updateFraction);
+        }
+        return h.value;
+    }
+
+    Camera getCamera(const RenderCheckpoint& checkpoint) {
+        Camera camera;
+        camera.position = checkpoint.cameraPosition;
+        camera.yaw = checkpoint.cameraYaw;
+        camera.pitch = checkpoint.cameraPitch;
+        camera.forward = checkpoint.cameraForward;
+        camera.right = checkpoint.cameraRight;
+        camera.up = checkpoint.cameraUp;
+        return camera;
+    }
+
+    bool save(const std::string& filepath, const RenderCheckpoint& checkpoint) {
+        size_t pixelCount = static_cast<size_t>(checkpoint.width) * checkpoint.height;
+        if (checkpoint.accumulation.size() != pixelCount * 4) {
+            std::cerr << "Error (Checkpoint): Accumulation doesn't match " << checkpoint.width << "x" << checkpoint.height << std::endl;
+            return false;
+        }
+
+        FileHeader header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.width = checkpoint.width;
+        header.height = checkpoint.height;
+        header.frame = checkpoint.frame;
+        header.frameOffset = checkpoint.frameOffset;
+        header.sampleCount = checkpoint.sampleCount;
+        header.settingsHash = checkpoint.settingsHash;
+        copyVec3(checkpoint.cameraPosition, header.cameraPosition);
+        header.cameraYaw = checkpoint.cameraYaw;
+        header.cameraPitch = checkpoint.cameraPitch;
+        copyVec3(checkpoint.cameraForward, header.cameraForward);
+        copyVec3(checkpoint.cameraRight, header.cameraRight);
+        copyVec3(checkpoint.cameraUp, header.cameraUp);
+
+        std::string temporaryPath = filepath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                std::cerr << "Error (Checkpoint): Could not open " << temporaryPath << " for writing" << std::endl;
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(checkpoint.accumulation.data()),
+                static_cast<std::streamsize>(checkpoint.accumulation.size() * sizeof(float)));
+            file.flush();
+            if (!file) {
+                std::cerr << "Error (Checkpoint): Failed writing " << temporaryPath << std::endl;
+                file.close();
+                std::filesystem::remove(temporaryPath);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, filepath, error);
+        if (error) {
+            std::cerr << "Error (Checkpoint): Could not replace " << filepath << ": " << error.message() << std::endl;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& filepath, RenderCheckpoint& checkpoint, uint32_t width, uint32_t height) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error (Checkpoint): Could not open " << filepath << std::endl;
+            return false;
+        }
+
+        FileHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != MAGIC) {
+            std::cerr << "Error (Checkpoint): " << filepath << " is not a checkpoint" << std::endl;
+            return false;
+        }
+        if (header.version != VERSION) {
+            std::cerr << "Error (Checkpoint): " << filepath << " has version " << header.version << ", expected " << VERSION << std::endl;
+            return false;
+        }
+        if (header.width != width || header.height != height) {
+            std::cerr << "Error (Checkpoint): " << filepath << " is " << header.width << "x" << header.height
+                << ", the renderer is " << width << "x" << height << std::endl;
+            return false;
+        }
+
+        // Both sizes are bounded by the renderer's, so this can't overflow
+        uint64_t accumulationBytes = static_cast<uint64_t>(width) * height * 4 * sizeof(float);
+        std::error_code error;
+        uintmax_t fileSize = std::filesystem::file_size(filepath, error);
+        if (error || fileSize < sizeof(header) || fileSize - sizeof(header) < accumulationBytes) {
+            std::cerr << "Error (Checkpoint): " << filepath << " is truncated" << std::endl;
+            return false;
+        }
+
+        checkpoint.width = header.width;
+        checkpoint.height = header.height;
+        checkpoint.frame = header.frame;
+        checkpoint.frameOffset = header.frameOffset;
+        checkpoint.sampleCount = header.sampleCount;
+        checkpoint.settingsHash = header.settingsHash;
+        checkpoint.cameraPosition = glm::vec3(header.cameraPosition[0], header.cameraPosition[1], header.cameraPosition[2]);
+        checkpoint.cameraYaw = header.cameraYaw;
+        checkpoint.cameraPitch = header.cameraPitch;
+        checkpoint.cameraForward = glm::vec3(header.cameraForward[0], header.cameraForward[1], header.cameraForward[2]);
+        checkpoint.cameraRight = glm::vec3(header.cameraRight[0], header.cameraRight[1], header.cameraRight[2]);
+        checkpoint.cameraUp = glm::vec3(header.cameraUp[0], header.cameraUp[1], header.cameraUp[2]);
+
+        checkpoint.accumulation.resize(static_cast<size_t>(header.width) * header.height * 4);
+        if (!file.read(reinterpret_cast<char*>(checkpoint.accumulation.data()),
+                static_cast<std::streamsize>(checkpoint.accumulation.size() * sizeof(float)))) {
+            std::cerr << "Error (Checkpoint): " << filepath << " is truncated" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+CheckpointWriter::CheckpointWriter(const CheckpointSettings& settings)
+    : m_settings(settings), m_lastWrite(std::chrono::steady_clock::now()) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    flush();
+}
+
+bool CheckpointWriter::update(Renderer& renderer, const Camera& camera, uint64_t settingsHash) {
+    if (m_settings.intervalSeconds <= 0.0f)
+        return false;
+
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - m_lastWrite;
+    if (elapsed.count() < m_settings.intervalSeconds)
+        return false;
+    return write(renderer, camera, settingsHash);
+}
+
+bool CheckpointWriter::write(Renderer& renderer, const Camera& camera, uint64_t settingsHash) {
+    if (m_settings.path.empty() || renderer.getSampleCount() == 0 || (m_pending.valid() && !m_pending.isReady()))
+        return false;
+
+    auto checkpoint = std::make_shared<RenderCheckpoint>();
+    renderer.captureCheckpoint(camera, *checkpoint);
+    checkpoint->settingsHash = settingsHash;
+
+    std::string path = m_settings.path;
+    m_pending = JobSystem::get().run([path, checkpoint]() {
+        bool saved = Checkpoint::save(path, *checkpoint);
+        if (saved)
+            std::cout << "Checkpoint: " << checkpoint->sampleCount << " samples saved to " << path << std::endl;
+        return saved;
+    });
+    m_lastWrite = std::chrono::steady_clock::now();
+    return true;
+}
+
+void CheckpointWriter::flush() {
+    if (m_pending.valid())
+        m_pending.wait();
+}
+
+const CheckpointSettings& CheckpointWriter::getSettings() const {
+    return m_settings;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "renderer/convergence.hpp"
+#include "renderer/renderer.hpp"
+
+const char* getStopReasonName(StopReason reason) {
+    switch (reason) {
+    case StopReason::None: return "None";
+    case StopReason::Samples: return "Target samples reached";
+    case StopReason::Noise: return "Target noise reached";
+    case StopReason::TimeLimit: return "Time limit reached";
+    }
+    return "Unknown";
+}
+
+void ConvergenceMonitor::setConditions(const StopConditions& conditions) {
+    m_conditions = conditions;
+
+    // Re-evaluated on the next frame, so raising a target resumes tracing
+    m_reason = StopReason::None;
+}
+
+const StopConditions& ConvergenceMonitor::getConditions() const {
+    return m_conditions;
+}
+
+bool ConvergenceMonitor::update(Renderer& renderer, double frameSeconds) {
+    uint32_t frame = renderer.getFrame();
+
+    // The frame counter only goes backwards when the accumulation was reset
+    if (frame <= m_lastFrame) {
+        m_reason = StopReason::None;
+        m_elapsed = 0.0;
+        m_lastNoiseCheck = 0.0;
+        m_noise = -1.0f;
+    }
+    else {
+        m_elapsed += frameSeconds;
+    }
+    m_lastFrame = frame;
+
+    if (m_reason != StopReason::None)
+        return true;
+
+    uint64_t samples = renderer.getSampleCount();
+
+    if (m_conditions.targetSamples > 0 && samples >= m_conditions.targetSamples)
+        m_reason = StopReason::Samples;
+    else if (m_conditions.timeLimit > 0.0f && m_elapsed >= m_conditions.timeLimit)
+        m_reason = StopReason::TimeLimit;
+    else if (m_conditions.targetNoise > 0.0f && samples >= MIN_NOISE_SAMPLES && m_elapsed - m_lastNoiseCheck >= NOISE_CHECK_INTERVAL) {
+        m_lastNoiseCheck = m_elapsed;
+        m_noise = renderer.estimateNoise();
+        if (m_noise >= 0.0f && m_noise <= m_conditions.targetNoise)
+            m_reason = StopReason::Noise;
+    }
+
+    return m_reason != StopReason::None;
+}
+
+bool ConvergenceMonitor::isConverged() const {
+    return m_reason != StopReason::None;
+}
+
+StopReason ConvergenceMonitor::getReason() const {
+    return m_reason;
+}
+
+float ConvergenceMonitor::getNoise() const {
+    return m_noise;
+}
+
+double ConvergenceMonitor::getElapsed() const {
+    return m_elapsed;
+}
\ No newline at end of file
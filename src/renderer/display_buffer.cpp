@@ -0,0 +1,86 @@
+#include "renderer/display_buffer.hpp"
+#include "renderer/renderer.hpp"
+#include "utils/gl_debug.hpp"
+
+namespace {
+    void waitAndDelete(GLsync& sync) {
+        if (!sync)
+            return;
+        glWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(sync);
+        sync = nullptr;
+    }
+}
+
+DisplayBuffer::~DisplayBuffer() {
+    reset();
+}
+
+void DisplayBuffer::publish(const Renderer& renderer) {
+    GLDebugGroup group("Display buffer publish");
+    Slot& slot = m_slots[m_back];
+    waitAndDelete(slot.read);
+
+    // Same size as the renderer's texture, which already avoids reallocating while resizing
+    uint32_t width = renderer.getTextureWidth();
+    uint32_t height = renderer.getTextureHeight();
+    if (!slot.texture || slot.width != width || slot.height != height) {
+        slot.texture.create("Display buffer");
+        glBindTexture(GL_TEXTURE_2D, slot.texture.get());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        slot.texture.setSize(getTextureLevelSize(GL_RGBA8, width, height));
+        slot.width = width;
+        slot.height = height;
+    }
+
+    glCopyImageSubData(renderer.getDisplayTexture(), GL_TEXTURE_2D, 0, 0, 0, 0,
+        slot.texture.get(), GL_TEXTURE_2D, 0, 0, 0, 0, renderer.getWidth(), renderer.getHeight(), 1);
+
+    // The slot may come back unread if the UI skipped a frame
+    if (slot.written)
+        glDeleteSync(slot.written);
+    slot.written = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();  // The fence has to be submitted before the other context can wait on it
+
+    slot.frame.texture = slot.texture.get();
+    slot.frame.scale = renderer.getDisplayScale();
+    slot.frame.sequence = ++m_sequence;
+
+    m_back = m_ready.exchange(m_back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+void DisplayBuffer::reset() {
+    for (Slot& slot : m_slots) {
+        waitAndDelete(slot.read);
+        if (slot.written)
+            glDeleteSync(slot.written);
+        slot.written = nullptr;
+        slot.texture.reset();
+        slot.width = 0;
+        slot.height = 0;
+        slot.frame = Frame();
+    }
+}
+
+const DisplayBuffer::Frame& DisplayBuffer::acquire() {
+    if (m_ready.load(std::memory_order_acquire) & FRESH) {
+        m_front = m_ready.exchange(m_front, std::memory_order_acq_rel) & ~FRESH;
+        waitAndDelete(m_slots[m_front].written);
+    }
+    return m_slots[m_front].frame;
+}
+
+void DisplayBuffer::endRead() {
+    Slot& slot = m_slots[m_front];
+    if (!slot.texture)
+        return;
+    if (slot.read)
+        glDeleteSync(slot.read);
+    slot.read = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "renderer/path_guide.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct TreeOffsets {
+    uint32_t quads;
+    uint32_t sums;
+    uint32_t counts;
+    uint32_t spatialCount;
+};
+
+TreeOffsets getOffsets(const std::vector<uint32_t>& tree) {
+    return { tree[0], tree[1], tree[2], tree[3] };
+}
+
+float getSum(const std::vector<uint32_t>& tree, const TreeOffsets& offsets, uint32_t node, uint32_t quadrant) {
+    float sum;
+    std::memcpy(&sum, &tree[offsets.sums + node * 4 + quadrant], sizeof(float));
+    return std::isfinite(sum) ? sum : 0.0f;
+}
+
+}
+
+void PathGuide::reset() {
+    m_spatial.assign(1, SpatialNode());
+    m_quads.assign(1, QuadNode());
+}
+
+std::vector<uint32_t> PathGuide::getTrainingTree() const {
+    uint32_t spatialCount = static_cast<uint32_t>(m_spatial.size());
+    uint32_t quadCount = static_cast<uint32_t>(m_quads.size());
+    uint32_t quadOffset = HEADER_SIZE + spatialCount * 2;
+    uint32_t sumOffset = quadOffset + quadCount * 4;
+    uint32_t countOffset = sumOffset + quadCount * 4;
+
+    // Zeroed sums are 0.0f
+    std::vector<uint32_t> tree(countOffset + spatialCount, 0);
+    tree[0] = quadOffset;
+    tree[1] = sumOffset;
+    tree[2] = countOffset;
+    tree[3] = spatialCount;
+
+    for (uint32_t i = 0; i < spatialCount; i++) {
+        tree[HEADER_SIZE + i * 2] = m_spatial[i].firstChild;
+        tree[HEADER_SIZE + i * 2 + 1] = m_spatial[i].quadRoot;
+    }
+    for (uint32_t i = 0; i < quadCount; i++) {
+        for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+            tree[quadOffset + i * 4 + quadrant] = m_quads[i].children[quadrant];
+    }
+    return tree;
+}
+
+void PathGuide::refine(const std::vector<uint32_t>& trained, uint32_t iteration, uint32_t threshold) {
+    if (trained.size() < HEADER_SIZE)
+        return;
+
+    m_spatial.assign(1, SpatialNode());
+    m_quads.clear();
+    float limit = static_cast<float>(threshold) * std::sqrt(std::exp2(static_cast<float>(iteration)));
+    refineSpatial(trained, 0, 0, 0, limit);
+}
+
+size_t PathGuide::getSpatialNodeCount() const {
+    return m_spatial.size();
+}
+
+size_t PathGuide::getQuadNodeCount() const {
+    return m_quads.size();
+}
+
+void PathGuide::refineSpatial(const std::vector<uint32_t>& trained, uint32_t node, uint32_t target, uint32_t depth,
+    float limit) {
+    TreeOffsets offsets = getOffsets(trained);
+
+    uint32_t firstChild = trained[HEADER_SIZE + node * 2];
+    if (firstChild != 0) {
+        // Adjacent children, and the vector may grow while they are filled, so indices rather than references
+        uint32_t children = static_cast<uint32_t>(m_spatial.size());
+        m_spatial.resize(children + 2);
+        m_spatial[target].firstChild = children;
+        for (uint32_t i = 0; i < 2; i++)
+            refineSpatial(trained, firstChild + i, children + i, depth + 1, limit);
+        return;
+    }
+
+    uint32_t root = trained[HEADER_SIZE + node * 2 + 1];
+    float sums[4];
+    float total = 0.0f;
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+        sums[quadrant] = getSum(trained, offsets, root, quadrant);
+        total += sums[quadrant];
+    }
+    uint32_t quadRoot = buildQuadtree(trained, root, sums, total, 1);
+    m_spatial[target].quadRoot = quadRoot;
+
+    splitSpatial(target, depth, static_cast<float>(trained[offsets.counts + node]), limit);
+}
+
+void PathGuide::splitSpatial(uint32_t node, uint32_t depth, float samples, float limit) {
+    if (samples <= limit || depth >= MAX_SPATIAL_DEPTH)
+        return;
+
+    // Both halves start from the learned distribution and assume the samples were spread evenly
+    uint32_t children = static_cast<uint32_t>(m_spatial.size());
+    m_spatial.resize(children + 2);
+    m_spatial[node].firstChild = children;
+    m_spatial[children].quadRoot = m_spatial[node].quadRoot;
+    m_spatial[children + 1].quadRoot = copyQuadtree(m_spatial[node].quadRoot);
+
+    for (uint32_t i = 0; i < 2; i++)
+        splitSpatial(children + i, depth + 1, samples * 0.5f, limit);
+}
+
+uint32_t PathGuide::buildQuadtree(const std::vector<uint32_t>& trained, uint32_t node, const float sums[4],
+    float total, uint32_t depth) {
+    TreeOffsets offsets = getOffsets(trained);
+
+    uint32_t index = static_cast<uint32_t>(m_quads.size());
+    m_quads.emplace_back();
+    if (!(total > 0.0f) || depth >= MAX_QUAD_DEPTH)
+        return index;
+
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+        if (sums[quadrant] <= SUBDIVIDE_FRACTION * total)
+            continue;
+
+        uint32_t child = node != NO_NODE ? trained[offsets.quads + node * 4 + quadrant] : 0;
+        float childSums[4];
+        for (uint32_t i = 0; i < 4; i++)
+            childSums[i] = child != 0 ? getSum(trained, offsets, child, i) : sums[quadrant] * 0.25f;
+
+        uint32_t built = buildQuadtree(trained, child != 0 ? child : NO_NODE, childSums, total, depth + 1);
+        m_quads[index].children[quadrant] = built;
+    }
+    return index;
+}
+
+uint32_t PathGuide::copyQuadtree(uint32_t node) {
+    QuadNode source = m_quads[node];
+    uint32_t index = static_cast<uint32_t>(m_quads.size());
+    m_quads.push_back(source);
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+        if (source.children[quadrant] != 0) {
+            uint32_t child = copyQuadtree(source.children[quadrant]);
+            m_quads[index].children[quadrant] = child;
+        }
+    }
+    return index;
+}
\ No newline at end of file
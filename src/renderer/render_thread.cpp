@@ -0,0 +1,128 @@
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "renderer/render_thread.hpp"
+#include "utils/gl_debug.hpp"
+
+RenderThread::RenderThread() : m_commands(QUEUE_CAPACITY) {}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+bool RenderThread::start(GLFWwindow* window, std::function<bool()> frame) {
+    if (isRunning())
+        return false;
+
+    // Windows can only be created on the main thread, the render thread then takes the context over
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_context = glfwCreateWindow(1, 1, "ray-tracing (render thread)", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!m_context) {
+        std::cerr << "Error: Could not create a shared context for the render thread" << std::endl;
+        return false;
+    }
+
+    // The caller's context stays current on its own thread
+    m_frame = std::move(frame);
+    m_stopping = false;
+    m_idle = false;
+    m_thread = std::thread(&RenderThread::run, this);
+    return true;
+}
+
+void RenderThread::stop() {
+    if (!m_thread.joinable())
+        return;
+
+    m_stopping = true;
+    wake();
+    m_thread.join();
+
+    glfwDestroyWindow(m_context);
+    m_context = nullptr;
+    m_frame = nullptr;
+}
+
+void RenderThread::post(Command command) {
+    while (!m_commands.tryPush(std::move(command)))
+        std::this_thread::yield();
+    wake();
+}
+
+bool RenderThread::isRunning() const {
+    return m_thread.joinable();
+}
+
+bool RenderThread::isIdle() const {
+    return m_idle.load();
+}
+
+bool RenderThread::isRenderThread() const {
+    return std::this_thread::get_id() == m_thread.get_id();
+}
+
+void RenderThread::run() {
+    glfwMakeContextCurrent(m_context);
+    GLDebug::install();  // Debug state is per context
+
+    GLsync lastFrame = nullptr;
+    while (!m_stopping) {
+        runCommands();
+        if (m_stopping)
+            break;
+
+        // At most one frame in flight, so commands such as camera moves show up on the next frame
+        if (lastFrame) {
+            glClientWaitSync(lastFrame, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(lastFrame);
+            lastFrame = nullptr;
+        }
+
+        bool busy = m_frame();
+        m_idle = !busy;
+        if (busy)
+            lastFrame = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        else
+            sleep();
+    }
+
+    if (lastFrame)
+        glDeleteSync(lastFrame);
+    runCommands();
+    glFinish();
+    glfwMakeContextCurrent(nullptr);
+}
+
+void RenderThread::runCommands() {
+    Command command;
+    while (m_commands.tryPop(command)) {
+        command();
+        command = nullptr;
+    }
+}
+
+void RenderThread::sleep() {
+    m_sleeping = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // A command posted before the flag was set would otherwise be missed
+    if (!m_commands.isEmpty() || m_stopping) {
+        m_sleeping = false;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait(lock, [this]() { return !m_sleeping.load(); });
+}
+
+void RenderThread::wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_sleeping.exchange(false))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_wake.notify_one();
+}
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -8,15 +10,19 @@
 #include "stb_image_write.h"
 
 #include "camera/camera.hpp"
+#include "renderer/checkpoint.hpp"
 #include "renderer/renderer.hpp"
 #include "scene/scene.hpp"
+#include "scene/scene_diff.hpp"
+#include "utils/gl_debug.hpp"
 #include "utils/io.hpp"
-#include "utils/shader.hpp"
+#include "utils/job_system.hpp"
 
-Renderer::Renderer(uint32_t width, uint32_t height)
-	: m_width(width), m_height(height) {
-	setupShaders();
-	setupQuad();
+Renderer::Renderer(uint32_t width, uint32_t height, std::shared_ptr<SceneResources> resources)
+	: m_resources(resources ? std::move(resources) : std::make_shared<SceneResources>()), m_width(width), m_height(height) {
+    m_resourceRevision = m_resources->getRevision();
+    for (GLQuery& query : m_timerQueries)
+        query.create("GPU frame timer");
 
     createTexturesAndFBO(width, height);
     resetFrame();
@@ -26,146 +32,275 @@ Renderer::~Renderer() {
 	cleanup();
 }
 
-void Renderer::setupShaders() {
-    m_shaderProgram = createShaderProgram("shaders/vertex.glsl", "shaders/fragment.glsl");
-    if (m_shaderProgram == 0)
-        std::cerr << "Failed to create shader program" << std::endl;
-
-    // Cache shader uniform locations
-    glUseProgram(m_shaderProgram);
-    m_uLocResolution = glGetUniformLocation(m_shaderProgram, "uResolution");
-    m_uLocCameraPos = glGetUniformLocation(m_shaderProgram, "uCameraPosition");
-    m_uLocCameraForward = glGetUniformLocation(m_shaderProgram, "uCameraForward");
-    m_uLocCameraRight = glGetUniformLocation(m_shaderProgram, "uCameraRight");
-    m_uLocCameraUp = glGetUniformLocation(m_shaderProgram, "uCameraUp");
-    m_uLocGamma = glGetUniformLocation(m_shaderProgram, "uGamma");
-    m_uLocMaxBounces = glGetUniformLocation(m_shaderProgram, "uMaxBounces");
-    m_uLocSamplesPerPixel = glGetUniformLocation(m_shaderProgram, "uSamplesPerPixel");
-    m_uLocFrame = glGetUniformLocation(m_shaderProgram, "uFrame");
-    m_uLocSkyboxTexture = glGetUniformLocation(m_shaderProgram, "uSkyboxTexture");
-    m_uLocHasSkybox = glGetUniformLocation(m_shaderProgram, "uHasSkybox");
-    m_uLocSkyboxExposure = glGetUniformLocation(m_shaderProgram, "uSkyboxExposure");
-    m_uLocSunDirection = glGetUniformLocation(m_shaderProgram, "uSunDirection");
-    m_uLocSunColour = glGetUniformLocation(m_shaderProgram, "uSunColour");
-    m_uLocSunIntensity = glGetUniformLocation(m_shaderProgram, "uSunIntensity");
-    m_uLocSunFocus = glGetUniformLocation(m_shaderProgram, "uSunFocus");
-    m_uLocNumSpheres = glGetUniformLocation(m_shaderProgram, "uNumSpheres");
-    m_uLocNumPlanes = glGetUniformLocation(m_shaderProgram, "uNumPlanes");
-    m_uLocNumQuads = glGetUniformLocation(m_shaderProgram, "uNumQuads");
-    glUseProgram(0);
+void Renderer::createTexturesAndFBO(uint32_t width, uint32_t height) {
+    // Keep the current textures while the image fits and they aren't more than twice too big
+    bool fits = width <= m_textureWidth && height <= m_textureHeight;
+    bool oversized = width * 2 < m_textureWidth || height * 2 < m_textureHeight;
+    if (m_fbo && fits && !oversized)
+        return;
+
+    // Round up so dragging a window edge doesn't reallocate every frame
+    m_textureWidth = (width + 127) / 128 * 128;
+    m_textureHeight = (height + 127) / 128 * 128;
+
+    GLDebugGroup group("Render target allocation");
+
+    // Create the single FBO
+    m_fbo.create("Path tracing FBO");
+
+    // Create accumulated image (GL_RGBA32F for precision)
+    m_accumulatedImage.create("Accumulation image");
+    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage.get());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_accumulatedImage.setSize(getTextureLevelSize(GL_RGBA32F, m_textureWidth, m_textureHeight));
+
+    // Create display texture (GL_RGBA8 for standard display), target for FBO
+    m_displayTexture.create("Display texture");
+    glBindTexture(GL_TEXTURE_2D, m_displayTexture.get());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_textureWidth, m_textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_displayTexture.setSize(getTextureLevelSize(GL_RGBA8, m_textureWidth, m_textureHeight));
+
+    if (m_statsEnabled)
+        createStatsResources();
+    if (m_restir.enabled)
+        createReservoirs();
 }
 
-void Renderer::setupQuad() {
-    // Fullscreen quad vertices
-    float vertices[] = {
-        // x, y, u, v
-        -1.0f, -1.0f, 0.0f, 0.0f,  // Bottom-left
-        1.0f, -1.0f, 1.0f, 0.0f,   // Bottom-right
-        -1.0f, 1.0f, 0.0f, 1.0f,   // Top-left
-        1.0f, 1.0f, 1.0f, 1.0f     // Top-right
-    };
+void Renderer::createStatsResources() {
+    // 64-bit counters stored as (lo, hi) pairs, see RayStats in fragment.glsl
+    if (!m_statsSSBO) {
+        m_statsSSBO.create("Ray statistics SSBO");
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsSSBO.get());
+        glBufferData(GL_SHADER_STORAGE_BUFFER, 12 * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+        m_statsSSBO.setSize(12 * sizeof(GLuint));
+        GLuint zero = 0;
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        for (GLBuffer& buffer : m_statsReadback) {
+            buffer.create("Ray statistics readback");
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.get());
+            glBufferData(GL_COPY_WRITE_BUFFER, 12 * sizeof(GLuint), nullptr, GL_STREAM_READ);
+            buffer.setSize(12 * sizeof(GLuint));
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
 
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
+    m_costImage.create("Ray cost image");
+    glBindTexture(GL_TEXTURE_2D, m_costImage.get());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_textureWidth, m_textureHeight, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_costImage.setSize(getTextureLevelSize(GL_R32F, m_textureWidth, m_textureHeight));
+}
 
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+void Renderer::createReservoirs() {
+    // RGBA32UI so light indices and counts stay exact, floats are stored as their bits
+    for (int i = 0; i < 2; ++i) {
+        m_reservoirs[i].create(i == 0 ? "ReSTIR reservoirs A" : "ReSTIR reservoirs B");
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_reservoirs[i].get());
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32UI, m_textureWidth, m_textureHeight, 2, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        m_reservoirs[i].setSize(getTextureLevelSize(GL_RGBA32UI, m_textureWidth, m_textureHeight) * 2);
+    }
+    m_reservoirIndex = 0;
+    m_hasReservoirHistory = false;
+}
 
-    // Position attribute (location 0)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+void Renderer::createGuideTrees() {
+    // Fixed to the bounds at the start of training, padded so surfaces on the boundary fall inside a cell
+    m_guideBounds = m_resources->getBounds();
+    if (!m_guideBounds.isEmpty()) {
+        glm::vec3 padding = glm::max(m_guideBounds.getExtent() * 0.01f, glm::vec3(1e-3f));
+        m_guideBounds.min -= padding;
+        m_guideBounds.max += padding;
+    }
 
-    // UV attribute (location 1)
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    m_pathGuide.reset();
+    m_guideTrees.create("Guiding trees");
+    uploadGuideTrees({}, m_pathGuide.getTrainingTree());
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_guideIteration = 0;
+    m_guideIterationFrames = 0;
 }
 
-void Renderer::setupSpheres() {
-    // Initialise sphere buffer
-    if (m_sphereSSBO == 0)
-        glGenBuffers(1, &m_sphereSSBO);
+void Renderer::uploadGuideTrees(const std::vector<uint32_t>& sampling, const std::vector<uint32_t>& training) {
+    std::vector<uint32_t> trees(sampling);
+    trees.insert(trees.end(), training.begin(), training.end());
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_sphereSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, m_spheres.size() * sizeof(Sphere), nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_sphereSSBO);  // binding = 0
+    size_t bytes = trees.size() * sizeof(uint32_t);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_guideTrees.get());
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, trees.data(), GL_DYNAMIC_COPY);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_guideTrees.setSize(bytes);
+
+    // Without a sampling tree the shader reads the empty training tree, with mixing at 0 until there is one
+    m_guideSamplingTree = 0;
+    m_guideTrainingTree = static_cast<uint32_t>(sampling.size());
+    m_guideTrainingSize = training.size();
 }
 
-void Renderer::uploadSpheres(const std::vector<Sphere>& spheres) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_sphereSSBO);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, spheres.size() * sizeof(Sphere), spheres.data());
+void Renderer::finishGuideIteration() {
+    GLDebugGroup group("Path guide refinement");
+
+    // One stall per iteration, and iterations double in length
+    std::vector<uint32_t> trained(m_guideTrainingSize);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_guideTrees.get());
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, m_guideTrainingTree * sizeof(uint32_t),
+        trained.size() * sizeof(uint32_t), trained.data());
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    glUniform1i(m_uLocNumSpheres, (GLint)spheres.size());
+
+    m_guideIteration++;
+    m_guideIterationFrames = 0;
+
+    if (isGuideTrained()) {
+        // The last tree is sampled from now on, nothing trains
+        m_guideSamplingTree = m_guideTrainingTree;
+        return;
+    }
+    m_pathGuide.refine(trained, m_guideIteration - 1, m_guiding.spatialThreshold);
+    uploadGuideTrees(trained, m_pathGuide.getTrainingTree());
 }
 
-void Renderer::setupPlanes() {
-    // Initialise plane buffer
-    if (m_planeSSBO == 0)
-        glGenBuffers(1, &m_planeSSBO);
+void Renderer::resetGuiding() {
+    if (m_guiding.enabled)
+        createGuideTrees();
+}
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_planeSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, m_planes.size() * sizeof(Plane), nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_planeSSBO);  // binding = 1
+void Renderer::createRadianceCache() {
+    size_t bytes = static_cast<size_t>(CACHE_ENTRY_COUNT) * CACHE_ENTRY_SIZE * sizeof(GLuint);
+    m_radianceCache.create("Radiance cache");
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_radianceCache.get());
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_radianceCache.setSize(bytes);
+    clearRadianceCache();
 }
 
-void Renderer::uploadPlanes(const std::vector<Plane>& planes) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_planeSSBO);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, planes.size() * sizeof(Plane), planes.data());
+void Renderer::clearRadianceCache() {
+    if (!m_radianceCache)
+        return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_radianceCache.get());
+    GLuint zero = 0;
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    glUniform1i(m_uLocNumPlanes, (GLint)planes.size());
 }
 
-void Renderer::setupQuads() {
-    // Initialise quad buffer
-    if (m_quadSSBO == 0)
-        glGenBuffers(1, &m_quadSSBO);
+void Renderer::resolveRadianceCache() {
+    const CacheResolveProgram* resolve = m_resources->getCacheResolveProgram();
+    if (!resolve)
+        return;
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_quadSSBO);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, m_quads.size() * sizeof(Quad), nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_quadSSBO);  // binding = 2
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    GLDebugGroup group("Radiance cache resolve");
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(resolve->program.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_radianceCache.get());  // binding = 6
+    glUniform1ui(resolve->uLocEntryCount, CACHE_ENTRY_COUNT);
+    glUniform1ui(resolve->uLocMaxSamples, CACHE_MAX_SAMPLES);
+    glUniform1ui(resolve->uLocMaxAge, CACHE_MAX_AGE);
+    glDispatchCompute((CACHE_ENTRY_COUNT + 63) / 64, 1, 1);  // local_size_x = 64
+
+    // The next frame reads the resolved entries
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 }
 
-void Renderer::uploadQuads(const std::vector<Quad>& quads) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_quadSSBO);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, quads.size() * sizeof(Quad), quads.data());
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-    glUniform1i(m_uLocNumQuads, (GLint)quads.size());
+void Renderer::copyRayStats() {
+    if (m_statsPending == STATS_READBACK_COUNT) {
+        m_statsCarried = true;  // The counters carry over to the next frame's copy
+        return;
+    }
+    m_statsCarried = false;
+
+    GLDebugGroup group("Ray stats copy");
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_statsSSBO.get());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_statsReadback[m_statsHead].get());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, 12 * sizeof(GLuint));
+    GLuint zero = 0;
+    glClearBufferData(GL_COPY_READ_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_statsFences[m_statsHead] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_statsHead = (m_statsHead + 1) % STATS_READBACK_COUNT;
+    m_statsPending++;
 }
 
-void Renderer::createTexturesAndFBO(uint32_t width, uint32_t height) {
-    // Cleanup existing resources
-    if (m_fbo != 0) glDeleteFramebuffers(1, &m_fbo);
-    if (m_accumulatedImage != 0) glDeleteTextures(1, &m_accumulatedImage);
-    if (m_displayTexture != 0) glDeleteTextures(1, &m_displayTexture);
+void Renderer::readRayStats(bool wait) {
+    // Oldest first, without waiting stop at the first copy still in flight
+    while (m_statsPending > 0) {
+        int slot = (m_statsHead - m_statsPending + STATS_READBACK_COUNT) % STATS_READBACK_COUNT;
+        GLenum status = glClientWaitSync(m_statsFences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(m_statsFences[slot], 0, 1000000000);  // 1 s
+        if (status == GL_TIMEOUT_EXPIRED)
+            break;
+
+        glDeleteSync(m_statsFences[slot]);
+        m_statsFences[slot] = nullptr;
+        m_statsPending--;
+        if (status == GL_WAIT_FAILED)
+            continue;  // Those counts are lost, later copies are still good
+
+        GLuint counters[12];
+        glBindBuffer(GL_COPY_READ_BUFFER, m_statsReadback[slot].get());
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        auto counter = [&](int index) {
+            return static_cast<uint64_t>(counters[index * 2]) | (static_cast<uint64_t>(counters[index * 2 + 1]) << 32);
+        };
+
+        m_rayStats.rays += counter(0);
+        m_rayStats.bounces += counter(1);
+        m_rayStats.primitiveTests += counter(2);
+        m_rayStats.missTerminations += counter(3);
+        m_rayStats.rouletteTerminations += counter(4);
+        m_rayStats.maxBounceTerminations += counter(5);
+    }
+}
 
-    // Create the single FBO
-    glGenFramebuffers(1, &m_fbo);
+void Renderer::flushRayStats() {
+    if (!m_statsEnabled || (m_statsPending == 0 && !m_statsCarried))
+        return;
 
-    // Create accumulated image (GL_RGBA32F for precision)
-    glGenTextures(1, &m_accumulatedImage);
-    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Counters left over while every copy was in flight go through one more copy
+    readRayStats(true);
+    copyRayStats();
+    readRayStats(true);
+}
 
-    // Create display texture (GL_RGBA8 for standard display), target for FBO
-    glGenTextures(1, &m_displayTexture);
-    glBindTexture(GL_TEXTURE_2D, m_displayTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+void Renderer::dropRayStats() {
+    for (GLsync& fence : m_statsFences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    m_statsPending = 0;
+    m_statsCarried = false;
+    m_rayStats = RayStats();
+
+    if (m_statsSSBO) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsSSBO.get());
+        GLuint zero = 0;
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
 }
 
 void Renderer::onResize(uint32_t width, uint32_t height) {
@@ -177,150 +312,298 @@ void Renderer::onResize(uint32_t width, uint32_t height) {
 
     createTexturesAndFBO(m_width, m_height);
     resetFrame();
+    m_hasReservoirHistory = false;  // Pixels no longer line up with the stored shading points
 }
 
-void Renderer::setGamma(float gamma) {
-    if (m_gamma != gamma) {
-        m_gamma = gamma;
-        resetFrame();
-    }
+void Renderer::setSamplesPerPixel(uint32_t samples) {
+    // Accumulation is weighted by sample count, so changing this keeps the current image
+    m_samplesPerPixel = std::max(samples, 1u);
 }
 
-void Renderer::setMaxBounces(uint32_t bounces) {
-    if (m_maxBounces != bounces) {
-        m_maxBounces = bounces;
+void Renderer::setFrameOffset(uint32_t offset) {
+    if (m_frameOffset != offset) {
+        m_frameOffset = offset;
         resetFrame();
     }
 }
 
-void Renderer::setSamplesPerPixel(uint32_t samples) {
-    if (m_samplesPerPixel != samples) {
-        m_samplesPerPixel = samples;
-        resetFrame();
+void Renderer::setStatsEnabled(bool enabled) {
+    if (m_statsEnabled == enabled)
+        return;
+
+    m_statsEnabled = enabled;
+
+    if (enabled) {
+        createStatsResources();
+    }
+    else {
+        dropRayStats();
+        m_statsSSBO.reset();
+        for (GLBuffer& buffer : m_statsReadback)
+            buffer.reset();
+        m_costImage.reset();
     }
+
+    resetFrame();
 }
 
-void Renderer::setSkybox(const std::string& filepath) {
-    if (filepath == "") {
-        m_skybox.cleanup();
-        resetFrame();
-        return;
+bool Renderer::isStatsEnabled() const {
+    return m_statsEnabled;
+}
+
+void Renderer::setHeatmap(bool show, float scale) {
+    m_showHeatmap = show;
+    m_heatmapScale = scale;
+}
+
+const RayStats& Renderer::getRayStats() const {
+    return m_rayStats;
+}
+
+void Renderer::setRestir(const RestirSettings& settings) {
+    bool toggled = settings.enabled != m_restir.enabled;
+    m_restir = settings;
+    m_restir.candidates = std::max(m_restir.candidates, 1u);
+    m_restir.maxHistory = std::max(m_restir.maxHistory, 1u);
+
+    if (toggled) {
+        if (m_restir.enabled) {
+            createReservoirs();
+        }
+        else {
+            m_reservoirs[0].reset();
+            m_reservoirs[1].reset();
+        }
     }
 
-    m_skybox.load(filepath);
+    // Frames from different estimators would blend, restart. Reservoirs are valid under any settings
     resetFrame();
 }
 
-void Renderer::setSkyboxExposure(float exposure) {
-    if (m_skyboxExposure != exposure) {
-        m_skyboxExposure = exposure;
-        resetFrame();
-    }
+const RestirSettings& Renderer::getRestir() const {
+    return m_restir;
 }
 
-void Renderer::setSunDirection(glm::vec3 direction) {
-    if (m_sunDirection != direction) {
-        m_sunDirection = direction;
-        resetFrame();
+void Renderer::setGuiding(const GuidingSettings& settings) {
+    bool retrain = settings.enabled != m_guiding.enabled || settings.trainingIterations != m_guiding.trainingIterations ||
+        settings.spatialThreshold != m_guiding.spatialThreshold;
+    m_guiding = settings;
+    m_guiding.mixing = std::clamp(m_guiding.mixing, 0.0f, 1.0f);
+    m_guiding.spatialThreshold = std::max(m_guiding.spatialThreshold, 1u);
+
+    if (retrain) {
+        if (m_guiding.enabled) {
+            createGuideTrees();
+        }
+        else {
+            m_guideTrees.reset();
+        }
     }
+
+    resetFrame();
 }
 
-void Renderer::setSunColour(glm::vec3 colour) {
-    if (m_sunColour != colour) {
-        m_sunColour = colour;
-        resetFrame();
-    }
+const GuidingSettings& Renderer::getGuiding() const {
+    return m_guiding;
 }
 
-void Renderer::setSunIntensity(float intensity) {
-    if (m_sunIntensity != intensity) {
-        m_sunIntensity = intensity;
-        resetFrame();
-    }
+bool Renderer::isGuideTrained() const {
+    return m_guiding.enabled && m_guideIteration >= m_guiding.trainingIterations;
 }
 
-void Renderer::setSunFocus(float focus) {
-    if (m_sunFocus != focus) {
-        m_sunFocus = focus;
-        resetFrame();
+void Renderer::setRadianceCache(const RadianceCacheSettings& settings) {
+    bool enabledChanged = settings.enabled != m_cache.enabled;
+    bool cellsChanged = settings.cellSize != m_cache.cellSize;
+    m_cache = settings;
+    m_cache.cellSize = std::max(m_cache.cellSize, 1e-4f);
+    m_cache.terminationBounce = std::max(m_cache.terminationBounce, 1u);
+    m_cache.updateFraction = std::clamp(m_cache.updateFraction, 0.0f, 1.0f);
+
+    if (enabledChanged) {
+        if (m_cache.enabled)
+            createRadianceCache();
+        else
+            m_radianceCache.reset();
+    }
+    else if (cellsChanged) {
+        // Entries are keyed by cell, none would be found again
+        clearRadianceCache();
     }
+
+    resetFrame();
+}
+
+const RadianceCacheSettings& Renderer::getRadianceCache() const {
+    return m_cache;
+}
+
+SceneResources& Renderer::getResources() {
+    return *m_resources;
+}
+
+const std::shared_ptr<SceneResources>& Renderer::getSharedResources() const {
+    return m_resources;
 }
 
 GLuint Renderer::getDisplayTexture() const {
-    return m_displayTexture;
+    return m_displayTexture.get();
+}
+
+glm::vec2 Renderer::getDisplayScale() const {
+    if (m_textureWidth == 0 || m_textureHeight == 0)
+        return glm::vec2(1.0f);
+    return glm::vec2(static_cast<float>(m_width) / m_textureWidth, static_cast<float>(m_height) / m_textureHeight);
 }
 
 uint32_t Renderer::getFrame() const {
     return m_frame;
 }
 
-void Renderer::render(const Camera& camera) {
-    // Reset accumulation if camera moved
-    static glm::vec3 lastCamPos = camera.position;
-    static glm::vec3 lastCamForward = camera.forward;
-    static glm::vec3 lastCamRight = camera.right;
-    static glm::vec3 lastCamUp = camera.up;
+uint64_t Renderer::getSampleCount() const {
+    return m_sampleCount;
+}
+
+uint32_t Renderer::getWidth() const {
+    return m_width;
+}
+
+uint32_t Renderer::getHeight() const {
+    return m_height;
+}
+
+uint32_t Renderer::getTextureWidth() const {
+    return m_textureWidth;
+}
+
+uint32_t Renderer::getTextureHeight() const {
+    return m_textureHeight;
+}
 
-    if (lastCamPos != camera.position || lastCamForward != camera.forward ||
-        lastCamRight != camera.right || lastCamUp != camera.up) {
+bool Renderer::hasCameraChanged(const Camera& camera) const {
+    return !m_hasLastCamera || m_lastCameraPosition != camera.position || m_lastCameraForward != camera.forward ||
+        m_lastCameraRight != camera.right || m_lastCameraUp != camera.up;
+}
+
+bool Renderer::needsRestart(const Camera& camera) const {
+    return hasCameraChanged(camera) || m_resourceRevision != m_resources->getRevision();
+}
+
+bool Renderer::render(const Camera& camera) {
+    GLDebugGroup group("Path tracing");
+    const PathTracerProgram* program = m_resources->getProgram(m_statsEnabled, m_restir.enabled, m_guiding.enabled,
+        m_cache.enabled);
+    if (!program)
+        return false;
+
+    // Reset accumulation if the shared scene changed since this view started. Stored light samples may
+    // refer to lights that moved or no longer exist, and the guides and cache learned the old scene's light
+    if (m_resourceRevision != m_resources->getRevision()) {
         resetFrame();
-        lastCamPos = camera.position;
-        lastCamForward = camera.forward;
-        lastCamRight = camera.right;
-        lastCamUp = camera.up;
+        m_resourceRevision = m_resources->getRevision();
+        m_hasReservoirHistory = false;
+        resetGuiding();
+        clearRadianceCache();
+    }
+
+    // Reset accumulation if camera moved
+    if (hasCameraChanged(camera)) {
+        if (m_hasLastCamera)
+            resetFrame();
+        m_hasLastCamera = true;
+        m_lastCameraPosition = camera.position;
+        m_lastCameraForward = camera.forward;
+        m_lastCameraRight = camera.right;
+        m_lastCameraUp = camera.up;
     }
 
     // Single Pass: Ray Trace & Accumulate
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_displayTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo.get());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_displayTexture.get(), 0);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cerr << "ERROR::FRAMEBUFFER:: Combined Pass FBO is not complete!" << std::endl;
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        return;
+        return false;
     }
 
     glViewport(0, 0, m_width, m_height);
 
-    glUseProgram(m_shaderProgram);
-
-    // Upload shader uniforms
-    glUniform2f(m_uLocResolution, (float)m_width, (float)m_height);
-    uploadSpheres(m_spheres);
-    uploadPlanes(m_planes);
-    uploadQuads(m_quads);
-    glUniform3fv(m_uLocCameraPos, 1, glm::value_ptr(camera.position));
-    glUniform3fv(m_uLocCameraForward, 1, glm::value_ptr(camera.forward));
-    glUniform3fv(m_uLocCameraRight, 1, glm::value_ptr(camera.right));
-    glUniform3fv(m_uLocCameraUp, 1, glm::value_ptr(camera.up));
-    glUniform3fv(m_uLocSunDirection, 1, glm::value_ptr(m_sunDirection));
-    glUniform3fv(m_uLocSunColour, 1, glm::value_ptr(m_sunColour));
-    glUniform1f(m_uLocSunIntensity, m_sunIntensity);
-    glUniform1f(m_uLocSunFocus, m_sunFocus);
-    glUniform1f(m_uLocGamma, m_gamma);
-    glUniform1ui(m_uLocMaxBounces, m_maxBounces);
-    glUniform1ui(m_uLocSamplesPerPixel, m_samplesPerPixel);
-    glUniform1ui(m_uLocFrame, m_frame);
-
-    // Skybox
-    if (m_skybox.getTextureID() != 0) {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, m_skybox.getTextureID());
-        glUniform1i(m_uLocSkyboxTexture, 1);
-        glUniform1i(m_uLocHasSkybox, 1);
-        glUniform1f(m_uLocSkyboxExposure, m_skyboxExposure);
+    glUseProgram(program->program.get());
+
+    // Upload shader uniforms, scene data is already resident
+    m_resources->bind(*program);
+    glUniform2f(program->uLocResolution, (float)m_width, (float)m_height);
+    glUniform3fv(program->uLocCameraPos, 1, glm::value_ptr(camera.position));
+    glUniform3fv(program->uLocCameraForward, 1, glm::value_ptr(camera.forward));
+    glUniform3fv(program->uLocCameraRight, 1, glm::value_ptr(camera.right));
+    glUniform3fv(program->uLocCameraUp, 1, glm::value_ptr(camera.up));
+    glUniform1ui(program->uLocSamplesPerPixel, m_samplesPerPixel);
+    glUniform1ui(program->uLocFrame, m_frame);
+    glUniform1ui(program->uLocFrameOffset, m_frameOffset);
+    glUniform1f(program->uLocSampleCount, static_cast<float>(m_sampleCount));
+
+    // Bind accumulated image
+    glBindImageTexture(0, m_accumulatedImage.get(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+
+    if (m_statsEnabled) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_statsSSBO.get());  // binding = 3
+        glBindImageTexture(1, m_costImage.get(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glUniform1i(program->uLocShowHeatmap, m_showHeatmap ? 1 : 0);
+        glUniform1f(program->uLocHeatmapScale, m_heatmapScale);
     }
-    else {
-        glUniform1i(m_uLocHasSkybox, 0);
+
+    if (m_restir.enabled) {
+        glBindImageTexture(2, m_reservoirs[1 - m_reservoirIndex].get(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA32UI);
+        glBindImageTexture(3, m_reservoirs[m_reservoirIndex].get(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+        glUniform1i(program->uLocRestirUnbiased, m_restir.unbiased ? 1 : 0);
+        glUniform1ui(program->uLocRestirCandidates, m_restir.candidates);
+        glUniform1ui(program->uLocRestirSpatialSamples, m_restir.spatialSamples);
+        glUniform1f(program->uLocRestirSpatialRadius, m_restir.spatialRadius);
+        glUniform1ui(program->uLocRestirMaxHistory, m_restir.maxHistory);
+        glUniform1i(program->uLocRestirHistory, m_hasReservoirHistory ? 1 : 0);
     }
 
-    // Bind accumulated image
-    glBindImageTexture(0, m_accumulatedImage, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+    bool guideTraining = m_guiding.enabled && !isGuideTrained();
+    if (m_guiding.enabled) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_guideTrees.get());  // binding = 5
+        glUniform3fv(program->uLocGuideBoundsMin, 1, glm::value_ptr(m_guideBounds.min));
+        glUniform3fv(program->uLocGuideBoundsSize, 1, glm::value_ptr(m_guideBounds.getExtent()));
+        glUniform1ui(program->uLocGuideSamplingTree, m_guideSamplingTree);
+        glUniform1ui(program->uLocGuideTrainingTree, m_guideTrainingTree);
+
+        // Nothing to sample until the first iteration finished, and nothing to learn in a scene without bounds
+        bool usable = !m_guideBounds.isEmpty();
+        glUniform1f(program->uLocGuideMixing, usable && m_guideIteration > 0 ? m_guiding.mixing : 0.0f);
+        glUniform1i(program->uLocGuideTraining, usable && guideTraining ? 1 : 0);
+    }
+
+    if (m_cache.enabled) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_radianceCache.get());  // binding = 6
+        glUniform1ui(program->uLocCacheEntryCount, CACHE_ENTRY_COUNT);
+        glUniform1f(program->uLocCacheCellSize, m_cache.cellSize);
+        glUniform1ui(program->uLocCacheTerminationBounce, m_cache.terminationBounce);
+        glUniform1f(program->uLocCacheUpdateFraction, m_cache.updateFraction);
+    }
+
+    // Draw fullscreen quad, timed unless every query is still in flight
+    bool timed = m_timerPending < TIMER_QUERY_COUNT;
+    if (timed) {
+        m_timerSamplesPerPixel[m_timerHead] = m_samplesPerPixel;
+        glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[m_timerHead].get());
+    }
+
+    m_resources->drawQuad();
 
-    // Draw fullscreen quad
-    glBindVertexArray(m_VAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    // Part of the frame's cost, so inside the timing
+    if (m_cache.enabled)
+        resolveRadianceCache();
+
+    if (timed) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_timerQueries[m_timerHead].label();
+        m_timerHead = (m_timerHead + 1) % TIMER_QUERY_COUNT;
+        m_timerPending++;
+    }
     glUseProgram(0);
 
     // Unbind image texture
@@ -329,104 +612,215 @@ void Renderer::render(const Camera& camera) {
     // Unbind FBO
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    if (m_statsEnabled) {
+        glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        copyRayStats();
+        readRayStats();
+    }
+
+    if (m_restir.enabled) {
+        glBindImageTexture(2, 0, 0, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA32UI);
+        glBindImageTexture(3, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+
+        // The next frame reads neighbouring pixels, which plain per-pixel accumulation never does
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        m_reservoirIndex = 1 - m_reservoirIndex;
+        m_hasReservoirHistory = true;
+    }
+
+    // Iteration i lasts 2^i frames, then the tree it trained is sampled and refined into the next one
+    if (guideTraining && ++m_guideIterationFrames >= (1u << std::min(m_guideIteration, 31u)))
+        finishGuideIteration();
+
     m_frame++;
+    m_sampleCount += m_samplesPerPixel;
+    return true;
 }
 
-void Renderer::loadScene(const Scene& scene) {
-    m_spheres = scene.spheres;
-    setupSpheres();
-    m_planes = scene.planes;
-    setupPlanes();
-    m_quads = scene.quads;
-    setupQuads();
-
-    setGamma(scene.gamma);
-    setMaxBounces(scene.maxBounces);
-    setSamplesPerPixel(scene.samplesPerPixel);
+bool Renderer::pollGpuTiming(GpuTiming& timing) {
+    bool found = false;
+
+    // Oldest first, keep the newest finished result
+    while (m_timerPending > 0) {
+        int index = (m_timerHead - m_timerPending + TIMER_QUERY_COUNT) % TIMER_QUERY_COUNT;
 
-    setSkybox(scene.skyboxPath);
-    setSkyboxExposure(scene.getSkyboxExposure());
+        GLint available = 0;
+        glGetQueryObjectiv(m_timerQueries[index].get(), GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
 
-    setSunDirection(scene.getSunDirection());
-    setSunColour(scene.sunColour);
-    setSunIntensity(scene.sunIntensity);
-    setSunFocus(scene.sunFocus);
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_timerQueries[index].get(), GL_QUERY_RESULT, &nanoseconds);
+        timing.milliseconds = static_cast<float>(nanoseconds / 1.0e6);
+        timing.samplesPerPixel = m_timerSamplesPerPixel[index];
+        m_timerPending--;
+        found = true;
+    }
+
+    return found;
+}
 
+void Renderer::loadScene(const Scene& scene) {
+    m_resources->loadScene(scene);
+    setSamplesPerPixel(scene.samplesPerPixel);
     resetFrame();
+    m_resourceRevision = m_resources->getRevision();
+    m_hasReservoirHistory = false;
+    resetGuiding();
+    clearRadianceCache();
 }
 
-void Renderer::saveRenderedImage(const std::string& filepath, int textureWidth, int textureHeight) {
-    if (m_displayTexture == 0 || textureWidth <= 0 || textureHeight <= 0) {
+void Renderer::updateScene(const Scene& scene, const SceneChanges& changes) {
+    // Changes that reach the image bump the resource revision, the next render restarts from that
+    m_resources->updateScene(scene, changes);
+    if (changes.samplesPerPixel)
+        setSamplesPerPixel(scene.samplesPerPixel);
+}
+
+Task<bool> Renderer::saveRenderedImage(const std::string& filepath, int textureWidth, int textureHeight) {
+    if (!m_displayTexture || textureWidth <= 0 || textureHeight <= 0) {
         std::cerr << "Error: Invalid texture ID or dimensions for saving image." << std::endl;
-        return;
+        return JobSystem::get().run([]() { return false; });
     }
 
-    GLuint fbo;
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_displayTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo.get());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_displayTexture.get(), 0);
 
     size_t bufferSize = static_cast<size_t>(textureWidth) * textureHeight * 4;
-    std::vector<unsigned char> pixels(bufferSize);
+    auto pixels = std::make_shared<std::vector<unsigned char>>(bufferSize);
 
-    glReadPixels(0, 0, textureWidth, textureHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glReadPixels(0, 0, textureWidth, textureHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &fbo);
 
-    std::vector<unsigned char> flippedPixels(bufferSize);
-    int rowSize = textureWidth * 4;
+    // Only the readback needs the context, flipping and PNG compression run on the job system
+    return JobSystem::get().run([filepath, textureWidth, textureHeight, pixels]() {
+        int rowSize = textureWidth * 4;
+        std::vector<unsigned char> flippedPixels(pixels->size());
+
+        for (int y = 0; y < textureHeight; ++y) {
+            memcpy(&flippedPixels[y * rowSize], &(*pixels)[(textureHeight - 1 - y) * rowSize], rowSize);
+        }
+
+        int result = stbi_write_png(filepath.c_str(), textureWidth, textureHeight, 4, flippedPixels.data(), rowSize);
+        if (result)
+            std::cout << "Image saved successfully to " << filepath << std::endl;
+        else
+            std::cerr << "Error: Failed to save image to " << filepath << std::endl;
+        return result != 0;
+    });
+}
+
+void Renderer::readAccumulation(std::vector<float>& pixels) {
+    // Make shader image stores visible to the readback
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
 
-    for (int y = 0; y < textureHeight; ++y) {
-        memcpy(&flippedPixels[y * rowSize], &pixels[(textureHeight - 1 - y) * rowSize], rowSize);
+    pixels.resize(static_cast<size_t>(m_textureWidth) * m_textureHeight * 4);
+    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage.get());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // The texture may be larger than the image, pack the rows
+    if (m_textureWidth != m_width) {
+        for (uint32_t y = 1; y < m_height; ++y)
+            std::copy_n(&pixels[static_cast<size_t>(y) * m_textureWidth * 4], static_cast<size_t>(m_width) * 4, &pixels[static_cast<size_t>(y) * m_width * 4]);
+    }
+    pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+}
+
+void Renderer::captureCheckpoint(const Camera& camera, RenderCheckpoint& checkpoint) {
+    readAccumulation(checkpoint.accumulation);
+    checkpoint.width = m_width;
+    checkpoint.height = m_height;
+    checkpoint.frame = m_frame;
+    checkpoint.frameOffset = m_frameOffset;
+    checkpoint.sampleCount = m_sampleCount;
+    checkpoint.cameraPosition = camera.position;
+    checkpoint.cameraYaw = camera.yaw;
+    checkpoint.cameraPitch = camera.pitch;
+    checkpoint.cameraForward = camera.forward;
+    checkpoint.cameraRight = camera.right;
+    checkpoint.cameraUp = camera.up;
+}
+
+bool Renderer::restoreCheckpoint(const RenderCheckpoint& checkpoint) {
+    if (checkpoint.width != m_width || checkpoint.height != m_height ||
+        checkpoint.accumulation.size() != static_cast<size_t>(m_width) * m_height * 4) {
+        std::cerr << "Error: Checkpoint is " << checkpoint.width << "x" << checkpoint.height
+                  << ", the renderer is " << m_width << "x" << m_height << std::endl;
+        return false;
+    }
+
+    resetFrame();
+    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage.get());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_FLOAT, checkpoint.accumulation.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // The next frame continues the RNG sequence and blends with the restored mean
+    m_frame = checkpoint.frame;
+    m_frameOffset = checkpoint.frameOffset;
+    m_sampleCount = checkpoint.sampleCount;
+    m_resourceRevision = m_resources->getRevision();
+    m_hasReservoirHistory = false;
+
+    m_hasLastCamera = true;
+    m_lastCameraPosition = checkpoint.cameraPosition;
+    m_lastCameraForward = checkpoint.cameraForward;
+    m_lastCameraRight = checkpoint.cameraRight;
+    m_lastCameraUp = checkpoint.cameraUp;
+    return true;
+}
+
+float Renderer::estimateNoise() {
+    uint64_t samples = getSampleCount();
+    if (samples < 2)
+        return -1.0f;
+
+    std::vector<float> pixels;
+    readAccumulation(pixels);
+
+    // Per pixel: variance of a sample from the second moment, then the standard error of the mean.
+    // The error is relative to the pixel's brightness, floored so black pixels don't dominate.
+    double bessel = static_cast<double>(samples) / static_cast<double>(samples - 1);
+    double sum = 0.0;
+    size_t pixelCount = pixels.size() / 4;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const float* pixel = &pixels[i * 4];
+        double luminance = 0.2126 * pixel[0] + 0.7152 * pixel[1] + 0.0722 * pixel[2];
+        double variance = std::max(pixel[3] - luminance * luminance, 0.0) * bessel;
+        sum += std::sqrt(variance / static_cast<double>(samples)) / (luminance + 0.01);
     }
 
-    int result = stbi_write_png(filepath.c_str(), textureWidth, textureHeight, 4, flippedPixels.data(), rowSize);
-    if (result)
-        std::cout << "Image saved successfully to " << filepath << std::endl;
-    else
-        std::cerr << "Error: Failed to save image to " << filepath << std::endl;
+    return pixelCount > 0 ? static_cast<float>(sum / static_cast<double>(pixelCount)) : -1.0f;
 }
 
 void Renderer::resetFrame() {
     m_frame = 1;
+    m_sampleCount = 0;
+    dropRayStats();  // Counts in flight belong to the old image
     // Clear accumulation texture
-    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage);
-    glClearTexImage(m_accumulatedImage, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, m_accumulatedImage.get());
+    glClearTexImage(m_accumulatedImage.get(), 0, GL_RGBA, GL_FLOAT, nullptr);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Renderer::cleanup() {
-    if (m_fbo != 0) {
-        glDeleteFramebuffers(1, &m_fbo);
-        m_fbo = 0;
-    }
-    if (m_accumulatedImage != 0) {
-        glDeleteTextures(1, &m_accumulatedImage);
-        m_accumulatedImage = 0;
-    }
-    if (m_displayTexture != 0) {
-        glDeleteTextures(1, &m_displayTexture);
-        m_displayTexture = 0;
-    }
-    if (m_shaderProgram != 0) {
-        glDeleteProgram(m_shaderProgram);
-        m_shaderProgram = 0;
-    }
-    if (m_VAO != 0) {
-        glDeleteVertexArrays(1, &m_VAO);
-        m_VAO = 0;
-    }
-    if (m_VBO != 0) {
-        glDeleteBuffers(1, &m_VBO);
-        m_VBO = 0;
-    }
-    if (m_sphereSSBO != 0) {
-        glDeleteBuffers(1, &m_sphereSSBO);
-        m_sphereSSBO = 0;
-    }
-    if (m_skybox.getTextureID() != 0) {
-        m_skybox.cleanup();
-    }
+    for (GLQuery& query : m_timerQueries)
+        query.reset();
+    m_timerPending = 0;
+
+    m_fbo.reset();
+    m_accumulatedImage.reset();
+    m_displayTexture.reset();
+    m_textureWidth = 0;
+    m_textureHeight = 0;
+    dropRayStats();
+    m_statsSSBO.reset();
+    for (GLBuffer& buffer : m_statsReadback)
+        buffer.reset();
+    m_costImage.reset();
+    m_reservoirs[0].reset();
+    m_reservoirs[1].reset();
+    m_guideTrees.reset();
+    m_radianceCache.reset();
 }
\ No newline at end of file
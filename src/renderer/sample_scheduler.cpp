@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "renderer/sample_scheduler.hpp"
+
+void SampleScheduler::setMode(BudgetMode mode) {
+    m_mode = mode;
+}
+
+BudgetMode SampleScheduler::getMode() const {
+    return m_mode;
+}
+
+void SampleScheduler::setBudget(float milliseconds) {
+    m_budget = std::max(milliseconds, 1.0f);
+}
+
+float SampleScheduler::getBudget() const {
+    return m_mode == BudgetMode::Throughput ? THROUGHPUT_BUDGET : m_budget;
+}
+
+void SampleScheduler::addTiming(float milliseconds, uint32_t samplesPerPixel, uint64_t pixelCount) {
+    if (samplesPerPixel == 0 || pixelCount == 0 || milliseconds <= 0.0f)
+        return;
+
+    float cost = milliseconds / (static_cast<float>(samplesPerPixel) * static_cast<float>(pixelCount));
+    if (m_costPerSample < 0.0f) {
+        m_costPerSample = cost;
+        m_frameTime = milliseconds;
+    }
+    else {
+        m_costPerSample += (cost - m_costPerSample) * SMOOTHING;
+        m_frameTime += (milliseconds - m_frameTime) * SMOOTHING;
+    }
+    m_pixelCount = pixelCount;
+
+    // Timings lag a few frames behind, so grow gradually but shrink at once to avoid stutter
+    float target = getBudget() / (m_costPerSample * static_cast<float>(pixelCount));
+    uint32_t next = static_cast<uint32_t>(std::clamp(target, 1.0f, static_cast<float>(MAX_SAMPLES_PER_PIXEL)));
+    m_samplesPerPixel = std::min(next, m_samplesPerPixel * 2);
+}
+
+void SampleScheduler::reset() {
+    m_costPerSample = -1.0f;
+    m_frameTime = 0.0f;
+    m_samplesPerPixel = 1;
+}
+
+uint32_t SampleScheduler::getSamplesPerPixel() const {
+    return m_samplesPerPixel;
+}
+
+float SampleScheduler::getFrameTime() const {
+    return m_frameTime;
+}
+
+float SampleScheduler::getSamplesPerSecond() const {
+    if (m_costPerSample <= 0.0f || m_pixelCount == 0)
+        return 0.0f;
+    return 1000.0f / (m_costPerSample * static_cast<float>(m_pixelCount));
+}
+
+float SampleScheduler::getPathsPerSecond() const {
+    return m_costPerSample > 0.0f ? 1000.0f / m_costPerSample : 0.0f;
+}
\ No newline at end of file
@@ -0,0 +1,654 @@
+#include <algorithm>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "renderer/scene_resources.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_compiler.hpp"
+#include "scene/scene_diff.hpp"
+#include "utils/gl_debug.hpp"
+#include "utils/shader.hpp"
+
+static float getLuminance(const glm::vec3& colour) {
+    return 0.2126f * colour.x + 0.7152f * colour.y + 0.0722f * colour.z;
+}
+
+// Up to a constant factor. Must agree with IsSampledLight in fragment.glsl on what emits
+static float getEmittedPower(const Material& material, float area) {
+    if (material.emissionStrength <= 0.0f)
+        return 0.0f;
+    return std::max(getLuminance(material.emissionColour), 0.0f) * material.emissionStrength * area;
+}
+
+SceneResources::SceneResources() {
+    setupQuad();
+}
+
+void SceneResources::setupQuad() {
+    // Fullscreen quad vertices
+    float vertices[] = {
+        // x, y, u, v
+        -1.0f, -1.0f, 0.0f, 0.0f,  // Bottom-left
+        1.0f, -1.0f, 1.0f, 0.0f,   // Bottom-right
+        -1.0f, 1.0f, 0.0f, 1.0f,   // Top-left
+        1.0f, 1.0f, 1.0f, 1.0f     // Top-right
+    };
+
+    m_VAO.create("Fullscreen quad VAO");
+    m_VBO.create("Fullscreen quad vertices");
+
+    glBindVertexArray(m_VAO.get());
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO.get());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    m_VBO.setSize(sizeof(vertices));
+
+    // Position attribute (location 0)
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // UV attribute (location 1)
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+const PathTracerProgram* SceneResources::getProgram(bool stats, bool restir, bool guiding, bool cache) {
+    std::unique_ptr<PathTracerProgram>& slot = m_programs[(stats ? 1 : 0) + (restir ? 2 : 0) + (guiding ? 4 : 0) + (cache ? 8 : 0)];
+    if (slot)
+        return slot->program ? slot.get() : nullptr;
+
+    slot = std::make_unique<PathTracerProgram>();
+    PathTracerProgram& p = *slot;
+
+    std::string defines;
+    std::string label = "Path tracing program";
+    if (stats) {
+        defines += "#define RT_STATS\n";
+        label += " (stats)";
+    }
+    if (restir) {
+        defines += "#define RT_RESTIR\n";
+        label += " (ReSTIR)";
+    }
+    if (guiding) {
+        defines += "#define RT_GUIDING\n";
+        label += " (guided)";
+    }
+    if (cache) {
+        defines += "#define RT_CACHE\n";
+        label += " (cached)";
+    }
+    p.program.adopt(createShaderProgram(getShaderPath("vertex.glsl"), getShaderPath("fragment.glsl"), defines), label.c_str());
+    if (!p.program) {
+        std::cerr << "Failed to create shader program" << std::endl;
+        return nullptr;
+    }
+
+    // Cache shader uniform locations
+    GLuint id = p.program.get();
+    p.uLocResolution = glGetUniformLocation(id, "uResolution");
+    p.uLocCameraPos = glGetUniformLocation(id, "uCameraPosition");
+    p.uLocCameraForward = glGetUniformLocation(id, "uCameraForward");
+    p.uLocCameraRight = glGetUniformLocation(id, "uCameraRight");
+    p.uLocCameraUp = glGetUniformLocation(id, "uCameraUp");
+    p.uLocGamma = glGetUniformLocation(id, "uGamma");
+    p.uLocMaxBounces = glGetUniformLocation(id, "uMaxBounces");
+    p.uLocSamplesPerPixel = glGetUniformLocation(id, "uSamplesPerPixel");
+    p.uLocFrame = glGetUniformLocation(id, "uFrame");
+    p.uLocFrameOffset = glGetUniformLocation(id, "uFrameOffset");
+    p.uLocSampleCount = glGetUniformLocation(id, "uSampleCount");
+    p.uLocSkyboxTexture = glGetUniformLocation(id, "uSkyboxTexture");
+    p.uLocHasSkybox = glGetUniformLocation(id, "uHasSkybox");
+    p.uLocSkyboxExposure = glGetUniformLocation(id, "uSkyboxExposure");
+    p.uLocSunDirection = glGetUniformLocation(id, "uSunDirection");
+    p.uLocSunColour = glGetUniformLocation(id, "uSunColour");
+    p.uLocSunIntensity = glGetUniformLocation(id, "uSunIntensity");
+    p.uLocSunFocus = glGetUniformLocation(id, "uSunFocus");
+    p.uLocNumSpheres = glGetUniformLocation(id, "uNumSpheres");
+    p.uLocNumPlanes = glGetUniformLocation(id, "uNumPlanes");
+    p.uLocNumQuads = glGetUniformLocation(id, "uNumQuads");
+    p.uLocNumBoxes = glGetUniformLocation(id, "uNumBoxes");
+    p.uLocNumDiscs = glGetUniformLocation(id, "uNumDiscs");
+    p.uLocNumCylinders = glGetUniformLocation(id, "uNumCylinders");
+    p.uLocShowHeatmap = glGetUniformLocation(id, "uShowHeatmap");
+    p.uLocHeatmapScale = glGetUniformLocation(id, "uHeatmapScale");
+    p.uLocNumLights = glGetUniformLocation(id, "uNumLights");
+    p.uLocSampledLightEnds = glGetUniformLocation(id, "uSampledLightEnds");
+    p.uLocRestirUnbiased = glGetUniformLocation(id, "uRestirUnbiased");
+    p.uLocRestirCandidates = glGetUniformLocation(id, "uRestirCandidates");
+    p.uLocRestirSpatialSamples = glGetUniformLocation(id, "uRestirSpatialSamples");
+    p.uLocRestirSpatialRadius = glGetUniformLocation(id, "uRestirSpatialRadius");
+    p.uLocRestirMaxHistory = glGetUniformLocation(id, "uRestirMaxHistory");
+    p.uLocRestirHistory = glGetUniformLocation(id, "uRestirHistory");
+    p.uLocGuideBoundsMin = glGetUniformLocation(id, "uGuideBoundsMin");
+    p.uLocGuideBoundsSize = glGetUniformLocation(id, "uGuideBoundsSize");
+    p.uLocGuideSamplingTree = glGetUniformLocation(id, "uGuideSamplingTree");
+    p.uLocGuideTrainingTree = glGetUniformLocation(id, "uGuideTrainingTree");
+    p.uLocGuideMixing = glGetUniformLocation(id, "uGuideMixing");
+    p.uLocGuideTraining = glGetUniformLocation(id, "uGuideTraining");
+    p.uLocCacheEntryCount = glGetUniformLocation(id, "uCacheEntryCount");
+    p.uLocCacheCellSize = glGetUniformLocation(id, "uCacheCellSize");
+    p.uLocCacheTerminationBounce = glGetUniformLocation(id, "uCacheTerminationBounce");
+    p.uLocCacheUpdateFraction = glGetUniformLocation(id, "uCacheUpdateFraction");
+
+    return slot.get();
+}
+
+const CacheResolveProgram* SceneResources::getCacheResolveProgram() {
+    if (m_cacheResolveProgram)
+        return m_cacheResolveProgram->program ? m_cacheResolveProgram.get() : nullptr;
+
+    m_cacheResolveProgram = std::make_unique<CacheResolveProgram>();
+    CacheResolveProgram& p = *m_cacheResolveProgram;
+    p.program.adopt(createComputeProgram(getShaderPath("radiance_cache.glsl")), "Radiance cache resolve program");
+    if (!p.program) {
+        std::cerr << "Failed to create shader program" << std::endl;
+        return nullptr;
+    }
+
+    GLuint id = p.program.get();
+    p.uLocEntryCount = glGetUniformLocation(id, "uEntryCount");
+    p.uLocMaxSamples = glGetUniformLocation(id, "uMaxSamples");
+    p.uLocMaxAge = glGetUniformLocation(id, "uMaxAge");
+
+    return m_cacheResolveProgram.get();
+}
+
+void SceneResources::uploadBuffer(GLBuffer& buffer, const char* label, GLuint binding, const void* data, size_t bytes) {
+    if (!buffer)
+        buffer.create(label);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.get());
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer.get());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    buffer.setSize(bytes);
+
+    m_revision++;
+}
+
+void SceneResources::updateBuffer(const GLBuffer& buffer, const void* data, size_t stride, const std::vector<PrimitiveRange>& ranges) {
+    if (ranges.empty())
+        return;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.get());
+    for (const PrimitiveRange& range : ranges)
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.first * stride, range.count * stride, bytes + range.first * stride);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    m_revision++;
+}
+
+void SceneResources::uploadLights() {
+    std::vector<Light> lights;
+    float totalPower = 0.0f;
+    // Returns the index the list stopped at, emitters from there on are left to paths that hit them
+    auto addLights = [&](const std::vector<float>& power, int type) {
+        size_t i = 0;
+        for (; i < power.size() && lights.size() < MAX_LIGHTS; ++i) {
+            if (power[i] > 0.0f) {
+                lights.push_back({ type, static_cast<int>(i), power[i], 0.0f });
+                totalPower += power[i];
+            }
+        }
+        return static_cast<int>(i);
+    };
+    m_sampledLightEnds.x = addLights(m_spherePower, LIGHT_SPHERE);
+    m_sampledLightEnds.y = addLights(m_quadPower, LIGHT_QUAD);
+    m_sampledLightEnds.z = addLights(m_discPower, LIGHT_DISC);
+
+    if (lights.size() == MAX_LIGHTS)
+        std::cerr << "Warning: Direct lighting samples only the first " << MAX_LIGHTS << " emitters, "
+            "the rest are only found by bouncing" << std::endl;
+
+    float cdf = 0.0f;
+    for (Light& light : lights) {
+        light.probability /= totalPower;
+        cdf += light.probability;
+        light.cdf = cdf;
+    }
+    if (!lights.empty())
+        lights.back().cdf = 1.0f;  // Rounding must not leave a gap at the top
+
+    uploadBuffer(m_lightSSBO, "Light SSBO", 4, lights.data(), lights.size() * sizeof(Light));  // binding = 4
+    m_numLights = static_cast<GLint>(lights.size());
+}
+
+void SceneResources::uploadSpheres(const std::vector<Sphere>& spheres) {
+    uploadBuffer(m_sphereSSBO, "Sphere SSBO", 0, spheres.data(), spheres.size() * sizeof(Sphere));  // binding = 0
+    m_numSpheres = static_cast<GLint>(spheres.size());
+
+    m_spherePower.resize(spheres.size());
+    for (size_t i = 0; i < spheres.size(); ++i)
+        m_spherePower[i] = getEmittedPower(spheres[i].material, 4.0f * 3.1415926f * spheres[i].radius * spheres[i].radius);
+    uploadLights();
+
+    m_sphereBounds = Bounds();
+    for (const Sphere& sphere : spheres)
+        m_sphereBounds.expand(SceneCompiler::getBounds(sphere));
+}
+
+void SceneResources::uploadPlanes(const std::vector<Plane>& planes) {
+    uploadBuffer(m_planeSSBO, "Plane SSBO", 1, planes.data(), planes.size() * sizeof(Plane));  // binding = 1
+    m_numPlanes = static_cast<GLint>(planes.size());
+}
+
+void SceneResources::uploadQuads(const std::vector<Quad>& quads) {
+    uploadBuffer(m_quadSSBO, "Quad SSBO", 2, quads.data(), quads.size() * sizeof(Quad));  // binding = 2
+    m_numQuads = static_cast<GLint>(quads.size());
+
+    m_quadPower.resize(quads.size());
+    for (size_t i = 0; i < quads.size(); ++i)
+        m_quadPower[i] = getEmittedPower(quads[i].material, quads[i].width * quads[i].height);
+    uploadLights();
+
+    m_quadBounds = Bounds();
+    for (const Quad& quad : quads)
+        m_quadBounds.expand(SceneCompiler::getBounds(quad));
+}
+
+void SceneResources::uploadBoxes(const std::vector<Box>& boxes) {
+    uploadBuffer(m_boxSSBO, "Box SSBO", 7, boxes.data(), boxes.size() * sizeof(Box));  // binding = 7
+    m_numBoxes = static_cast<GLint>(boxes.size());
+
+    m_boxBounds = Bounds();
+    for (const Box& box : boxes)
+        m_boxBounds.expand(SceneCompiler::getBounds(box));
+}
+
+void SceneResources::uploadDiscs(const std::vector<Disc>& discs) {
+    uploadBuffer(m_discSSBO, "Disc SSBO", 8, discs.data(), discs.size() * sizeof(Disc));  // binding = 8
+    m_numDiscs = static_cast<GLint>(discs.size());
+
+    m_discPower.resize(discs.size());
+    for (size_t i = 0; i < discs.size(); ++i)
+        m_discPower[i] = getEmittedPower(discs[i].material, 3.1415926f * discs[i].radius * discs[i].radius);
+    uploadLights();
+
+    m_discBounds = Bounds();
+    for (const Disc& disc : discs)
+        m_discBounds.expand(SceneCompiler::getBounds(disc));
+}
+
+void SceneResources::uploadCylinders(const std::vector<Cylinder>& cylinders) {
+    uploadBuffer(m_cylinderSSBO, "Cylinder SSBO", 9, cylinders.data(), cylinders.size() * sizeof(Cylinder));  // binding = 9
+    m_numCylinders = static_cast<GLint>(cylinders.size());
+
+    m_cylinderBounds = Bounds();
+    for (const Cylinder& cylinder : cylinders)
+        m_cylinderBounds.expand(SceneCompiler::getBounds(cylinder));
+}
+
+void SceneResources::updateSpheres(const std::vector<Sphere>& spheres, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(spheres.size()) != m_numSpheres) {
+        uploadSpheres(spheres);
+        return;
+    }
+
+    updateBuffer(m_sphereSSBO, spheres.data(), sizeof(Sphere), ranges);
+
+    // Rebuild the light list only if an edit changed what emits
+    bool lightsChanged = false;
+    for (const PrimitiveRange& range : ranges) {
+        for (size_t i = range.first; i < range.first + range.count; ++i) {
+            float power = getEmittedPower(spheres[i].material, 4.0f * 3.1415926f * spheres[i].radius * spheres[i].radius);
+            lightsChanged |= power != m_spherePower[i];
+            m_spherePower[i] = power;
+        }
+    }
+    if (lightsChanged)
+        uploadLights();
+
+    m_sphereBounds = Bounds();
+    for (const Sphere& sphere : spheres)
+        m_sphereBounds.expand(SceneCompiler::getBounds(sphere));
+}
+
+void SceneResources::updatePlanes(const std::vector<Plane>& planes, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(planes.size()) != m_numPlanes)
+        uploadPlanes(planes);
+    else
+        updateBuffer(m_planeSSBO, planes.data(), sizeof(Plane), ranges);
+}
+
+void SceneResources::updateQuads(const std::vector<Quad>& quads, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(quads.size()) != m_numQuads) {
+        uploadQuads(quads);
+        return;
+    }
+
+    updateBuffer(m_quadSSBO, quads.data(), sizeof(Quad), ranges);
+
+    // Rebuild the light list only if an edit changed what emits
+    bool lightsChanged = false;
+    for (const PrimitiveRange& range : ranges) {
+        for (size_t i = range.first; i < range.first + range.count; ++i) {
+            float power = getEmittedPower(quads[i].material, quads[i].width * quads[i].height);
+            lightsChanged |= power != m_quadPower[i];
+            m_quadPower[i] = power;
+        }
+    }
+    if (lightsChanged)
+        uploadLights();
+
+    m_quadBounds = Bounds();
+    for (const Quad& quad : quads)
+        m_quadBounds.expand(SceneCompiler::getBounds(quad));
+}
+
+void SceneResources::updateBoxes(const std::vector<Box>& boxes, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(boxes.size()) != m_numBoxes) {
+        uploadBoxes(boxes);
+        return;
+    }
+
+    updateBuffer(m_boxSSBO, boxes.data(), sizeof(Box), ranges);
+
+    m_boxBounds = Bounds();
+    for (const Box& box : boxes)
+        m_boxBounds.expand(SceneCompiler::getBounds(box));
+}
+
+void SceneResources::updateDiscs(const std::vector<Disc>& discs, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(discs.size()) != m_numDiscs) {
+        uploadDiscs(discs);
+        return;
+    }
+
+    updateBuffer(m_discSSBO, discs.data(), sizeof(Disc), ranges);
+
+    // Rebuild the light list only if an edit changed what emits
+    bool lightsChanged = false;
+    for (const PrimitiveRange& range : ranges) {
+        for (size_t i = range.first; i < range.first + range.count; ++i) {
+            float power = getEmittedPower(discs[i].material, 3.1415926f * discs[i].radius * discs[i].radius);
+            lightsChanged |= power != m_discPower[i];
+            m_discPower[i] = power;
+        }
+    }
+    if (lightsChanged)
+        uploadLights();
+
+    m_discBounds = Bounds();
+    for (const Disc& disc : discs)
+        m_discBounds.expand(SceneCompiler::getBounds(disc));
+}
+
+void SceneResources::updateCylinders(const std::vector<Cylinder>& cylinders, const std::vector<PrimitiveRange>& ranges) {
+    if (static_cast<GLint>(cylinders.size()) != m_numCylinders) {
+        uploadCylinders(cylinders);
+        return;
+    }
+
+    updateBuffer(m_cylinderSSBO, cylinders.data(), sizeof(Cylinder), ranges);
+
+    m_cylinderBounds = Bounds();
+    for (const Cylinder& cylinder : cylinders)
+        m_cylinderBounds.expand(SceneCompiler::getBounds(cylinder));
+}
+
+void SceneResources::loadScene(const Scene& scene) {
+    GLDebugGroup group("Scene upload");
+    uploadSpheres(scene.spheres);
+    uploadPlanes(scene.planes);
+    uploadQuads(scene.quads);
+    uploadBoxes(scene.boxes);
+    uploadDiscs(scene.discs);
+    uploadCylinders(scene.cylinders);
+
+    setGamma(scene.gamma);
+    setMaxBounces(scene.maxBounces);
+
+    setSkybox(scene.skyboxPath);
+    setSkyboxExposure(scene.getSkyboxExposure());
+
+    setSunDirection(scene.getSunDirection());
+    setSunColour(scene.sunColour);
+    setSunIntensity(scene.sunIntensity);
+    setSunFocus(scene.sunFocus);
+}
+
+void SceneResources::updateScene(const Scene& scene, const SceneChanges& changes) {
+    GLDebugGroup group("Scene update");
+    if (changes.spheres.any())
+        updateSpheres(scene.spheres, changes.spheres.ranges);
+    if (changes.planes.any())
+        updatePlanes(scene.planes, changes.planes.ranges);
+    if (changes.quads.any())
+        updateQuads(scene.quads, changes.quads.ranges);
+    if (changes.boxes.any())
+        updateBoxes(scene.boxes, changes.boxes.ranges);
+    if (changes.discs.any())
+        updateDiscs(scene.discs, changes.discs.ranges);
+    if (changes.cylinders.any())
+        updateCylinders(scene.cylinders, changes.cylinders.ranges);
+
+    // The setters only restart accumulation for values that actually differ
+    if (changes.tracing) {
+        setGamma(scene.gamma);
+        setMaxBounces(scene.maxBounces);
+    }
+
+    if (changes.skybox)
+        setSkybox(scene.skyboxPath);
+
+    if (changes.environment) {
+        setSkyboxExposure(scene.getSkyboxExposure());
+        setSunDirection(scene.getSunDirection());
+        setSunColour(scene.sunColour);
+        setSunIntensity(scene.sunIntensity);
+        setSunFocus(scene.sunFocus);
+    }
+}
+
+void SceneResources::setGamma(float gamma) {
+    if (m_gamma != gamma) {
+        m_gamma = gamma;
+        m_revision++;
+    }
+}
+
+void SceneResources::setMaxBounces(uint32_t bounces) {
+    if (m_maxBounces != bounces) {
+        m_maxBounces = bounces;
+        m_revision++;
+    }
+}
+
+void SceneResources::setSkybox(const std::string& filepath) {
+    if (filepath == "") {
+        m_revision++;
+        m_hasSkybox = false;
+        if (m_skyboxCacheCapacity <= 1)
+            m_skyboxCache.clear();
+        return;
+    }
+
+    auto cached = std::find_if(m_skyboxCache.begin(), m_skyboxCache.end(),
+        [&](const auto& entry) { return entry.first == filepath; });
+
+    if (cached != m_skyboxCache.end()) {
+        m_revision++;
+        std::rotate(m_skyboxCache.begin(), cached, cached + 1);
+        m_hasSkybox = true;
+        return;
+    }
+
+    SkyboxData data;
+    if (!Skybox::decode(filepath, m_skyboxFormat, data)) {
+        m_revision++;
+        m_hasSkybox = false;
+        return;
+    }
+    setSkybox(data);
+}
+
+void SceneResources::setSkybox(const SkyboxData& data) {
+    // Decoded for a format that has since changed
+    if (data.format != m_skyboxFormat) {
+        setSkybox(data.filepath);
+        return;
+    }
+
+    m_revision++;
+
+    auto cached = std::find_if(m_skyboxCache.begin(), m_skyboxCache.end(),
+        [&](const auto& entry) { return entry.first == data.filepath; });
+    if (cached != m_skyboxCache.end())
+        m_skyboxCache.erase(cached);
+
+    // Evict before uploading so a single-entry cache never holds two textures
+    while (!m_skyboxCache.empty() && m_skyboxCache.size() >= m_skyboxCacheCapacity)
+        m_skyboxCache.pop_back();
+
+    auto skybox = std::make_unique<Skybox>();
+    if (!skybox->upload(data)) {
+        m_hasSkybox = false;
+        return;
+    }
+    m_skyboxCache.insert(m_skyboxCache.begin(), { data.filepath, std::move(skybox) });
+    m_hasSkybox = true;
+}
+
+bool SceneResources::isSkyboxCached(const std::string& filepath) const {
+    return std::any_of(m_skyboxCache.begin(), m_skyboxCache.end(),
+        [&](const auto& entry) { return entry.first == filepath; });
+}
+
+std::vector<std::string> SceneResources::getCachedSkyboxes() const {
+    std::vector<std::string> paths;
+    for (const auto& entry : m_skyboxCache)
+        paths.push_back(entry.first);
+    return paths;
+}
+
+void SceneResources::setSkyboxCacheCapacity(size_t capacity) {
+    m_skyboxCacheCapacity = std::max<size_t>(capacity, 1);
+    while (m_skyboxCache.size() > m_skyboxCacheCapacity)
+        m_skyboxCache.pop_back();
+}
+
+void SceneResources::setSkyboxFormat(SkyboxFormat format) {
+    if (m_skyboxFormat == format)
+        return;
+
+    m_skyboxFormat = format;
+
+    // Cached textures are in the old format, reload the active one
+    std::string activePath = (m_hasSkybox && !m_skyboxCache.empty()) ? m_skyboxCache.front().first : "";
+    m_skyboxCache.clear();
+    m_hasSkybox = false;
+    setSkybox(activePath);
+}
+
+void SceneResources::setSkyboxExposure(float exposure) {
+    if (m_skyboxExposure != exposure) {
+        m_skyboxExposure = exposure;
+        m_revision++;
+    }
+}
+
+void SceneResources::setSunDirection(glm::vec3 direction) {
+    if (m_sunDirection != direction) {
+        m_sunDirection = direction;
+        m_revision++;
+    }
+}
+
+void SceneResources::setSunColour(glm::vec3 colour) {
+    if (m_sunColour != colour) {
+        m_sunColour = colour;
+        m_revision++;
+    }
+}
+
+void SceneResources::setSunIntensity(float intensity) {
+    if (m_sunIntensity != intensity) {
+        m_sunIntensity = intensity;
+        m_revision++;
+    }
+}
+
+void SceneResources::setSunFocus(float focus) {
+    if (m_sunFocus != focus) {
+        m_sunFocus = focus;
+        m_revision++;
+    }
+}
+
+SkyboxFormat SceneResources::getSkyboxFormat() const {
+    return m_skyboxFormat;
+}
+
+const Skybox* SceneResources::getActiveSkybox() const {
+    if (!m_hasSkybox || m_skyboxCache.empty())
+        return nullptr;
+    return m_skyboxCache.front().second.get();
+}
+
+uint64_t SceneResources::getRevision() const {
+    return m_revision;
+}
+
+GLint SceneResources::getLightCount() const {
+    return m_numLights;
+}
+
+Bounds SceneResources::getBounds() const {
+    Bounds bounds = m_sphereBounds;
+    bounds.expand(m_quadBounds);
+    bounds.expand(m_boxBounds);
+    bounds.expand(m_discBounds);
+    bounds.expand(m_cylinderBounds);
+    return bounds;
+}
+
+void SceneResources::bind(const PathTracerProgram& program) const {
+    // Bindings are global state, another SceneResources may have replaced them
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_sphereSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_planeSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_quadSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_lightSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_boxSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_discSSBO.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_cylinderSSBO.get());
+    glUniform1i(program.uLocNumSpheres, m_numSpheres);
+    glUniform1i(program.uLocNumPlanes, m_numPlanes);
+    glUniform1i(program.uLocNumQuads, m_numQuads);
+    glUniform1i(program.uLocNumBoxes, m_numBoxes);
+    glUniform1i(program.uLocNumDiscs, m_numDiscs);
+    glUniform1i(program.uLocNumCylinders, m_numCylinders);
+    glUniform1i(program.uLocNumLights, m_numLights);
+    glUniform3iv(program.uLocSampledLightEnds, 1, glm::value_ptr(m_sampledLightEnds));
+
+    glUniform1f(program.uLocGamma, m_gamma);
+    glUniform1ui(program.uLocMaxBounces, m_maxBounces);
+
+    glUniform3fv(program.uLocSunDirection, 1, glm::value_ptr(m_sunDirection));
+    glUniform3fv(program.uLocSunColour, 1, glm::value_ptr(m_sunColour));
+    glUniform1f(program.uLocSunIntensity, m_sunIntensity);
+    glUniform1f(program.uLocSunFocus, m_sunFocus);
+
+    const Skybox* skybox = getActiveSkybox();
+    if (skybox && skybox->getTextureID() != 0) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, skybox->getTextureID());
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(program.uLocSkyboxTexture, 1);
+        glUniform1i(program.uLocHasSkybox, 1);
+        glUniform1f(program.uLocSkyboxExposure, m_skyboxExposure);
+    }
+    else {
+        glUniform1i(program.uLocHasSkybox, 0);
+    }
+}
+
+void SceneResources::drawQuad() const {
+    glBindVertexArray(m_VAO.get());
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "scene/scene_binary.hpp"
+#include "scene/scene_compiler.hpp"
+#include "utils/mapped_file.hpp"
+
+namespace SceneBinary {
+    static uint64_t alignOffset(uint64_t offset) {
+        return (offset + 15) & ~static_cast<uint64_t>(15);
+    }
+
+    // Bytes per element of each known section type, 0 for types this version skips
+    static uint64_t getElementSize(uint32_t type) {
+        switch (type) {
+        case SECTION_NAME:
+        case SECTION_SKYBOX_PATH:
+            return sizeof(char);
+        case SECTION_SPHERES:
+            return sizeof(Sphere);
+        case SECTION_PLANES:
+            return sizeof(Plane);
+        case SECTION_QUADS:
+            return sizeof(Quad);
+        case SECTION_ANIMATION:
+            return sizeof(AnimationSettings);
+        case SECTION_KEYFRAMES:
+            return sizeof(CameraKeyframe);
+        case SECTION_BOXES:
+            return sizeof(Box);
+        case SECTION_DISCS:
+            return sizeof(Disc);
+        case SECTION_CYLINDERS:
+            return sizeof(Cylinder);
+        default:
+            return 0;
+        }
+    }
+
+    // Stride and bounds are checked when the section table is validated
+    template <typename T>
+    static void readArray(const MappedFile& file, const Section& section, std::vector<T>& out) {
+        const T* first = reinterpret_cast<const T*>(file.data() + section.offset);
+        out.assign(first, first + section.count);
+    }
+
+    bool isBinaryScene(const std::string& filename) {
+        size_t length = std::strlen(EXTENSION);
+        return filename.size() >= length && filename.compare(filename.size() - length, length, EXTENSION) == 0;
+    }
+
+    bool saveScene(const std::string& filename, const Scene& source) {
+        // Loading skips the compile step, so files always hold compiled primitives
+        Scene scene = source;
+        SceneCompiler::compile(scene);
+
+        struct Payload {
+            SectionType type;
+            uint32_t stride;
+            const void* data;
+            uint64_t count;
+        };
+
+        AnimationSettings animation = {};
+        animation.fps = scene.cameraTrack.fps;
+        animation.duration = scene.cameraTrack.duration;
+        animation.interpolation = static_cast<int32_t>(scene.cameraTrack.interpolation);
+
+        std::vector<Payload> payloads = {
+            { SECTION_NAME, 1, scene.name.data(), scene.name.size() },
+            { SECTION_SKYBOX_PATH, 1, scene.skyboxPath.data(), scene.skyboxPath.size() },
+            { SECTION_SPHERES, sizeof(Sphere), scene.spheres.data(), scene.spheres.size() },
+            { SECTION_PLANES, sizeof(Plane), scene.planes.data(), scene.planes.size() },
+            { SECTION_QUADS, sizeof(Quad), scene.quads.data(), scene.quads.size() },
+            { SECTION_BOXES, sizeof(Box), scene.boxes.data(), scene.boxes.size() },
+            { SECTION_DISCS, sizeof(Disc), scene.discs.data(), scene.discs.size() },
+            { SECTION_CYLINDERS, sizeof(Cylinder), scene.cylinders.data(), scene.cylinders.size() },
+            { SECTION_ANIMATION, sizeof(AnimationSettings), &animation, 1 },
+            { SECTION_KEYFRAMES, sizeof(CameraKeyframe), scene.cameraTrack.keyframes.data(), scene.cameraTrack.keyframes.size() }
+        };
+
+        FileHeader header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.sectionCount = static_cast<uint32_t>(payloads.size());
+        header.sectionTableOffset = alignOffset(sizeof(FileHeader));
+
+        Settings& settings = header.settings;
+        settings.gamma = scene.gamma;
+        settings.maxBounces = scene.maxBounces;
+        settings.samplesPerPixel = scene.samplesPerPixel;
+        std::memcpy(settings.cameraPosition, &scene.camera.position.x, sizeof(settings.cameraPosition));
+        settings.cameraYaw = scene.camera.yaw;
+        settings.cameraPitch = scene.camera.pitch;
+        settings.skyboxExposureEV = scene.skyboxExposureEV;
+        settings.sunPitch = scene.sunPitch;
+        settings.sunYaw = scene.sunYaw;
+        std::memcpy(settings.sunColour, &scene.sunColour.x, sizeof(settings.sunColour));
+        settings.sunIntensity = scene.sunIntensity;
+        settings.sunFocus = scene.sunFocus;
+
+        // Lay out payloads after the section table
+        std::vector<Section> sections;
+        uint64_t offset = alignOffset(header.sectionTableOffset + payloads.size() * sizeof(Section));
+        for (const Payload& payload : payloads) {
+            sections.push_back({ payload.type, payload.stride, offset, payload.count });
+            offset = alignOffset(offset + payload.stride * payload.count);
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open scene file for writing: " << filename << std::endl;
+            return false;
+        }
+
+        auto padTo = [&](uint64_t target) {
+            static const char zeros[16] = {};
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            if (target > position)
+                file.write(zeros, static_cast<std::streamsize>(target - position));
+        };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        padTo(header.sectionTableOffset);
+        file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Section));
+
+        for (size_t i = 0; i < payloads.size(); ++i) {
+            padTo(sections[i].offset);
+            file.write(static_cast<const char*>(payloads[i].data), static_cast<std::streamsize>(payloads[i].stride * payloads[i].count));
+        }
+
+        if (!file.good()) {
+            std::cerr << "Error: Failed writing binary scene: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool loadScene(const std::string& filename, Scene& scene) {
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+
+        if (file.size() < sizeof(FileHeader)) {
+            std::cerr << "Error: Binary scene file is truncated: " << filename << std::endl;
+            return false;
+        }
+
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION) {
+            std::cerr << "Error: Unsupported binary scene file (version " << header.version << "): " << filename << std::endl;
+            return false;
+        }
+
+        // Sizes are compared without sums or products that a crafted header could overflow
+        uint64_t size = file.size();
+        if (header.sectionTableOffset > size || header.sectionCount > (size - header.sectionTableOffset) / sizeof(Section)) {
+            std::cerr << "Error: Binary scene section table is truncated: " << filename << std::endl;
+            return false;
+        }
+
+        // Validate everything before touching the scene
+        std::vector<Section> sections(header.sectionCount);
+        std::memcpy(sections.data(), file.data() + header.sectionTableOffset, sections.size() * sizeof(Section));
+        for (const Section& section : sections) {
+            uint64_t elementSize = getElementSize(section.type);
+            if (elementSize != 0 && section.stride != elementSize) {
+                std::cerr << "Error: Binary scene layout mismatch (section " << section.type << ", stride " << section.stride
+                    << ", expected " << elementSize << "), reconvert the scene: " << filename << std::endl;
+                return false;
+            }
+
+            bool inBounds = section.offset <= size
+                && (section.count == 0 || (section.stride != 0 && section.count <= (size - section.offset) / section.stride));
+            if (!inBounds) {
+                std::cerr << "Error: Binary scene section " << section.type << " is truncated: " << filename << std::endl;
+                return false;
+            }
+        }
+
+        Scene loaded;
+
+        const Settings& settings = header.settings;
+        loaded.gamma = settings.gamma;
+        loaded.maxBounces = settings.maxBounces;
+        loaded.samplesPerPixel = settings.samplesPerPixel;
+        loaded.camera.position = glm::vec3(settings.cameraPosition[0], settings.cameraPosition[1], settings.cameraPosition[2]);
+        loaded.camera.yaw = settings.cameraYaw;
+        loaded.camera.pitch = settings.cameraPitch;
+        loaded.camera.updateOrientation();
+        loaded.skyboxExposureEV = settings.skyboxExposureEV;
+        loaded.sunPitch = settings.sunPitch;
+        loaded.sunYaw = settings.sunYaw;
+        loaded.sunColour = glm::vec3(settings.sunColour[0], settings.sunColour[1], settings.sunColour[2]);
+        loaded.sunIntensity = settings.sunIntensity;
+        loaded.sunFocus = settings.sunFocus;
+
+        for (const Section& section : sections) {
+            const char* bytes = reinterpret_cast<const char*>(file.data() + section.offset);
+
+            switch (section.type) {
+            case SECTION_NAME:
+                loaded.name.assign(bytes, section.count);
+                break;
+            case SECTION_SKYBOX_PATH:
+                loaded.skyboxPath.assign(bytes, section.count);
+                break;
+            case SECTION_SPHERES:
+                readArray(file, section, loaded.spheres);
+                break;
+            case SECTION_PLANES:
+                readArray(file, section, loaded.planes);
+                break;
+            case SECTION_QUADS:
+                readArray(file, section, loaded.quads);
+                break;
+            case SECTION_BOXES:
+                readArray(file, section, loaded.boxes);
+                break;
+            case SECTION_DISCS:
+                readArray(file, section, loaded.discs);
+                break;
+            case SECTION_CYLINDERS:
+                readArray(file, section, loaded.cylinders);
+                break;
+            case SECTION_ANIMATION: {
+                std::vector<AnimationSettings> animation;
+                readArray(file, section, animation);
+                if (!animation.empty()) {
+                    loaded.cameraTrack.fps = animation[0].fps;
+                    loaded.cameraTrack.duration = animation[0].duration;
+                    loaded.cameraTrack.interpolation = static_cast<CameraInterpolation>(animation[0].interpolation);
+                }
+                break;
+            }
+            case SECTION_KEYFRAMES:
+                readArray(file, section, loaded.cameraTrack.keyframes);
+                break;
+            default:
+                break;
+            }
+        }
+
+        scene = std::move(loaded);
+        std::cout << "Scene '" << scene.name << "' loaded successfully." << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,215 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "scene/scene_compiler.hpp"
+
+namespace SceneCompiler {
+    namespace {
+        constexpr float MIN_LENGTH = 1e-6f;
+
+        bool isFinite(const glm::vec3& v) {
+            return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+        }
+
+        // Half the extent along each world axis of a disc with the given unit normal
+        glm::vec3 getDiscExtent(const glm::vec3& normal, float radius) {
+            return radius * glm::sqrt(glm::max(glm::vec3(1.0f) - normal * normal, glm::vec3(0.0f)));
+        }
+
+        void warnRemoved(size_t count, const char* type, const Scene& scene) {
+            if (count > 0)
+                std::cerr << "Warning: Removed " << count << " degenerate " << type << " from '" << scene.name << "'" << std::endl;
+        }
+
+        // Keeps the primitives that compile, in order
+        template <typename T, typename Compile>
+        size_t compileAll(std::vector<T>& primitives, Compile compile) {
+            size_t kept = 0;
+            for (size_t i = 0; i < primitives.size(); ++i) {
+                if (!compile(primitives[i]))
+                    continue;
+                if (kept != i)
+                    primitives[kept] = primitives[i];
+                kept++;
+            }
+
+            size_t removed = primitives.size() - kept;
+            primitives.resize(kept);
+            return removed;
+        }
+    }
+
+    bool compileSphere(Sphere& sphere) {
+        if (!isFinite(sphere.position) || !std::isfinite(sphere.radius) || sphere.radius <= 0.0f)
+            return false;
+
+        sphere.radiusSquared = sphere.radius * sphere.radius;
+        sphere.inverseRadius = 1.0f / sphere.radius;
+        sphere._pad0 = 0.0f;
+        sphere._pad1 = 0.0f;
+        return true;
+    }
+
+    bool compilePlane(Plane& plane) {
+        float length = glm::length(plane.normal);
+        if (!isFinite(plane.position) || !std::isfinite(length) || length < MIN_LENGTH)
+            return false;
+
+        plane.normal /= length;
+        plane.offset = glm::dot(plane.normal, plane.position);
+        plane._pad1 = 0.0f;
+        return true;
+    }
+
+    bool compileQuad(Quad& quad) {
+        if (!isFinite(quad.position) || !std::isfinite(quad.width) || !std::isfinite(quad.height) ||
+            quad.width <= 0.0f || quad.height <= 0.0f)
+            return false;
+
+        float normalLength = glm::length(quad.normal);
+        if (!std::isfinite(normalLength) || normalLength < MIN_LENGTH)
+            return false;
+        glm::vec3 normal = quad.normal / normalLength;
+
+        // Gram-Schmidt, right keeps its direction within the plane
+        glm::vec3 right = quad.right - normal * glm::dot(quad.right, normal);
+        float rightLength = glm::length(right);
+        if (!std::isfinite(rightLength) || rightLength < MIN_LENGTH)
+            return false;
+        right /= rightLength;
+
+        // Up follows from the other two, on the side the scene gave
+        glm::vec3 up = glm::cross(normal, right);
+        if (glm::dot(up, quad.up) < 0.0f)
+            up = -up;
+
+        quad.normal = normal;
+        quad.right = right;
+        quad.up = up;
+        quad.halfWidth = quad.width * 0.5f;
+        quad.halfHeight = quad.height * 0.5f;
+        return true;
+    }
+
+    bool compileBox(Box& box) {
+        glm::vec3 size(box.width, box.height, box.depth);
+        if (!isFinite(box.position) || !isFinite(size) || box.width <= 0.0f || box.height <= 0.0f || box.depth <= 0.0f)
+            return false;
+
+        float rightLength = glm::length(box.right);
+        if (!std::isfinite(rightLength) || rightLength < MIN_LENGTH)
+            return false;
+        glm::vec3 right = box.right / rightLength;
+
+        // Gram-Schmidt, up keeps its direction perpendicular to right
+        glm::vec3 up = box.up - right * glm::dot(box.up, right);
+        float upLength = glm::length(up);
+        if (!std::isfinite(upLength) || upLength < MIN_LENGTH)
+            return false;
+        up /= upLength;
+
+        box.inward = box.inward != 0 ? 1 : 0;
+        box.right = right;
+        box.up = up;
+        box.forward = glm::cross(right, up);
+        box.halfSize = size * 0.5f;
+        box._pad0 = 0.0f;
+        return true;
+    }
+
+    bool compileDisc(Disc& disc) {
+        float length = glm::length(disc.normal);
+        if (!isFinite(disc.position) || !std::isfinite(disc.radius) || disc.radius <= 0.0f ||
+            !std::isfinite(length) || length < MIN_LENGTH)
+            return false;
+
+        disc.normal /= length;
+        disc.radiusSquared = disc.radius * disc.radius;
+        return true;
+    }
+
+    bool compileCylinder(Cylinder& cylinder) {
+        float length = glm::length(cylinder.axis);
+        if (!isFinite(cylinder.position) || !std::isfinite(cylinder.radius) || !std::isfinite(cylinder.height) ||
+            cylinder.radius <= 0.0f || cylinder.height <= 0.0f || !std::isfinite(length) || length < MIN_LENGTH)
+            return false;
+
+        cylinder.axis /= length;
+        cylinder.radiusSquared = cylinder.radius * cylinder.radius;
+        cylinder.halfHeight = cylinder.height * 0.5f;
+        cylinder._pad0 = 0.0f;
+        cylinder._pad1 = 0.0f;
+        return true;
+    }
+
+    Bounds getBounds(const Sphere& sphere) {
+        Bounds bounds;
+        bounds.expand(sphere.position - glm::vec3(sphere.radius));
+        bounds.expand(sphere.position + glm::vec3(sphere.radius));
+        return bounds;
+    }
+
+    Bounds getBounds(const Quad& quad) {
+        glm::vec3 extent = glm::abs(quad.right) * (quad.width * 0.5f) + glm::abs(quad.up) * (quad.height * 0.5f);
+        Bounds bounds;
+        bounds.expand(quad.position - extent);
+        bounds.expand(quad.position + extent);
+        return bounds;
+    }
+
+    Bounds getBounds(const Box& box) {
+        glm::vec3 extent = glm::abs(box.right) * (box.width * 0.5f) + glm::abs(box.up) * (box.height * 0.5f) +
+            glm::abs(glm::cross(box.right, box.up)) * (box.depth * 0.5f);
+        Bounds bounds;
+        bounds.expand(box.position - extent);
+        bounds.expand(box.position + extent);
+        return bounds;
+    }
+
+    Bounds getBounds(const Disc& disc) {
+        glm::vec3 extent = getDiscExtent(disc.normal, disc.radius);
+        Bounds bounds;
+        bounds.expand(disc.position - extent);
+        bounds.expand(disc.position + extent);
+        return bounds;
+    }
+
+    Bounds getBounds(const Cylinder& cylinder) {
+        // The two end discs bound it
+        glm::vec3 extent = glm::abs(cylinder.axis) * (cylinder.height * 0.5f) + getDiscExtent(cylinder.axis, cylinder.radius);
+        Bounds bounds;
+        bounds.expand(cylinder.position - extent);
+        bounds.expand(cylinder.position + extent);
+        return bounds;
+    }
+
+    Report compile(Scene& scene) {
+        Report report;
+        report.removedSpheres = compileAll(scene.spheres, compileSphere);
+        report.removedPlanes = compileAll(scene.planes, compilePlane);
+        report.removedQuads = compileAll(scene.quads, compileQuad);
+        report.removedBoxes = compileAll(scene.boxes, compileBox);
+        report.removedDiscs = compileAll(scene.discs, compileDisc);
+        report.removedCylinders = compileAll(scene.cylinders, compileCylinder);
+
+        for (const Sphere& sphere : scene.spheres)
+            report.bounds.expand(getBounds(sphere));
+        for (const Quad& quad : scene.quads)
+            report.bounds.expand(getBounds(quad));
+        for (const Box& box : scene.boxes)
+            report.bounds.expand(getBounds(box));
+        for (const Disc& disc : scene.discs)
+            report.bounds.expand(getBounds(disc));
+        for (const Cylinder& cylinder : scene.cylinders)
+            report.bounds.expand(getBounds(cylinder));
+
+        warnRemoved(report.removedSpheres, "sphere(s)", scene);
+        warnRemoved(report.removedPlanes, "plane(s)", scene);
+        warnRemoved(report.removedQuads, "quad(s)", scene);
+        warnRemoved(report.removedBoxes, "box(es)", scene);
+        warnRemoved(report.removedDiscs, "disc(s)", scene);
+        warnRemoved(report.removedCylinders, "cylinder(s)", scene);
+        return report;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <cstring>
+
+#include "scene/scene_diff.hpp"
+
+namespace {
+    // Compiled primitives have zeroed padding, so equal values mean equal bytes
+    template <typename T>
+    SceneChanges::Primitives comparePrimitives(const std::vector<T>& before, const std::vector<T>& after) {
+        SceneChanges::Primitives changes;
+        if (before.size() != after.size()) {
+            changes.resized = true;
+            return changes;
+        }
+
+        for (size_t i = 0; i < after.size(); ++i) {
+            if (std::memcmp(&before[i], &after[i], sizeof(T)) == 0)
+                continue;
+
+            if (!changes.ranges.empty()) {
+                PrimitiveRange& last = changes.ranges.back();
+                if (i - (last.first + last.count) <= SceneDiff::MERGE_GAP) {
+                    last.count = i + 1 - last.first;
+                    continue;
+                }
+            }
+            changes.ranges.push_back({ i, 1 });
+        }
+        return changes;
+    }
+
+    bool sameCamera(const Camera& a, const Camera& b) {
+        return a.position == b.position && a.yaw == b.yaw && a.pitch == b.pitch;
+    }
+
+    bool sameTrack(const CameraTrack& a, const CameraTrack& b) {
+        if (a.interpolation != b.interpolation || a.fps != b.fps || a.duration != b.duration || a.keyframes.size() != b.keyframes.size())
+            return false;
+        for (size_t i = 0; i < a.keyframes.size(); ++i) {
+            const CameraKeyframe& ka = a.keyframes[i];
+            const CameraKeyframe& kb = b.keyframes[i];
+            if (ka.time != kb.time || ka.position != kb.position || ka.yaw != kb.yaw || ka.pitch != kb.pitch)
+                return false;
+        }
+        return true;
+    }
+
+    void describePrimitives(std::string& text, const SceneChanges::Primitives& changes, const char* type, const char* plural) {
+        if (!changes.any())
+            return;
+        if (!text.empty())
+            text += ", ";
+        if (changes.resized)
+            text += std::string("all ") + plural;
+        else
+            text += std::to_string(changes.ranges.size()) + " " + type + (changes.ranges.size() == 1 ? " range" : " ranges");
+    }
+
+    void describeFlag(std::string& text, bool changed, const char* name) {
+        if (!changed)
+            return;
+        if (!text.empty())
+            text += ", ";
+        text += name;
+    }
+}
+
+bool SceneChanges::Primitives::any() const {
+    return resized || !ranges.empty();
+}
+
+bool SceneChanges::isEmpty() const {
+    return !affectsImage() && !samplesPerPixel && !camera && !cameraTrack && !name;
+}
+
+bool SceneChanges::affectsImage() const {
+    return spheres.any() || planes.any() || quads.any() || boxes.any() || discs.any() || cylinders.any() ||
+        tracing || skybox || environment;
+}
+
+namespace SceneDiff {
+    SceneChanges compare(const Scene& before, const Scene& after) {
+        SceneChanges changes;
+        changes.spheres = comparePrimitives(before.spheres, after.spheres);
+        changes.planes = comparePrimitives(before.planes, after.planes);
+        changes.quads = comparePrimitives(before.quads, after.quads);
+        changes.boxes = comparePrimitives(before.boxes, after.boxes);
+        changes.discs = comparePrimitives(before.discs, after.discs);
+        changes.cylinders = comparePrimitives(before.cylinders, after.cylinders);
+
+        changes.tracing = before.gamma != after.gamma || before.maxBounces != after.maxBounces;
+        changes.samplesPerPixel = before.samplesPerPixel != after.samplesPerPixel;
+        changes.skybox = before.skyboxPath != after.skyboxPath;
+        changes.environment = before.skyboxExposureEV != after.skyboxExposureEV ||
+            before.sunPitch != after.sunPitch || before.sunYaw != after.sunYaw || before.sunColour != after.sunColour ||
+            before.sunIntensity != after.sunIntensity || before.sunFocus != after.sunFocus;
+        changes.camera = !sameCamera(before.camera, after.camera);
+        changes.cameraTrack = !sameTrack(before.cameraTrack, after.cameraTrack);
+        changes.name = before.name != after.name;
+        return changes;
+    }
+
+    std::string describe(const SceneChanges& changes) {
+        std::string text;
+        describePrimitives(text, changes.spheres, "sphere", "spheres");
+        describePrimitives(text, changes.planes, "plane", "planes");
+        describePrimitives(text, changes.quads, "quad", "quads");
+        describePrimitives(text, changes.boxes, "box", "boxes");
+        describePrimitives(text, changes.discs, "disc", "discs");
+        describePrimitives(text, changes.cylinders, "cylinder", "cylinders");
+        describeFlag(text, changes.tracing, "tracing");
+        describeFlag(text, changes.samplesPerPixel, "samples per pixel");
+        describeFlag(text, changes.skybox, "skybox");
+        describeFlag(text, changes.environment, "environment");
+        describeFlag(text, changes.camera, "camera");
+        describeFlag(text, changes.cameraTrack, "camera track");
+        describeFlag(text, changes.name, "name");
+        return text.empty() ? "nothing" : text;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <utility>
+
+#include "scene/scene_compiler.hpp"
+#include "scene/scene_index.hpp"
+
+using Intersection::Hit;
+using Intersection::HitType;
+using Intersection::Ray;
+
+namespace {
+    constexpr uint32_t MAX_LEAF_SIZE = 4;
+    constexpr int MAX_DEPTH = 64;  // Traversal stack, a median split over 2^32 primitives is 32 deep
+
+    struct BuildEntry {
+        HitType type;
+        uint32_t index;
+        Bounds bounds;
+        glm::vec3 centre;
+    };
+
+    // Distance to where the ray enters the bounds, if it does before maxDistance
+    bool intersectBounds(const Bounds& bounds, const glm::vec3& origin, const glm::vec3& invDir, float maxDistance, float& distance) {
+        glm::vec3 t0 = (bounds.min - origin) * invDir;
+        glm::vec3 t1 = (bounds.max - origin) * invDir;
+        glm::vec3 tMin = glm::min(t0, t1);
+        glm::vec3 tMax = glm::max(t0, t1);
+        float tEntry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float tExit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+        distance = tEntry;
+        return tEntry <= tExit;
+    }
+
+    void testEntry(const Ray& ray, const Scene& scene, HitType type, uint32_t index, Hit& hit) {
+        float distance = 0.0f;
+        int face = -1;
+        bool found = false;
+        switch (type) {
+        case HitType::Sphere:
+            found = Intersection::intersectSphere(ray, scene.spheres[index], distance);
+            break;
+        case HitType::Quad:
+            found = Intersection::intersectQuad(ray, scene.quads[index], distance);
+            break;
+        case HitType::Box:
+            found = Intersection::intersectBox(ray, scene.boxes[index], distance, face);
+            break;
+        case HitType::Disc:
+            found = Intersection::intersectDisc(ray, scene.discs[index], distance);
+            break;
+        case HitType::Cylinder:
+            found = Intersection::intersectCylinder(ray, scene.cylinders[index], distance);
+            break;
+        default:
+            break;
+        }
+
+        if (found && distance < hit.distance) {
+            hit.type = type;
+            hit.index = static_cast<int>(index);
+            hit.distance = distance;
+            hit.face = face;
+        }
+    }
+}
+
+Bounds SceneIndex::getBounds(const Scene& scene, HitType type, size_t index) {
+    switch (type) {
+    case HitType::Sphere:
+        return SceneCompiler::getBounds(scene.spheres[index]);
+    case HitType::Quad:
+        return SceneCompiler::getBounds(scene.quads[index]);
+    case HitType::Box:
+        return SceneCompiler::getBounds(scene.boxes[index]);
+    case HitType::Disc:
+        return SceneCompiler::getBounds(scene.discs[index]);
+    case HitType::Cylinder:
+        return SceneCompiler::getBounds(scene.cylinders[index]);
+    default:
+        return Bounds();
+    }
+}
+
+void SceneIndex::build(const Scene& scene) {
+    m_nodes.clear();
+    m_parents.clear();
+    m_entries.clear();
+
+    std::vector<BuildEntry> entries;
+    entries.reserve(scene.spheres.size() + scene.quads.size() + scene.boxes.size() + scene.discs.size() + scene.cylinders.size());
+    auto addEntries = [&](HitType type, size_t count) {
+        m_leaves[static_cast<size_t>(type)].assign(count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            Bounds bounds = getBounds(scene, type, i);
+            entries.push_back({ type, static_cast<uint32_t>(i), bounds, bounds.getCentre() });
+        }
+    };
+    addEntries(HitType::Sphere, scene.spheres.size());
+    addEntries(HitType::Quad, scene.quads.size());
+    addEntries(HitType::Box, scene.boxes.size());
+    addEntries(HitType::Disc, scene.discs.size());
+    addEntries(HitType::Cylinder, scene.cylinders.size());
+    if (entries.empty())
+        return;
+
+    m_nodes.reserve(entries.size());
+    m_parents.reserve(entries.size());
+    m_nodes.emplace_back();
+    m_parents.push_back(NO_PARENT);
+
+    // Each range is split at the median of its centres along their longest axis, children are allocated in pairs
+    struct Task {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Task> tasks = { { 0, 0, static_cast<uint32_t>(entries.size()) } };
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+
+        Bounds bounds;
+        Bounds centres;
+        for (uint32_t i = task.begin; i < task.end; ++i) {
+            bounds.expand(entries[i].bounds);
+            centres.expand(entries[i].centre);
+        }
+        m_nodes[task.node].bounds = bounds;
+
+        glm::vec3 extent = centres.getExtent();
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        uint32_t count = task.end - task.begin;
+        if (count <= MAX_LEAF_SIZE || extent[axis] <= 0.0f) {
+            // Identical centres can't be split, they share one leaf
+            m_nodes[task.node].first = task.begin;
+            m_nodes[task.node].count = count;
+            continue;
+        }
+
+        uint32_t middle = task.begin + count / 2;
+        std::nth_element(entries.begin() + task.begin, entries.begin() + middle, entries.begin() + task.end,
+            [axis](const BuildEntry& a, const BuildEntry& b) { return a.centre[axis] < b.centre[axis]; });
+
+        uint32_t left = static_cast<uint32_t>(m_nodes.size());
+        m_nodes[task.node].first = left;
+        m_nodes.resize(m_nodes.size() + 2);
+        m_parents.push_back(task.node);
+        m_parents.push_back(task.node);
+        tasks.push_back({ left, task.begin, middle });
+        tasks.push_back({ left + 1, middle, task.end });
+    }
+
+    m_entries.reserve(entries.size());
+    for (const BuildEntry& entry : entries)
+        m_entries.push_back({ entry.type, entry.index });
+    for (uint32_t node = 0; node < m_nodes.size(); ++node) {
+        for (uint32_t i = 0; i < m_nodes[node].count; ++i) {
+            const Entry& entry = m_entries[m_nodes[node].first + i];
+            m_leaves[static_cast<size_t>(entry.type)][entry.index] = node;
+        }
+    }
+}
+
+void SceneIndex::refit(const Scene& scene, uint32_t leaf) {
+    Bounds bounds;
+    for (uint32_t i = 0; i < m_nodes[leaf].count; ++i) {
+        const Entry& entry = m_entries[m_nodes[leaf].first + i];
+        bounds.expand(getBounds(scene, entry.type, entry.index));
+    }
+    m_nodes[leaf].bounds = bounds;
+
+    // Ancestors take the union of their children, until one comes out unchanged
+    for (uint32_t node = m_parents[leaf]; node != NO_PARENT; node = m_parents[node]) {
+        Bounds fitted = m_nodes[m_nodes[node].first].bounds;
+        fitted.expand(m_nodes[m_nodes[node].first + 1].bounds);
+        if (fitted.min == m_nodes[node].bounds.min && fitted.max == m_nodes[node].bounds.max)
+            break;
+        m_nodes[node].bounds = fitted;
+    }
+}
+
+void SceneIndex::update(const Scene& scene, const SceneChanges& changes) {
+    const std::pair<HitType, const SceneChanges::Primitives*> indexed[] = {
+        { HitType::Sphere, &changes.spheres },
+        { HitType::Quad, &changes.quads },
+        { HitType::Box, &changes.boxes },
+        { HitType::Disc, &changes.discs },
+        { HitType::Cylinder, &changes.cylinders },
+    };
+
+    for (const auto& primitives : indexed) {
+        if (primitives.second->resized) {
+            build(scene);
+            return;
+        }
+    }
+
+    for (const auto& [type, primitives] : indexed) {
+        for (const PrimitiveRange& range : primitives->ranges) {
+            for (size_t i = range.first; i < range.first + range.count; ++i)
+                update(scene, type, i);
+        }
+    }
+}
+
+void SceneIndex::update(const Scene& scene, HitType type, size_t index) {
+    const std::vector<uint32_t>& leaves = m_leaves[static_cast<size_t>(type)];
+    if (index < leaves.size())
+        refit(scene, leaves[index]);
+}
+
+Hit SceneIndex::intersect(const Ray& ray, const Scene& scene) const {
+    Hit hit;
+    for (size_t i = 0; i < scene.planes.size(); ++i) {
+        float distance;
+        if (Intersection::intersectPlane(ray, scene.planes[i], distance) && distance < hit.distance) {
+            hit.type = HitType::Plane;
+            hit.index = static_cast<int>(i);
+            hit.distance = distance;
+        }
+    }
+
+    float distance;
+    glm::vec3 invDir = 1.0f / ray.dir;
+    if (m_nodes.empty() || !intersectBounds(m_nodes[0].bounds, ray.origin, invDir, hit.distance, distance))
+        return hit;
+
+    // Nearer child first, a node is skipped once a hit closer than its bounds is found
+    std::pair<uint32_t, float> stack[MAX_DEPTH];
+    int size = 0;
+    stack[size++] = { 0, distance };
+    while (size > 0) {
+        auto [nodeIndex, entryDistance] = stack[--size];
+        if (entryDistance > hit.distance)
+            continue;
+
+        const Node& node = m_nodes[nodeIndex];
+        if (node.count > 0) {
+            for (uint32_t i = 0; i < node.count; ++i) {
+                const Entry& entry = m_entries[node.first + i];
+                testEntry(ray, scene, entry.type, entry.index, hit);
+            }
+            continue;
+        }
+
+        float leftDistance, rightDistance;
+        bool left = intersectBounds(m_nodes[node.first].bounds, ray.origin, invDir, hit.distance, leftDistance);
+        bool right = intersectBounds(m_nodes[node.first + 1].bounds, ray.origin, invDir, hit.distance, rightDistance);
+        if (left && right) {
+            if (leftDistance <= rightDistance) {
+                stack[size++] = { node.first + 1, rightDistance };
+                stack[size++] = { node.first, leftDistance };
+            }
+            else {
+                stack[size++] = { node.first, leftDistance };
+                stack[size++] = { node.first + 1, rightDistance };
+            }
+        }
+        else if (left) {
+            stack[size++] = { node.first, leftDistance };
+        }
+        else if (right) {
+            stack[size++] = { node.first + 1, rightDistance };
+        }
+    }
+    return hit;
+}
+
+size_t SceneIndex::getNodeCount() const {
+    return m_nodes.size();
+}
+
+size_t SceneIndex::getPrimitiveCount() const {
+    return m_entries.size();
+}
\ No newline at end of file
@@ -1,13 +1,22 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
 
+#include "scene/scene_binary.hpp"
+#include "scene/scene_compiler.hpp"
 #include "scene/scene_loader.hpp"
+#include "utils/job_system.hpp"
 
 #include "json.hpp"
 
 using json = nlohmann::json;
 
 namespace SceneLoader {
+    // Large primitive arrays are parsed on the job system in chunks of this size
+    constexpr size_t PRIMITIVES_PER_JOB = 512;
+    constexpr uint64_t MAX_GENERATED_INSTANCES = 1u << 20;  // Instances the generators of one scene may place in total
+
     glm::vec3 parseVec3(const json& j_vec) {
         return glm::vec3(j_vec[0].get<float>(), j_vec[1].get<float>(), j_vec[2].get<float>());
     }
@@ -27,7 +36,389 @@ namespace SceneLoader {
         return mat;
     }
 
+    Sphere parseSphere(const json& j_sphere) {
+        Sphere s;
+        s.position = parseVec3(j_sphere.at("position"));
+        s.radius = j_sphere.at("radius").get<float>();
+        s.material = parseMaterial(j_sphere.at("material"));
+        return s;
+    }
+
+    Plane parsePlane(const json& j_plane) {
+        Plane p;
+        p.position = parseVec3(j_plane.at("position"));
+        p.normal = parseVec3(j_plane.at("normal"));
+        p.material = parseMaterial(j_plane.at("material"));
+        return p;
+    }
+
+    Quad parseQuad(const json& j_quad) {
+        Quad q;
+        q.position = parseVec3(j_quad.at("position"));
+        q.width = j_quad.at("width");
+        q.normal = parseVec3(j_quad.at("normal"));
+        q.height = j_quad.at("height");
+        q.right = parseVec3(j_quad.at("right"));
+        q.up = parseVec3(j_quad.at("up"));
+        q.material = parseMaterial(j_quad.at("material"));
+        return q;
+    }
+
+    Box parseBox(const json& j_box) {
+        static const char* const FACE_NAMES[BOX_FACE_COUNT] = { "left", "right", "bottom", "top", "back", "front" };
+
+        Box b = {};
+        b.position = parseVec3(j_box.at("position"));
+        glm::vec3 size = parseVec3(j_box.at("size"));
+        b.width = size.x;
+        b.height = size.y;
+        b.depth = size.z;
+        b.right = j_box.contains("right") ? parseVec3(j_box.at("right")) : glm::vec3(1.0f, 0.0f, 0.0f);
+        b.up = j_box.contains("up") ? parseVec3(j_box.at("up")) : glm::vec3(0.0f, 1.0f, 0.0f);
+        b.inward = j_box.value("inward", false) ? 1 : 0;
+
+        // "faces" overrides the material of single faces, e.g. the coloured walls of a room
+        Material material = parseMaterial(j_box.at("material"));
+        for (int face = 0; face < BOX_FACE_COUNT; ++face) {
+            b.materials[face] = material;
+            if (j_box.contains("faces") && j_box.at("faces").contains(FACE_NAMES[face]))
+                b.materials[face] = parseMaterial(j_box.at("faces").at(FACE_NAMES[face]));
+        }
+        return b;
+    }
+
+    Disc parseDisc(const json& j_disc) {
+        Disc d = {};
+        d.position = parseVec3(j_disc.at("position"));
+        d.radius = j_disc.at("radius").get<float>();
+        d.normal = parseVec3(j_disc.at("normal"));
+        d.material = parseMaterial(j_disc.at("material"));
+        return d;
+    }
+
+    Cylinder parseCylinder(const json& j_cylinder) {
+        Cylinder c = {};
+        c.position = parseVec3(j_cylinder.at("position"));
+        c.radius = j_cylinder.at("radius").get<float>();
+        c.axis = j_cylinder.contains("axis") ? parseVec3(j_cylinder.at("axis")) : glm::vec3(0.0f, 1.0f, 0.0f);
+        c.height = j_cylinder.at("height").get<float>();
+        c.material = parseMaterial(j_cylinder.at("material"));
+        return c;
+    }
+
+    // === INSTANCING ===
+
+    struct Prototype {
+        enum Type { SPHERE, PLANE, QUAD, BOX, DISC, CYLINDER } type;
+        Sphere sphere;
+        Plane plane;
+        Quad quad;
+        Box box;
+        Disc disc;
+        Cylinder cylinder;
+    };
+
+    struct Transform {
+        glm::vec3 translation = glm::vec3(0.0f);
+        glm::mat3 rotation = glm::mat3(1.0f);
+        float scale = 1.0f;
+    };
+
+    // Yaw (Y), then pitch (X), then roll (Z), in degrees
+    glm::mat3 eulerRotation(const glm::vec3& degrees) {
+        float cx = cos(glm::radians(degrees.x)), sx = sin(glm::radians(degrees.x));
+        float cy = cos(glm::radians(degrees.y)), sy = sin(glm::radians(degrees.y));
+        float cz = cos(glm::radians(degrees.z)), sz = sin(glm::radians(degrees.z));
+
+        glm::mat3 rx(glm::vec3(1, 0, 0), glm::vec3(0, cx, sx), glm::vec3(0, -sx, cx));
+        glm::mat3 ry(glm::vec3(cy, 0, -sy), glm::vec3(0, 1, 0), glm::vec3(sy, 0, cy));
+        glm::mat3 rz(glm::vec3(cz, sz, 0), glm::vec3(-sz, cz, 0), glm::vec3(0, 0, 1));
+        return ry * rx * rz;
+    }
+
+    Transform parseTransform(const json& j_instance) {
+        Transform t;
+        if (j_instance.contains("position"))
+            t.translation = parseVec3(j_instance.at("position"));
+        if (j_instance.contains("rotation"))
+            t.rotation = eulerRotation(parseVec3(j_instance.at("rotation")));
+        t.scale = j_instance.value("scale", 1.0f);
+        return t;
+    }
+
+    bool parsePrototypes(const json& j_prototypes, std::map<std::string, Prototype>& prototypes) {
+        for (const auto& [name, j_proto] : j_prototypes.items()) {
+            // Prototypes are defined around the origin unless given a position
+            json j_shape = j_proto;
+            if (!j_shape.contains("position"))
+                j_shape["position"] = { 0.0f, 0.0f, 0.0f };
+
+            Prototype proto;
+            std::string type = j_shape.value("type", "sphere");
+            if (type == "sphere") {
+                proto.type = Prototype::SPHERE;
+                proto.sphere = parseSphere(j_shape);
+            }
+            else if (type == "plane") {
+                proto.type = Prototype::PLANE;
+                proto.plane = parsePlane(j_shape);
+            }
+            else if (type == "quad") {
+                proto.type = Prototype::QUAD;
+                proto.quad = parseQuad(j_shape);
+            }
+            else if (type == "box") {
+                proto.type = Prototype::BOX;
+                proto.box = parseBox(j_shape);
+            }
+            else if (type == "disc") {
+                proto.type = Prototype::DISC;
+                proto.disc = parseDisc(j_shape);
+            }
+            else if (type == "cylinder") {
+                proto.type = Prototype::CYLINDER;
+                proto.cylinder = parseCylinder(j_shape);
+            }
+            else {
+                std::cerr << "Error: Unknown prototype type '" << type << "' for prototype '" << name << "'" << std::endl;
+                return false;
+            }
+            prototypes[name] = proto;
+        }
+        return true;
+    }
+
+    void placeInstance(const Prototype& proto, const Transform& t, Scene& scene) {
+        switch (proto.type) {
+        case Prototype::SPHERE: {
+            Sphere s = proto.sphere;
+            s.position = t.translation + t.rotation * (s.position * t.scale);
+            s.radius *= t.scale;
+            scene.spheres.push_back(s);
+            break;
+        }
+        case Prototype::PLANE: {
+            Plane p = proto.plane;
+            p.position = t.translation + t.rotation * (p.position * t.scale);
+            p.normal = glm::normalize(t.rotation * p.normal);
+            scene.planes.push_back(p);
+            break;
+        }
+        case Prototype::QUAD: {
+            Quad q = proto.quad;
+            q.position = t.translation + t.rotation * (q.position * t.scale);
+            q.normal = glm::normalize(t.rotation * q.normal);
+            q.right = glm::normalize(t.rotation * q.right);
+            q.up = glm::normalize(t.rotation * q.up);
+            q.width *= t.scale;
+            q.height *= t.scale;
+            scene.quads.push_back(q);
+            break;
+        }
+        case Prototype::BOX: {
+            Box b = proto.box;
+            b.position = t.translation + t.rotation * (b.position * t.scale);
+            b.right = glm::normalize(t.rotation * b.right);
+            b.up = glm::normalize(t.rotation * b.up);
+            b.width *= t.scale;
+            b.height *= t.scale;
+            b.depth *= t.scale;
+            scene.boxes.push_back(b);
+            break;
+        }
+        case Prototype::DISC: {
+            Disc d = proto.disc;
+            d.position = t.translation + t.rotation * (d.position * t.scale);
+            d.normal = glm::normalize(t.rotation * d.normal);
+            d.radius *= t.scale;
+            scene.discs.push_back(d);
+            break;
+        }
+        case Prototype::CYLINDER: {
+            Cylinder c = proto.cylinder;
+            c.position = t.translation + t.rotation * (c.position * t.scale);
+            c.axis = glm::normalize(t.rotation * c.axis);
+            c.radius *= t.scale;
+            c.height *= t.scale;
+            scene.cylinders.push_back(c);
+            break;
+        }
+        }
+    }
+
+    // Small deterministic generator, so scattered scenes are identical on every platform/compiler
+    struct SeededRandom {
+        uint32_t state;
+
+        explicit SeededRandom(uint32_t seed) : state(seed * 747796405u + 2891336453u) {}
+
+        float next() {
+            state = state * 747796405u + 2891336453u;
+            uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+            word = (word >> 22u) ^ word;
+            return (word >> 8) * (1.0f / 16777216.0f);  // [0, 1)
+        }
+
+        float range(float min, float max) {
+            return min + (max - min) * next();
+        }
+    };
+
+    bool runGenerator(const json& j_gen, const std::map<std::string, Prototype>& prototypes, Scene& scene) {
+        std::string protoName = j_gen.at("prototype").get<std::string>();
+        auto proto = prototypes.find(protoName);
+        if (proto == prototypes.end()) {
+            std::cerr << "Error: Generator references unknown prototype '" << protoName << "'" << std::endl;
+            return false;
+        }
+
+        std::string type = j_gen.at("type").get<std::string>();
+        Transform base = parseTransform(j_gen);
+
+        if (type == "grid") {
+            // count [x, y, z] copies spaced by spacing [x, y, z], starting at position
+            glm::vec3 count = parseVec3(j_gen.at("count"));
+            glm::vec3 spacing = j_gen.contains("spacing") ? parseVec3(j_gen.at("spacing")) : glm::vec3(1.0f);
+            auto inRange = [](float n) { return n >= 0.0f && n <= (float)MAX_GENERATED_INSTANCES; };
+            if (!inRange(count.x) || !inRange(count.y) || !inRange(count.z)) {
+                std::cerr << "Error: Grid generator count must be between 0 and " << MAX_GENERATED_INSTANCES << " per axis" << std::endl;
+                return false;
+            }
+            int nx = std::max(1, (int)count.x), ny = std::max(1, (int)count.y), nz = std::max(1, (int)count.z);
+            // Each axis is capped above, so the product fits in 64 bits
+            if ((uint64_t)nx * ny * nz > MAX_GENERATED_INSTANCES) {
+                std::cerr << "Error: Grid generator would place " << (uint64_t)nx * ny * nz << " instances, the limit is " << MAX_GENERATED_INSTANCES << std::endl;
+                return false;
+            }
+
+            for (int z = 0; z < nz; ++z)
+                for (int y = 0; y < ny; ++y)
+                    for (int x = 0; x < nx; ++x) {
+                        Transform t = base;
+                        t.translation += glm::vec3(x * spacing.x, y * spacing.y, z * spacing.z);
+                        placeInstance(proto->second, t, scene);
+                    }
+        }
+        else if (type == "scatter") {
+            // count copies uniformly placed in the [min, max] box, with optional scale range and random yaw
+            int64_t count = j_gen.at("count").get<int64_t>();
+            if (count < 0 || (uint64_t)count > MAX_GENERATED_INSTANCES) {
+                std::cerr << "Error: Scatter generator count must be between 0 and " << MAX_GENERATED_INSTANCES << ", got " << count << std::endl;
+                return false;
+            }
+            SeededRandom rng(j_gen.value("seed", 0u));
+            glm::vec3 min = parseVec3(j_gen.at("min"));
+            glm::vec3 max = parseVec3(j_gen.at("max"));
+            glm::vec3 scaleRange = glm::vec3(base.scale, base.scale, 0.0f);
+            if (j_gen.contains("scaleRange")) {
+                const json& j_range = j_gen.at("scaleRange");
+                if (!j_range.is_array() || j_range.size() != 2) {
+                    std::cerr << "Error: Scatter generator scaleRange must be [min, max]" << std::endl;
+                    return false;
+                }
+                scaleRange = glm::vec3(j_range[0].get<float>(), j_range[1].get<float>(), 0.0f);
+            }
+            bool randomYaw = j_gen.value("randomYaw", false);
+
+            for (int64_t i = 0; i < count; ++i) {
+                Transform t = base;
+                t.translation = glm::vec3(rng.range(min.x, max.x), rng.range(min.y, max.y), rng.range(min.z, max.z));
+                t.scale = rng.range(scaleRange.x, scaleRange.y);
+                if (randomYaw)
+                    t.rotation = eulerRotation(glm::vec3(0.0f, rng.range(0.0f, 360.0f), 0.0f)) * base.rotation;
+                placeInstance(proto->second, t, scene);
+            }
+        }
+        else {
+            std::cerr << "Error: Unknown generator type '" << type << "'" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void appendScene(Scene& scene, const Scene& fragment) {
+        scene.spheres.insert(scene.spheres.end(), fragment.spheres.begin(), fragment.spheres.end());
+        scene.planes.insert(scene.planes.end(), fragment.planes.begin(), fragment.planes.end());
+        scene.quads.insert(scene.quads.end(), fragment.quads.begin(), fragment.quads.end());
+        scene.boxes.insert(scene.boxes.end(), fragment.boxes.begin(), fragment.boxes.end());
+        scene.discs.insert(scene.discs.end(), fragment.discs.begin(), fragment.discs.end());
+        scene.cylinders.insert(scene.cylinders.end(), fragment.cylinders.begin(), fragment.cylinders.end());
+    }
+
+    bool expandInstances(const json& j, Scene& scene) {
+        std::map<std::string, Prototype> prototypes;
+        if (j.contains("prototypes") && !parsePrototypes(j.at("prototypes"), prototypes))
+            return false;
+
+        // The instance list and every generator expand into their own fragment on the job system,
+        // then the fragments are appended in file order so the result matches a serial load
+        std::vector<Task<bool>> tasks;
+        std::vector<Scene> fragments;
+        size_t generatorCount = j.contains("generators") ? j.at("generators").size() : 0;
+        fragments.resize(1 + generatorCount);
+
+        if (j.contains("instances"))
+            tasks.push_back(JobSystem::get().run([&j, &prototypes, &fragment = fragments[0]]() {
+                for (const auto& j_instance : j.at("instances")) {
+                    std::string protoName = j_instance.at("prototype").get<std::string>();
+                    auto proto = prototypes.find(protoName);
+                    if (proto == prototypes.end()) {
+                        std::cerr << "Error: Instance references unknown prototype '" << protoName << "'" << std::endl;
+                        return false;
+                    }
+                    placeInstance(proto->second, parseTransform(j_instance), fragment);
+                }
+                return true;
+            }));
+
+        for (size_t i = 0; i < generatorCount; ++i)
+            tasks.push_back(JobSystem::get().run([&j_gen = j.at("generators")[i], &prototypes, &fragment = fragments[1 + i]]() {
+                return runGenerator(j_gen, prototypes, fragment);
+            }));
+
+        // Every job references the locals above, so all must finish before an error returns
+        for (const Task<bool>& task : tasks)
+            task.wait();
+
+        bool success = true;
+        for (const Task<bool>& task : tasks)
+            success = task.get() && success;
+        if (!success)
+            return false;
+
+        // Each generator is capped on its own, this bounds the whole file
+        uint64_t generated = 0;
+        for (size_t i = 1; i < fragments.size(); ++i) {
+            const Scene& f = fragments[i];
+            generated += f.spheres.size() + f.planes.size() + f.quads.size() + f.boxes.size() + f.discs.size() + f.cylinders.size();
+        }
+        if (generated > MAX_GENERATED_INSTANCES) {
+            std::cerr << "Error: Generators would place " << generated << " instances, the limit is " << MAX_GENERATED_INSTANCES << std::endl;
+            return false;
+        }
+
+        for (const Scene& fragment : fragments)
+            appendScene(scene, fragment);
+        return true;
+    }
+
+    // Parses a primitive array in parallel chunks, each element lands at its file position
+    template <typename T, typename Parse>
+    void parseArray(const json& j_array, std::vector<T>& out, Parse parse) {
+        size_t offset = out.size();
+        out.resize(offset + j_array.size());
+        JobSystem::get().parallelFor(0, j_array.size(), PRIMITIVES_PER_JOB, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                out[offset + i] = parse(j_array[i]);
+        });
+    }
+
     bool loadScene(const std::string& filename, Scene& scene) {
+        // Binary scenes are stored compiled
+        if (SceneBinary::isBinaryScene(filename))
+            return SceneBinary::loadScene(filename, scene);
+
         std::ifstream file(filename);
         if (!file.is_open()) {
             std::cerr << "Error: Could not open scene file: " << filename << std::endl;
@@ -48,6 +439,9 @@ namespace SceneLoader {
         scene.spheres.clear();
         scene.planes.clear();
         scene.quads.clear();
+        scene.boxes.clear();
+        scene.discs.clear();
+        scene.cylinders.clear();
 
         // Parse Tracing
         if (j.contains("tracing")) {
@@ -66,6 +460,29 @@ namespace SceneLoader {
             scene.camera.updateOrientation();
         }
 
+        // Parse Animation
+        scene.cameraTrack = CameraTrack();
+        if (j.contains("animation")) {
+            const auto& j_anim = j.at("animation");
+            scene.cameraTrack.fps = j_anim.value("fps", 30.0f);
+            scene.cameraTrack.duration = j_anim.value("duration", 0.0f);
+            scene.cameraTrack.interpolation = j_anim.value("interpolation", "smooth") == "linear"
+                ? CameraInterpolation::Linear : CameraInterpolation::Smooth;
+
+            if (j_anim.contains("keyframes") && j_anim.at("keyframes").is_array())
+                for (const auto& j_key : j_anim.at("keyframes")) {
+                    CameraKeyframe key;
+                    key.time = j_key.at("time").get<float>();
+                    key.position = parseVec3(j_key.at("position"));
+                    key.yaw = j_key.at("yaw").get<float>();
+                    key.pitch = j_key.at("pitch").get<float>();
+                    scene.cameraTrack.keyframes.push_back(key);
+                }
+
+            std::stable_sort(scene.cameraTrack.keyframes.begin(), scene.cameraTrack.keyframes.end(),
+                [](const CameraKeyframe& a, const CameraKeyframe& b) { return a.time < b.time; });
+        }
+
         // Parse Environment
         if (j.contains("environment")) {
             const auto& j_env = j.at("environment");
@@ -80,39 +497,54 @@ namespace SceneLoader {
 
         // Parse Spheres
         if (j.contains("spheres") && j.at("spheres").is_array())
-            for (const auto& j_sphere : j.at("spheres")) {
-                Sphere s;
-                s.position = parseVec3(j_sphere.at("position"));
-                s.radius = j_sphere.at("radius").get<float>();
-                s.material = parseMaterial(j_sphere.at("material"));
-                scene.spheres.push_back(s);
-            }
+            parseArray(j.at("spheres"), scene.spheres, parseSphere);
 
         // Parse Planes
         if (j.contains("planes") && j.at("planes").is_array())
-            for (const auto& j_plane : j.at("planes")) {
-                Plane p;
-                p.position = parseVec3(j_plane.at("position"));
-                p.normal = parseVec3(j_plane.at("normal"));
-                p.material = parseMaterial(j_plane.at("material"));
-                scene.planes.push_back(p);
-            }
+            parseArray(j.at("planes"), scene.planes, parsePlane);
 
         // Parse Quads
         if (j.contains("quads") && j.at("quads").is_array())
-            for (const auto& j_quad : j.at("quads")) {
-                Quad q;
-                q.position = parseVec3(j_quad.at("position"));
-                q.width = j_quad.at("width");
-                q.normal = parseVec3(j_quad.at("normal"));
-                q.height = j_quad.at("height");
-                q.right = parseVec3(j_quad.at("right"));
-                q.up = parseVec3(j_quad.at("up"));
-                q.material = parseMaterial(j_quad.at("material"));
-                scene.quads.push_back(q);
+            parseArray(j.at("quads"), scene.quads, parseQuad);
+
+        // Parse Boxes, Discs and Cylinders
+        if (j.contains("boxes") && j.at("boxes").is_array())
+            parseArray(j.at("boxes"), scene.boxes, parseBox);
+        if (j.contains("discs") && j.at("discs").is_array())
+            parseArray(j.at("discs"), scene.discs, parseDisc);
+        if (j.contains("cylinders") && j.at("cylinders").is_array())
+            parseArray(j.at("cylinders"), scene.cylinders, parseCylinder);
+
+        // Parse Prototypes, Instances and Generators
+        if (j.contains("prototypes") || j.contains("instances") || j.contains("generators")) {
+            try {
+                if (!expandInstances(j, scene)) {
+                    std::cerr << "Error expanding instances in " << filename << std::endl;
+                    return false;
+                }
+            } catch (const json::exception& e) {
+                std::cerr << "Error expanding instances in " << filename << ": " << e.what() << std::endl;
+                return false;
             }
+        }
+
+        SceneCompiler::compile(scene);
 
         std::cout << "Scene '" << j.value("name", "Unknown Scene") << "' loaded successfully." << std::endl;
         return true;
     }
+
+    Task<std::shared_ptr<Scene>> loadSceneAsync(const std::string& filename) {
+        return JobSystem::get().run([filename]() {
+            auto scene = std::make_shared<Scene>();
+            try {
+                if (!loadScene(filename, *scene))
+                    scene.reset();
+            } catch (const json::exception& e) {
+                std::cerr << "Error loading scene " << filename << ": " << e.what() << std::endl;
+                scene.reset();
+            }
+            return scene;
+        });
+    }
 }
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "stb_image_write.h"
+
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "sequence/sequence_renderer.hpp"
+#include "utils/async_readback.hpp"
+#include "utils/gl_context.hpp"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <csignal>
+#endif
+
+namespace Sequence {
+    // The output pattern split around its frame number token
+    struct FramePattern {
+        std::string prefix;
+        std::string suffix;
+        size_t width = 0;  // Zero padded to this many digits
+    };
+
+    // Accepts exactly one %d or %0Nd token. Other percent signs must be written as %%
+    static bool parseFramePattern(const std::string& pattern, FramePattern& result) {
+        result = FramePattern();
+        bool found = false;
+        std::string* part = &result.prefix;
+
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            if (pattern[i] != '%') {
+                *part += pattern[i];
+                continue;
+            }
+            if (i + 1 < pattern.size() && pattern[i + 1] == '%') {
+                *part += '%';
+                ++i;
+                continue;
+            }
+
+            size_t end = i + 1;
+            size_t width = 0;
+            if (end < pattern.size() && pattern[end] == '0') {
+                ++end;
+                size_t digits = end;
+                while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9' && end - digits < 2)
+                    width = width * 10 + (pattern[end++] - '0');
+                if (end == digits)
+                    return false;
+            }
+            if (found || end >= pattern.size() || pattern[end] != 'd')
+                return false;
+
+            found = true;
+            result.width = width;
+            part = &result.suffix;
+            i = end;
+        }
+        return found;
+    }
+
+    static std::string formatFramePath(const FramePattern& pattern, uint32_t frame) {
+        std::string number = std::to_string(frame);
+        if (number.size() < pattern.width)
+            number.insert(0, pattern.width - number.size(), '0');
+        return pattern.prefix + number + pattern.suffix;
+    }
+
+    // Quotes one argument for the shell popen runs, so paths are never parsed as shell syntax
+    static bool quoteArgument(const std::string& argument, std::string& quoted) {
+#ifdef _WIN32
+        // cmd.exe has no escape for a quote inside quotes and expands %VAR% even there
+        if (argument.find_first_of("\"%") != std::string::npos)
+            return false;
+        quoted = "\"" + argument + "\"";
+#else
+        quoted = "'";
+        for (char c : argument) {
+            if (c == '\'')
+                quoted += "'\\''";
+            else
+                quoted += c;
+        }
+        quoted += "'";
+#endif
+        return true;
+    }
+
+    // Encodes frames on background threads. PNG frames are independent and use several threads,
+    // the ffmpeg pipe needs frames in order and uses one.
+    class FrameWriter {
+    public:
+        FrameWriter(const SequenceSettings& settings, uint32_t width, uint32_t height, float fps)
+            : m_settings(settings), m_width(width), m_height(height) {
+            size_t threadCount = settings.writerThreads > 0 ? settings.writerThreads : 1;
+
+            if (!settings.videoPath.empty()) {
+                threadCount = 1;
+
+                std::string ffmpeg, output;
+                if (!quoteArgument(settings.ffmpegPath, ffmpeg) || !quoteArgument(settings.videoPath, output)) {
+                    std::cerr << "Error (Sequence): ffmpeg and video paths cannot contain quotes or percent signs" << std::endl;
+                    m_failed = true;
+                }
+                else {
+                    // "file:" keeps an output path that starts with a dash from being read as an option
+                    quoteArgument("file:" + settings.videoPath, output);
+                    std::string command = ffmpeg + " -loglevel error -y -f rawvideo -pix_fmt rgba -s "
+                        + std::to_string(width) + "x" + std::to_string(height) + " -r " + std::to_string(fps)
+                        + " -i - -vf vflip -c:v libx264 -pix_fmt yuv420p " + output;
+#ifdef _WIN32
+                    // cmd.exe strips the outermost pair of quotes from the line
+                    command = "\"" + command + "\"";
+                    m_pipe = popen(command.c_str(), "wb");
+#else
+                    m_pipe = popen(command.c_str(), "w");
+#endif
+                    if (!m_pipe) {
+                        std::cerr << "Error (Sequence): Failed to start ffmpeg: " << command << std::endl;
+                        m_failed = true;
+                    }
+#ifndef _WIN32
+                    // If ffmpeg exits early, fwrite fails with EPIPE instead of the signal killing us
+                    std::signal(SIGPIPE, SIG_IGN);
+#endif
+                }
+            }
+            else if (!parseFramePattern(settings.outputPattern, m_pattern)) {
+                std::cerr << "Error (Sequence): Output pattern needs exactly one %d or %0Nd frame number, "
+                    "other percent signs written as %%: " << settings.outputPattern << std::endl;
+                m_failed = true;
+            }
+
+            m_maxQueued = threadCount * 2;
+            for (size_t i = 0; i < threadCount; ++i)
+                m_threads.emplace_back(&FrameWriter::writerLoop, this);
+        }
+
+        ~FrameWriter() {
+            finish();
+        }
+
+        bool isValid() const {
+            return !m_failed;
+        }
+
+        // Blocks while the queue is full, returns the time spent waiting
+        double push(uint32_t frameIndex, std::vector<unsigned char>&& pixels) {
+            auto start = std::chrono::steady_clock::now();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_spaceAvailable.wait(lock, [&] { return m_queue.size() < m_maxQueued; });
+            m_queue.push_back({ frameIndex, std::move(pixels) });
+            m_frameAvailable.notify_one();
+
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // Returns false if any frame failed to write or ffmpeg did not exit cleanly
+        bool finish() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_finished = true;
+            }
+            m_frameAvailable.notify_all();
+
+            for (auto& thread : m_threads)
+                thread.join();
+            m_threads.clear();
+
+            if (m_pipe) {
+                int status = pclose(m_pipe);
+                m_pipe = nullptr;
+                if (status != 0) {
+                    std::cerr << "Error (Sequence): ffmpeg exited with status " << status << std::endl;
+                    m_failed = true;
+                }
+            }
+            return !m_failed;
+        }
+
+    private:
+        struct Frame {
+            uint32_t index;
+            std::vector<unsigned char> pixels;
+        };
+
+        const SequenceSettings& m_settings;
+        uint32_t m_width;
+        uint32_t m_height;
+        FILE* m_pipe = nullptr;
+        FramePattern m_pattern;
+        std::atomic<bool> m_failed{ false };
+
+        std::mutex m_mutex;
+        std::condition_variable m_frameAvailable;
+        std::condition_variable m_spaceAvailable;
+        std::deque<Frame> m_queue;
+        size_t m_maxQueued = 2;
+        bool m_finished = false;
+        std::vector<std::thread> m_threads;
+
+        void writerLoop() {
+            std::vector<unsigned char> flipped;
+
+            while (true) {
+                Frame frame;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_frameAvailable.wait(lock, [&] { return m_finished || !m_queue.empty(); });
+                    if (m_queue.empty())
+                        return;
+                    frame = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                m_spaceAvailable.notify_one();
+
+                if (m_failed)
+                    continue;  // Keep draining so push never blocks
+
+                if (m_pipe) {
+                    if (fwrite(frame.pixels.data(), 1, frame.pixels.size(), m_pipe) != frame.pixels.size()) {
+                        std::cerr << "Error (Sequence): Failed to write frame " << frame.index << " to ffmpeg" << std::endl;
+                        m_failed = true;
+                    }
+                    continue;
+                }
+
+                size_t rowSize = static_cast<size_t>(m_width) * 4;
+                flipped.resize(frame.pixels.size());
+                for (uint32_t y = 0; y < m_height; ++y)
+                    std::memcpy(&flipped[y * rowSize], &frame.pixels[(m_height - 1 - y) * rowSize], rowSize);
+
+                std::string path = formatFramePath(m_pattern, frame.index);
+                if (!stbi_write_png(path.c_str(), (int)m_width, (int)m_height, 4, flipped.data(), (int)rowSize)) {
+                    std::cerr << "Error (Sequence): Failed to write frame " << path << std::endl;
+                    m_failed = true;
+                }
+            }
+        }
+    };
+
+    static bool renderFrames(const SequenceSettings& settings, Scene& scene) {
+        const CameraTrack& track = scene.cameraTrack;
+        if (track.isEmpty()) {
+            std::cerr << "Error (Sequence): Scene has no camera animation keyframes" << std::endl;
+            return false;
+        }
+
+        Renderer renderer(settings.width, settings.height);
+        renderer.loadScene(scene);
+        if (settings.samplesPerPixel > 0)
+            renderer.setSamplesPerPixel(settings.samplesPerPixel);
+
+        uint32_t samplesPerDispatch = settings.samplesPerPixel > 0 ? settings.samplesPerPixel : static_cast<uint32_t>(scene.samplesPerPixel);
+        uint32_t dispatchesPerFrame = (std::max(settings.samplesPerFrame, 1u) + samplesPerDispatch - 1) / samplesPerDispatch;
+
+        int frameCount = static_cast<int>(track.getFrameCount());
+        int firstFrame = std::max(settings.firstFrame, 0);
+        int lastFrame = settings.lastFrame < 0 ? frameCount - 1 : std::min(settings.lastFrame, frameCount - 1);
+
+        FrameWriter writer(settings, settings.width, settings.height, track.fps);
+        if (!writer.isValid())
+            return false;
+
+        AsyncReadback readback(3);
+        std::vector<unsigned char> pixels;
+        uint64_t tag = 0;
+        double exportStallMs = 0.0;
+
+        std::cout << "Rendering frames " << firstFrame << "-" << lastFrame << " at " << settings.width << "x" << settings.height
+            << ", " << dispatchesPerFrame * samplesPerDispatch << " spp per frame" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int frame = firstFrame; frame <= lastFrame; ++frame) {
+            Camera camera = track.evaluate(frame / track.fps);
+            for (uint32_t i = 0; i < dispatchesPerFrame; ++i)
+                renderer.render(camera);
+
+            // Queue the readback behind this frame's draws, then hand over any finished earlier frames
+            while (!readback.hasFailed() && !readback.begin(renderer.getDisplayTexture(), settings.width, settings.height, static_cast<uint64_t>(frame))) {
+                if (readback.fetch(pixels, tag, true))
+                    exportStallMs += writer.push(static_cast<uint32_t>(tag), std::move(pixels));
+            }
+            while (readback.fetch(pixels, tag, false))
+                exportStallMs += writer.push(static_cast<uint32_t>(tag), std::move(pixels));
+
+            if (readback.hasFailed() || !writer.isValid())
+                break;
+
+            std::cout << "\rFrame " << frame << "/" << lastFrame << std::flush;
+        }
+
+        while (readback.getPendingCount() > 0 && !readback.hasFailed())
+            if (readback.fetch(pixels, tag, true))
+                exportStallMs += writer.push(static_cast<uint32_t>(tag), std::move(pixels));
+
+        double renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bool written = writer.finish();
+        if (readback.hasFailed() || !written) {
+            std::cout << std::endl;
+            std::cerr << "Error (Sequence): Export failed" << std::endl;
+            return false;
+        }
+        double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int framesRendered = std::max(lastFrame - firstFrame + 1, 0);
+        std::cout << std::endl << framesRendered << " frames in " << totalSeconds << "s ("
+            << framesRendered / std::max(renderSeconds, 1e-6) << " fps while rendering), export stalls "
+            << exportStallMs << "ms" << std::endl;
+        return true;
+    }
+
+    int runSequence(const SequenceSettings& settings) {
+        GLFWwindow* context = createHeadlessContext(settings.width, settings.height);
+        if (!context)
+            return EXIT_FAILURE;
+
+        bool success = false;
+        Scene scene;
+        if (SceneLoader::loadScene(settings.scenePath, scene))
+            success = renderFrames(settings, scene);
+
+        destroyHeadlessContext(context);
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "json.hpp"
+
+#include "renderer/convergence.hpp"
+#include "renderer/renderer.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "server/render_server.hpp"
+#include "utils/gl_context.hpp"
+#include "utils/image.hpp"
+
+using json = nlohmann::json;
+
+namespace Server {
+    static double now() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Reads one '\n' terminated line, buffering any bytes past it for the next call. Fails on overlong lines
+    static bool readLine(Socket& socket, std::string& buffer, std::string& line) {
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+
+            if (buffer.size() > MAX_LINE_LENGTH)
+                return false;
+
+            char chunk[4096];
+            int received = socket.recvSome(chunk, sizeof(chunk));
+            if (received <= 0)
+                return false;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+    }
+
+    bool Connection::sendLine(const std::string& line) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        std::string data = line + "\n";
+        return socket.sendAll(data.data(), data.size());
+    }
+
+    bool RenderServer::JobOrder::operator()(const Job& a, const Job& b) const {
+        if (a.priority != b.priority)
+            return a.priority < b.priority;
+        return a.id > b.id;
+    }
+
+    RenderServer::RenderServer(const ServerSettings& settings)
+        : m_settings(settings) {}
+
+    RenderServer::~RenderServer() {
+        stop();
+    }
+
+    int RenderServer::run() {
+        m_listener = Socket::listen(m_settings.port, m_settings.bindAddress);
+        if (!m_listener.isValid())
+            return EXIT_FAILURE;
+
+        GLFWwindow* context = createHeadlessContext(640, 480);
+        if (!context)
+            return EXIT_FAILURE;
+
+        {
+            // Created once, everything it compiles and uploads is reused between jobs
+            Renderer renderer(640, 480);
+            renderer.getResources().setSkyboxCacheCapacity(m_settings.skyboxCacheCapacity);
+            renderer.getResources().setSkyboxFormat(m_settings.skyboxFormat);
+
+            m_acceptThread = std::thread(&RenderServer::acceptLoop, this);
+            std::cout << "Render server listening on " << m_settings.bindAddress << ":" << m_settings.port << std::endl;
+
+            Job job;
+            while (popJob(job))
+                renderJob(renderer, job);
+
+            stop();
+        }
+
+        destroyHeadlessContext(context);
+        return EXIT_SUCCESS;
+    }
+
+    void RenderServer::acceptLoop() {
+        while (m_running) {
+            reapReaders();
+            if (!m_listener.waitReadable(100))
+                continue;
+
+            Socket socket = m_listener.accept();
+            if (!socket.isValid())
+                continue;
+
+            auto connection = std::make_shared<Connection>();
+            connection->socket = std::move(socket);
+
+            std::lock_guard<std::mutex> lock(m_readersMutex);
+            m_readers.push_back({ connection, std::thread(&RenderServer::readConnection, this, connection) });
+        }
+    }
+
+    void RenderServer::reapReaders() {
+        std::vector<Reader> closed;
+        {
+            std::lock_guard<std::mutex> lock(m_readersMutex);
+            auto open = std::partition(m_readers.begin(), m_readers.end(), [](const Reader& reader) { return !reader.connection->closed; });
+            std::move(open, m_readers.end(), std::back_inserter(closed));
+            m_readers.erase(open, m_readers.end());
+        }
+
+        // Queued jobs keep their connection, only the thread goes
+        for (Reader& reader : closed)
+            reader.thread.join();
+    }
+
+    void RenderServer::readConnection(std::shared_ptr<Connection> connection) {
+        std::string buffer;
+        std::string line;
+        while (m_running && readLine(connection->socket, buffer, line)) {
+            if (!line.empty())
+                handleRequest(line, connection);
+        }
+        connection->closed = true;
+    }
+
+    // Type and range checked request fields. A missing field keeps the fallback
+    static bool readUnsigned(const json& request, const char* key, uint64_t max, uint64_t& value, std::string& error) {
+        if (!request.contains(key))
+            return true;
+        const json& field = request.at(key);
+        if (!field.is_number_unsigned() || field.get<uint64_t>() > max) {  // Negative integers parse as signed
+            error = std::string("'") + key + "' must be an integer from 0 to " + std::to_string(max);
+            return false;
+        }
+        value = field.get<uint64_t>();
+        return true;
+    }
+
+    static bool readFloat(const json& request, const char* key, float max, float& value, std::string& error) {
+        if (!request.contains(key))
+            return true;
+        const json& field = request.at(key);
+        if (!field.is_number() || !std::isfinite(field.get<double>()) || field.get<double>() < 0.0 || field.get<double>() > max) {
+            error = std::string("'") + key + "' must be a number from 0 to " + std::to_string(max);
+            return false;
+        }
+        value = field.get<float>();
+        return true;
+    }
+
+    static bool readString(const json& request, const char* key, std::string& value, std::string& error) {
+        if (!request.contains(key))
+            return true;
+        const json& field = request.at(key);
+        if (!field.is_string() || field.get_ref<const std::string&>().empty()) {
+            error = std::string("'") + key + "' must be a non-empty string";
+            return false;
+        }
+        value = field.get<std::string>();
+        return true;
+    }
+
+    // Fills a job from a render request, false with a message if a field is invalid
+    static bool parseJob(const json& request, Job& job, std::string& error) {
+        if (!request.contains("scene")) {
+            error = "Job is missing 'scene'";
+            return false;
+        }
+
+        uint64_t width = 0, height = 0, samplesPerPixel = 0, targetSamples = 0;
+        job.outputPath = "exports/server_render.png";
+        if (!readString(request, "scene", job.scenePath, error) || !readString(request, "output", job.outputPath, error)
+            || !readUnsigned(request, "width", MAX_JOB_SIZE, width, error) || !readUnsigned(request, "height", MAX_JOB_SIZE, height, error)
+            || !readUnsigned(request, "spp", 1024, samplesPerPixel, error) || !readUnsigned(request, "samples", UINT32_MAX, targetSamples, error)
+            || !readFloat(request, "noise", 1.0f, job.targetNoise, error) || !readFloat(request, "timeLimit", 1.0e6f, job.timeLimit, error))
+            return false;
+
+        if (request.contains("priority")) {
+            const json& priority = request.at("priority");
+            if (!priority.is_number_integer() || priority.get<int64_t>() < INT32_MIN || priority.get<int64_t>() > INT32_MAX) {
+                error = "'priority' must be an integer";
+                return false;
+            }
+            job.priority = priority.get<int>();
+        }
+
+        job.width = static_cast<uint32_t>(width);
+        job.height = static_cast<uint32_t>(height);
+        job.samplesPerPixel = static_cast<uint32_t>(samplesPerPixel);
+        job.targetSamples = targetSamples;
+        return true;
+    }
+
+    // Reads a request line into its command and, for "render", its job. Anything the types or ranges don't allow,
+    // down to the line not being JSON, comes back as an error message
+    static bool parseRequest(const std::string& line, std::string& command, Job& job, std::string& error) {
+        try {
+            json request = json::parse(line);
+            if (!request.is_object()) {
+                error = "Request must be a JSON object";
+                return false;
+            }
+
+            command = "render";
+            if (!readString(request, "command", command, error))
+                return false;
+            return command != "render" || parseJob(request, job, error);
+        } catch (const json::exception& e) {
+            error = e.what();
+            return false;
+        }
+    }
+
+    void RenderServer::handleRequest(const std::string& line, const std::shared_ptr<Connection>& connection) {
+        std::string command;
+        std::string error;
+        Job job;
+        if (!parseRequest(line, command, job, error)) {
+            connection->sendLine(json{ { "event", "error" }, { "message", error } }.dump());
+            return;
+        }
+
+        if (command == "shutdown") {
+            connection->sendLine(json{ { "event", "shutdown" } }.dump());
+            m_running = false;
+            m_queueCondition.notify_all();
+            return;
+        }
+
+        if (command == "status") {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            connection->sendLine(json{ { "event", "status" }, { "queued", m_queue.size() } }.dump());
+            return;
+        }
+
+        if (command != "render") {
+            connection->sendLine(json{ { "event", "error" }, { "message", "Unknown command '" + command + "'" } }.dump());
+            return;
+        }
+
+        job.submitTime = now();
+        job.connection = connection;
+
+        size_t queued;
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            job.id = m_nextJobId++;
+            m_queue.push(job);
+            queued = m_queue.size();
+        }
+        m_queueCondition.notify_one();
+
+        connection->sendLine(json{ { "event", "queued" }, { "job", job.id }, { "position", queued } }.dump());
+    }
+
+    bool RenderServer::popJob(Job& job) {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        m_queueCondition.wait(lock, [&] { return !m_running || !m_queue.empty(); });
+        if (!m_running)
+            return false;
+
+        job = m_queue.top();
+        m_queue.pop();
+        return true;
+    }
+
+    void RenderServer::renderJob(Renderer& renderer, Job& job) {
+        Connection& client = *job.connection;
+
+        double startTime = now();
+        double queuedMs = (startTime - job.submitTime) * 1000.0;
+        client.sendLine(json{ { "event", "started" }, { "job", job.id }, { "queuedMs", queuedMs } }.dump());
+
+        Scene scene;
+        if (!SceneLoader::loadScene(job.scenePath, scene)) {
+            client.sendLine(json{ { "event", "error" }, { "job", job.id }, { "message", "Failed to load scene: " + job.scenePath } }.dump());
+            return;
+        }
+
+        if (job.width > 0 && job.height > 0)
+            renderer.onResize(job.width, job.height);
+        renderer.loadScene(scene);
+        if (job.samplesPerPixel > 0)
+            renderer.setSamplesPerPixel(job.samplesPerPixel);
+
+        uint64_t samplesPerFrame = job.samplesPerPixel > 0 ? job.samplesPerPixel : static_cast<uint64_t>(scene.samplesPerPixel);
+        bool hasOtherLimit = job.targetNoise > 0.0f || job.timeLimit > 0.0f;
+
+        StopConditions conditions;
+        conditions.targetSamples = (job.targetSamples > 0 || hasOtherLimit) ? job.targetSamples : samplesPerFrame;
+        conditions.targetNoise = job.targetNoise;
+        conditions.timeLimit = job.timeLimit;
+
+        ConvergenceMonitor convergence;
+        convergence.setConditions(conditions);
+
+        glFinish();
+        double renderStartTime = now();
+        double loadMs = (renderStartTime - startTime) * 1000.0;
+        double lastProgressTime = renderStartTime;
+        double lastFrameTime = renderStartTime;
+        bool converged = false;
+
+        while (m_running) {
+            renderer.render(scene.camera);
+
+            double time = now();
+            converged = convergence.update(renderer, time - lastFrameTime);
+            lastFrameTime = time;
+            if (converged)
+                break;
+
+            if (time - lastProgressTime > 0.25) {
+                lastProgressTime = time;
+                json progress{ { "event", "progress" }, { "job", job.id },
+                    { "samples", renderer.getSampleCount() }, { "target", conditions.targetSamples },
+                    { "elapsedMs", (time - renderStartTime) * 1000.0 } };
+                if (convergence.getNoise() >= 0.0f)
+                    progress["noise"] = convergence.getNoise();
+                client.sendLine(progress.dump());
+            }
+        }
+
+        glFinish();
+        double exportStartTime = now();
+        double renderMs = (exportStartTime - renderStartTime) * 1000.0;
+
+        // Shut down mid-job, a partial image must not replace whatever is at the output path
+        if (!converged) {
+            client.sendLine(json{ { "event", "cancelled" }, { "job", job.id }, { "samples", renderer.getSampleCount() },
+                { "stopReason", "shutdown" }, { "queuedMs", queuedMs }, { "loadMs", loadMs }, { "renderMs", renderMs } }.dump());
+            std::cout << "Job " << job.id << " (" << job.scenePath << "): cancelled by shutdown after " << renderMs << "ms" << std::endl;
+            return;
+        }
+
+        std::vector<float> pixels;
+        renderer.readAccumulation(pixels);
+        bool saved = saveFloatImage(job.outputPath, pixels.data(), (int)renderer.getWidth(), (int)renderer.getHeight(), scene.gamma);
+        double exportMs = (now() - exportStartTime) * 1000.0;
+
+        client.sendLine(json{ { "event", saved ? "done" : "error" }, { "job", job.id }, { "output", job.outputPath },
+            { "samples", renderer.getSampleCount() }, { "stopReason", getStopReasonName(convergence.getReason()) },
+            { "queuedMs", queuedMs }, { "loadMs", loadMs },
+            { "renderMs", renderMs }, { "exportMs", exportMs } }.dump());
+
+        std::cout << "Job " << job.id << " (" << job.scenePath << "): load " << loadMs << "ms, render " << renderMs
+            << "ms, export " << exportMs << "ms" << std::endl;
+    }
+
+    void RenderServer::stop() {
+        m_running = false;
+        m_queueCondition.notify_all();
+
+        if (m_acceptThread.joinable())
+            m_acceptThread.join();
+
+        std::vector<Reader> readers;
+        {
+            std::lock_guard<std::mutex> lock(m_readersMutex);
+            for (Reader& reader : m_readers)
+                reader.connection->socket.shutdown();
+            readers.swap(m_readers);
+        }
+
+        for (Reader& reader : readers)
+            reader.thread.join();
+
+        m_listener.close();
+    }
+
+    int runServer(const ServerSettings& settings) {
+        if (!Net::initialise())
+            return EXIT_FAILURE;
+
+        int result;
+        {
+            RenderServer server(settings);
+            result = server.run();
+        }
+
+        Net::shutdown();
+        return result;
+    }
+
+    int submitJob(const std::string& host, uint16_t port, const std::string& jobJson) {
+        if (!Net::initialise())
+            return EXIT_FAILURE;
+
+        int result = EXIT_FAILURE;
+        {
+            Connection connection;
+            connection.socket = Socket::connect(host, port);
+            if (connection.socket.isValid() && connection.sendLine(jobJson)) {
+                std::string buffer;
+                std::string line;
+                while (readLine(connection.socket, buffer, line)) {
+                    std::cout << line << std::endl;
+
+                    json event = json::parse(line, nullptr, false);
+                    std::string type = event.is_object() ? event.value("event", "") : "";
+                    if (type == "done" || type == "status" || type == "shutdown") {
+                        result = EXIT_SUCCESS;
+                        break;
+                    }
+                    if (type == "error" || type == "cancelled")
+                        break;
+                }
+            }
+        }
+
+        Net::shutdown();
+        return result;
+    }
+}
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "session/session_recorder.hpp"
+
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+namespace Session {
+    constexpr int RECORDING_VERSION = 1;
+
+    namespace {
+        const char* BUDGET_MODE_NAMES[] = { "fixed", "interactive", "throughput" };
+
+        json toJson(const glm::vec3& v) {
+            return json::array({ v.x, v.y, v.z });
+        }
+
+        glm::vec3 parseVec3(const json& j_vec, const glm::vec3& fallback) {
+            if (!j_vec.is_array() || j_vec.size() != 3)
+                return fallback;
+            return glm::vec3(j_vec[0].get<float>(), j_vec[1].get<float>(), j_vec[2].get<float>());
+        }
+
+        json toJson(const SessionSettings& settings) {
+            return {
+                { "gamma", settings.gamma },
+                { "maxBounces", settings.maxBounces },
+                { "samplesPerPixel", settings.samplesPerPixel },
+                { "budgetMode", BUDGET_MODE_NAMES[static_cast<int>(settings.budgetMode)] },
+                { "frameBudget", settings.frameBudget },
+                { "skyboxPath", settings.skyboxPath },
+                { "skyboxFormat", getSkyboxFormatName(settings.skyboxFormat) },
+                { "skyboxExposureEV", settings.skyboxExposureEV },
+                { "sunPitch", settings.sunPitch },
+                { "sunYaw", settings.sunYaw },
+                { "sunColour", toJson(settings.sunColour) },
+                { "sunIntensity", settings.sunIntensity },
+                { "sunFocus", settings.sunFocus },
+                { "stats", settings.statsEnabled },
+                { "restir", {
+                    { "enabled", settings.restir.enabled },
+                    { "unbiased", settings.restir.unbiased },
+                    { "candidates", settings.restir.candidates },
+                    { "spatialSamples", settings.restir.spatialSamples },
+                    { "spatialRadius", settings.restir.spatialRadius },
+                    { "maxHistory", settings.restir.maxHistory } } },
+                { "guiding", {
+                    { "enabled", settings.guiding.enabled },
+                    { "mixing", settings.guiding.mixing },
+                    { "trainingIterations", settings.guiding.trainingIterations },
+                    { "spatialThreshold", settings.guiding.spatialThreshold } } },
+                { "radianceCache", {
+                    { "enabled", settings.radianceCache.enabled },
+                    { "cellSize", settings.radianceCache.cellSize },
+                    { "terminationBounce", settings.radianceCache.terminationBounce },
+                    { "updateFraction", settings.radianceCache.updateFraction } } },
+            };
+        }
+
+        // Missing values keep their defaults, so recordings stay readable as settings are added
+        SessionSettings parseSettings(const json& j_settings) {
+            SessionSettings settings;
+            settings.gamma = j_settings.value("gamma", settings.gamma);
+            settings.maxBounces = j_settings.value("maxBounces", settings.maxBounces);
+            settings.samplesPerPixel = j_settings.value("samplesPerPixel", settings.samplesPerPixel);
+            std::string budgetMode = j_settings.value("budgetMode", "fixed");
+            for (int i = 0; i < 3; ++i)
+                if (budgetMode == BUDGET_MODE_NAMES[i])
+                    settings.budgetMode = static_cast<BudgetMode>(i);
+            settings.frameBudget = j_settings.value("frameBudget", settings.frameBudget);
+            settings.skyboxPath = j_settings.value("skyboxPath", settings.skyboxPath);
+            parseSkyboxFormat(j_settings.value("skyboxFormat", "RGB32F"), settings.skyboxFormat);
+            settings.skyboxExposureEV = j_settings.value("skyboxExposureEV", settings.skyboxExposureEV);
+            settings.sunPitch = j_settings.value("sunPitch", settings.sunPitch);
+            settings.sunYaw = j_settings.value("sunYaw", settings.sunYaw);
+            settings.sunColour = parseVec3(j_settings.value("sunColour", json()), settings.sunColour);
+            settings.sunIntensity = j_settings.value("sunIntensity", settings.sunIntensity);
+            settings.sunFocus = j_settings.value("sunFocus", settings.sunFocus);
+            settings.statsEnabled = j_settings.value("stats", settings.statsEnabled);
+
+            json j_restir = j_settings.value("restir", json::object());
+            settings.restir.enabled = j_restir.value("enabled", settings.restir.enabled);
+            settings.restir.unbiased = j_restir.value("unbiased", settings.restir.unbiased);
+            settings.restir.candidates = j_restir.value("candidates", settings.restir.candidates);
+            settings.restir.spatialSamples = j_restir.value("spatialSamples", settings.restir.spatialSamples);
+            settings.restir.spatialRadius = j_restir.value("spatialRadius", settings.restir.spatialRadius);
+            settings.restir.maxHistory = j_restir.value("maxHistory", settings.restir.maxHistory);
+
+            json j_guiding = j_settings.value("guiding", json::object());
+            settings.guiding.enabled = j_guiding.value("enabled", settings.guiding.enabled);
+            settings.guiding.mixing = j_guiding.value("mixing", settings.guiding.mixing);
+            settings.guiding.trainingIterations = j_guiding.value("trainingIterations", settings.guiding.trainingIterations);
+            settings.guiding.spatialThreshold = j_guiding.value("spatialThreshold", settings.guiding.spatialThreshold);
+
+            json j_cache = j_settings.value("radianceCache", json::object());
+            settings.radianceCache.enabled = j_cache.value("enabled", settings.radianceCache.enabled);
+            settings.radianceCache.cellSize = j_cache.value("cellSize", settings.radianceCache.cellSize);
+            settings.radianceCache.terminationBounce = j_cache.value("terminationBounce", settings.radianceCache.terminationBounce);
+            settings.radianceCache.updateFraction = j_cache.value("updateFraction", settings.radianceCache.updateFraction);
+            return settings;
+        }
+
+        float lerpAngle(float a, float b, float t) {
+            // Yaw wraps at +-360 degrees, a step across the wrap isn't a turn
+            float delta = std::fmod(b - a, 360.0f);
+            if (delta > 180.0f)
+                delta -= 360.0f;
+            if (delta < -180.0f)
+                delta += 360.0f;
+            return a + delta * t;
+        }
+    }
+
+    bool saveRecording(const std::string& filepath, const Recording& recording) {
+        json j_events = json::array();
+        for (const SessionEvent& event : recording.events) {
+            json j_event = { { "time", event.time } };
+            switch (event.type) {
+            case EventType::Scene:
+                j_event["type"] = "scene";
+                j_event["path"] = event.scenePath;
+                break;
+            case EventType::Viewport:
+                j_event["type"] = "viewport";
+                j_event["width"] = event.width;
+                j_event["height"] = event.height;
+                break;
+            case EventType::Settings:
+                j_event["type"] = "settings";
+                j_event["settings"] = toJson(event.settings);
+                break;
+            }
+            j_events.push_back(std::move(j_event));
+        }
+
+        // Cameras are the bulk of a recording, one compact row each: time, position, yaw, pitch
+        json j_cameras = json::array();
+        for (const CameraSample& sample : recording.cameras)
+            j_cameras.push_back({ sample.time, sample.position.x, sample.position.y, sample.position.z, sample.yaw, sample.pitch });
+
+        json j = {
+            { "version", RECORDING_VERSION },
+            { "duration", recording.duration },
+            { "events", std::move(j_events) },
+            { "cameras", std::move(j_cameras) },
+        };
+
+        std::ofstream file(filepath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error (Session): Could not write recording " << filepath << std::endl;
+            return false;
+        }
+        file << j.dump();
+        return file.good();
+    }
+
+    bool loadRecording(const std::string& filepath, Recording& recording) {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            std::cerr << "Error (Session): Could not open recording " << filepath << std::endl;
+            return false;
+        }
+
+        json j;
+        try {
+            file >> j;
+        } catch (const json::parse_error& e) {
+            std::cerr << "Error (Session): Could not parse " << filepath << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        recording = Recording();
+        try {
+            // value() throws on anything but an object, so this is checked in here too
+            int version = j.value("version", 0);
+            if (version != RECORDING_VERSION) {
+                std::cerr << "Error (Session): " << filepath << " is version " << version << ", expected " << RECORDING_VERSION << std::endl;
+                return false;
+            }
+
+            recording.duration = j.at("duration").get<double>();
+            for (const json& j_event : j.at("events")) {
+                SessionEvent event;
+                event.time = j_event.at("time").get<double>();
+                std::string type = j_event.at("type").get<std::string>();
+                if (type == "scene") {
+                    event.type = EventType::Scene;
+                    event.scenePath = j_event.at("path").get<std::string>();
+                }
+                else if (type == "viewport") {
+                    event.type = EventType::Viewport;
+                    event.width = j_event.at("width").get<uint32_t>();
+                    event.height = j_event.at("height").get<uint32_t>();
+                }
+                else if (type == "settings") {
+                    event.type = EventType::Settings;
+                    event.settings = parseSettings(j_event.at("settings"));
+                }
+                else {
+                    std::cerr << "Error (Session): Unknown event type '" << type << "' in " << filepath << std::endl;
+                    return false;
+                }
+                recording.events.push_back(std::move(event));
+            }
+
+            for (const json& j_camera : j.at("cameras")) {
+                CameraSample sample;
+                sample.time = j_camera.at(0).get<double>();
+                sample.position = glm::vec3(j_camera.at(1).get<float>(), j_camera.at(2).get<float>(), j_camera.at(3).get<float>());
+                sample.yaw = j_camera.at(4).get<float>();
+                sample.pitch = j_camera.at(5).get<float>();
+                recording.cameras.push_back(sample);
+            }
+        } catch (const json::exception& e) {
+            std::cerr << "Error (Session): Invalid recording " << filepath << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        // Written in order, but a hand edited file may not be
+        std::stable_sort(recording.events.begin(), recording.events.end(),
+            [](const SessionEvent& a, const SessionEvent& b) { return a.time < b.time; });
+        std::stable_sort(recording.cameras.begin(), recording.cameras.end(),
+            [](const CameraSample& a, const CameraSample& b) { return a.time < b.time; });
+        return true;
+    }
+
+    Camera evaluateCamera(const std::vector<CameraSample>& cameras, double time) {
+        Camera camera;
+        if (cameras.empty())
+            return camera;
+
+        auto next = std::upper_bound(cameras.begin(), cameras.end(), time,
+            [](double t, const CameraSample& sample) { return t < sample.time; });
+        if (next == cameras.begin()) {
+            camera.position = next->position;
+            camera.yaw = next->yaw;
+            camera.pitch = next->pitch;
+        }
+        else if (next == cameras.end()) {
+            camera.position = cameras.back().position;
+            camera.yaw = cameras.back().yaw;
+            camera.pitch = cameras.back().pitch;
+        }
+        else {
+            const CameraSample& previous = *(next - 1);
+            double span = next->time - previous.time;
+            float t = span > 0.0 ? static_cast<float>((time - previous.time) / span) : 1.0f;
+            camera.position = glm::mix(previous.position, next->position, t);
+            camera.yaw = lerpAngle(previous.yaw, next->yaw, t);
+            camera.pitch = glm::mix(previous.pitch, next->pitch, t);
+        }
+        camera.updateOrientation();
+        return camera;
+    }
+
+    void SessionRecorder::start(const std::string& filepath, double time, const std::string& scenePath) {
+        m_filepath = filepath;
+        m_active = true;
+        m_startTime = time;
+        m_lastUpdate = 0.0;
+        m_recording = Recording();
+        m_hasState = false;
+
+        // The first update records the rest of the starting state
+        if (!scenePath.empty())
+            recordScene(time, scenePath);
+    }
+
+    bool SessionRecorder::stop(double time) {
+        if (!m_active)
+            return false;
+        m_active = false;
+        m_recording.duration = std::max(time - m_startTime, m_lastUpdate);
+
+        bool saved = saveRecording(m_filepath, m_recording);
+        if (saved)
+            std::cout << "Recorded " << m_recording.duration << "s session to " << m_filepath << std::endl;
+        m_recording = Recording();
+        return saved;
+    }
+
+    bool SessionRecorder::isRecording() const {
+        return m_active;
+    }
+
+    const std::string& SessionRecorder::getFilepath() const {
+        return m_filepath;
+    }
+
+    double SessionRecorder::getDuration(double time) const {
+        return m_active ? time - m_startTime : 0.0;
+    }
+
+    size_t SessionRecorder::getEventCount() const {
+        return m_recording.events.size() + m_recording.cameras.size();
+    }
+
+    void SessionRecorder::recordScene(double time, const std::string& scenePath) {
+        if (!m_active)
+            return;
+
+        SessionEvent event;
+        event.time = time - m_startTime;
+        event.type = EventType::Scene;
+        event.scenePath = scenePath;
+        m_recording.events.push_back(std::move(event));
+    }
+
+    void SessionRecorder::update(double time, const Camera& camera, const SessionSettings& settings, uint32_t width, uint32_t height) {
+        if (!m_active)
+            return;
+        double now = time - m_startTime;
+
+        if (!m_hasState || width != m_width || height != m_height) {
+            SessionEvent event;
+            event.time = now;
+            event.type = EventType::Viewport;
+            event.width = width;
+            event.height = height;
+            m_recording.events.push_back(std::move(event));
+            m_width = width;
+            m_height = height;
+        }
+
+        std::string serialised = toJson(settings).dump();
+        if (!m_hasState || serialised != m_settings) {
+            SessionEvent event;
+            event.time = now;
+            event.type = EventType::Settings;
+            event.settings = settings;
+            m_recording.events.push_back(std::move(event));
+            m_settings = std::move(serialised);
+        }
+
+        CameraSample sample;
+        sample.time = now;
+        sample.position = camera.position;
+        sample.yaw = camera.yaw;
+        sample.pitch = camera.pitch;
+        if (!m_hasState || sample.position != m_camera.position || sample.yaw != m_camera.yaw || sample.pitch != m_camera.pitch) {
+            // After a still spell, hold the old camera until the previous frame so replay doesn't drift across the gap
+            if (m_hasState && m_recording.cameras.back().time < m_lastUpdate) {
+                CameraSample held = m_camera;
+                held.time = m_lastUpdate;
+                m_recording.cameras.push_back(held);
+            }
+            m_recording.cameras.push_back(sample);
+            m_camera = sample;
+        }
+
+        m_hasState = true;
+        m_lastUpdate = now;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "renderer/renderer.hpp"
+#include "renderer/sample_scheduler.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_loader.hpp"
+#include "session/session_recorder.hpp"
+#include "session/session_replay.hpp"
+#include "utils/gl_context.hpp"
+
+namespace Session {
+    constexpr uint32_t DEFAULT_WIDTH = 1280;
+    constexpr uint32_t DEFAULT_HEIGHT = 720;
+    constexpr double MAX_FRAMES = 1000000.0;  // Over four hours at 60 fps
+
+    struct FrameTiming {
+        uint32_t frame;
+        double time;  // Session time of the frame
+        uint32_t samplesPerPixel;
+        float cpuMilliseconds;    // Recording the frame's commands
+        float gpuMilliseconds;    // Negative if the timer query had no result
+        float totalMilliseconds;  // Until the GPU finished
+    };
+
+    // The renderer and what the UI would have posted to it during the session. Scheduled budgets would pick samples
+    // per pixel from this machine's GPU timings, so every frame renders the recorded fixed count instead
+    struct ReplayState {
+        Renderer& renderer;
+        Scene scene;  // Sun angles convert to a direction through it
+        uint32_t samplesPerPixel = 1;
+        bool scheduledWarned = false;  // A recorded interactive or throughput budget was reported
+        bool sceneLoaded = false;
+        bool fixedSize = false;
+
+        explicit ReplayState(Renderer& renderer) : renderer(renderer) {}
+    };
+
+    static void applySettings(ReplayState& state, const SessionSettings& settings) {
+        SceneResources& resources = state.renderer.getResources();
+        resources.setGamma(settings.gamma);
+        resources.setMaxBounces(static_cast<uint32_t>(std::max(settings.maxBounces, 1)));
+        resources.setSkyboxFormat(settings.skyboxFormat);
+        if (settings.skyboxPath != state.scene.skyboxPath) {
+            resources.setSkybox(settings.skyboxPath);
+            state.scene.skyboxPath = settings.skyboxPath;
+        }
+        resources.setSkyboxExposure(std::pow(2.0f, settings.skyboxExposureEV));
+
+        state.scene.sunPitch = settings.sunPitch;
+        state.scene.sunYaw = settings.sunYaw;
+        resources.setSunDirection(state.scene.getSunDirection());
+        resources.setSunColour(settings.sunColour);
+        resources.setSunIntensity(settings.sunIntensity);
+        resources.setSunFocus(settings.sunFocus);
+
+        state.samplesPerPixel = static_cast<uint32_t>(std::max(settings.samplesPerPixel, 1));
+        if (settings.budgetMode != BudgetMode::Fixed && !state.scheduledWarned) {
+            std::cout << "\rRecorded with a scheduled frame budget, replaying at a fixed " << state.samplesPerPixel
+                << " samples per pixel so frames don't depend on this GPU" << std::endl;
+            state.scheduledWarned = true;
+        }
+
+        state.renderer.setStatsEnabled(settings.statsEnabled);
+        state.renderer.setRestir(settings.restir);
+        state.renderer.setGuiding(settings.guiding);
+        state.renderer.setRadianceCache(settings.radianceCache);
+    }
+
+    static bool applyEvent(ReplayState& state, const SessionEvent& event) {
+        switch (event.type) {
+        case EventType::Scene:
+            if (!SceneLoader::loadScene(event.scenePath, state.scene)) {
+                std::cerr << "Error (Session): Failed to load recorded scene " << event.scenePath << std::endl;
+                return false;
+            }
+            state.renderer.loadScene(state.scene);
+            state.samplesPerPixel = static_cast<uint32_t>(std::max(state.scene.samplesPerPixel, 1));
+            state.sceneLoaded = true;
+            return true;
+        case EventType::Viewport:
+            if (!state.fixedSize)
+                state.renderer.onResize(event.width, event.height);
+            return true;
+        case EventType::Settings:
+            applySettings(state, event.settings);
+            return true;
+        }
+        return true;
+    }
+
+    // Nearest rank, values must be sorted
+    static float percentile(const std::vector<float>& values, float fraction) {
+        if (values.empty())
+            return 0.0f;
+        size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    }
+
+    static void printRow(const char* name, std::vector<float> values) {
+        if (values.empty()) {
+            std::printf("%-10s %9s\n", name, "n/a");
+            return;
+        }
+
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (float value : values)
+            sum += value;
+        std::printf("%-10s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, sum / values.size(), percentile(values, 0.5f),
+            percentile(values, 0.9f), percentile(values, 0.95f), percentile(values, 0.99f), values.back());
+    }
+
+    static void printReport(const std::vector<FrameTiming>& frames) {
+        std::vector<float> cpu, gpu, total;
+        for (const FrameTiming& frame : frames) {
+            cpu.push_back(frame.cpuMilliseconds);
+            if (frame.gpuMilliseconds >= 0.0f)
+                gpu.push_back(frame.gpuMilliseconds);
+            total.push_back(frame.totalMilliseconds);
+        }
+
+        std::printf("%-10s %9s %9s %9s %9s %9s %9s\n", "(ms)", "mean", "p50", "p90", "p95", "p99", "max");
+        printRow("CPU", cpu);
+        printRow("GPU", gpu);
+        printRow("Frame", total);
+    }
+
+    static bool writeReport(const std::string& filepath, const std::vector<FrameTiming>& frames) {
+        std::ofstream file(filepath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error (Session): Could not write report " << filepath << std::endl;
+            return false;
+        }
+
+        // Budgets are always fixed during replay, the column name says so
+        file << "frame,time,fixed_samples_per_pixel,cpu_ms,gpu_ms,frame_ms\n";
+        for (const FrameTiming& frame : frames) {
+            file << frame.frame << "," << frame.time << "," << frame.samplesPerPixel << "," << frame.cpuMilliseconds << ",";
+            if (frame.gpuMilliseconds >= 0.0f)
+                file << frame.gpuMilliseconds;
+            file << "," << frame.totalMilliseconds << "\n";
+        }
+        return file.good();
+    }
+
+    static bool replayFrames(const ReplaySettings& settings, const Recording& recording, uint32_t width, uint32_t height) {
+        if (!std::isfinite(recording.duration) || recording.duration < 0.0) {
+            std::cerr << "Error (Session): " << settings.recordingPath << " has an invalid duration " << recording.duration << std::endl;
+            return false;
+        }
+        if (!std::isfinite(settings.fps)) {
+            std::cerr << "Error (Session): Invalid replay frame rate " << settings.fps << std::endl;
+            return false;
+        }
+
+        double step = 1.0 / std::max(settings.fps, 1.0f);
+        double exactCount = std::floor(recording.duration / step) + 1.0;
+        if (exactCount > MAX_FRAMES) {
+            std::cerr << "Error (Session): Replaying " << settings.recordingPath << " would take " << exactCount
+                << " frames, the limit is " << MAX_FRAMES << std::endl;
+            return false;
+        }
+        uint32_t frameCount = static_cast<uint32_t>(exactCount);
+
+        Renderer renderer(width, height);
+        ReplayState state(renderer);
+        state.fixedSize = settings.width > 0 && settings.height > 0;
+        std::vector<FrameTiming> frames;
+        frames.reserve(frameCount);
+
+        std::cout << "Replaying " << settings.recordingPath << ": " << recording.duration << "s, " << frameCount << " frames at "
+            << settings.fps << " fps" << std::endl;
+
+        size_t nextEvent = 0;
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            double time = frame * step;
+            for (; nextEvent < recording.events.size() && recording.events[nextEvent].time <= time; ++nextEvent) {
+                if (!applyEvent(state, recording.events[nextEvent]))
+                    return false;
+            }
+
+            // Nothing was on screen before the first scene finished loading
+            if (!state.sceneLoaded)
+                continue;
+
+            Camera camera = recording.cameras.empty() ? state.scene.camera : evaluateCamera(recording.cameras, time);
+            uint32_t samplesPerPixel = state.samplesPerPixel;
+            renderer.setSamplesPerPixel(samplesPerPixel);
+
+            auto start = std::chrono::steady_clock::now();
+            renderer.render(camera);
+            auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            auto finished = std::chrono::steady_clock::now();
+
+            FrameTiming timing;
+            timing.frame = frame;
+            timing.time = time;
+            timing.samplesPerPixel = samplesPerPixel;
+            timing.cpuMilliseconds = std::chrono::duration<float, std::milli>(submitted - start).count();
+            timing.totalMilliseconds = std::chrono::duration<float, std::milli>(finished - start).count();
+            timing.gpuMilliseconds = -1.0f;
+
+            Renderer::GpuTiming gpuTiming;
+            if (renderer.pollGpuTiming(gpuTiming))
+                timing.gpuMilliseconds = gpuTiming.milliseconds;
+            frames.push_back(timing);
+
+            if (frame % 60 == 0)
+                std::cout << "\rFrame " << frame << "/" << frameCount - 1 << std::flush;
+        }
+        std::cout << "\rRendered " << frames.size() << " frames" << std::endl;
+
+        printReport(frames);
+        return settings.reportPath.empty() || writeReport(settings.reportPath, frames);
+    }
+
+    int runReplay(const ReplaySettings& settings) {
+        Recording recording;
+        if (!loadRecording(settings.recordingPath, recording))
+            return EXIT_FAILURE;
+
+        // The render size starts at the first recorded viewport unless given
+        uint32_t width = settings.width;
+        uint32_t height = settings.height;
+        if (width == 0 || height == 0) {
+            width = DEFAULT_WIDTH;
+            height = DEFAULT_HEIGHT;
+            auto viewport = std::find_if(recording.events.begin(), recording.events.end(),
+                [](const SessionEvent& event) { return event.type == EventType::Viewport && event.width > 0 && event.height > 0; });
+            if (viewport != recording.events.end()) {
+                width = viewport->width;
+                height = viewport->height;
+            }
+        }
+
+        GLFWwindow* context = createHeadlessContext(width, height);
+        if (!context)
+            return EXIT_FAILURE;
+
+        bool success = replayFrames(settings, recording, width, height);
+
+        destroyHeadlessContext(context);
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
\ No newline at end of file
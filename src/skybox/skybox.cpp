@@ -1,9 +1,116 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 #include "skybox/skybox.hpp"
+#include "skybox/skybox_encoding.hpp"
+#include "utils/gl_debug.hpp"
+
+namespace {
+    // Pre-encoded BC6H mip chain stored next to the source HDR
+    struct BC6HCacheHeader {
+        char magic[4] = { 'B', 'C', '6', 'H' };
+        uint32_t version = 1;
+        int32_t width = 0;
+        int32_t height = 0;
+        uint32_t levelCount = 0;
+        uint32_t _pad0 = 0;
+        uint64_t sourceSize = 0;  // Invalidates the cache when the source changes
+        int64_t sourceTime = 0;
+    };
+
+    bool getSourceStamp(const std::string& filepath, uint64_t& size, int64_t& time) {
+        std::error_code error;
+        size = std::filesystem::file_size(filepath, error);
+        if (error) return false;
+        time = static_cast<int64_t>(std::filesystem::last_write_time(filepath, error).time_since_epoch().count());
+        return !error;
+    }
+
+    bool readBC6HCache(const std::string& cachePath, const std::string& filepath, SkyboxData& data) {
+        std::ifstream file(cachePath, std::ios::binary);
+        if (!file)
+            return false;
+
+        BC6HCacheHeader expected;
+        BC6HCacheHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+
+        uint64_t sourceSize = 0;
+        int64_t sourceTime = 0;
+        bool sourceKnown = getSourceStamp(filepath, sourceSize, sourceTime);
+        if (std::memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version ||
+            header.width <= 0 || header.height <= 0 || header.levelCount == 0 ||
+            (sourceKnown && (header.sourceSize != sourceSize || header.sourceTime != sourceTime)))
+            return false;
+
+        std::vector<std::vector<uint8_t>> levels(header.levelCount);
+        for (uint32_t level = 0, w = header.width, h = header.height; level < header.levelCount;
+             ++level, w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+            levels[level].resize(SkyboxEncoding::bc6hSize(w, h));
+            if (!file.read(reinterpret_cast<char*>(levels[level].data()), static_cast<std::streamsize>(levels[level].size()))) {
+                std::cerr << "Warning (Skybox): Ignoring truncated BC6H cache: " << cachePath << std::endl;
+                return false;
+            }
+        }
+
+        data.width = header.width;
+        data.height = header.height;
+        data.channels = 3;
+        data.levels = std::move(levels);
+        data.fromCache = true;
+        return true;
+    }
+
+    void writeBC6HCache(const std::string& cachePath, const std::string& filepath, const SkyboxData& data) {
+        BC6HCacheHeader header;
+        header.width = data.width;
+        header.height = data.height;
+        header.levelCount = static_cast<uint32_t>(data.levels.size());
+        if (!getSourceStamp(filepath, header.sourceSize, header.sourceTime))
+            return;
+
+        std::ofstream cache(cachePath, std::ios::binary);
+        if (!cache)
+            return;
+        cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const std::vector<uint8_t>& level : data.levels)
+            cache.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+    }
+}
+
+const char* getSkyboxFormatName(SkyboxFormat format) {
+    switch (format) {
+    case SkyboxFormat::RGB32F: return "RGB32F";
+    case SkyboxFormat::RGB16F: return "RGB16F";
+    case SkyboxFormat::RGB9_E5: return "RGB9_E5";
+    case SkyboxFormat::BC6H: return "BC6H";
+    }
+    return "Unknown";
+}
+
+bool parseSkyboxFormat(const std::string& name, SkyboxFormat& format) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    for (SkyboxFormat candidate : { SkyboxFormat::RGB32F, SkyboxFormat::RGB16F, SkyboxFormat::RGB9_E5, SkyboxFormat::BC6H }) {
+        std::string candidateName = getSkyboxFormatName(candidate);
+        std::transform(candidateName.begin(), candidateName.end(), candidateName.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower == candidateName) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
 
 Skybox::Skybox() {}
 
@@ -12,7 +119,7 @@ Skybox::~Skybox() {
 }
 
 GLuint Skybox::getTextureID() const {
-	return m_textureId;
+	return m_texture.get();
 }
 
 int Skybox::getWidth() const {
@@ -23,18 +130,84 @@ int Skybox::getHeight() const {
 	return m_height;
 }
 
-bool Skybox::load(const std::string& filepath) {
-	cleanup();
+SkyboxFormat Skybox::getFormat() const {
+    return m_format;
+}
+
+size_t Skybox::getMemoryUsage() const {
+    return m_memoryUsage;
+}
+
+bool Skybox::decode(const std::string& filepath, SkyboxFormat format, SkyboxData& data) {
+    data = SkyboxData();
+    data.filepath = filepath;
+    data.format = format;
 
-    float* imageData = stbi_loadf(filepath.c_str(), &m_width, &m_height, &m_channels, 0);
+    // A valid BC6H cache skips decoding the HDR entirely
+    std::string cachePath = filepath + ".bc6h";
+    if (format == SkyboxFormat::BC6H && readBC6HCache(cachePath, filepath, data))
+        return true;
+
+    // The compact formats are RGB only
+    int requestedChannels = (format == SkyboxFormat::RGB32F) ? 0 : 3;
+    float* imageData = stbi_loadf(filepath.c_str(), &data.width, &data.height, &data.channels, requestedChannels);
 
     if (!imageData) {
         std::cerr << "Error (Skybox): Failed to load HDR image: " << filepath << " - " << stbi_failure_reason() << std::endl;
         return false;
     }
 
-    glGenTextures(1, &m_textureId);
-    glBindTexture(GL_TEXTURE_2D, m_textureId);
+    if (format == SkyboxFormat::RGB32F) {
+        data.pixels.assign(imageData, imageData + static_cast<size_t>(data.width) * data.height * data.channels);
+        stbi_image_free(imageData);
+        return true;
+    }
+
+    // RGB9_E5 and BC6H can't be rendered to, so mipmaps are built on the CPU for every compact format
+    data.channels = 3;
+    std::vector<SkyboxEncoding::FloatImage> levels = SkyboxEncoding::buildMipChain(imageData, data.width, data.height);
+    stbi_image_free(imageData);
+
+    data.levels.reserve(levels.size());
+    for (const SkyboxEncoding::FloatImage& image : levels) {
+        std::vector<uint8_t> bytes;
+        switch (format) {
+        case SkyboxFormat::RGB16F: {
+            std::vector<uint16_t> encoded = SkyboxEncoding::encodeRGB16F(image);
+            bytes.resize(encoded.size() * sizeof(uint16_t));
+            std::memcpy(bytes.data(), encoded.data(), bytes.size());
+            break;
+        }
+        case SkyboxFormat::RGB9_E5: {
+            std::vector<uint32_t> encoded = SkyboxEncoding::encodeRGB9E5(image);
+            bytes.resize(encoded.size() * sizeof(uint32_t));
+            std::memcpy(bytes.data(), encoded.data(), bytes.size());
+            break;
+        }
+        case SkyboxFormat::BC6H:
+            bytes = SkyboxEncoding::encodeBC6H(image);
+            break;
+        default:
+            break;
+        }
+        data.levels.push_back(std::move(bytes));
+    }
+
+    if (format == SkyboxFormat::BC6H)
+        writeBC6HCache(cachePath, filepath, data);
+    return true;
+}
+
+bool Skybox::upload(const SkyboxData& data) {
+    GLDebugGroup group("Skybox upload");
+    cleanup();
+    m_format = data.format;
+    m_width = data.width;
+    m_height = data.height;
+    m_channels = data.channels;
+
+    m_texture.create("Skybox " + data.filepath + (data.fromCache ? " (BC6H cache)" : ""));
+    glBindTexture(GL_TEXTURE_2D, m_texture.get());
 
     // Texture parameters for HDR
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -42,6 +215,35 @@ bool Skybox::load(const std::string& filepath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    if (data.format == SkyboxFormat::RGB32F)
+        uploadFloat(data);
+    else
+        uploadCompact(data);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "Error (Skybox): Failed to upload " << getSkyboxFormatName(m_format) << " texture" << std::endl;
+        if (data.format == SkyboxFormat::BC6H)
+            std::filesystem::remove(data.filepath + ".bc6h");
+        cleanup();
+        return false;
+    }
+
+    m_texture.setSize(m_memoryUsage);
+    return true;
+}
+
+bool Skybox::load(const std::string& filepath, SkyboxFormat format) {
+    SkyboxData data;
+    if (!decode(filepath, format, data)) {
+        cleanup();
+        return false;
+    }
+    return upload(data);
+}
+
+void Skybox::uploadFloat(const SkyboxData& data) {
     // Determine internal format based on channels (default 3)
     GLenum internalFormat = GL_RGB32F;
     GLenum format = GL_RGB;
@@ -59,22 +261,54 @@ bool Skybox::load(const std::string& filepath) {
         format = GL_RED;
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_width, m_height, 0, format, GL_FLOAT, imageData);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_width, m_height, 0, format, GL_FLOAT, data.pixels.data());
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    // Free CPU-side image data
-    stbi_image_free(imageData);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Full chain is about 4/3 of the base level
+    m_memoryUsage = 0;
+    for (int w = m_width, h = m_height; ; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        m_memoryUsage += static_cast<size_t>(w) * h * m_channels * sizeof(float);
+        if (w == 1 && h == 1) break;
+    }
+}
 
-    return true;
+void Skybox::uploadCompact(const SkyboxData& data) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(data.levels.size()) - 1);
+
+    m_memoryUsage = 0;
+    int w = m_width;
+    int h = m_height;
+    for (size_t level = 0; level < data.levels.size(); ++level, w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        const std::vector<uint8_t>& bytes = data.levels[level];
+        GLint mip = static_cast<GLint>(level);
+
+        switch (m_format) {
+        case SkyboxFormat::RGB16F:
+            glTexImage2D(GL_TEXTURE_2D, mip, GL_RGB16F, w, h, 0, GL_RGB, GL_HALF_FLOAT, bytes.data());
+            break;
+        case SkyboxFormat::RGB9_E5:
+            glTexImage2D(GL_TEXTURE_2D, mip, GL_RGB9_E5, w, h, 0, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, bytes.data());
+            break;
+        case SkyboxFormat::BC6H:
+            glCompressedTexImage2D(GL_TEXTURE_2D, mip, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, w, h, 0,
+                static_cast<GLsizei>(bytes.size()), bytes.data());
+            break;
+        default:
+            break;
+        }
+        m_memoryUsage += bytes.size();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 void Skybox::cleanup() {
-    if (m_textureId != 0) {
-        glDeleteTextures(1, &m_textureId);
-        m_textureId = 0;
+    if (m_texture) {
+        m_texture.reset();
         m_width = 0;
         m_height = 0;
         m_channels = 0;
+        m_memoryUsage = 0;
     }
 }
\ No newline at end of file
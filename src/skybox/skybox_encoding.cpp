@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "skybox/skybox_encoding.hpp"
+#include "utils/job_system.hpp"
+
+namespace SkyboxEncoding {
+
+    namespace {
+        constexpr float MAX_HALF = 65504.0f;
+        constexpr uint16_t MAX_HALF_BITS = 0x7BFF;
+
+        // Work per job when encoding on the job system, small levels stay on the calling thread
+        constexpr size_t ROWS_PER_JOB = 32;
+        constexpr size_t TEXELS_PER_JOB = 16384;
+        constexpr size_t BLOCK_ROWS_PER_JOB = 4;
+
+        // BC6H 4-bit index interpolation weights (out of 64)
+        constexpr int BC6H_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Sets `count` bits starting at `offset` in a 128-bit little-endian block
+        void writeBits(uint8_t* block, int& offset, uint32_t value, int count) {
+            for (int i = 0; i < count; ++i, ++offset) {
+                if (value & (1u << i))
+                    block[offset >> 3] |= static_cast<uint8_t>(1u << (offset & 7));
+            }
+        }
+
+        // Mode 11 endpoints are 10-bit, unquantized to 16 bits and later scaled by 31/64
+        int unquantize10(int value) {
+            if (value == 0) return 0;
+            if (value == 1023) return 0xFFFF;
+            return ((value << 16) + 0x8000) >> 10;
+        }
+
+        int finishUnsigned(int value) {
+            return (value * 31) >> 6;
+        }
+
+        int quantize10(int halfBits) {
+            // Inverse of finishUnsigned(unquantize10(e)) ~= e * 31 + 15.5
+            int best = std::clamp(static_cast<int>(std::lround((halfBits - 15.5f) / 31.0f)), 0, 1023);
+
+            // The end codes are special cased, check the neighbours
+            int bestError = std::abs(finishUnsigned(unquantize10(best)) - halfBits);
+            for (int candidate = std::max(best - 1, 0); candidate <= std::min(best + 1, 1023); ++candidate) {
+                int error = std::abs(finishUnsigned(unquantize10(candidate)) - halfBits);
+                if (error < bestError) {
+                    best = candidate;
+                    bestError = error;
+                }
+            }
+            return best;
+        }
+
+        void encodeBC6HBlock(const FloatImage& image, int blockX, int blockY, uint8_t* block) {
+            // Texels as unsigned half bit patterns, BC6H interpolates in this space
+            int texels[16][3];
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(blockX * 4 + x, image.width - 1);
+                    int sy = std::min(blockY * 4 + y, image.height - 1);
+                    const float* rgb = &image.rgb[(static_cast<size_t>(sy) * image.width + sx) * 3];
+                    for (int c = 0; c < 3; ++c) {
+                        float value = std::clamp(rgb[c], 0.0f, MAX_HALF);
+                        texels[y * 4 + x][c] = floatToHalf(value);
+                    }
+                }
+            }
+
+            // Endpoints from the bounding box of the block
+            int endpoints[2][3];
+            for (int c = 0; c < 3; ++c) {
+                int low = texels[0][c];
+                int high = texels[0][c];
+                for (int i = 1; i < 16; ++i) {
+                    low = std::min(low, texels[i][c]);
+                    high = std::max(high, texels[i][c]);
+                }
+                endpoints[0][c] = quantize10(low);
+                endpoints[1][c] = quantize10(high);
+            }
+
+            int palette[16][3];
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < 3; ++c) {
+                    int a = unquantize10(endpoints[0][c]);
+                    int b = unquantize10(endpoints[1][c]);
+                    palette[i][c] = finishUnsigned((a * (64 - BC6H_WEIGHTS[i]) + b * BC6H_WEIGHTS[i] + 32) >> 6);
+                }
+            }
+
+            int indices[16];
+            for (int t = 0; t < 16; ++t) {
+                int64_t bestError = INT64_MAX;
+                for (int i = 0; i < 16; ++i) {
+                    int64_t error = 0;
+                    for (int c = 0; c < 3; ++c) {
+                        int64_t d = texels[t][c] - palette[i][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError = error;
+                        indices[t] = i;
+                    }
+                }
+            }
+
+            // The anchor index is stored with 3 bits, so its top bit must be zero
+            if (indices[0] >= 8) {
+                std::swap(endpoints[0], endpoints[1]);
+                for (int& index : indices)
+                    index = 15 - index;
+            }
+
+            std::memset(block, 0, 16);
+            int offset = 0;
+            writeBits(block, offset, 0x03, 5);  // Mode 11
+            for (int e = 0; e < 2; ++e)
+                for (int c = 0; c < 3; ++c)
+                    writeBits(block, offset, static_cast<uint32_t>(endpoints[e][c]), 10);
+            writeBits(block, offset, static_cast<uint32_t>(indices[0]), 3);
+            for (int t = 1; t < 16; ++t)
+                writeBits(block, offset, static_cast<uint32_t>(indices[t]), 4);
+        }
+    }
+
+    std::vector<FloatImage> buildMipChain(const float* rgb, int width, int height) {
+        std::vector<FloatImage> levels;
+
+        FloatImage base;
+        base.width = width;
+        base.height = height;
+        base.rgb.assign(rgb, rgb + static_cast<size_t>(width) * height * 3);
+        levels.push_back(std::move(base));
+
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const FloatImage& source = levels.back();
+
+            FloatImage level;
+            level.width = std::max(source.width / 2, 1);
+            level.height = std::max(source.height / 2, 1);
+            level.rgb.resize(static_cast<size_t>(level.width) * level.height * 3);
+
+            JobSystem::get().parallelFor(0, level.height, ROWS_PER_JOB, [&](size_t rowBegin, size_t rowEnd) {
+                for (int y = static_cast<int>(rowBegin); y < static_cast<int>(rowEnd); ++y) {
+                    int y0 = std::min(y * 2, source.height - 1);
+                    int y1 = std::min(y * 2 + 1, source.height - 1);
+                    for (int x = 0; x < level.width; ++x) {
+                        int x0 = std::min(x * 2, source.width - 1);
+                        int x1 = std::min(x * 2 + 1, source.width - 1);
+                        for (int c = 0; c < 3; ++c) {
+                            float sum = source.rgb[(static_cast<size_t>(y0) * source.width + x0) * 3 + c]
+                                      + source.rgb[(static_cast<size_t>(y0) * source.width + x1) * 3 + c]
+                                      + source.rgb[(static_cast<size_t>(y1) * source.width + x0) * 3 + c]
+                                      + source.rgb[(static_cast<size_t>(y1) * source.width + x1) * 3 + c];
+                            level.rgb[(static_cast<size_t>(y) * level.width + x) * 3 + c] = sum * 0.25f;
+                        }
+                    }
+                }
+            });
+
+            levels.push_back(std::move(level));
+        }
+
+        return levels;
+    }
+
+    uint16_t floatToHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if (((bits >> 23) & 0xFF) == 0xFF)  // Inf/NaN
+            return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+        if (exponent >= 31)  // Overflow
+            return static_cast<uint16_t>(sign | 0x7C00);
+
+        if (exponent <= 0) {  // Denormal or zero
+            if (exponent < -10)
+                return static_cast<uint16_t>(sign);
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1)
+                half++;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000)  // Round to nearest, a carry correctly bumps the exponent
+            half++;
+        return static_cast<uint16_t>(half);
+    }
+
+    float halfToFloat(uint16_t value) {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+        uint32_t bits;
+
+        if (exponent == 0) {
+            if (mantissa == 0) {
+                bits = sign;
+            }
+            else {  // Normalise the denormal
+                exponent = 127 - 15 + 1;
+                while ((mantissa & 0x400) == 0) {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+            }
+        }
+        else if (exponent == 31) {
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        }
+        else {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    std::vector<uint16_t> encodeRGB16F(const FloatImage& image) {
+        std::vector<uint16_t> result(image.rgb.size());
+        JobSystem::get().parallelFor(0, image.rgb.size(), TEXELS_PER_JOB * 3, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                result[i] = floatToHalf(std::min(image.rgb[i], MAX_HALF));  // Clamp instead of overflowing to Inf
+        });
+        return result;
+    }
+
+    uint32_t packRGB9E5(float r, float g, float b) {
+        // EXT_texture_shared_exponent reference encoding
+        constexpr int MANTISSA_BITS = 9;
+        constexpr int EXPONENT_BIAS = 15;
+        constexpr float SHARED_MAX = 65408.0f;  // (2^9 - 1) / 2^9 * 2^16
+
+        auto clampComponent = [&](float value) {
+            return (value > 0.0f) ? std::min(value, SHARED_MAX) : 0.0f;  // Also maps NaN to 0
+        };
+        r = clampComponent(r);
+        g = clampComponent(g);
+        b = clampComponent(b);
+
+        float maxComponent = std::max(r, std::max(g, b));
+        int sharedExponent = std::max(-EXPONENT_BIAS - 1, static_cast<int>(std::floor(std::log2(std::max(maxComponent, 1e-30f))))) + 1 + EXPONENT_BIAS;
+
+        double denominator = std::pow(2.0, sharedExponent - EXPONENT_BIAS - MANTISSA_BITS);
+        int maxMantissa = static_cast<int>(std::floor(maxComponent / denominator + 0.5));
+        if (maxMantissa == (1 << MANTISSA_BITS)) {
+            denominator *= 2.0;
+            sharedExponent++;
+        }
+
+        uint32_t rm = static_cast<uint32_t>(std::floor(r / denominator + 0.5));
+        uint32_t gm = static_cast<uint32_t>(std::floor(g / denominator + 0.5));
+        uint32_t bm = static_cast<uint32_t>(std::floor(b / denominator + 0.5));
+        return rm | (gm << 9) | (bm << 18) | (static_cast<uint32_t>(sharedExponent) << 27);
+    }
+
+    std::vector<uint32_t> encodeRGB9E5(const FloatImage& image) {
+        size_t texelCount = static_cast<size_t>(image.width) * image.height;
+        std::vector<uint32_t> result(texelCount);
+        JobSystem::get().parallelFor(0, texelCount, TEXELS_PER_JOB, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                result[i] = packRGB9E5(image.rgb[i * 3 + 0], image.rgb[i * 3 + 1], image.rgb[i * 3 + 2]);
+        });
+        return result;
+    }
+
+    size_t bc6hSize(int width, int height) {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * 16;
+    }
+
+    std::vector<uint8_t> encodeBC6H(const FloatImage& image) {
+        int blocksX = (image.width + 3) / 4;
+        int blocksY = (image.height + 3) / 4;
+
+        // Blocks are independent, so the output matches a serial encode exactly
+        std::vector<uint8_t> result(bc6hSize(image.width, image.height));
+        JobSystem::get().parallelFor(0, blocksY, BLOCK_ROWS_PER_JOB, [&](size_t rowBegin, size_t rowEnd) {
+            for (int by = static_cast<int>(rowBegin); by < static_cast<int>(rowEnd); ++by)
+                for (int bx = 0; bx < blocksX; ++bx)
+                    encodeBC6HBlock(image, bx, by, &result[(static_cast<size_t>(by) * blocksX + bx) * 16]);
+        });
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <iostream>
+
+#include "utils/async_readback.hpp"
+#include "utils/gl_debug.hpp"
+
+AsyncReadback::AsyncReadback(size_t slotCount)
+    : m_slots(slotCount > 0 ? slotCount : 1) {
+    for (Slot& slot : m_slots)
+        slot.pbo.create("Readback PBO");
+    m_fbo.create("Readback FBO");
+}
+
+AsyncReadback::~AsyncReadback() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+    }
+}
+
+bool AsyncReadback::begin(GLuint texture, uint32_t width, uint32_t height, uint64_t tag) {
+    if (m_failed || m_pending == m_slots.size())
+        return false;
+
+    Slot& slot = m_slots[(m_head + m_pending) % m_slots.size()];
+    slot.width = width;
+    slot.height = height;
+    slot.size = static_cast<size_t>(width) * height * 4;
+    slot.tag = tag;
+
+    GLDebugGroup group("Async readback");
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo.get());
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo.get());
+    glBufferData(GL_PIXEL_PACK_BUFFER, slot.size, nullptr, GL_STREAM_READ);
+    slot.pbo.setSize(slot.size);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);  // Returns immediately, copies into the PBO
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    m_pending++;
+    return true;
+}
+
+bool AsyncReadback::fetch(std::vector<unsigned char>& pixels, uint64_t& tag, bool wait) {
+    if (m_failed || m_pending == 0)
+        return false;
+
+    Slot& slot = m_slots[m_head];
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (wait && status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1ms
+
+    if (status == GL_WAIT_FAILED) {
+        fail("waiting for the fence failed");
+        return false;
+    }
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    pixels.resize(slot.size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo.get());
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+    if (mapped)
+        std::memcpy(pixels.data(), mapped, slot.size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!mapped) {
+        fail("mapping the pixel buffer failed");
+        return false;
+    }
+
+    tag = slot.tag;
+    m_head = (m_head + 1) % m_slots.size();
+    m_pending--;
+    return true;
+}
+
+void AsyncReadback::fail(const char* reason) {
+    std::cerr << "Error: Async readback " << reason << std::endl;
+    m_failed = true;
+    for (Slot& slot : m_slots) {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+    m_pending = 0;
+}
+
+size_t AsyncReadback::getPendingCount() const {
+    return m_pending;
+}
+
+bool AsyncReadback::hasFailed() const {
+    return m_failed;
+}
@@ -0,0 +1,41 @@
+#include <algorithm>
+
+#include "utils/cli.hpp"
+
+CommandLine::CommandLine(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i)
+        m_args.emplace_back(argv[i]);
+}
+
+bool CommandLine::has(const std::string& flag) const {
+    return std::find(m_args.begin(), m_args.end(), flag) != m_args.end();
+}
+
+std::string CommandLine::get(const std::string& flag, const std::string& fallback) const {
+    auto it = std::find(m_args.begin(), m_args.end(), flag);
+    if (it == m_args.end() || it + 1 == m_args.end())
+        return fallback;
+    return *(it + 1);
+}
+
+int CommandLine::getInt(const std::string& flag, int fallback) const {
+    std::string value = get(flag);
+    if (value.empty())
+        return fallback;
+    try {
+        return std::stoi(value);
+    } catch (...) {
+        return fallback;
+    }
+}
+
+float CommandLine::getFloat(const std::string& flag, float fallback) const {
+    std::string value = get(flag);
+    if (value.empty())
+        return fallback;
+    try {
+        return std::stof(value);
+    } catch (...) {
+        return fallback;
+    }
+}
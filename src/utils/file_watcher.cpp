@@ -0,0 +1,132 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "utils/file_watcher.hpp"
+
+#ifndef __linux__
+namespace {
+    // Without inotify the modification time is checked at most this often
+    constexpr int POLL_MILLISECONDS = 250;
+}
+#endif
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::watch(const std::string& filepath) {
+    stop();
+
+    std::filesystem::path path(filepath);
+    std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        std::cerr << "Error: Could not create an inotify instance: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Saves that replace the file arrive as a move or create in the directory
+    m_watch = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (m_watch < 0) {
+        std::cerr << "Error: Could not watch " << directory.string() << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+#else
+    std::error_code error;
+    m_lastWriteTime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        std::cerr << "Error: Could not watch " << filepath << ": " << error.message() << std::endl;
+        return false;
+    }
+    m_lastCheck = std::chrono::steady_clock::now();
+#endif
+
+    m_path = filepath;
+    m_filename = path.filename().string();
+    m_pending = false;
+    return true;
+}
+
+void FileWatcher::stop() {
+#ifdef __linux__
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_watch = -1;
+#endif
+    m_path.clear();
+    m_filename.clear();
+    m_pending = false;
+}
+
+bool FileWatcher::readChanges() {
+#ifdef __linux__
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+
+    while (true) {
+        ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && m_filename == event->name)
+                changed = true;
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+#else
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastCheck < std::chrono::milliseconds(POLL_MILLISECONDS))
+        return false;
+    m_lastCheck = now;
+
+    // Missing while an editor swaps the file in, the next check sees the new one
+    std::error_code error;
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(m_path, error);
+    if (error || writeTime == m_lastWriteTime)
+        return false;
+
+    m_lastWriteTime = writeTime;
+    return true;
+#endif
+}
+
+bool FileWatcher::poll() {
+    if (!isWatching())
+        return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (readChanges()) {
+        m_pending = true;
+        m_lastChange = now;
+    }
+
+    if (!m_pending || now - m_lastChange < std::chrono::milliseconds(SETTLE_MILLISECONDS))
+        return false;
+
+    m_pending = false;
+    return true;
+}
+
+bool FileWatcher::isWatching() const {
+    return !m_path.empty();
+}
+
+const std::string& FileWatcher::getPath() const {
+    return m_path;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <iostream>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "utils/gl_context.hpp"
+#include "utils/gl_debug.hpp"
+
+// GLFW is shared by every context in the process, only terminate it with the last one
+static int s_contextCount = 0;
+
+GLFWwindow* createHeadlessContext(uint32_t width, uint32_t height) {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return nullptr;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLDebug::isDebugContext() ? GLFW_TRUE : GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "ray-tracing (headless)", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create headless GLFW window" << std::endl;
+        if (s_contextCount == 0)
+            glfwTerminate();
+        return nullptr;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialise GLAD" << std::endl;
+        glfwDestroyWindow(window);
+        if (s_contextCount == 0)
+            glfwTerminate();
+        return nullptr;
+    }
+
+    GLDebug::install();
+    s_contextCount++;
+    return window;
+}
+
+void destroyHeadlessContext(GLFWwindow* window) {
+    if (!window)
+        return;
+
+    glfwDestroyWindow(window);
+    if (--s_contextCount == 0)
+        glfwTerminate();
+}
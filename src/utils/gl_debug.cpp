@@ -0,0 +1,89 @@
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "utils/gl_debug.hpp"
+
+namespace GLDebug {
+
+    namespace {
+        const unsigned MAX_REPEATS = 3;  // Logged occurrences of one message, later ones are only counted
+
+        bool s_debugContext = false;
+
+        struct MessageLog {
+            std::mutex mutex;
+            std::map<std::pair<GLenum, GLuint>, unsigned> counts;  // By source and id
+        };
+
+        MessageLog& messageLog() {
+            static MessageLog instance;
+            return instance;
+        }
+
+        const char* getTypeName(GLenum type) {
+            switch (type) {
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behaviour";
+            case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+            case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+            default: return "other";
+            }
+        }
+
+        void GLAPIENTRY onMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+            const GLchar* message, const void* userParam) {
+            (void)length;
+            (void)userParam;
+            if (severity == GL_DEBUG_SEVERITY_NOTIFICATION || type == GL_DEBUG_TYPE_PUSH_GROUP ||
+                type == GL_DEBUG_TYPE_POP_GROUP || type == GL_DEBUG_TYPE_MARKER)
+                return;
+
+            MessageLog& log = messageLog();
+            std::lock_guard<std::mutex> lock(log.mutex);
+            unsigned count = ++log.counts[{ source, id }];
+            if (count > MAX_REPEATS)
+                return;
+
+            if (type == GL_DEBUG_TYPE_ERROR)
+                std::cerr << "Error (GL): " << message;
+            else
+                std::cerr << "Warning (GL " << getTypeName(type) << "): " << message;
+            if (count == MAX_REPEATS)
+                std::cerr << " (repeats are no longer logged)";
+            std::cerr << std::endl;
+        }
+    }
+
+    void setDebugContext(bool enabled) {
+        s_debugContext = enabled;
+    }
+
+    bool isDebugContext() {
+        return s_debugContext;
+    }
+
+    void install() {
+        if (!GLAD_GL_VERSION_4_3)
+            return;
+
+        glEnable(GL_DEBUG_OUTPUT);
+        if (s_debugContext)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(onMessage, nullptr);
+
+        // Filtered in the driver as well, so it doesn't format messages nobody reads
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    }
+}
+
+GLDebugGroup::GLDebugGroup(const char* name) {
+    if (GLAD_GL_VERSION_4_3)
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+GLDebugGroup::~GLDebugGroup() {
+    if (GLAD_GL_VERSION_4_3)
+        glPopDebugGroup();
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <algorithm>
+
+#include "utils/gl_resource.hpp"
+
+// glObjectLabel fails on names that were generated but never bound, so create() binds them once
+static void bindOnce(GpuResourceKind kind, GLuint id) {
+    GLint previous = 0;
+    switch (kind) {
+    case GpuResourceKind::Buffer:
+        glGetIntegerv(GL_COPY_WRITE_BUFFER_BINDING, &previous);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, previous);
+        break;
+    case GpuResourceKind::Framebuffer:
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, id);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+        break;
+    case GpuResourceKind::VertexArray:
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+        glBindVertexArray(id);
+        glBindVertexArray(previous);
+        break;
+    default: break;
+    }
+}
+
+static GLenum getLabelIdentifier(GpuResourceKind kind) {
+    switch (kind) {
+    case GpuResourceKind::Buffer: return GL_BUFFER;
+    case GpuResourceKind::Texture: return GL_TEXTURE;
+    case GpuResourceKind::Framebuffer: return GL_FRAMEBUFFER;
+    case GpuResourceKind::Program: return GL_PROGRAM;
+    case GpuResourceKind::VertexArray: return GL_VERTEX_ARRAY;
+    case GpuResourceKind::Query: return GL_QUERY;
+    }
+    return GL_NONE;
+}
+
+template <GpuResourceKind Kind>
+void GLHandle<Kind>::create(const std::string& label) {
+    reset();
+
+    switch (Kind) {
+    case GpuResourceKind::Buffer: glGenBuffers(1, &m_id); break;
+    case GpuResourceKind::Texture: glGenTextures(1, &m_id); break;
+    case GpuResourceKind::Framebuffer: glGenFramebuffers(1, &m_id); break;
+    case GpuResourceKind::Program: m_id = glCreateProgram(); break;
+    case GpuResourceKind::VertexArray: glGenVertexArrays(1, &m_id); break;
+    case GpuResourceKind::Query: glGenQueries(1, &m_id); break;
+    }
+
+    GpuMemory::track(Kind, m_id, label);
+
+    // Textures and queries only exist once they have storage or have been used
+    if (Kind != GpuResourceKind::Texture && Kind != GpuResourceKind::Query) {
+        bindOnce(Kind, m_id);
+        this->label();
+    }
+}
+
+template <GpuResourceKind Kind>
+void GLHandle<Kind>::adopt(GLuint id, const std::string& label) {
+    reset();
+    m_id = id;
+    GpuMemory::track(Kind, m_id, label);
+    if (Kind != GpuResourceKind::Query)
+        this->label();  // Adopted objects were already bound or filled by their creator
+}
+
+template <GpuResourceKind Kind>
+void GLHandle<Kind>::reset() {
+    if (m_id == 0)
+        return;
+
+    GpuMemory::untrack(Kind, m_id);
+    m_labelled = false;
+
+    switch (Kind) {
+    case GpuResourceKind::Buffer: glDeleteBuffers(1, &m_id); break;
+    case GpuResourceKind::Texture: glDeleteTextures(1, &m_id); break;
+    case GpuResourceKind::Framebuffer: glDeleteFramebuffers(1, &m_id); break;
+    case GpuResourceKind::Program: glDeleteProgram(m_id); break;
+    case GpuResourceKind::VertexArray: glDeleteVertexArrays(1, &m_id); break;
+    case GpuResourceKind::Query: glDeleteQueries(1, &m_id); break;
+    }
+
+    m_id = 0;
+}
+
+template <GpuResourceKind Kind>
+void GLHandle<Kind>::setSize(size_t bytes) {
+    GpuMemory::setSize(Kind, m_id, bytes);
+    label();
+}
+
+template <GpuResourceKind Kind>
+void GLHandle<Kind>::label() {
+    if (m_labelled || m_id == 0 || !GLAD_GL_VERSION_4_3)
+        return;
+
+    GLint maxLength = 0;
+    glGetIntegerv(GL_MAX_LABEL_LENGTH, &maxLength);
+    std::string text = GpuMemory::getLabel(Kind, m_id);
+    text.resize(std::min<size_t>(text.size(), static_cast<size_t>(std::max(maxLength - 1, 0))));
+
+    glObjectLabel(getLabelIdentifier(Kind), m_id, static_cast<GLsizei>(text.size()), text.c_str());
+    m_labelled = true;
+}
+
+template class GLHandle<GpuResourceKind::Buffer>;
+template class GLHandle<GpuResourceKind::Texture>;
+template class GLHandle<GpuResourceKind::Framebuffer>;
+template class GLHandle<GpuResourceKind::Program>;
+template class GLHandle<GpuResourceKind::VertexArray>;
+template class GLHandle<GpuResourceKind::Query>;
+
+size_t getTextureLevelSize(GLenum internalFormat, uint32_t width, uint32_t height) {
+    size_t bytesPerTexel = 4;
+    switch (internalFormat) {
+    case GL_RGBA32F:
+    case GL_RGBA32UI: bytesPerTexel = 16; break;
+    case GL_RGB32F: bytesPerTexel = 12; break;
+    case GL_RG32F: bytesPerTexel = 8; break;
+    case GL_RGBA16F: bytesPerTexel = 8; break;
+    case GL_RGB16F: bytesPerTexel = 6; break;
+    case GL_R8: bytesPerTexel = 1; break;
+    default: break;  // RGBA8, R32F, RGB9_E5, R32UI ...
+    }
+    return static_cast<size_t>(width) * height * bytesPerTexel;
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "utils/gpu_memory.hpp"
+
+const char* getGpuResourceKindName(GpuResourceKind kind) {
+    switch (kind) {
+    case GpuResourceKind::Buffer: return "Buffer";
+    case GpuResourceKind::Texture: return "Texture";
+    case GpuResourceKind::Framebuffer: return "Framebuffer";
+    case GpuResourceKind::Program: return "Program";
+    case GpuResourceKind::VertexArray: return "Vertex Array";
+    case GpuResourceKind::Query: return "Query";
+    }
+    return "Unknown";
+}
+
+namespace GpuMemory {
+
+    namespace {
+        struct Registry {
+            std::mutex mutex;
+            std::map<std::pair<GpuResourceKind, GLuint>, Allocation> allocations;
+            size_t total = 0;
+            size_t budget = 0;
+            bool warned = false;
+        };
+
+        Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        void checkBudget(Registry& r) {
+            if (r.budget == 0 || r.total <= r.budget) {
+                r.warned = false;
+                return;
+            }
+            if (!r.warned) {
+                r.warned = true;
+                std::cerr << "Warning (GPU Memory): " << r.total / (1024 * 1024) << " MB in use exceeds the "
+                    << r.budget / (1024 * 1024) << " MB budget" << std::endl;
+            }
+        }
+    }
+
+    void track(GpuResourceKind kind, GLuint id, const std::string& label) {
+        if (id == 0)
+            return;
+
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto& allocation = r.allocations[{ kind, id }];
+        r.total -= allocation.bytes;
+        allocation = { kind, id, 0, label };
+    }
+
+    void setSize(GpuResourceKind kind, GLuint id, size_t bytes) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.allocations.find({ kind, id });
+        if (it == r.allocations.end())
+            return;
+
+        r.total = r.total - it->second.bytes + bytes;
+        it->second.bytes = bytes;
+        checkBudget(r);
+    }
+
+    void untrack(GpuResourceKind kind, GLuint id) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.allocations.find({ kind, id });
+        if (it == r.allocations.end())
+            return;
+
+        r.total -= it->second.bytes;
+        r.allocations.erase(it);
+        checkBudget(r);
+    }
+
+    std::string getLabel(GpuResourceKind kind, GLuint id) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.allocations.find({ kind, id });
+        return it == r.allocations.end() ? std::string() : it->second.label;
+    }
+
+    size_t getTotal() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.total;
+    }
+
+    size_t getTotal(GpuResourceKind kind) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        size_t total = 0;
+        for (const auto& entry : r.allocations)
+            if (entry.second.kind == kind)
+                total += entry.second.bytes;
+        return total;
+    }
+
+    size_t getObjectCount() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.allocations.size();
+    }
+
+    std::vector<Allocation> getAllocations() {
+        std::vector<Allocation> result;
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            result.reserve(r.allocations.size());
+            for (const auto& entry : r.allocations)
+                result.push_back(entry.second);
+        }
+
+        std::sort(result.begin(), result.end(), [](const Allocation& a, const Allocation& b) { return a.bytes > b.bytes; });
+        return result;
+    }
+
+    void setBudget(size_t bytes) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.budget = bytes;
+        r.warned = false;
+        checkBudget(r);
+    }
+
+    size_t getBudget() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.budget;
+    }
+
+    bool isOverBudget() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.budget > 0 && r.total > r.budget;
+    }
+}
\ No newline at end of file
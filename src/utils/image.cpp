@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "stb_image_write.h"
+
+#include "utils/image.hpp"
+
+static bool hasExtension(const std::string& filepath, const std::string& extension) {
+    return filepath.size() >= extension.size() &&
+        filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool saveFloatImage(const std::string& filepath, const float* pixels, int width, int height, float gamma) {
+    if (!pixels || width <= 0 || height <= 0) {
+        std::cerr << "Error: Invalid buffer or dimensions for saving image." << std::endl;
+        return false;
+    }
+
+    int result = 0;
+    if (hasExtension(filepath, ".hdr")) {
+        std::vector<float> rgb(static_cast<size_t>(width) * height * 3);
+        for (int y = 0; y < height; ++y) {
+            const float* src = pixels + static_cast<size_t>(height - 1 - y) * width * 4;
+            float* dst = rgb.data() + static_cast<size_t>(y) * width * 3;
+            for (int x = 0; x < width; ++x) {
+                dst[x * 3 + 0] = src[x * 4 + 0];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
+        }
+        result = stbi_write_hdr(filepath.c_str(), width, height, 3, rgb.data());
+    }
+    else {
+        std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+        float invGamma = 1.0f / gamma;
+        for (int y = 0; y < height; ++y) {
+            const float* src = pixels + static_cast<size_t>(height - 1 - y) * width * 4;
+            unsigned char* dst = rgba.data() + static_cast<size_t>(y) * width * 4;
+            for (int x = 0; x < width; ++x) {
+                for (int c = 0; c < 3; ++c) {
+                    float value = std::pow(std::max(src[x * 4 + c], 0.0f), invGamma);
+                    dst[x * 4 + c] = static_cast<unsigned char>(std::min(value, 1.0f) * 255.0f + 0.5f);
+                }
+                dst[x * 4 + 3] = 255;
+            }
+        }
+        result = stbi_write_png(filepath.c_str(), width, height, 4, rgba.data(), width * 4);
+    }
+
+    if (result)
+        std::cout << "Image saved successfully to " << filepath << std::endl;
+    else
+        std::cerr << "Error: Failed to save image to " << filepath << std::endl;
+    return result != 0;
+}
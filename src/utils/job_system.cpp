@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+
+#include "utils/job_system.hpp"
+
+namespace JobDetail {
+    struct Job {
+        JobSystem* system = nullptr;
+        std::function<void()> function;
+        JobThread thread = JobThread::Worker;
+
+        // Unfinished dependencies, plus one held by submit() until the job is fully set up
+        std::atomic<int> remainingDependencies{ 1 };
+
+        std::mutex mutex;
+        std::condition_variable finishedCondition;
+        std::vector<std::shared_ptr<Job>> dependents;
+        std::atomic<bool> finished{ false };
+    };
+}
+
+namespace {
+    // Set on worker threads, so jobs they submit stay in their own queue
+    thread_local const JobSystem* t_workerSystem = nullptr;
+    thread_local size_t t_workerIndex = 0;
+}
+
+bool JobHandle::isReady() const {
+    return m_job && m_job->finished.load(std::memory_order_acquire);
+}
+
+void JobHandle::wait() const {
+    if (m_job)
+        m_job->system->waitFor(*m_job);
+}
+
+JobSystem& JobSystem::get() {
+    static JobSystem instance(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    return instance;
+}
+
+JobSystem::JobSystem(unsigned workerCount) : m_mainThread(std::this_thread::get_id()) {
+    workerCount = std::max(workerCount, 1u);
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, static_cast<size_t>(i));
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_sleepCondition.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+std::shared_ptr<JobDetail::Job> JobSystem::submit(std::function<void()> function, const std::vector<JobHandle>& dependencies, JobThread thread) {
+    auto job = std::make_shared<JobDetail::Job>();
+    job->system = this;
+    job->function = std::move(function);
+    job->thread = thread;
+    m_pendingJobs.fetch_add(1);
+
+    for (const JobHandle& dependency : dependencies) {
+        if (!dependency.m_job)
+            continue;
+        std::lock_guard<std::mutex> lock(dependency.m_job->mutex);
+        if (!dependency.m_job->finished.load(std::memory_order_acquire)) {
+            job->remainingDependencies.fetch_add(1);
+            dependency.m_job->dependents.push_back(job);
+        }
+    }
+
+    // Drop the setup reference, the job is queued here unless a dependency is still running
+    if (job->remainingDependencies.fetch_sub(1) == 1)
+        enqueue(job);
+    return job;
+}
+
+void JobSystem::enqueue(std::shared_ptr<JobDetail::Job> job) {
+    if (job->thread == JobThread::Main) {
+        std::function<void()> wake;
+        {
+            std::lock_guard<std::mutex> lock(m_mainMutex);
+            m_mainJobs.push_back(std::move(job));
+            wake = m_wakeMainThread;
+        }
+        if (wake)
+            wake();
+        return;
+    }
+
+    // Workers keep their own jobs local, other threads spread them round robin
+    size_t index = (t_workerSystem == this) ? t_workerIndex : m_nextQueue.fetch_add(1) % m_queues.size();
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->jobs.push_back(std::move(job));
+    }
+    m_queuedJobs.fetch_add(1);
+
+    // Taking the lock orders this with a worker that is about to sleep
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_sleepCondition.notify_one();
+}
+
+void JobSystem::execute(const std::shared_ptr<JobDetail::Job>& job) {
+    // The packaged task captures exceptions into the future
+    job->function();
+    job->function = nullptr;
+
+    std::vector<std::shared_ptr<JobDetail::Job>> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->finished.store(true, std::memory_order_release);
+        dependents.swap(job->dependents);
+    }
+    job->finishedCondition.notify_all();
+
+    for (std::shared_ptr<JobDetail::Job>& dependent : dependents)
+        if (dependent->remainingDependencies.fetch_sub(1) == 1)
+            enqueue(std::move(dependent));
+
+    m_pendingJobs.fetch_sub(1);
+}
+
+bool JobSystem::runWorkerJob() {
+    std::shared_ptr<JobDetail::Job> job;
+
+    // Own queue first, newest job while it is still in cache
+    size_t start = 0;
+    if (t_workerSystem == this) {
+        start = t_workerIndex;
+        WorkerQueue& own = *m_queues[start];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    else {
+        start = m_nextQueue.load() % m_queues.size();
+    }
+
+    // Then steal the oldest job of another queue
+    for (size_t i = 0; !job && i < m_queues.size(); ++i) {
+        WorkerQueue& victim = *m_queues[(start + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (!job)
+        return false;
+
+    m_queuedJobs.fetch_sub(1);
+    execute(job);
+    return true;
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_workerSystem = this;
+    t_workerIndex = index;
+
+    while (true) {
+        if (runWorkerJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCondition.wait(lock, [this]() { return m_stopping || m_queuedJobs.load() > 0; });
+        if (m_stopping && m_queuedJobs.load() == 0)
+            return;
+    }
+}
+
+void JobSystem::waitFor(JobDetail::Job& job) {
+    while (!job.finished.load(std::memory_order_acquire)) {
+        // Help out instead of blocking, the awaited job may be queued behind others
+        if (isMainThread() && runMainThreadJobs() > 0)
+            continue;
+        if (runWorkerJob())
+            continue;
+
+        // Nothing to run, the job is in progress elsewhere. Wake up now and then for new main thread jobs
+        std::unique_lock<std::mutex> lock(job.mutex);
+        job.finishedCondition.wait_for(lock, std::chrono::milliseconds(1),
+            [&job]() { return job.finished.load(std::memory_order_acquire); });
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (end <= begin)
+        return;
+
+    // A few chunks per thread balances uneven work without much scheduling overhead
+    size_t count = end - begin;
+    size_t maxChunks = (m_workers.size() + 1) * 4;
+    size_t chunks = std::clamp<size_t>(count / std::max<size_t>(grain, 1), 1, maxChunks);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    if (chunks == 1) {
+        body(begin, end);
+        return;
+    }
+
+    std::vector<Task<void>> tasks;
+    for (size_t chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+        size_t chunkEnd = std::min(chunkBegin + chunkSize, end);
+        tasks.push_back(run([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }));
+    }
+
+    // The first chunk runs here. The others reference body, so they must finish before an exception leaves
+    std::exception_ptr error;
+    try {
+        body(begin, std::min(begin + chunkSize, end));
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    for (const Task<void>& task : tasks) {
+        try {
+            task.get();
+        }
+        catch (...) {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+size_t JobSystem::runMainThreadJobs() {
+    // Only the jobs queued so far, continuations they queue run on the next call
+    std::deque<std::shared_ptr<JobDetail::Job>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        jobs.swap(m_mainJobs);
+    }
+
+    for (const std::shared_ptr<JobDetail::Job>& job : jobs)
+        execute(job);
+    return jobs.size();
+}
+
+bool JobSystem::hasMainThreadJobs() const {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    return !m_mainJobs.empty();
+}
+
+void JobSystem::setMainThread() {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_mainThread = std::this_thread::get_id();
+}
+
+bool JobSystem::isMainThread() const {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    return m_mainThread == std::this_thread::get_id();
+}
+
+void JobSystem::setMainThreadWakeCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_wakeMainThread = std::move(callback);
+}
+
+void JobSystem::waitForIdle() {
+    bool mainThread = isMainThread();
+    while (m_pendingJobs.load() > 0) {
+        if (mainThread && runMainThreadJobs() > 0)
+            continue;
+        if (!runWorkerJob())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+unsigned JobSystem::getWorkerCount() const {
+    return static_cast<unsigned>(m_workers.size());
+}
+
+size_t JobSystem::getPendingJobCount() const {
+    return m_pendingJobs.load();
+}
\ No newline at end of file
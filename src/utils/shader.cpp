@@ -5,9 +5,59 @@
 #include "utils/io.hpp"
 #include "utils/shader.hpp"
 
-GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
-    std::string vertexCode = readFile(vertexPath);
-    std::string fragmentCode = readFile(fragmentPath);
+static std::string s_shaderDirectory = "shaders";
+
+void setShaderDirectory(const std::string& directory) {
+    s_shaderDirectory = directory;
+}
+
+std::string getShaderPath(const std::string& filename) {
+    if (s_shaderDirectory.empty())
+        return filename;
+    return s_shaderDirectory + "/" + filename;
+}
+
+static std::string injectDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty())
+        return source;
+
+    // #version must stay the first line
+    size_t versionLine = source.find("#version");
+    size_t insertAt = versionLine == std::string::npos ? 0 : source.find('\n', versionLine);
+    if (insertAt == std::string::npos)
+        return source + "\n" + defines;
+    return source.substr(0, insertAt + 1) + defines + source.substr(insertAt + 1);
+}
+
+static bool checkShader(GLuint shader, const std::string& path) {
+    GLint success = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[2048];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "Error: Failed to compile shader " << path << ":\n" << infoLog << std::endl;
+    }
+    return success != 0;
+}
+
+static GLuint linkProgram(GLuint program) {
+    glLinkProgram(program);
+
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char infoLog[2048];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "Error: Failed to link shader program:\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+GLuint createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines) {
+    std::string vertexCode = injectDefines(readFile(vertexPath), defines);
+    std::string fragmentCode = injectDefines(readFile(fragmentPath), defines);
 
     if (vertexCode.empty() || fragmentCode.empty()) {
         std::cerr << "Error: Failed to read shader files." << std::endl;
@@ -20,17 +70,40 @@ GLuint createShaderProgram(const std::string& vertexPath, const std::string& fra
     GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(vertex, 1, &vertexCodePtr, nullptr);
     glCompileShader(vertex);
+    checkShader(vertex, vertexPath);
 
     GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
     glShaderSource(fragment, 1, &fragmentCodePtr, nullptr);
     glCompileShader(fragment);
+    checkShader(fragment, fragmentPath);
 
     GLuint program = glCreateProgram();
     glAttachShader(program, vertex);
     glAttachShader(program, fragment);
-    glLinkProgram(program);
+    program = linkProgram(program);
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
     return program;
+}
+
+GLuint createComputeProgram(const std::string& computePath, const std::string& defines) {
+    std::string computeCode = injectDefines(readFile(computePath), defines);
+    if (computeCode.empty()) {
+        std::cerr << "Error: Failed to read shader file " << computePath << std::endl;
+        return 0;
+    }
+
+    const char* computeCodePtr = computeCode.c_str();
+    GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute, 1, &computeCodePtr, nullptr);
+    glCompileShader(compute);
+    checkShader(compute, computePath);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, compute);
+    program = linkProgram(program);
+
+    glDeleteShader(compute);
+    return program;
 }
\ No newline at end of file